@@ -0,0 +1,85 @@
+#include "../src/ArrowExport.h"
+#include "../src/Exchange.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+std::vector<char> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+// rows follow price-time priority: bids from the best down, then asks from the best up
+TEST(ArrowExportTest, CapturesQueuesInPriorityOrder) {
+    Book book;
+    OrderIdSequence ids;
+    applyCommand(book, {CommandType::Add, Side::Buy, 10, 990, -1, 1}, ids);  // 0
+    applyCommand(book, {CommandType::Add, Side::Buy, 20, 995, -1, 2}, ids);  // 1
+    applyCommand(book, {CommandType::Add, Side::Buy, 30, 990, -1, 3}, ids);  // 2
+    applyCommand(book, {CommandType::Add, Side::Sell, 40, 1010, -1, 4}, ids); // 3
+    applyCommand(book, {CommandType::Add, Side::Sell, 50, 1005, -1, 5}, ids); // 4
+
+    Level3Snapshot snapshot;
+    captureLevel3(book, "TTF 24Q-ICN", snapshot);
+    ASSERT_EQ(snapshot.size(), 5);
+    EXPECT_EQ(snapshot.orderIds, (std::vector<int64_t>{1, 0, 2, 4, 3}));
+    EXPECT_EQ(snapshot.sides, (std::vector<int8_t>{0, 0, 0, 1, 1}));
+    EXPECT_EQ(snapshot.prices, (std::vector<int32_t>{995, 990, 990, 1005, 1010}));
+    EXPECT_EQ(snapshot.queuePositions, (std::vector<int32_t>{0, 0, 1, 0, 0}));
+    EXPECT_EQ(snapshot.eventTimes, (std::vector<int32_t>{2, 1, 3, 5, 4}));
+    ASSERT_EQ(snapshot.books.size(), 1);
+    EXPECT_EQ(snapshot.books[0].end, 5);
+}
+
+// an exchange-wide export is a valid Arrow file framing one record batch per book
+TEST(ArrowExportTest, WritesArrowFile) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument("TTF 24Q-ICN");
+    exchange.addInstrument("TTF 24Z-ICN");
+    exchange.addInstrument("TTF 25H-ICN");
+    for (int i = 0; i < 100; ++i) {
+        exchange.applyCommand("TTF 24Q-ICN", {CommandType::Add, Side::Buy, 1 + i, 900 + i % 10, -1, 0});
+        exchange.applyCommand("TTF 24Z-ICN", {CommandType::Add, Side::Sell, 1 + i, 1100 + i % 10, -1, 0});
+    }
+
+    Level3Snapshot snapshot;
+    captureLevel3(exchange, snapshot);
+    ASSERT_EQ(snapshot.books.size(), 3);
+    const std::string path = (std::filesystem::temp_directory_path() / "level3.arrow").string();
+    const ArrowExportStats stats = writeArrowIpc(snapshot, path);
+    EXPECT_EQ(stats.rows, 200);
+    // the empty book has no record batch
+    EXPECT_EQ(stats.recordBatches, 2);
+
+    const std::vector<char> file = readFile(path);
+    ASSERT_EQ(file.size(), stats.bytes);
+    EXPECT_EQ(std::string(file.data(), 6), "ARROW1");
+    EXPECT_EQ(std::string(file.data() + file.size() - 6, 6), "ARROW1");
+    int32_t footerLength;
+    std::memcpy(&footerLength, file.data() + file.size() - 10, 4);
+    ASSERT_GT(footerLength, 0);
+    ASSERT_LT(static_cast<size_t>(footerLength), file.size());
+    // the end of stream marker precedes the footer
+    const char* endOfStream = file.data() + file.size() - 10 - footerLength - 8;
+    EXPECT_EQ(std::memcmp(endOfStream, "\xff\xff\xff\xff\0\0\0\0", 8), 0);
+
+    // the order id column of each book is copied verbatim, 64 byte aligned
+    for (const Level3BookRange& book : snapshot.books) {
+        if (book.begin == book.end) {
+            continue;
+        }
+        const char* column = reinterpret_cast<const char*>(snapshot.orderIds.data() + book.begin);
+        const size_t size = (book.end - book.begin) * sizeof(int64_t);
+        const auto found = std::search(file.begin(), file.end(), column, column + size);
+        ASSERT_NE(found, file.end());
+        EXPECT_EQ((found - file.begin()) % 8, 0);
+    }
+    std::filesystem::remove(path);
+}
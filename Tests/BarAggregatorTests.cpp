@@ -0,0 +1,204 @@
+#include "../src/BarWriters.h"
+#include "../src/Book.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <unistd.h>
+
+class BarAggregatorTest : public ::testing::Test {
+protected:
+    BarAggregator aggregator;
+    std::vector<Bar> bars;
+
+    class CollectingSink : public BarSink {
+    public:
+        explicit CollectingSink(std::vector<Bar>& bars) : bars(bars) {}
+        void onBar(const Bar& bar) override { bars.push_back(bar); }
+
+    private:
+        std::vector<Bar>& bars;
+    };
+
+    class CollectingFillSink : public FillSink {
+    public:
+        std::vector<Fill> fills;
+        void onFill(const Fill& fill) override { fills.push_back(fill); }
+    };
+
+    CollectingSink sink{bars};
+
+    void SetUp() override {
+        aggregator.addBarSink(&sink);
+    }
+
+    static Fill makeFill(int price, int shares, int eventTime) {
+        return Fill{0, 0, price, shares, Side::Buy, eventTime};
+    }
+};
+
+// a book reports every execution to its fill sinks, at the price of the resting order
+TEST_F(BarAggregatorTest, BookFillStream) {
+    Book book;
+    OrderIdSequence orderIdSequence;
+    CollectingFillSink fills;
+    book.addFillSink(&fills);
+
+    OrderData sell1(Side::Sell, 10, 40, OrderType::Limit);
+    OrderData sell2(Side::Sell, 10, 41, OrderType::Limit);
+    OrderData buy(Side::Buy, 15, 50, OrderType::Limit);
+    buy.eventTime = 1000;
+    book.addOrderToBook(sell1, orderIdSequence);
+    book.addOrderToBook(sell2, orderIdSequence);
+    book.addOrderToBook(buy, orderIdSequence);
+    book.placeMarketOrder(3, Side::Buy, 1001);
+
+    ASSERT_EQ(fills.fills.size(), 3);
+    EXPECT_EQ(fills.fills[0].restingOrderId, 0);
+    EXPECT_EQ(fills.fills[0].price, 4000);
+    EXPECT_EQ(fills.fills[0].shares, 10);
+    EXPECT_EQ(fills.fills[0].eventTime, 1000);
+    EXPECT_EQ(fills.fills[1].restingOrderId, 1);
+    EXPECT_EQ(fills.fills[1].price, 4100);
+    EXPECT_EQ(fills.fills[1].shares, 5);
+    EXPECT_EQ(fills.fills[2].shares, 3);
+    EXPECT_EQ(fills.fills[2].eventTime, 1001);
+    EXPECT_EQ(fills.fills[2].aggressorSide, Side::Buy);
+    for (size_t i = 0; i < fills.fills.size(); ++i) {
+        EXPECT_EQ(fills.fills[i].sequence, i);
+    }
+}
+
+// fills in a later period complete the open bars
+TEST_F(BarAggregatorTest, BarsRollOnFills) {
+    const uint32_t instrument = aggregator.addInstrument();
+
+    aggregator.onFill(instrument, makeFill(100, 10, 120));
+    aggregator.onFill(instrument, makeFill(105, 5, 120));
+    aggregator.onFill(instrument, makeFill(95, 5, 120));
+    aggregator.onFill(instrument, makeFill(101, 10, 121));
+    EXPECT_EQ(bars.size(), 1);
+
+    const Bar& second = bars[0];
+    EXPECT_EQ(second.resolution, 1);
+    EXPECT_EQ(second.start, 120);
+    EXPECT_EQ(second.open, 100);
+    EXPECT_EQ(second.high, 105);
+    EXPECT_EQ(second.low, 95);
+    EXPECT_EQ(second.close, 95);
+    EXPECT_EQ(second.volume, 20);
+    EXPECT_EQ(second.notional, 100 * 10 + 105 * 5 + 95 * 5);
+    EXPECT_EQ(second.trades, 3);
+
+    aggregator.onFill(instrument, makeFill(110, 1, 180));
+    ASSERT_EQ(bars.size(), 3);
+    EXPECT_EQ(bars[1].resolution, 1);
+    EXPECT_EQ(bars[1].start, 121);
+    EXPECT_EQ(bars[2].resolution, 60);
+    EXPECT_EQ(bars[2].start, 120);
+    EXPECT_EQ(bars[2].open, 100);
+    EXPECT_EQ(bars[2].close, 101);
+    EXPECT_EQ(bars[2].volume, 30);
+    EXPECT_EQ(bars[2].trades, 4);
+}
+
+// the timer completes the bars of quiet instruments, and only the ones whose period ended
+TEST_F(BarAggregatorTest, TimerCompletesBars) {
+    const uint32_t first = aggregator.addInstrument();
+    const uint32_t second = aggregator.addInstrument();
+
+    aggregator.onFill(first, makeFill(100, 10, 60));
+    aggregator.onFill(second, makeFill(200, 10, 61));
+
+    EXPECT_EQ(aggregator.onTimer(61), 1);
+    ASSERT_EQ(bars.size(), 1);
+    EXPECT_EQ(bars[0].instrument, first);
+
+    EXPECT_EQ(aggregator.onTimer(120), 3);
+    EXPECT_EQ(aggregator.onTimer(120), 0);
+    EXPECT_EQ(bars.size(), 4);
+}
+
+// running totals give the vwap of all the fills of an instrument
+TEST_F(BarAggregatorTest, RunningVwap) {
+    const uint32_t instrument = aggregator.addInstrument();
+    EXPECT_FALSE(aggregator.getTotals(instrument).vwap().has_value());
+
+    aggregator.onFill(instrument, makeFill(100, 30, 0));
+    aggregator.onFill(instrument, makeFill(200, 10, 500));
+
+    const TradingTotals& totals = aggregator.getTotals(instrument);
+    EXPECT_EQ(totals.volume, 40);
+    EXPECT_EQ(totals.trades, 2);
+    EXPECT_DOUBLE_EQ(*totals.vwap(), 125.0);
+}
+
+// bars written in columnar blocks read back unchanged
+TEST_F(BarAggregatorTest, ColumnarRoundTrip) {
+    const std::string path = ::testing::TempDir() + "bars_" + std::to_string(getpid()) + ".bin";
+    {
+        ColumnarBarWriter writer(path, 4);
+        aggregator.addBarSink(&writer);
+        const uint32_t instrument = aggregator.addInstrument();
+        for (int second = 0; second < 10; ++second) {
+            aggregator.onFill(instrument, makeFill(100 + second, 1 + second, second));
+        }
+        aggregator.onTimer(60);
+        EXPECT_EQ(writer.getBarsWritten(), 8);
+    }
+
+    std::vector<Bar> read = readColumnarBars(path);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(read.size(), bars.size());
+    for (size_t i = 0; i < bars.size(); ++i) {
+        EXPECT_EQ(read[i].instrument, bars[i].instrument);
+        EXPECT_EQ(read[i].resolution, bars[i].resolution);
+        EXPECT_EQ(read[i].start, bars[i].start);
+        EXPECT_EQ(read[i].open, bars[i].open);
+        EXPECT_EQ(read[i].high, bars[i].high);
+        EXPECT_EQ(read[i].low, bars[i].low);
+        EXPECT_EQ(read[i].close, bars[i].close);
+        EXPECT_EQ(read[i].volume, bars[i].volume);
+        EXPECT_EQ(read[i].notional, bars[i].notional);
+        EXPECT_EQ(read[i].trades, bars[i].trades);
+    }
+}
+
+// bars published to shared memory can be consumed through a second mapping, and overflow is counted
+TEST_F(BarAggregatorTest, SharedMemoryRing) {
+    const std::string name = "/exchange_bars_test_" + std::to_string(getpid());
+    SharedMemoryBarSink publisher(name, 2);
+    SharedMemoryRing<Bar> consumer = SharedMemoryRing<Bar>::open(name);
+
+    aggregator.addBarSink(&publisher);
+    const uint32_t instrument = aggregator.addInstrument();
+    aggregator.onFill(instrument, makeFill(100, 1, 0));
+    aggregator.onFill(instrument, makeFill(101, 1, 1));
+    aggregator.onTimer(60);
+
+    EXPECT_EQ(consumer.size(), 2);
+    EXPECT_EQ(publisher.getDropped(), 1);
+
+    Bar bar{};
+    ASSERT_TRUE(consumer.tryPop(bar));
+    EXPECT_EQ(bar.start, 0);
+    EXPECT_EQ(bar.close, 100);
+    ASSERT_TRUE(consumer.tryPop(bar));
+    EXPECT_EQ(bar.start, 1);
+    EXPECT_FALSE(consumer.tryPop(bar));
+
+    EXPECT_THROW(SharedMemoryRing<Bar>::create(name, 3), std::invalid_argument);
+}
+
+// a ring truncated by another process is refused instead of faulting on its records
+TEST_F(BarAggregatorTest, TruncatedSharedMemoryRing) {
+    const std::string name = "/exchange_bars_truncated_" + std::to_string(getpid());
+    SharedMemoryRing<Bar> producer = SharedMemoryRing<Bar>::create(name, 1024);
+
+    const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, 4096), 0);
+    close(fd);
+
+    EXPECT_THROW(SharedMemoryRing<Bar>::open(name), std::runtime_error);
+    SharedMemoryRing<Bar>::unlink(name);
+}
@@ -0,0 +1,106 @@
+#include "../src/MatchingThread.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+class RecordingSink : public FillSink {
+public:
+    void onFill(const Fill& fill) override { fills.push_back(fill); }
+    std::vector<Fill> fills;
+};
+
+} // namespace
+
+class BatchAuctionTest : public ::testing::Test {
+protected:
+    Book book;
+    OrderIdSequence orderIdSequence;
+    RecordingSink sink;
+
+    void add(Side side, int shares, int price) {
+        applyCommand(book, {CommandType::Add, side, shares, price, -1, 0}, orderIdSequence);
+    }
+};
+
+// crossing orders rest until the auction, which executes the whole crossing volume at one price
+TEST_F(BatchAuctionTest, UncrossesAtAUniformPrice) {
+    book.setMatchingMode(MatchingMode::BatchAuction);
+    book.addFillSink(&sink);
+    add(Side::Buy, 10, 1005);
+    add(Side::Buy, 10, 1003);
+    add(Side::Buy, 10, 999);
+    add(Side::Sell, 5, 998);
+    add(Side::Sell, 10, 1001);
+    add(Side::Sell, 10, 1004);
+    EXPECT_TRUE(sink.fills.empty());
+    EXPECT_EQ(book.getBuySide()->getBestLimit()->getLimitPrice(), 1005);
+    EXPECT_EQ(book.getSellSide()->getBestLimit()->getLimitPrice(), 998);
+
+    const AuctionResult result = book.uncross(42);
+    EXPECT_TRUE(result.crossed);
+    EXPECT_EQ(result.shares, 15);
+    EXPECT_EQ(result.buyLevels, 2);
+    EXPECT_EQ(result.sellLevels, 2);
+    EXPECT_EQ(result.price, 1002);
+    // one fill per pair of a buy and a sell, the sell as the resting order
+    int filledShares = 0;
+    for (const Fill& fill : sink.fills) {
+        EXPECT_EQ(fill.price, 1002);
+        EXPECT_EQ(fill.eventTime, 42);
+        EXPECT_EQ(fill.aggressorSide, Side::Buy);
+        filledShares += fill.shares;
+    }
+    EXPECT_EQ(filledShares, result.shares);
+    ASSERT_EQ(sink.fills.size(), 3);
+    EXPECT_EQ(sink.fills[0].restingOrderId, 3);
+    EXPECT_EQ(sink.fills[0].contraOrderId, 0);
+    EXPECT_EQ(sink.fills[2].restingOrderId, 4);
+    EXPECT_EQ(sink.fills[2].contraOrderId, 1);
+    EXPECT_EQ(sink.fills[2].sequence, 2);
+    EXPECT_EQ(book.getBuySide()->getBestLimit()->getLimitPrice(), 1003);
+    EXPECT_EQ(book.getBuySide()->getBestLimit()->getTotalVolume(), 5);
+    EXPECT_EQ(book.getSellSide()->getBestLimit()->getLimitPrice(), 1004);
+    EXPECT_EQ(book.getMetrics().snapshot().sharesTraded, 15);
+    EXPECT_FALSE(book.uncross().crossed);
+    book.removeFillSink(&sink);
+}
+
+// market orders are rejected in batch auction mode, and leaving it runs a last auction
+TEST_F(BatchAuctionTest, ModeSwitches) {
+    book.setMatchingMode(MatchingMode::BatchAuction, std::chrono::milliseconds(50));
+    add(Side::Buy, 10, 1000);
+    add(Side::Sell, 4, 1000);
+    EXPECT_FALSE(applyCommand(book, {CommandType::Market, Side::Buy, 1, 0, -1, 0}, orderIdSequence).accepted);
+    EXPECT_FALSE(book.uncrossIfDue(std::chrono::steady_clock::now()));
+    EXPECT_EQ(book.getAllOrders()->size(), 2);
+
+    book.setMatchingMode(MatchingMode::Continuous);
+    EXPECT_EQ(book.getAllOrders()->size(), 1);
+    EXPECT_TRUE(book.getSellSide()->getSideTree().empty());
+    EXPECT_EQ(book.getBuySide()->getBestLimit()->getTotalVolume(), 6);
+    EXPECT_FALSE(book.uncrossIfDue(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+}
+
+// a matching thread runs the auctions of its book once their interval ends, even while idle
+TEST_F(BatchAuctionTest, MatchingThreadRunsDueAuctions) {
+    book.setMatchingMode(MatchingMode::BatchAuction, std::chrono::milliseconds(20));
+    add(Side::Buy, 10, 1001);
+    add(Side::Sell, 10, 1000);
+    PublishedDepth depth;
+    DepthReader reader(depth);
+    MatchingThread matchingThread(book, orderIdSequence);
+    matchingThread.publishDepth(depth);
+    matchingThread.start();
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (reader.read().bidLevels != 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    matchingThread.stop();
+
+    EXPECT_GE(matchingThread.getAuctions(), 1);
+    EXPECT_TRUE(book.getAllOrders()->empty());
+    EXPECT_EQ(reader.read().lastTrade.price, 1000);
+}
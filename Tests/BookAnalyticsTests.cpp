@@ -0,0 +1,138 @@
+#include "../src/AnalyticsStream.h"
+#include "../src/Exchange.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+class BookAnalyticsTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Book> orderBook;
+    OrderIdSequence orderIdSequence;
+
+    void SetUp() override {
+        orderBook = std::make_unique<Book>();
+    }
+
+    // recomputes the depth aggregates of a side from scratch
+    template<typename Iterator>
+    static TopDepth walkDepth(Iterator begin, Iterator end) {
+        TopDepth depth;
+        for (auto it = begin; it != end && depth.levels < analyticsDepth; ++it, ++depth.levels) {
+            depth.volume += it->second->getTotalVolume();
+            depth.notional += static_cast<int64_t>(it->first) * it->second->getTotalVolume();
+        }
+        return depth;
+    }
+
+    void expectConsistentDepth() {
+        const auto& bids = orderBook->getBuySide()->getSideTree();
+        const auto& asks = orderBook->getSellSide()->getSideTree();
+        TopDepth expectedBids = walkDepth(bids.rbegin(), bids.rend());
+        TopDepth expectedAsks = walkDepth(asks.begin(), asks.end());
+
+        EXPECT_EQ(orderBook->getBuySide()->getTopDepth().volume, expectedBids.volume);
+        EXPECT_EQ(orderBook->getBuySide()->getTopDepth().notional, expectedBids.notional);
+        EXPECT_EQ(orderBook->getSellSide()->getTopDepth().volume, expectedAsks.volume);
+        EXPECT_EQ(orderBook->getSellSide()->getTopDepth().notional, expectedAsks.notional);
+    }
+};
+
+// analytics of a simple two sided book
+TEST_F(BookAnalyticsTest, TwoSidedBook) {
+    OrderData bid(Side::Buy, 30, 99, OrderType::Limit);
+    OrderData ask(Side::Sell, 10, 101, OrderType::Limit);
+
+    orderBook->addOrderToBook(bid, orderIdSequence);
+    orderBook->addOrderToBook(ask, orderIdSequence);
+
+    BookAnalytics analytics = orderBook->getAnalytics();
+    EXPECT_EQ(analytics.bestBid, 9900);
+    EXPECT_EQ(analytics.bestAsk, 10100);
+    EXPECT_DOUBLE_EQ(analytics.imbalance, 0.5);
+    EXPECT_DOUBLE_EQ(*analytics.microprice, (9900.0 * 10 + 10100.0 * 30) / 40);
+    EXPECT_DOUBLE_EQ(*analytics.weightedMid, 10000);
+    EXPECT_DOUBLE_EQ(*analytics.depthWeightedSpread, 200);
+}
+
+// an empty side leaves the price based analytics undefined
+TEST_F(BookAnalyticsTest, OneSidedBook) {
+    OrderData bid(Side::Buy, 30, 99, OrderType::Limit);
+    orderBook->addOrderToBook(bid, orderIdSequence);
+
+    BookAnalytics analytics = orderBook->getAnalytics();
+    EXPECT_DOUBLE_EQ(analytics.imbalance, 1);
+    EXPECT_FALSE(analytics.microprice.has_value());
+    EXPECT_FALSE(analytics.weightedMid.has_value());
+    EXPECT_FALSE(analytics.bestAsk.has_value());
+}
+
+// only the best levels contribute to the depth
+TEST_F(BookAnalyticsTest, DepthIsLimitedToTopLevels) {
+    for (int i = 0; i < analyticsDepth + 3; ++i) {
+        OrderData ask(Side::Sell, 10, 100 + i, OrderType::Limit);
+        orderBook->addOrderToBook(ask, orderIdSequence);
+    }
+
+    EXPECT_EQ(orderBook->getSellSide()->getTopDepth().levels, analyticsDepth);
+    EXPECT_EQ(orderBook->getAnalytics().askDepthVolume, 10 * analyticsDepth);
+    expectConsistentDepth();
+}
+
+// the incremental aggregates match a full walk after a random mix of operations
+TEST_F(BookAnalyticsTest, IncrementalMatchesRecomputation) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> price(9990, 10010);
+    std::uniform_int_distribution<int> shares(1, 20);
+    std::uniform_int_distribution<int> action(0, 9);
+
+    for (int i = 0; i < 3000; ++i) {
+        const int choice = action(rng);
+        const auto* allOrders = orderBook->getAllOrders();
+        if (choice < 6 || allOrders->empty()) {
+            Side side = (choice % 2) ? Side::Buy : Side::Sell;
+            OrderData order(side, shares(rng), price(rng) / 100.0f, OrderType::Limit);
+            orderBook->addOrderToBook(order, orderIdSequence);
+        } else if (choice < 8) {
+            orderBook->cancelOrder(allOrders->begin()->first);
+        } else if (choice < 9) {
+            orderBook->modifyOrderSize(allOrders->begin()->first, shares(rng));
+        } else {
+            Side side = (i % 2) ? Side::Buy : Side::Sell;
+            const int available = (side == Side::Buy) ? orderBook->getSellSide()->getBestLimit() ? orderBook->getSellSide()->getBestLimit()->getTotalVolume() : 0
+                                                      : orderBook->getBuySide()->getBestLimit() ? orderBook->getBuySide()->getBestLimit()->getTotalVolume() : 0;
+            if (available > 1) {
+                orderBook->placeMarketOrder(available - 1, side);
+            }
+        }
+        expectConsistentDepth();
+        if (HasFailure()) {
+            FAIL() << "aggregates diverged after operation " << i;
+        }
+    }
+}
+
+// the stream publishes changed books at most once per interval
+TEST_F(BookAnalyticsTest, StreamPublishesChangesAtLowRate) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument("TTF 24Q-ICN");
+    exchange.addInstrument("TTF 24Z-ICN");
+
+    AnalyticsStream stream(exchange, std::chrono::milliseconds(100));
+    std::vector<AnalyticsUpdate> received;
+    stream.subscribe([&](const std::vector<AnalyticsUpdate>& updates) {
+        received.insert(received.end(), updates.begin(), updates.end());
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(stream.poll(start), 2);
+
+    OrderData bid(Side::Buy, 10, 47, OrderType::Limit);
+    exchange.addOrder("TTF 24Q-ICN", bid);
+
+    EXPECT_EQ(stream.poll(start + std::chrono::milliseconds(50)), 0);
+    EXPECT_EQ(stream.poll(start + std::chrono::milliseconds(100)), 1);
+    EXPECT_EQ(stream.poll(start + std::chrono::milliseconds(200)), 0);
+
+    ASSERT_EQ(received.size(), 3);
+    EXPECT_EQ(received.back().ticker, "TTF 24Q-ICN");
+    EXPECT_EQ(received.back().analytics.bestBid, 4700);
+}
@@ -0,0 +1,111 @@
+#include "../src/Exchange.hpp"
+#include <gtest/gtest.h>
+
+class BookStatisticsTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Book> orderBook;
+    OrderIdSequence orderIdSequence;
+
+    void SetUp() override {
+        orderBook = std::make_unique<Book>();
+    }
+};
+
+// orders either create a level or join one
+TEST_F(BookStatisticsTest, LevelCreationsAndJoins) {
+    OrderData order1(Side::Buy, 10, 47, OrderType::Limit);
+    OrderData order2(Side::Buy, 10, 47, OrderType::Limit);
+    OrderData order3(Side::Buy, 10, 47, OrderType::Limit);
+    OrderData order4(Side::Sell, 10, 50, OrderType::Limit);
+
+    orderBook->addOrderToBook(order1, orderIdSequence);
+    orderBook->addOrderToBook(order2, orderIdSequence);
+    orderBook->addOrderToBook(order3, orderIdSequence);
+    orderBook->addOrderToBook(order4, orderIdSequence);
+
+    BookStatisticsSnapshot statistics = orderBook->getStatisticsSnapshot();
+    EXPECT_EQ(statistics.levelCreations, 2);
+    EXPECT_EQ(statistics.levelJoins, 2);
+    EXPECT_EQ(statistics.queueLength.count, 4);
+    EXPECT_EQ(statistics.queueLength.buckets[1], 2); // queues of length 1
+    EXPECT_EQ(statistics.queueLength.buckets[2], 2); // queues of length 2 and 3
+}
+
+// the distance from the touch is measured in ticks on the order's own side
+TEST_F(BookStatisticsTest, TouchDistance) {
+    OrderData best(Side::Buy, 10, 47, OrderType::Limit);
+    OrderData behind(Side::Buy, 10, 46.90, OrderType::Limit);
+    OrderData improving(Side::Buy, 10, 47.10, OrderType::Limit);
+
+    orderBook->addOrderToBook(best, orderIdSequence);
+    orderBook->addOrderToBook(behind, orderIdSequence);
+    orderBook->addOrderToBook(improving, orderIdSequence);
+
+    BookStatisticsSnapshot statistics = orderBook->getStatisticsSnapshot();
+    EXPECT_EQ(statistics.touchDistance.count, 3);
+    EXPECT_EQ(statistics.touchDistance.sum, 10);
+    EXPECT_EQ(statistics.touchDistance.buckets[0], 2);
+}
+
+// the lifetime of a level is the number of orders accepted after it was created
+TEST_F(BookStatisticsTest, LevelLifetime) {
+    OrderData order1(Side::Sell, 10, 47, OrderType::Limit);
+    OrderData order2(Side::Sell, 10, 48, OrderType::Limit);
+    OrderData order3(Side::Sell, 10, 49, OrderType::Limit);
+
+    orderBook->addOrderToBook(order1, orderIdSequence);
+    orderBook->addOrderToBook(order2, orderIdSequence);
+    orderBook->addOrderToBook(order3, orderIdSequence);
+    orderBook->cancelOrder(0);
+
+    BookStatisticsSnapshot statistics = orderBook->getStatisticsSnapshot();
+    EXPECT_EQ(statistics.levelLifetime.count, 1);
+    EXPECT_EQ(statistics.levelLifetime.sum, 2); // two orders accepted after the level was created
+}
+
+// the advisor needs enough orders before recommending anything but the tree
+TEST_F(BookStatisticsTest, AdvisorKeepsTreeWithoutData) {
+    OrderData order(Side::Buy, 10, 47, OrderType::Limit);
+    orderBook->addOrderToBook(order, orderIdSequence);
+
+    StorageRecommendation recommendation = StorageAdvisor::recommend(orderBook->getStatisticsSnapshot());
+    EXPECT_EQ(recommendation.policy, StoragePolicy::SparseTree);
+    EXPECT_EQ(recommendation.ladderWindowTicks, 0);
+}
+
+// a book churning levels close to the touch gets a ladder sized from the touch distance
+TEST_F(BookStatisticsTest, AdvisorRecommendsLadderForChurn) {
+    for (int i = 0; i < 2000; ++i) {
+        OrderData order(Side::Buy, 10, 40 + (i % 8) * 0.01f, OrderType::Limit);
+        orderBook->addOrderToBook(order, orderIdSequence);
+        orderBook->cancelOrder(i);
+    }
+
+    StorageRecommendation recommendation = StorageAdvisor::recommend(orderBook->getStatisticsSnapshot());
+    EXPECT_EQ(recommendation.policy, StoragePolicy::DenseLadder);
+    EXPECT_GT(recommendation.ladderWindowTicks, 0);
+    EXPECT_LE(recommendation.ladderWindowTicks, 16);
+}
+
+// a stable book with long queues keeps the tree
+TEST_F(BookStatisticsTest, AdvisorKeepsTreeForStableLevels) {
+    for (int i = 0; i < 2000; ++i) {
+        OrderData order(Side::Sell, 10, 50 + (i % 4) * 0.01f, OrderType::Limit);
+        orderBook->addOrderToBook(order, orderIdSequence);
+    }
+
+    StorageRecommendation recommendation = StorageAdvisor::recommend(orderBook->getStatisticsSnapshot());
+    EXPECT_EQ(recommendation.policy, StoragePolicy::SparseTree);
+    EXPECT_FALSE(recommendation.rationale.empty());
+}
+
+// the exchange produces a recommendation per instrument
+TEST_F(BookStatisticsTest, ExchangeRecommendations) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument("TTF 24Q-ICN");
+    exchange.addInstrument("TTF 24Z-ICN");
+
+    std::map<std::string, StorageRecommendation> recommendations = exchange.getStorageRecommendations();
+    EXPECT_EQ(recommendations.size(), 2);
+    EXPECT_EQ(recommendations["TTF 24Q-ICN"].policy, StoragePolicy::SparseTree);
+}
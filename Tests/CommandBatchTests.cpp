@@ -0,0 +1,51 @@
+#include "../src/CommandBatch.h"
+#include <gtest/gtest.h>
+
+// a batch across instruments fills the result rows, and fills and depth come back as rows
+TEST(CommandBatchTest, SubmitsRowsAndCollectsFills) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument("TTF 24Q-ICN");
+    CommandBatchSession session(exchange);
+    const uint32_t second = session.addInstrument("TTF 24Z-ICN");
+    EXPECT_EQ(session.addInstrument("TTF 24Q-ICN"), 0);
+    EXPECT_EQ(second, 1);
+    EXPECT_NE(exchange.getOrderBook("TTF 24Z-ICN"), nullptr);
+
+    const int64_t commands[] = {
+        0, static_cast<int64_t>(CommandType::Add), 0, 10, 1000, -1, 1,
+        0, static_cast<int64_t>(CommandType::Add), 0, 5, 1000, -1, 2,
+        0, static_cast<int64_t>(CommandType::Add), 1, 12, 990, -1, 3,
+        1, static_cast<int64_t>(CommandType::Market), 0, 5, 0, -1, 4,
+        // unknown instrument, then unknown side
+        2, static_cast<int64_t>(CommandType::Add), 0, 5, 1000, -1, 5,
+        0, static_cast<int64_t>(CommandType::Add), 2, 5, 1000, -1, 6,
+    };
+    EXPECT_EQ(session.submit(commands, 6), 3);
+    EXPECT_EQ(session.getResults(), (std::vector<int64_t>{1, 0, 1, 1, 1, -1, 0, -1, 0, -1, 0, -1}));
+
+    // the sell of 12 filled the first buy and 2 of the second, aggressor side 1
+    EXPECT_EQ(session.getFills(), (std::vector<int64_t>{0, 0, 0, 1000, 10, 1, 3, 0, 1, 1, 1000, 2, 1, 3}));
+    session.clearFills();
+    EXPECT_TRUE(session.getFills().empty());
+
+    const std::vector<int64_t>& depth = session.captureDepth(0, 2);
+    EXPECT_EQ(depth, (std::vector<int64_t>{1000, 3, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0}));
+    EXPECT_THROW(session.captureDepth(2, 1), std::out_of_range);
+}
+
+// rows whose shares, price or event time don't fit the book's int fields are rejected, not truncated
+TEST(CommandBatchTest, RejectsOutOfRangeRows) {
+    Exchange exchange("ENDEX");
+    CommandBatchSession session(exchange);
+    session.addInstrument("TTF 24Q-ICN");
+
+    const int64_t commands[] = {
+        0, static_cast<int64_t>(CommandType::Add), 0, (int64_t{1} << 32) + 10, 1000, -1, 1,
+        0, static_cast<int64_t>(CommandType::Add), 0, 10, (int64_t{1} << 32) + 1000, -1, 2,
+        0, static_cast<int64_t>(CommandType::Add), 0, 10, 1000, -1, int64_t{1} << 40,
+        0, static_cast<int64_t>(CommandType::Add), 0, 10, 1000, -1, 4,
+    };
+    EXPECT_EQ(session.submit(commands, 4), 1);
+    EXPECT_EQ(session.getResults(), (std::vector<int64_t>{0, -1, 0, -1, 0, -1, 1, 0}));
+    EXPECT_EQ(exchange.getOrderBook("TTF 24Q-ICN")->getBuySide()->getSideVolume(), 10);
+}
@@ -0,0 +1,147 @@
+#include "../src/Book.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+class RecordingSink : public FillSink {
+public:
+    void onFill(const Fill& fill) override { fills.push_back(fill); }
+    std::vector<Fill> fills;
+};
+
+} // namespace
+
+class ConstrainedOrderTest : public ::testing::Test {
+protected:
+    Book book;
+    OrderIdSequence orderIdSequence;
+    RecordingSink sink;
+
+    std::optional<int64_t> add(Side side, int shares, float price, int minQuantity = 0) {
+        OrderData order(side, shares, price, OrderType::Limit);
+        order.minQuantity = minQuantity;
+        return book.addOrderToBook(order, orderIdSequence);
+    }
+};
+
+// resting all-or-none and minimum quantity orders only take the volumes they accept
+TEST_F(ConstrainedOrderTest, RestingOrdersRefuseSmallExecutions) {
+    book.addFillSink(&sink);
+    add(Side::Sell, 50, 10.00, allOrNoneQuantity); // id 0, all-or-none
+    add(Side::Sell, 40, 10.00, 20);      // id 1, at least 20 shares
+    add(Side::Sell, 30, 10.00);          // id 2
+
+    EXPECT_FALSE(add(Side::Buy, 10, 10.01).has_value());
+    ASSERT_EQ(sink.fills.size(), 1);
+    EXPECT_EQ(sink.fills[0].restingOrderId, 2);
+
+    EXPECT_FALSE(add(Side::Buy, 25, 10.01).has_value());
+    ASSERT_EQ(sink.fills.size(), 2);
+    EXPECT_EQ(sink.fills[1].restingOrderId, 1);
+    EXPECT_EQ(sink.fills[1].shares, 25);
+
+    // the 15 shares left of order 1 are below its minimum, so only all of them can execute
+    EXPECT_FALSE(add(Side::Buy, 60, 10.01).has_value());
+    ASSERT_EQ(sink.fills.size(), 4);
+    EXPECT_EQ(sink.fills[2].restingOrderId, 0);
+    EXPECT_EQ(sink.fills[2].shares, 50);
+    EXPECT_EQ(sink.fills[3].restingOrderId, 2);
+    EXPECT_EQ(sink.fills[3].shares, 10);
+
+    const Limit* level = book.getSellSide()->getBestLimit();
+    EXPECT_EQ(level->getSize(), 2);
+    EXPECT_EQ(level->getTotalVolume(), 25);
+    EXPECT_EQ(level->getConstrainedVolume(), 15);
+    EXPECT_EQ(book.getSellSide()->getSideVolume(), 25);
+    book.removeFillSink(&sink);
+}
+
+// a run of all-or-none orders is stepped over as a whole and the rest of the volume goes to the next level
+TEST_F(ConstrainedOrderTest, SkipsRunsOfConstrainedOrders) {
+    for (int i = 0; i < 100; ++i) {
+        add(Side::Sell, 50, 10.00, allOrNoneQuantity);
+    }
+    add(Side::Sell, 5, 10.00);
+    add(Side::Sell, 10, 10.01);
+
+    EXPECT_FALSE(add(Side::Buy, 12, 10.02).has_value());
+    const Limit* level = book.getSellSide()->getBestLimit();
+    EXPECT_EQ(level->getLimitPrice(), 1000);
+    EXPECT_EQ(level->getSize(), 100);
+    EXPECT_EQ(book.getSellSide()->findLimit(1001)->getTotalVolume(), 3);
+
+    // cancelling the first order of the run hands the run over to the next one
+    book.cancelOrder(0);
+    book.cancelOrder(50);
+    EXPECT_FALSE(add(Side::Buy, 50, 10.01).has_value());
+    EXPECT_EQ(book.getAllOrders()->count(1), 0);
+    EXPECT_EQ(level->getSize(), 97);
+    EXPECT_EQ(level->getConstrainedVolume(), 97 * 50);
+
+    EXPECT_EQ(level->getHeadOrder()->getOrderId(), 2);
+    EXPECT_EQ(level->getConstrainedRuns(), 1);
+    EXPECT_EQ(level->getEligibleVolume(49), 0);
+    EXPECT_EQ(level->getEligibleVolume(120), 100);
+}
+
+// incoming orders are rejected when they cross but can't execute their minimum, and constrained
+// orders sit out the volume of an auction
+TEST_F(ConstrainedOrderTest, IncomingMinimumsAndAuctions) {
+    add(Side::Sell, 30, 10.00, allOrNoneQuantity);
+    add(Side::Sell, 10, 10.00);
+
+    EXPECT_THROW(add(Side::Buy, 20, 10.01, allOrNoneQuantity), std::runtime_error);
+    EXPECT_EQ(book.getMetrics().snapshot().rejects[static_cast<size_t>(RejectReason::InsufficientLiquidity)], 1);
+    EXPECT_EQ(book.getSellSide()->getSideVolume(), 40);
+    EXPECT_THROW(add(Side::Buy, 10, 10.00, -1), std::invalid_argument);
+
+    EXPECT_FALSE(add(Side::Buy, 10, 10.01, 10).has_value());
+    EXPECT_FALSE(add(Side::Buy, 30, 10.01, allOrNoneQuantity).has_value());
+    EXPECT_EQ(book.getSellSide()->getBestLimit(), nullptr);
+
+    book.setMatchingMode(MatchingMode::BatchAuction);
+    add(Side::Sell, 20, 10.00, allOrNoneQuantity);
+    add(Side::Sell, 10, 10.00);
+    add(Side::Buy, 15, 10.00);
+    const AuctionResult result = book.uncross();
+    EXPECT_TRUE(result.crossed);
+    EXPECT_EQ(result.shares, 10);
+    EXPECT_EQ(book.getSellSide()->getBestLimit()->getTotalVolume(), 20);
+    EXPECT_EQ(book.getSellSide()->getBestLimit()->getConstrainedVolume(), 20);
+    EXPECT_EQ(book.getBuySide()->getBestLimit()->getTotalVolume(), 5);
+}
+
+// a price change replaces the order: the old id leaves the book and the order count is unchanged
+TEST_F(ConstrainedOrderTest, PriceModifyReplacesTheOrder) {
+    add(Side::Buy, 10, 10.00);
+    const std::optional<int64_t> buy = add(Side::Buy, 30, 10.00, 20);
+    ASSERT_TRUE(buy.has_value());
+    const size_t orders = book.getAllOrders()->size();
+
+    book.modifyOrderLimitPrice(*buy, 9.90, orderIdSequence);
+    EXPECT_EQ(book.getAllOrders()->count(*buy), 0);
+    EXPECT_EQ(book.getAllOrders()->size(), orders);
+    EXPECT_EQ(book.getMetrics().snapshot().restingOrders, orders);
+    EXPECT_THROW(book.cancelOrder(*buy), std::invalid_argument);
+    const Limit* level = book.getBuySide()->findLimit(990);
+    ASSERT_NE(level, nullptr);
+    EXPECT_EQ(level->getHeadOrder()->getMinQuantity(), 20);
+    EXPECT_EQ(book.getAllOrders()->count(level->getHeadOrder()->getOrderId()), 1);
+}
+
+// a price change that would cross without executing the order's minimum is rejected and leaves the order resting
+TEST_F(ConstrainedOrderTest, RejectedPriceModifyKeepsTheOrder) {
+    add(Side::Sell, 10, 10.05);
+    const std::optional<int64_t> buy = add(Side::Buy, 30, 10.00, allOrNoneQuantity);
+    ASSERT_TRUE(buy.has_value());
+
+    EXPECT_THROW(book.modifyOrderLimitPrice(*buy, 10.06, orderIdSequence), std::runtime_error);
+    ASSERT_EQ(book.getAllOrders()->count(*buy), 1);
+    const Limit* level = book.getBuySide()->getBestLimit();
+    ASSERT_NE(level, nullptr);
+    EXPECT_EQ(level->getLimitPrice(), 1000);
+    EXPECT_EQ(level->getHeadOrder()->getOrderId(), *buy);
+    EXPECT_EQ(level->getConstrainedVolume(), 30);
+    EXPECT_EQ(book.getBuySide()->getSideVolume(), 30);
+    EXPECT_EQ(book.getSellSide()->getSideVolume(), 10);
+}
@@ -0,0 +1,114 @@
+#include "../src/DarkPool.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+class RecordingSink : public FillSink {
+public:
+    void onFill(const Fill& fill) override { fills.push_back(fill); }
+    std::vector<Fill> fills;
+};
+
+ConsolidatedQuote referenceQuote(int bid, int ask) {
+    ConsolidatedQuote quote;
+    quote.bidPrice = bid;
+    quote.bidVenues = 1;
+    quote.askPrice = ask;
+    quote.askVenues = 1;
+    return quote;
+}
+
+} // namespace
+
+class DarkPoolTest : public ::testing::Test {
+protected:
+    OrderIdSequence orderIdSequence;
+    RecordingSink sink;
+};
+
+// orders rest without matching until a cross, which fills them at the reference midpoint
+TEST_F(DarkPoolTest, CrossesAtTheMidpoint) {
+    DarkPool pool(orderIdSequence, DarkPriority::Time);
+    pool.addFillSink(&sink);
+    const int64_t buy = pool.addOrder(Side::Buy, 10, 1010);
+    const int64_t sell = pool.addOrder(Side::Sell, 6, 990);
+    EXPECT_EQ(pool.getPool(Side::Buy).getTotalVolume(), 10);
+    EXPECT_TRUE(sink.fills.empty());
+
+    const DarkCrossReport report = pool.cross(referenceQuote(1000, 1004), 7);
+    EXPECT_TRUE(report.crossed);
+    EXPECT_EQ(report.price, 1002);
+    EXPECT_EQ(report.shares, 6);
+    EXPECT_EQ(report.matches, 1);
+    ASSERT_EQ(sink.fills.size(), 1);
+    EXPECT_EQ(sink.fills[0].restingOrderId, sell);
+    EXPECT_EQ(sink.fills[0].contraOrderId, buy);
+    EXPECT_EQ(sink.fills[0].aggressorSide, Side::Buy);
+    EXPECT_EQ(sink.fills[0].shares, 6);
+    EXPECT_EQ(sink.fills[0].price, 1002);
+    EXPECT_EQ(sink.fills[0].eventTime, 7);
+
+    EXPECT_EQ(pool.getAllOrders().size(), 1);
+    EXPECT_EQ(pool.getPool(Side::Buy).getTotalVolume(), 4);
+    EXPECT_EQ(pool.getPool(Side::Sell).getHeadOrder(), nullptr);
+    const BookMetricsSnapshot metrics = pool.getMetrics().snapshot();
+    EXPECT_EQ(metrics.sharesTraded, 6);
+    EXPECT_EQ(metrics.ordersFilled, 1);
+    EXPECT_EQ(metrics.restingOrders, 1);
+
+    EXPECT_FALSE(pool.cross(referenceQuote(1000, 1000)).crossed);
+    EXPECT_FALSE(pool.cross(ConsolidatedQuote{}).crossed);
+    pool.removeFillSink(&sink);
+}
+
+// larger orders cross first, and orders whose limit rejects the midpoint keep waiting
+TEST_F(DarkPoolTest, SizePriorityAndLimits) {
+    DarkPool pool(orderIdSequence);
+    pool.addFillSink(&sink);
+    const int64_t small = pool.addOrder(Side::Buy, 5, 1100);
+    const int64_t large = pool.addOrder(Side::Buy, 20, 1100);
+    const int64_t limited = pool.addOrder(Side::Buy, 50, 990);
+    const int64_t later = pool.addOrder(Side::Buy, 5, 1100);
+    pool.addOrder(Side::Sell, 27, 900);
+    EXPECT_EQ(pool.getPool(Side::Buy).getHeadOrder()->getOrderId(), limited);
+
+    const DarkCrossReport report = pool.cross(referenceQuote(999, 1002));
+    EXPECT_EQ(report.price, 1000);
+    EXPECT_EQ(report.shares, 27);
+    EXPECT_EQ(report.matches, 3);
+    // one fill per match, so the fills add up to the shares crossed
+    ASSERT_EQ(sink.fills.size(), 3);
+    int filledShares = 0;
+    for (const Fill& fill : sink.fills) {
+        filledShares += fill.shares;
+    }
+    EXPECT_EQ(filledShares, report.shares);
+    EXPECT_EQ(sink.fills[0].contraOrderId, large);
+    EXPECT_EQ(sink.fills[1].contraOrderId, small);
+    EXPECT_EQ(sink.fills[2].contraOrderId, later);
+    EXPECT_EQ(sink.fills[2].shares, 2);
+    EXPECT_EQ(pool.getAllOrders().count(limited), 1);
+    EXPECT_EQ(pool.getPool(Side::Buy).getSize(), 2);
+    EXPECT_EQ(pool.getPool(Side::Buy).getTotalVolume(), 53);
+    pool.removeFillSink(&sink);
+}
+
+// commands are applied like on a book, crosses only run once their interval elapsed
+TEST_F(DarkPoolTest, CommandsAndCrossInterval) {
+    DarkPool pool(orderIdSequence, DarkPriority::Time, std::chrono::milliseconds(100));
+    const CommandResult added = pool.apply({CommandType::Add, Side::Sell, 10, 1000, -1, 0});
+    ASSERT_TRUE(added.accepted);
+    EXPECT_FALSE(pool.apply({CommandType::Market, Side::Buy, 10, 0, -1, 0}).accepted);
+    EXPECT_FALSE(pool.apply({CommandType::Add, Side::Buy, 0, 1000, -1, 0}).accepted);
+    EXPECT_FALSE(pool.apply({CommandType::Add, Side::Buy, 10, 1000, -1, 0, 5}).accepted);
+    EXPECT_TRUE(pool.apply({CommandType::Cancel, Side::Sell, 0, 0, *added.orderId, 0}).accepted);
+    EXPECT_FALSE(pool.apply({CommandType::Cancel, Side::Sell, 0, 0, *added.orderId, 0}).accepted);
+    EXPECT_TRUE(pool.getAllOrders().empty());
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(pool.crossIfDue(start, referenceQuote(999, 1001)));
+    EXPECT_TRUE(pool.crossIfDue(start + std::chrono::milliseconds(100), referenceQuote(999, 1001)));
+    EXPECT_FALSE(pool.crossIfDue(start + std::chrono::milliseconds(150), referenceQuote(999, 1001)));
+    EXPECT_EQ(pool.getCrosses(), 1);
+    EXPECT_EQ(pool.getMetrics().snapshot().rejects[static_cast<size_t>(RejectReason::UnknownOrder)], 1);
+}
@@ -0,0 +1,121 @@
+#include "../src/DepthConflator.h"
+#include "../src/BookCommand.h"
+#include <gtest/gtest.h>
+
+class DepthConflatorTest : public ::testing::Test {
+protected:
+    Book book;
+    OrderIdSequence orderIdSequence;
+    PublishedDepth depth;
+    DepthConflator conflator;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // adds a bid and publishes the book, as a matching thread would at the end of a batch
+    void addBidAndPublish(int price) {
+        applyCommand(book, {CommandType::Add, Side::Buy, 1, price, -1, 0}, orderIdSequence);
+        depth.publish(book);
+    }
+
+    std::chrono::steady_clock::time_point at(int milliseconds) const {
+        return start + std::chrono::milliseconds(milliseconds);
+    }
+};
+
+// each subscriber gets the latest view at its own rate, skipping the views published in between
+TEST_F(DepthConflatorTest, SubscribersReceiveLatestViewAtTheirOwnRate) {
+    conflator.addBook("TTF 24Q-ICN", depth);
+    std::vector<DepthUpdate> fast, slow;
+    conflator.subscribe(std::chrono::milliseconds(100), [&](const std::vector<DepthUpdate>& updates) {
+        fast.insert(fast.end(), updates.begin(), updates.end());
+    });
+    conflator.subscribe(std::chrono::milliseconds(1000), [&](const std::vector<DepthUpdate>& updates) {
+        slow.insert(slow.end(), updates.begin(), updates.end());
+    });
+
+    EXPECT_EQ(conflator.poll(at(0)), 2);
+    for (int tick = 1; tick <= 10; ++tick) {
+        for (int i = 0; i < 5; ++i) {
+            addBidAndPublish(1000 + tick * 10 + i);
+        }
+        conflator.poll(at(tick * 100));
+    }
+
+    ASSERT_EQ(fast.size(), 11);
+    EXPECT_EQ(fast[1].view.version, 5);
+    EXPECT_EQ(fast[1].skippedViews, 4);
+    EXPECT_EQ(fast.back().view.version, 50);
+    EXPECT_EQ(fast.back().view.bids[0].price, 1104);
+
+    ASSERT_EQ(slow.size(), 2);
+    EXPECT_EQ(slow.back().ticker, "TTF 24Q-ICN");
+    EXPECT_EQ(slow.back().view.version, 50);
+    EXPECT_EQ(slow.back().skippedViews, 49);
+    EXPECT_EQ(conflator.getDeliveredUpdates(), 13);
+    EXPECT_EQ(conflator.getSkippedViews(), 10 * 4 + 49);
+}
+
+// books that did not change since a subscriber's last delivery are not sent again
+TEST_F(DepthConflatorTest, UnchangedBooksAreNotResent) {
+    Book otherBook;
+    PublishedDepth otherDepth;
+    conflator.addBook("TTF 24Q-ICN", depth);
+    conflator.addBook("TTF 24Z-ICN", otherDepth);
+
+    std::vector<std::string> tickers;
+    const auto id = conflator.subscribe(std::chrono::milliseconds(100), [&](const std::vector<DepthUpdate>& updates) {
+        for (const DepthUpdate& update : updates) {
+            tickers.push_back(update.ticker);
+        }
+    });
+
+    EXPECT_EQ(conflator.poll(at(0)), 2);
+    addBidAndPublish(1000);
+    EXPECT_EQ(conflator.poll(at(50)), 0);
+    EXPECT_EQ(conflator.poll(at(100)), 1);
+    EXPECT_EQ(conflator.poll(at(200)), 0);
+    EXPECT_EQ(tickers, (std::vector<std::string>{"TTF 24Q-ICN", "TTF 24Z-ICN", "TTF 24Q-ICN"}));
+
+    conflator.unsubscribe(id);
+    addBidAndPublish(1001);
+    EXPECT_EQ(conflator.getSubscriberCount(), 0);
+    EXPECT_EQ(conflator.poll(at(300)), 0);
+}
+
+// a book added after subscribing is delivered at the subscriber's next update
+TEST_F(DepthConflatorTest, BooksAddedLaterAreDelivered) {
+    std::vector<DepthUpdate> received;
+    conflator.subscribe(std::chrono::milliseconds(100), [&](const std::vector<DepthUpdate>& updates) {
+        received.insert(received.end(), updates.begin(), updates.end());
+    });
+    EXPECT_EQ(conflator.poll(at(0)), 0);
+
+    addBidAndPublish(1000);
+    conflator.addBook("TTF 24Q-ICN", depth);
+    EXPECT_EQ(conflator.poll(at(100)), 1);
+    ASSERT_EQ(received.size(), 1);
+    EXPECT_EQ(received[0].view.bidLevels, 1);
+    EXPECT_EQ(received[0].skippedViews, 0);
+}
+
+// a subscriber callback can register another consumer, which joins at the following poll
+TEST_F(DepthConflatorTest, SubscribesFromACallback) {
+    conflator.addBook("TTF 24Q-ICN", depth);
+
+    std::vector<int> received;
+    for (int i = 0; i < 2; ++i) {
+        conflator.subscribe(std::chrono::milliseconds(100), [&, i](const std::vector<DepthUpdate>& updates) {
+            received.push_back(i);
+            for (int j = 0; j < 8; ++j) {
+                conflator.subscribe(std::chrono::milliseconds(100), [&](const std::vector<DepthUpdate>&) { received.push_back(-1); });
+            }
+        });
+    }
+
+    EXPECT_EQ(conflator.poll(at(0)), 2);
+    EXPECT_EQ(received, (std::vector<int>{0, 1}));
+    EXPECT_EQ(conflator.getSubscriberCount(), 18);
+
+    received.clear();
+    EXPECT_EQ(conflator.poll(at(50)), 16);
+    EXPECT_EQ(received, std::vector<int>(16, -1));
+}
@@ -0,0 +1,91 @@
+#include "../src/ImpactEstimator.h"
+#include "../src/BookCommand.h"
+#include <gtest/gtest.h>
+#include <cmath>
+
+class ImpactEstimatorTest : public ::testing::Test {
+protected:
+    Book book;
+    OrderIdSequence orderIdSequence;
+    PublishedDepth depth;
+};
+
+// a query walks the cumulative levels of the opposite side and prices against the mid
+TEST_F(ImpactEstimatorTest, EstimatesAveragePriceSlippageAndLevels) {
+    applyCommand(book, {CommandType::Add, Side::Buy, 10, 990, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Add, Side::Buy, 20, 980, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Add, Side::Sell, 10, 1010, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Add, Side::Sell, 10, 1020, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Add, Side::Sell, 10, 1030, -1, 0}, orderIdSequence);
+    ASSERT_TRUE(depth.publish(book));
+
+    ImpactEstimator estimator;
+    const uint32_t instrument = estimator.addBook("TTF 24Q-ICN", depth);
+    const std::vector<ImpactEstimate> estimates = estimator.estimate({
+        {instrument, Side::Buy, 5},
+        {instrument, Side::Buy, 25},
+        {instrument, Side::Sell, 20},
+    });
+
+    EXPECT_TRUE(estimates[0].complete);
+    EXPECT_DOUBLE_EQ(estimates[0].midPrice, 1000);
+    EXPECT_DOUBLE_EQ(estimates[0].averagePrice, 1010);
+    EXPECT_DOUBLE_EQ(estimates[0].slippage, 10);
+    EXPECT_DOUBLE_EQ(estimates[0].slippageBps, 100);
+    EXPECT_EQ(estimates[0].levelsConsumed, 1);
+
+    EXPECT_TRUE(estimates[1].complete);
+    EXPECT_EQ(estimates[1].filledShares, 25);
+    EXPECT_DOUBLE_EQ(estimates[1].averagePrice, (1010.0 * 10 + 1020.0 * 10 + 1030.0 * 5) / 25);
+    EXPECT_EQ(estimates[1].levelsConsumed, 3);
+    EXPECT_EQ(estimates[1].worstPrice, 1030);
+
+    EXPECT_DOUBLE_EQ(estimates[2].averagePrice, (990.0 * 10 + 980.0 * 10) / 20);
+    EXPECT_DOUBLE_EQ(estimates[2].slippage, 15);
+    EXPECT_EQ(estimates[2].levelsConsumed, 2);
+    EXPECT_EQ(book.getAllOrders()->size(), 5);
+}
+
+// quantities beyond the displayed depth are reported as incomplete, empty sides have no mid
+TEST_F(ImpactEstimatorTest, IncompleteAndOneSidedBooks) {
+    applyCommand(book, {CommandType::Add, Side::Sell, 10, 1010, -1, 0}, orderIdSequence);
+    ASSERT_TRUE(depth.publish(book));
+
+    ImpactEstimator estimator;
+    const uint32_t instrument = estimator.addBook("TTF 24Q-ICN", depth);
+    const std::vector<ImpactEstimate> estimates = estimator.estimate({
+        {instrument, Side::Buy, 15},
+        {instrument, Side::Sell, 1},
+    });
+
+    EXPECT_FALSE(estimates[0].complete);
+    EXPECT_EQ(estimates[0].filledShares, 10);
+    EXPECT_DOUBLE_EQ(estimates[0].averagePrice, 1010);
+    EXPECT_TRUE(std::isnan(estimates[0].midPrice));
+    EXPECT_FALSE(estimates[1].complete);
+    EXPECT_EQ(estimates[1].filledShares, 0);
+    EXPECT_EQ(estimates[1].levelsConsumed, 0);
+
+    const ImpactQuery unknown{instrument + 1, Side::Buy, 1};
+    EXPECT_THROW(estimator.estimate({unknown}), std::out_of_range);
+}
+
+// the cumulative depth is rebuilt only when a new view is published
+TEST_F(ImpactEstimatorTest, RebuildsOnlyOnNewViews) {
+    applyCommand(book, {CommandType::Add, Side::Buy, 10, 990, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Add, Side::Sell, 10, 1010, -1, 0}, orderIdSequence);
+    ASSERT_TRUE(depth.publish(book));
+
+    ImpactEstimator estimator;
+    const uint32_t instrument = estimator.addBook("TTF 24Q-ICN", depth);
+    std::vector<ImpactQuery> queries(100, ImpactQuery{instrument, Side::Buy, 5});
+    estimator.estimate(queries);
+    estimator.estimate(queries);
+    EXPECT_EQ(estimator.getViewRefreshes(), 1);
+
+    applyCommand(book, {CommandType::Add, Side::Sell, 10, 1005, -1, 0}, orderIdSequence);
+    ASSERT_TRUE(depth.publish(book));
+    const std::vector<ImpactEstimate> estimates = estimator.estimate(queries);
+    EXPECT_EQ(estimator.getViewRefreshes(), 2);
+    EXPECT_DOUBLE_EQ(estimates[0].averagePrice, 1005);
+}
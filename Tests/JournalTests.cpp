@@ -0,0 +1,229 @@
+#include "../src/Journal.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <tuple>
+
+namespace {
+
+std::string journalPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// the live orders of a book by id, as (side, shares, limit)
+std::map<int64_t, std::tuple<Side, int, int>> liveOrders(const Book& book) {
+    std::map<int64_t, std::tuple<Side, int, int>> orders;
+    for (const auto& [orderId, order] : *book.getAllOrders()) {
+        orders[orderId] = {order->getOrderSide(), order->getShares(), order->getLimit()};
+    }
+    return orders;
+}
+
+// writes a random workload for two instruments to a journal and applies it to live books
+void writeWorkload(const std::string& path, Book& first, Book& second, OrderIdSequence& firstIds,
+                   OrderIdSequence& secondIds, int commands) {
+    JournalWriter writer(path, 256);
+    const uint32_t firstInstrument = writer.addInstrument("TTF 24Q-ICN");
+    const uint32_t secondInstrument = writer.addInstrument("TTF 24Z-ICN");
+    std::mt19937 random(7);
+    std::vector<int64_t> resting[2];
+    for (int i = 0; i < commands; ++i) {
+        const int which = random() % 2;
+        Book& book = which == 0 ? first : second;
+        OrderIdSequence& ids = which == 0 ? firstIds : secondIds;
+        std::vector<int64_t>& orders = resting[which];
+        const Side side = random() % 2 ? Side::Buy : Side::Sell;
+        BookCommand command{CommandType::Add, side, 1 + static_cast<int>(random() % 50),
+                            side == Side::Buy ? 990 - static_cast<int>(random() % 20) : 1010 + static_cast<int>(random() % 20),
+                            -1, i / 10};
+        const int kind = random() % 10;
+        if (kind == 0 && !orders.empty()) {
+            command.type = CommandType::Cancel;
+            command.orderId = orders[random() % orders.size()];
+        } else if (kind == 1 && !orders.empty()) {
+            command.type = CommandType::ModifySize;
+            command.orderId = orders[random() % orders.size()];
+        } else if (kind == 2) {
+            command.type = CommandType::Market;
+            command.shares = 1 + random() % 20;
+        } else if (kind == 3) {
+            // crosses the spread
+            command.price = side == Side::Buy ? 1015 : 985;
+        }
+        writer.append(which == 0 ? firstInstrument : secondInstrument, command);
+        const CommandResult result = applyCommand(book, command, ids);
+        if (result.orderId) {
+            orders.push_back(*result.orderId);
+        }
+    }
+}
+
+} // namespace
+
+// every kind of record reads back as written, across instruments and event times
+TEST(JournalTest, RoundTripsEveryRecord) {
+    const std::string path = journalPath("journal_roundtrip.bin");
+    {
+        JournalWriter writer(path);
+        EXPECT_EQ(writer.addInstrument("TTF 24Q-ICN"), 0);
+        EXPECT_EQ(writer.addInstrument("TTF 24Z-ICN"), 1);
+        writer.append(0, {CommandType::Add, Side::Buy, 10, 1000, -1, 5});
+        writer.append(1, {CommandType::Add, Side::Sell, 20, 2500, -1, 5});
+        writer.append(0, {CommandType::Cancel, Side::Buy, 0, 0, 42, 9});
+        writer.append(0, {CommandType::ModifySize, Side::Sell, 7, 0, 40, 3});
+        writer.append(1, {CommandType::Market, Side::Sell, 15, 0, -1, 3});
+        writer.appendRestore(1, 1234567, Side::Sell, 30, 2490);
+        writer.appendNextOrderId(1, 1234600);
+        EXPECT_THROW(writer.append(2, {CommandType::Market, Side::Buy, 1, 0, -1, 0}), std::out_of_range);
+    }
+
+    JournalReader reader(path);
+    JournalRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, JournalRecordType::Instrument);
+    EXPECT_EQ(record.ticker, "TTF 24Q-ICN");
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.instrument, 1);
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, JournalRecordType::Add);
+    EXPECT_EQ(record.instrument, 0);
+    EXPECT_EQ(record.command.side, Side::Buy);
+    EXPECT_EQ(record.command.shares, 10);
+    EXPECT_EQ(record.command.price, 1000);
+    EXPECT_EQ(record.command.eventTime, 5);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.instrument, 1);
+    EXPECT_EQ(record.command.side, Side::Sell);
+    EXPECT_EQ(record.command.price, 2500);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, JournalRecordType::Cancel);
+    EXPECT_EQ(record.command.orderId, 42);
+    EXPECT_EQ(record.command.eventTime, 9);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, JournalRecordType::ModifySize);
+    EXPECT_EQ(record.command.orderId, 40);
+    EXPECT_EQ(record.command.shares, 7);
+    EXPECT_EQ(record.command.eventTime, 3);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, JournalRecordType::Market);
+    EXPECT_EQ(record.command.shares, 15);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, JournalRecordType::Restore);
+    EXPECT_EQ(record.command.orderId, 1234567);
+    EXPECT_EQ(record.command.shares, 30);
+    EXPECT_EQ(record.command.price, 2490);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, JournalRecordType::NextOrderId);
+    EXPECT_EQ(record.command.orderId, 1234600);
+    EXPECT_FALSE(reader.next(record));
+    std::filesystem::remove(path);
+}
+
+// recovery rebuilds the books with the ids they had, and stops cleanly at a torn last record
+TEST(JournalTest, RecoveryRebuildsBooks) {
+    const std::string path = journalPath("journal_recovery.bin");
+    Book first, second;
+    OrderIdSequence firstIds, secondIds;
+    writeWorkload(path, first, second, firstIds, secondIds, 5000);
+
+    JournalRecovery recovery = recoverJournal(path);
+    ASSERT_EQ(recovery.books.size(), 2);
+    EXPECT_EQ(recovery.records, 5002);
+    EXPECT_EQ(recovery.books[0].ticker, "TTF 24Q-ICN");
+    EXPECT_EQ(liveOrders(*recovery.books[0].book), liveOrders(first));
+    EXPECT_EQ(liveOrders(*recovery.books[1].book), liveOrders(second));
+    EXPECT_EQ(recovery.books[0].orderIdSequence->peekNextId(), firstIds.peekNextId());
+    EXPECT_EQ(recovery.books[1].orderIdSequence->peekNextId(), secondIds.peekNextId());
+    // the workload is about 5 bytes per command
+    EXPECT_LT(std::filesystem::file_size(path), 5000 * 6);
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    EXPECT_EQ(recoverJournal(path).records, 5001);
+    std::filesystem::remove(path);
+}
+
+// a compacted journal is smaller and recovers the same orders, ids and time priority
+TEST(JournalTest, CompactionKeepsLiveOrders) {
+    const std::string input = journalPath("journal_full.bin");
+    const std::string output = journalPath("journal_compacted.bin");
+    Book first, second;
+    OrderIdSequence firstIds, secondIds;
+    writeWorkload(input, first, second, firstIds, secondIds, 5000);
+
+    const CompactionStats stats = compactJournal(input, output);
+    EXPECT_EQ(stats.inputRecords, 5002);
+    EXPECT_EQ(stats.liveOrders, first.getAllOrders()->size() + second.getAllOrders()->size());
+    EXPECT_EQ(stats.outputRecords, 2 + stats.liveOrders + 2);
+    EXPECT_EQ(stats.outputBytes, std::filesystem::file_size(output));
+    EXPECT_LT(stats.outputBytes, stats.inputBytes / 2);
+
+    JournalRecovery recovery = recoverJournal(output);
+    ASSERT_EQ(recovery.books.size(), 2);
+    EXPECT_EQ(recovery.rejectedCommands, 0);
+    EXPECT_EQ(liveOrders(*recovery.books[0].book), liveOrders(first));
+    EXPECT_EQ(recovery.books[1].orderIdSequence->peekNextId(), secondIds.peekNextId());
+
+    // the same sweep consumes the same orders in both books
+    OrderIdSequence unused;
+    applyCommand(first, {CommandType::Market, Side::Sell, 200, 0, -1, 0}, unused);
+    applyCommand(*recovery.books[0].book, {CommandType::Market, Side::Sell, 200, 0, -1, 0}, unused);
+    EXPECT_EQ(liveOrders(*recovery.books[0].book), liveOrders(first));
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
+
+// minimum quantities survive the journal and its compaction, so constrained orders recover as they were
+TEST(JournalTest, KeepsMinimumQuantities) {
+    const std::string input = journalPath("journal_constrained.bin");
+    const std::string output = journalPath("journal_constrained_compacted.bin");
+    const BookCommand commands[] = {
+        {CommandType::Add, Side::Sell, 50, 1000, -1, 1, allOrNoneQuantity},
+        {CommandType::Add, Side::Sell, 40, 1000, -1, 1, 20},
+        {CommandType::Add, Side::Sell, 30, 1000, -1, 2},
+        // crosses but can't get its 125 shares, so it is rejected
+        {CommandType::Add, Side::Buy, 130, 1001, -1, 2, 125},
+        {CommandType::Add, Side::Buy, 25, 1001, -1, 3},
+        // an invalid minimum is journaled as sent, in a single byte, and rejected on recovery too
+        {CommandType::Add, Side::Buy, 5, 990, -1, 3, -1},
+    };
+    Book book;
+    OrderIdSequence ids;
+    uint64_t lastRecordBytes = 0;
+    {
+        JournalWriter writer(input);
+        const uint32_t instrument = writer.addInstrument("TTF 24Q-ICN");
+        for (const BookCommand& command : commands) {
+            const uint64_t bytes = writer.getBytesWritten();
+            writer.append(instrument, command);
+            lastRecordBytes = writer.getBytesWritten() - bytes;
+            applyCommand(book, command, ids);
+        }
+    }
+    // tag, shares, price delta and minimum
+    EXPECT_EQ(lastRecordBytes, 4);
+
+    JournalReader reader(input);
+    JournalRecord record;
+    ASSERT_TRUE(reader.next(record));
+    for (const BookCommand& command : commands) {
+        ASSERT_TRUE(reader.next(record));
+        EXPECT_EQ(record.command.minQuantity, command.minQuantity);
+    }
+
+    JournalRecovery recovery = recoverJournal(input);
+    EXPECT_EQ(recovery.rejectedCommands, 2);
+    EXPECT_EQ(liveOrders(*recovery.books[0].book), liveOrders(book));
+
+    compactJournal(input, output);
+    JournalRecovery compacted = recoverJournal(output);
+    const Book& restored = *compacted.books[0].book;
+    EXPECT_EQ(liveOrders(restored), liveOrders(book));
+    EXPECT_EQ(restored.getAllOrders()->at(0)->getMinQuantity(), allOrNoneQuantity);
+    EXPECT_EQ(restored.getAllOrders()->at(1)->getMinQuantity(), 20);
+    // the 15 shares left of order 1 are below its minimum
+    EXPECT_EQ(restored.getSellSide()->getBestLimit()->getConstrainedVolume(), 50 + 15);
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
@@ -1,4 +1,5 @@
 #include "../src/Book.h"
+#include "../src/BookCommand.h"
 #include <gtest/gtest.h>
 #include <chrono>
 
@@ -444,3 +445,19 @@ TEST_F(LimitOrderTest, TestChangingOrderSize) {
     EXPECT_EQ(orderBook->getBuySide()->findLimit(4500)->getTotalVolume(), 20);
     EXPECT_EQ(orderBook->getBuySide()->findLimit(4500)->getSize(), 1);
 }
+
+// Test that a size modification to zero or below is rejected and leaves the book as it was
+TEST_F(LimitOrderTest, RejectsNonPositiveSizes) {
+    applyCommand(*orderBook, {CommandType::Add, Side::Sell, 10, 1000, -1, 0}, orderIdSequence);
+    applyCommand(*orderBook, {CommandType::Add, Side::Sell, 10, 1000, -1, 0}, orderIdSequence);
+
+    EXPECT_FALSE(applyCommand(*orderBook, {CommandType::ModifySize, Side::Sell, 0, 0, 0, 0}, orderIdSequence).accepted);
+    EXPECT_FALSE(applyCommand(*orderBook, {CommandType::ModifySize, Side::Sell, -5, 0, 1, 0}, orderIdSequence).accepted);
+    EXPECT_EQ(orderBook->getMetrics().snapshot().rejects[static_cast<size_t>(RejectReason::InvalidSize)], 2);
+    EXPECT_EQ(orderBook->getSellSide()->getBestLimit()->getTotalVolume(), 20);
+
+    // the book is not crossed: a buy through the level executes
+    EXPECT_FALSE(applyCommand(*orderBook, {CommandType::Add, Side::Buy, 3, 1001, -1, 0}, orderIdSequence).orderId.has_value());
+    EXPECT_EQ(orderBook->getSellSide()->getBestLimit()->getTotalVolume(), 17);
+    EXPECT_EQ(orderBook->getBuySide()->getBestLimit(), nullptr);
+}
@@ -0,0 +1,159 @@
+#include "../src/MappedBook.h"
+#include <gtest/gtest.h>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+std::string bookPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+class RecordingSink : public FillSink {
+public:
+    std::vector<Fill> fills;
+
+    void onFill(const Fill& fill) override {
+        fills.push_back(fill);
+    }
+};
+
+// a random stream of adds, crossing adds, cancels, resizes and small market orders
+std::vector<BookCommand> randomCommands(int count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<BookCommand> commands;
+    int64_t orderIds = 0;
+    for (int i = 0; i < count; ++i) {
+        const Side side = random() % 2 ? Side::Buy : Side::Sell;
+        BookCommand command{CommandType::Add, side, 1 + static_cast<int>(random() % 50),
+                            side == Side::Buy ? 990 - static_cast<int>(random() % 40) : 1010 + static_cast<int>(random() % 40),
+                            -1, i};
+        const int kind = random() % 10;
+        if (kind < 2 && orderIds > 0) {
+            command.type = kind == 0 ? CommandType::Cancel : CommandType::ModifySize;
+            command.orderId = static_cast<int64_t>(random() % orderIds);
+        } else if (kind == 2) {
+            command.type = CommandType::Market;
+            command.shares = 1 + random() % 20;
+        } else {
+            if (kind == 3) {
+                command.price = side == Side::Buy ? 1020 : 980;
+            }
+            ++orderIds;
+        }
+        commands.push_back(command);
+    }
+    return commands;
+}
+
+} // namespace
+
+// the mapped book accepts, rests and fills the same orders as Book
+TEST(MappedBookTest, MatchesLikeBook) {
+    const std::string path = bookPath("mapped_book_matches.bin");
+    MappedBook mapped(path, 10000, 1000);
+    Book book;
+    OrderIdSequence ids;
+    RecordingSink mappedFills, bookFills;
+    mapped.addFillSink(&mappedFills);
+    book.addFillSink(&bookFills);
+
+    for (const BookCommand& command : randomCommands(20000, 3)) {
+        const CommandResult expected = applyCommand(book, command, ids);
+        const CommandResult actual = mapped.apply(command);
+        ASSERT_EQ(actual.accepted, expected.accepted);
+        ASSERT_EQ(actual.orderId, expected.orderId);
+    }
+
+    ASSERT_GT(bookFills.fills.size(), 1000);
+    ASSERT_EQ(mappedFills.fills.size(), bookFills.fills.size());
+    for (size_t i = 0; i < bookFills.fills.size(); ++i) {
+        EXPECT_EQ(mappedFills.fills[i].restingOrderId, bookFills.fills[i].restingOrderId);
+        EXPECT_EQ(mappedFills.fills[i].price, bookFills.fills[i].price);
+        EXPECT_EQ(mappedFills.fills[i].shares, bookFills.fills[i].shares);
+    }
+    EXPECT_EQ(mapped.getOrderCount(), book.getAllOrders()->size());
+    for (const auto& [orderId, order] : *book.getAllOrders()) {
+        const MappedOrderView expected{orderId, order->getOrderSide(), order->getShares(), order->getLimit()};
+        EXPECT_EQ(mapped.findOrder(orderId), expected);
+    }
+    EXPECT_EQ(mapped.getBestPrice(Side::Buy), book.getBuySide()->getBestLimit()->getLimitPrice());
+    EXPECT_EQ(mapped.getLevelCount(), book.getBuySide()->getSideTree().size() + book.getSellSide()->getSideTree().size());
+    EXPECT_EQ(mapped.getNextOrderId(), ids.peekNextId());
+    EXPECT_TRUE(mapped.verify());
+    std::filesystem::remove(path);
+}
+
+// a book killed with its process is reopened in place and carries on with the same ids and sequences
+TEST(MappedBookTest, ReopensAfterProcessCrash) {
+    const std::string path = bookPath("mapped_book_reopen.bin");
+    const std::vector<BookCommand> commands = randomCommands(5000, 5);
+    { MappedBook created(path, 4096, 512); }
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        MappedBook book(path);
+        for (const BookCommand& command : commands) {
+            book.apply(command);
+        }
+        raise(SIGKILL);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFSIGNALED(status));
+
+    MappedBook expected(bookPath("mapped_book_expected.bin"), 4096, 512);
+    for (const BookCommand& command : commands) {
+        expected.apply(command);
+    }
+    MappedBook reopened(path);
+    EXPECT_TRUE(reopened.verify());
+    EXPECT_EQ(reopened.getAppliedCommands(), commands.size());
+    EXPECT_EQ(reopened.getOrders(Side::Buy), expected.getOrders(Side::Buy));
+    EXPECT_EQ(reopened.getOrders(Side::Sell), expected.getOrders(Side::Sell));
+    EXPECT_EQ(reopened.getFillSequence(), expected.getFillSequence());
+
+    const BookCommand add{CommandType::Add, Side::Buy, 5, 900, -1, 0};
+    EXPECT_EQ(reopened.apply(add).orderId, expected.apply(add).orderId);
+    std::filesystem::remove(path);
+    std::filesystem::remove(bookPath("mapped_book_expected.bin"));
+}
+
+// files left in the middle of a command or with a damaged header are refused, full books reject orders
+TEST(MappedBookTest, RefusesTornFilesAndRejectsWhenFull) {
+    const std::string path = bookPath("mapped_book_torn.bin");
+    {
+        MappedBook book(path, 2, 2);
+        EXPECT_TRUE(book.apply({CommandType::Add, Side::Buy, 10, 990, -1, 0}).accepted);
+        EXPECT_TRUE(book.apply({CommandType::Add, Side::Sell, 10, 1010, -1, 0}).accepted);
+        // minimum quantities can't be stored, so constrained orders don't rest as plain ones
+        EXPECT_FALSE(book.apply({CommandType::Add, Side::Sell, 10, 1010, -1, 0, allOrNoneQuantity}).accepted);
+        // no level slot left for a new price, no order slot left at all
+        EXPECT_FALSE(book.apply({CommandType::Add, Side::Buy, 10, 980, -1, 0}).accepted);
+        EXPECT_TRUE(book.apply({CommandType::Cancel, Side::Buy, 0, 0, 0, 0}).accepted);
+        EXPECT_TRUE(book.apply({CommandType::Add, Side::Buy, 10, 980, -1, 0}).accepted);
+        EXPECT_FALSE(book.apply({CommandType::Add, Side::Buy, 10, 980, -1, 0}).accepted);
+        EXPECT_EQ(book.getRejectedCommands(), 3);
+        EXPECT_TRUE(book.verify());
+    }
+    EXPECT_NO_THROW(MappedBook{path});
+
+    auto writeHeaderByte = [&path](size_t offset, char value) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(value);
+    };
+    writeHeaderByte(offsetof(MappedBookHeader, dirty), 1);
+    EXPECT_THROW(MappedBook{path}, std::runtime_error);
+    writeHeaderByte(offsetof(MappedBookHeader, dirty), 0);
+    EXPECT_NO_THROW(MappedBook{path});
+    writeHeaderByte(offsetof(MappedBookHeader, nextOrderId), 42);
+    EXPECT_THROW(MappedBook{path}, std::runtime_error);
+    EXPECT_THROW(MappedBook(path, 0, 1), std::invalid_argument);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,247 @@
+#include "../src/MatchingThread.h"
+#include <gtest/gtest.h>
+#include <chrono>
+
+namespace {
+
+// a coroutine that starts eagerly and is never awaited
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask submitOne(MatchingThread& matchingThread, Executor& executor, BookCommand command, ExecutionReport& report, bool& done,
+                       uint32_t session = 0) {
+    report = co_await matchingThread.submit(command, executor, session);
+    done = true;
+}
+
+DetachedTask submitMany(MatchingThread& matchingThread, Executor& executor, int orders, int& accepted, bool& done) {
+    for (int i = 0; i < orders; ++i) {
+        BookCommand command{CommandType::Add, Side::Buy, 1, 1000 + i % 10, -1, 0};
+        ExecutionReport report = co_await matchingThread.submit(command, executor);
+        accepted += report.status == SubmitStatus::Accepted;
+    }
+    done = true;
+}
+
+DetachedTask submitRecording(MatchingThread& matchingThread, Executor& executor, BookCommand command, uint32_t session,
+                             std::vector<std::string>& executionOrder, std::string tag, ExecutionReport& report) {
+    report = co_await matchingThread.submit(command, executor, session);
+    executionOrder.push_back(tag);
+}
+
+// runs the event loop until the flag is set
+void runUntil(EventLoopExecutor& executor, const bool& flag) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!flag && std::chrono::steady_clock::now() < deadline) {
+        if (!executor.runPending()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace
+
+class MatchingThreadTest : public ::testing::Test {
+protected:
+    Book book;
+    OrderIdSequence orderIdSequence;
+    EventLoopExecutor executor;
+};
+
+// a coroutine resumes on its own executor with the ack and the fills of its order
+TEST_F(MatchingThreadTest, ReportsAckAndFills) {
+    MatchingThread matchingThread(book, orderIdSequence);
+    matchingThread.start();
+
+    ExecutionReport restingReport, crossingReport;
+    bool restingDone = false, crossingDone = false;
+    submitOne(matchingThread, executor, {CommandType::Add, Side::Sell, 10, 1000, -1, 0}, restingReport, restingDone);
+    runUntil(executor, restingDone);
+    submitOne(matchingThread, executor, {CommandType::Add, Side::Buy, 15, 1001, -1, 0}, crossingReport, crossingDone);
+    runUntil(executor, crossingDone);
+
+    ASSERT_TRUE(restingDone);
+    EXPECT_EQ(restingReport.status, SubmitStatus::Accepted);
+    EXPECT_EQ(restingReport.orderId, 0);
+    EXPECT_EQ(restingReport.fills, 0);
+
+    ASSERT_TRUE(crossingDone);
+    EXPECT_EQ(crossingReport.status, SubmitStatus::Accepted);
+    EXPECT_EQ(crossingReport.orderId, 1);
+    EXPECT_EQ(crossingReport.fills, 1);
+    EXPECT_EQ(crossingReport.filledShares, 10);
+    EXPECT_EQ(crossingReport.filledNotional, 10000);
+}
+
+// a command rejected by the book is reported as such
+TEST_F(MatchingThreadTest, ReportsReject) {
+    MatchingThread matchingThread(book, orderIdSequence);
+    matchingThread.start();
+
+    ExecutionReport report;
+    bool done = false;
+    submitOne(matchingThread, executor, {CommandType::Cancel, Side::Buy, 0, 0, 42, 0}, report, done);
+    runUntil(executor, done);
+
+    ASSERT_TRUE(done);
+    EXPECT_EQ(report.status, SubmitStatus::Rejected);
+    EXPECT_EQ(book.getMetrics().snapshot().rejects[static_cast<size_t>(RejectReason::UnknownOrder)], 1);
+}
+
+// commands beyond the completion records in flight complete immediately as busy
+TEST_F(MatchingThreadTest, BusyWhenRecordsExhausted) {
+    MatchingThread matchingThread(book, orderIdSequence, 1);
+
+    ExecutionReport first, second;
+    bool firstDone = false, secondDone = false;
+    submitOne(matchingThread, executor, {CommandType::Add, Side::Buy, 1, 1000, -1, 0}, first, firstDone);
+    submitOne(matchingThread, executor, {CommandType::Add, Side::Buy, 1, 1000, -1, 0}, second, secondDone);
+    EXPECT_FALSE(firstDone);
+    ASSERT_TRUE(secondDone);
+    EXPECT_EQ(second.status, SubmitStatus::Busy);
+
+    matchingThread.start();
+    runUntil(executor, firstDone);
+    EXPECT_EQ(first.status, SubmitStatus::Accepted);
+}
+
+// many coroutines, resumed inline on the matching thread, reuse the same few records
+TEST_F(MatchingThreadTest, InlineExecutorRecyclesRecords) {
+    InlineExecutor inlineExecutor;
+    MatchingThread matchingThread(book, orderIdSequence, 4);
+    matchingThread.start();
+
+    int accepted[4] = {};
+    bool done[4] = {};
+    for (int i = 0; i < 4; ++i) {
+        submitMany(matchingThread, inlineExecutor, 1000, accepted[i], done[i]);
+    }
+    matchingThread.stop();
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(done[i]);
+        EXPECT_EQ(accepted[i], 1000);
+    }
+    EXPECT_EQ(matchingThread.getProcessedCommands(), 4000);
+    EXPECT_EQ(book.getMetrics().snapshot().restingOrders, 4000);
+}
+
+// over the threshold new orders are shed while cancels are admitted, on reserved records, and run
+// ahead of the orders of other sessions
+TEST_F(MatchingThreadTest, ShedsOrdersButAdmitsCancels) {
+    const CommandResult resting = applyCommand(book, {CommandType::Add, Side::Sell, 10, 1000, -1, 0}, orderIdSequence);
+    MatchingThread matchingThread(book, orderIdSequence, 4);
+    matchingThread.setLoadShedding({3, 0, 1, true});
+
+    ExecutionReport buys[4], cancel;
+    bool buysDone[4] = {}, cancelDone = false;
+    for (int i = 0; i < 4; ++i) {
+        submitOne(matchingThread, executor, {CommandType::Add, Side::Buy, 5, 1001, -1, 0}, buys[i], buysDone[i], 1);
+    }
+    ASSERT_TRUE(buysDone[3]);
+    EXPECT_EQ(buys[3].status, SubmitStatus::Shed);
+    EXPECT_TRUE(matchingThread.isShedding());
+    EXPECT_EQ(matchingThread.getQueueDepth(), 3);
+
+    submitOne(matchingThread, executor, {CommandType::Cancel, Side::Sell, 0, 0, *resting.orderId, 0}, cancel, cancelDone);
+    EXPECT_FALSE(cancelDone);
+    matchingThread.start();
+    runUntil(executor, cancelDone);
+    runUntil(executor, buysDone[2]);
+    matchingThread.stop();
+
+    ASSERT_TRUE(cancelDone);
+    EXPECT_EQ(cancel.status, SubmitStatus::Accepted);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(buysDone[i]);
+        EXPECT_EQ(buys[i].status, SubmitStatus::Accepted);
+        // the cancel, although sent last, took the resting order out before the buys could cross it
+        EXPECT_EQ(buys[i].fills, 0);
+    }
+    EXPECT_EQ(matchingThread.getShedCommands(), 1);
+    EXPECT_EQ(matchingThread.getMaxQueueDepth(), 4);
+    EXPECT_EQ(matchingThread.getQueueDepth(), 0);
+    EXPECT_FALSE(matchingThread.isShedding());
+}
+
+// shedding ends with the burst: once the matching thread drained the queue, orders are admitted again
+TEST_F(MatchingThreadTest, ResumesAfterTheQueueDrains) {
+    MatchingThread matchingThread(book, orderIdSequence, 8);
+    matchingThread.setLoadShedding({3, 0, 1, false});
+
+    ExecutionReport burst[4], later;
+    bool burstDone[4] = {}, laterDone = false;
+    for (int i = 0; i < 4; ++i) {
+        submitOne(matchingThread, executor, {CommandType::Add, Side::Buy, 1, 1000, -1, 0}, burst[i], burstDone[i]);
+    }
+    EXPECT_EQ(burst[3].status, SubmitStatus::Shed);
+    EXPECT_TRUE(matchingThread.isShedding());
+
+    matchingThread.start();
+    runUntil(executor, burstDone[2]);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (matchingThread.isShedding() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(matchingThread.isShedding());
+
+    submitOne(matchingThread, executor, {CommandType::Add, Side::Buy, 1, 1000, -1, 0}, later, laterDone);
+    runUntil(executor, laterDone);
+    matchingThread.stop();
+    EXPECT_EQ(later.status, SubmitStatus::Accepted);
+    EXPECT_EQ(matchingThread.getShedCommands(), 1);
+    EXPECT_EQ(book.getBuySide()->getBestLimit()->getTotalVolume(), 4);
+}
+
+// without a shedding policy the queue depth is only monitored
+TEST_F(MatchingThreadTest, MonitorsQueueDepthWithoutShedding) {
+    MatchingThread matchingThread(book, orderIdSequence, 8);
+    ExecutionReport reports[8];
+    bool done[8] = {};
+    for (int i = 0; i < 8; ++i) {
+        submitOne(matchingThread, executor, {CommandType::Add, Side::Buy, 1, 1000, -1, 0}, reports[i], done[i]);
+    }
+    EXPECT_EQ(matchingThread.getQueueDepth(), 8);
+    matchingThread.start();
+    runUntil(executor, done[7]);
+    matchingThread.stop();
+
+    EXPECT_EQ(reports[7].status, SubmitStatus::Accepted);
+    EXPECT_EQ(matchingThread.getMaxQueueDepth(), 8);
+    EXPECT_EQ(matchingThread.getShedCommands(), 0);
+}
+
+// cancels overtake the commands of other sessions in their batch but never one of their own session
+TEST_F(MatchingThreadTest, CancelsFirstKeepsEachSessionsOrder) {
+    const int64_t ask = *applyCommand(book, {CommandType::Add, Side::Sell, 10, 1000, -1, 0}, orderIdSequence).orderId;
+    const int64_t bid1 = *applyCommand(book, {CommandType::Add, Side::Buy, 5, 900, -1, 0}, orderIdSequence).orderId;
+    const int64_t bid2 = *applyCommand(book, {CommandType::Add, Side::Buy, 5, 901, -1, 0}, orderIdSequence).orderId;
+
+    InlineExecutor inlineExecutor;
+    MatchingThread matchingThread(book, orderIdSequence);
+    matchingThread.setBatchScheduling(BatchScheduling::CancelsFirst);
+
+    std::vector<std::string> executionOrder;
+    ExecutionReport reports[5];
+    submitRecording(matchingThread, inlineExecutor, {CommandType::Add, Side::Buy, 10, 1001, -1, 0}, 1, executionOrder, "add 1", reports[0]);
+    submitRecording(matchingThread, inlineExecutor, {CommandType::Cancel, Side::Sell, 0, 0, ask, 0}, 0, executionOrder, "cancel 0", reports[1]);
+    submitRecording(matchingThread, inlineExecutor, {CommandType::Add, Side::Buy, 1, 800, -1, 0}, 2, executionOrder, "add 2", reports[2]);
+    submitRecording(matchingThread, inlineExecutor, {CommandType::Cancel, Side::Buy, 0, 0, bid1, 0}, 2, executionOrder, "cancel 2", reports[3]);
+    submitRecording(matchingThread, inlineExecutor, {CommandType::Cancel, Side::Buy, 0, 0, bid2, 0}, 3, executionOrder, "cancel 3", reports[4]);
+    matchingThread.start();
+    matchingThread.stop();
+
+    EXPECT_EQ(executionOrder, (std::vector<std::string>{"cancel 0", "cancel 3", "add 1", "add 2", "cancel 2"}));
+    EXPECT_EQ(matchingThread.getBatches(), 1);
+    EXPECT_EQ(reports[0].fills, 0);
+    for (const ExecutionReport& report : reports) {
+        EXPECT_EQ(report.status, SubmitStatus::Accepted);
+    }
+}
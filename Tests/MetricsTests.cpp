@@ -0,0 +1,185 @@
+#include "../src/Exchange.hpp"
+#include "../src/MetricsServer.h"
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class MetricsTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Book> orderBook;
+    OrderIdSequence orderIdSequence;
+
+    void SetUp() override {
+        orderBook = std::make_unique<Book>();
+    }
+};
+
+// adding and cancelling orders updates the counters
+TEST_F(MetricsTest, AddAndCancelCounters) {
+    OrderData order1(Side::Buy, 10, 47, OrderType::Limit);
+    OrderData order2(Side::Buy, 20, 47, OrderType::Limit);
+    OrderData order3(Side::Buy, 30, 46, OrderType::Limit);
+
+    orderBook->addOrderToBook(order1, orderIdSequence);
+    orderBook->addOrderToBook(order2, orderIdSequence);
+    orderBook->addOrderToBook(order3, orderIdSequence);
+    orderBook->cancelOrder(2);
+
+    BookMetricsSnapshot snapshot = orderBook->getMetrics().snapshot();
+    EXPECT_EQ(snapshot.ordersAdded, 3);
+    EXPECT_EQ(snapshot.ordersCancelled, 1);
+    EXPECT_EQ(snapshot.levelsCreated, 2);
+    EXPECT_EQ(snapshot.levelsDestroyed, 1);
+    EXPECT_EQ(snapshot.restingOrders, 2);
+    EXPECT_EQ(snapshot.sweepDepth.count, 0);
+}
+
+// an aggressive order records the levels it crossed and the orders it filled
+TEST_F(MetricsTest, SweepDepthAndFills) {
+    OrderData sell1(Side::Sell, 10, 40, OrderType::Limit);
+    OrderData sell2(Side::Sell, 10, 41, OrderType::Limit);
+    OrderData sell3(Side::Sell, 10, 42, OrderType::Limit);
+    OrderData buy(Side::Buy, 25, 50, OrderType::Limit);
+
+    orderBook->addOrderToBook(sell1, orderIdSequence);
+    orderBook->addOrderToBook(sell2, orderIdSequence);
+    orderBook->addOrderToBook(sell3, orderIdSequence);
+    orderBook->addOrderToBook(buy, orderIdSequence);
+
+    BookMetricsSnapshot snapshot = orderBook->getMetrics().snapshot();
+    EXPECT_EQ(snapshot.ordersFilled, 2);
+    EXPECT_EQ(snapshot.sharesTraded, 25);
+    EXPECT_EQ(snapshot.levelsDestroyed, 2);
+    EXPECT_EQ(snapshot.restingOrders, 1);
+    EXPECT_EQ(snapshot.sweepDepth.count, 1);
+    EXPECT_EQ(snapshot.sweepDepth.sum, 3);
+    EXPECT_EQ(snapshot.sweepDepth.buckets[2], 1); // 2-3 levels
+}
+
+// orders completely consumed by a partial fill of their level leave the book
+TEST_F(MetricsTest, PartialFillRemovesFilledOrders) {
+    OrderData buy1(Side::Buy, 5, 30, OrderType::Limit);
+    OrderData buy2(Side::Buy, 5, 30, OrderType::Limit);
+
+    orderBook->addOrderToBook(buy1, orderIdSequence);
+    orderBook->addOrderToBook(buy2, orderIdSequence);
+    orderBook->placeMarketOrder(7, Side::Sell);
+
+    EXPECT_EQ(orderBook->getAllOrders()->size(), 1);
+    EXPECT_EQ(orderBook->getAllOrders()->count(0), 0);
+    EXPECT_EQ(orderBook->getMetrics().snapshot().ordersFilled, 1);
+    EXPECT_EQ(orderBook->getMetrics().snapshot().restingOrders, 1);
+}
+
+// rejected orders are counted by reason
+TEST_F(MetricsTest, RejectsByReason) {
+    OrderData negativeSize(Side::Buy, -1, 30, OrderType::Limit);
+    OrderData negativePrice(Side::Buy, 1, -30, OrderType::Limit);
+
+    EXPECT_THROW(orderBook->addOrderToBook(negativeSize, orderIdSequence), std::invalid_argument);
+    EXPECT_THROW(orderBook->addOrderToBook(negativePrice, orderIdSequence), std::invalid_argument);
+    EXPECT_THROW(orderBook->cancelOrder(42), std::invalid_argument);
+    EXPECT_THROW(orderBook->placeMarketOrder(5, Side::Buy), std::runtime_error);
+
+    BookMetricsSnapshot snapshot = orderBook->getMetrics().snapshot();
+    EXPECT_EQ(snapshot.rejects[static_cast<size_t>(RejectReason::InvalidSize)], 1);
+    EXPECT_EQ(snapshot.rejects[static_cast<size_t>(RejectReason::InvalidPrice)], 1);
+    EXPECT_EQ(snapshot.rejects[static_cast<size_t>(RejectReason::UnknownOrder)], 1);
+    EXPECT_EQ(snapshot.rejects[static_cast<size_t>(RejectReason::InsufficientLiquidity)], 1);
+    EXPECT_EQ(snapshot.ordersAdded, 0);
+    EXPECT_TRUE(orderBook->getBuySide()->getSideTree().empty());
+}
+
+// the exchange snapshot covers every book and renders as prometheus text
+TEST_F(MetricsTest, ExchangeSnapshotAndPrometheusFormat) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument("TTF 24Q-ICN");
+    exchange.addInstrument("TTF 24Z-ICN");
+
+    OrderData order(Side::Buy, 5, 47, OrderType::Limit);
+    exchange.addOrder("TTF 24Q-ICN", order);
+
+    ExchangeMetricsSnapshot snapshot = exchange.getMetricsSnapshot();
+    EXPECT_EQ(snapshot.books.size(), 2);
+    EXPECT_EQ(snapshot.books["TTF 24Q-ICN"].ordersAdded, 1);
+    EXPECT_EQ(snapshot.books["TTF 24Z-ICN"].ordersAdded, 0);
+
+    // orders for an instrument the exchange doesn't cover are counted before they are refused
+    EXPECT_THROW(exchange.addOrder("TTF 25H-ICN", order), std::runtime_error);
+    EXPECT_EQ(exchange.getMetricsSnapshot().unknownInstrumentRejects, 1);
+
+    std::string text = formatPrometheusMetrics(snapshot);
+    EXPECT_NE(text.find("# TYPE exchange_orders_added_total counter"), std::string::npos);
+    EXPECT_NE(text.find("exchange_orders_added_total{exchange=\"ENDEX\",instrument=\"TTF 24Q-ICN\"} 1"), std::string::npos);
+    EXPECT_NE(text.find("exchange_sweep_depth_levels_bucket{exchange=\"ENDEX\",instrument=\"TTF 24Q-ICN\",le=\"+Inf\"} 0"), std::string::npos);
+}
+
+// the metrics server answers scrapes on localhost
+TEST_F(MetricsTest, ServerAnswersScrape) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument("TTF 24Q-ICN");
+
+    MetricsServer server(exchange, 0);
+    server.start();
+    ASSERT_NE(server.getPort(), 0);
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(client, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(server.getPort());
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+    const std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(client, request.data(), request.size(), 0);
+
+    std::string response;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, received);
+    }
+    close(client);
+    server.stop();
+
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK", 0), 0);
+    EXPECT_NE(response.find("exchange_resting_orders{exchange=\"ENDEX\",instrument=\"TTF 24Q-ICN\"} 0"), std::string::npos);
+}
+
+// a client that connects without sending a request neither blocks scrapes for long nor stop()
+TEST_F(MetricsTest, SilentClientTimesOut) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument("TTF 24Q-ICN");
+
+    MetricsServer server(exchange, 0);
+    server.start();
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(server.getPort());
+
+    int silent = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(silent, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    const std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(client, request.data(), request.size(), 0);
+    std::string response;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, received);
+    }
+    close(client);
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK", 0), 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    server.stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    close(silent);
+}
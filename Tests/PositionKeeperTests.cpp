@@ -0,0 +1,118 @@
+#include "../src/PositionKeeper.h"
+#include <gtest/gtest.h>
+#include <chrono>
+
+namespace {
+
+// waits until the keeper applied the given number of fills
+bool waitForFills(const PositionKeeper& keeper, uint64_t fills) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (keeper.getProcessedFills() < fills && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    return keeper.getProcessedFills() == fills;
+}
+
+} // namespace
+
+// positions realize P&L at the average entry price and can flip from long to short
+TEST(PositionKeeperTest, AverageCostPnl) {
+    PositionKeeper keeper(2, 1);
+    keeper.start();
+    keeper.publish({0, 0, Side::Buy, 100, 10});
+    keeper.publish({0, 0, Side::Buy, 130, 10});
+    keeper.publish({0, 0, Side::Sell, 125, 5});
+    keeper.publish({0, 0, Side::Sell, 100, 20});
+    ASSERT_TRUE(waitForFills(keeper, 4));
+
+    const PositionSnapshot position = keeper.getPosition(0, 0);
+    // bought 20 at an average of 115: 5 sold at 125 realize +50, 15 sold at 100 realize -225
+    EXPECT_EQ(position.realizedPnl, 50 - 225);
+    EXPECT_EQ(position.netShares, -5);
+    EXPECT_EQ(position.openNotional, -500);
+    EXPECT_EQ(position.tradedShares, 45);
+    EXPECT_EQ(position.tradedNotional, 1000 + 1300 + 625 + 2000);
+    EXPECT_EQ(position.fills, 4);
+    EXPECT_EQ(keeper.getPosition(1, 0).fills, 0);
+    EXPECT_THROW(keeper.getPosition(2, 0), std::out_of_range);
+}
+
+// both sides of every fill of a book reach the positions of their accounts
+TEST(PositionKeeperTest, AttributesFillsOfABook) {
+    Book book;
+    OrderIdSequence orderIdSequence;
+    PositionKeeper keeper(3, 2);
+    AccountFillSink sink(keeper, 1);
+    book.addFillSink(&sink);
+    keeper.start();
+
+    sink.apply(book, {CommandType::Add, Side::Sell, 10, 1000, -1, 0}, orderIdSequence, 0);
+    sink.apply(book, {CommandType::Add, Side::Sell, 10, 1010, -1, 0}, orderIdSequence, 1);
+    sink.apply(book, {CommandType::Add, Side::Buy, 15, 1020, -1, 0}, orderIdSequence, 2);
+    ASSERT_TRUE(waitForFills(keeper, 4));
+
+    EXPECT_EQ(keeper.getPosition(0, 1).netShares, -10);
+    EXPECT_EQ(keeper.getPosition(1, 1).netShares, -5);
+    EXPECT_EQ(keeper.getPosition(2, 1).netShares, 15);
+    EXPECT_EQ(keeper.getPosition(2, 1).openNotional, 10000 + 5050);
+    EXPECT_EQ(keeper.getAccountPositions(2)[0].fills, 0);
+    EXPECT_EQ(sink.getUnattributedFills(), 0);
+
+    // an order entered without an account executes without a resting side
+    OrderData anonymous(Side::Sell, 1, 9.0f, OrderType::Limit);
+    book.addOrderToBook(anonymous, orderIdSequence);
+    sink.apply(book, {CommandType::Market, Side::Buy, 1, 0, -1, 0}, orderIdSequence, 2);
+    ASSERT_TRUE(waitForFills(keeper, 5));
+    EXPECT_EQ(sink.getUnattributedFills(), 1);
+    book.removeFillSink(&sink);
+}
+
+// an auction fill goes to the owners of both resting orders, whoever sent the last command
+TEST(PositionKeeperTest, AttributesAuctionFills) {
+    Book book;
+    OrderIdSequence orderIdSequence;
+    PositionKeeper keeper(3, 1);
+    AccountFillSink sink(keeper, 0);
+    book.addFillSink(&sink);
+    book.setMatchingMode(MatchingMode::BatchAuction);
+    keeper.start();
+
+    sink.apply(book, {CommandType::Add, Side::Buy, 10, 1005, -1, 0}, orderIdSequence, 0);
+    sink.apply(book, {CommandType::Add, Side::Sell, 10, 1001, -1, 0}, orderIdSequence, 1);
+    sink.apply(book, {CommandType::Add, Side::Buy, 10, 990, -1, 0}, orderIdSequence, 2);
+    EXPECT_EQ(book.uncross().shares, 10);
+    ASSERT_TRUE(waitForFills(keeper, 2));
+
+    EXPECT_EQ(keeper.getPosition(0, 0).netShares, 10);
+    EXPECT_EQ(keeper.getPosition(1, 0).netShares, -10);
+    EXPECT_EQ(keeper.getPosition(2, 0).fills, 0);
+    EXPECT_EQ(sink.getUnattributedFills(), 0);
+    book.removeFillSink(&sink);
+}
+
+// readers racing with the keeper only see positions that are consistent with whole fills
+TEST(PositionKeeperTest, ConcurrentReadersSeeWholeFills) {
+    PositionKeeper keeper(1, 1, 64);
+    keeper.start();
+    constexpr int fills = 50000;
+    std::atomic<bool> done = false;
+    int inconsistent = 0;
+
+    std::thread reader([&]() {
+        while (!done) {
+            const PositionSnapshot position = keeper.getPosition(0, 0);
+            // every fill buys 2 shares at 100
+            inconsistent += position.netShares != 2 * static_cast<int64_t>(position.fills) ||
+                            position.tradedNotional != 200 * static_cast<int64_t>(position.fills);
+        }
+    });
+    for (int i = 0; i < fills; ++i) {
+        keeper.publish({0, 0, Side::Buy, 100, 2});
+    }
+    EXPECT_TRUE(waitForFills(keeper, fills));
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(inconsistent, 0);
+    EXPECT_EQ(keeper.getPosition(0, 0).netShares, 2 * fills);
+}
@@ -0,0 +1,139 @@
+#include "../src/MatchingThread.h"
+#include <gtest/gtest.h>
+#include <chrono>
+
+namespace {
+
+// a coroutine that starts eagerly and is never awaited
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask submitAll(MatchingThread& matchingThread, Executor& executor, std::vector<BookCommand> commands, std::atomic<bool>& done) {
+    for (const BookCommand& command : commands) {
+        co_await matchingThread.submit(command, executor);
+    }
+    done = true;
+}
+
+} // namespace
+
+class PublishedDepthTest : public ::testing::Test {
+protected:
+    Book book;
+    OrderIdSequence orderIdSequence;
+};
+
+// a view holds the best levels of each side, best first, and the last trade
+TEST_F(PublishedDepthTest, PublishesTopLevelsAndLastTrade) {
+    PublishedDepth depth;
+    book.addFillSink(&depth);
+    DepthReader reader(depth);
+    EXPECT_EQ(reader.read().version, 0);
+    EXPECT_EQ(reader.read().bidLevels, 0);
+
+    for (int i = 0; i < 12; ++i) {
+        applyCommand(book, {CommandType::Add, Side::Buy, 10, 900 + i, -1, 0}, orderIdSequence);
+    }
+    applyCommand(book, {CommandType::Add, Side::Buy, 5, 911, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Add, Side::Sell, 7, 950, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Add, Side::Sell, 8, 960, -1, 0}, orderIdSequence);
+    applyCommand(book, {CommandType::Market, Side::Buy, 3, 0, -1, 42}, orderIdSequence);
+    ASSERT_TRUE(depth.publish(book));
+
+    const DepthView view = reader.read();
+    EXPECT_EQ(view.version, 1);
+    ASSERT_EQ(view.bidLevels, publishedDepthLevels);
+    EXPECT_EQ(view.bids[0].price, 911);
+    EXPECT_EQ(view.bids[0].volume, 15);
+    EXPECT_EQ(view.bids[0].orders, 2);
+    EXPECT_EQ(view.bids[publishedDepthLevels - 1].price, 902);
+    ASSERT_EQ(view.askLevels, 2);
+    EXPECT_EQ(view.asks[0].price, 950);
+    EXPECT_EQ(view.asks[0].volume, 4);
+    EXPECT_EQ(view.asks[1].price, 960);
+    ASSERT_TRUE(view.hasLastTrade);
+    EXPECT_EQ(view.lastTrade.price, 950);
+    EXPECT_EQ(view.lastTrade.shares, 3);
+    EXPECT_EQ(view.lastTrade.eventTime, 42);
+    book.removeFillSink(&depth);
+}
+
+// the matching thread republishes the depth once per batch
+TEST_F(PublishedDepthTest, MatchingThreadRepublishesAfterEachBatch) {
+    PublishedDepth depth;
+    DepthReader reader(depth);
+    InlineExecutor executor;
+    MatchingThread matchingThread(book, orderIdSequence);
+    matchingThread.publishDepth(depth);
+    matchingThread.start();
+
+    std::atomic<bool> done = false;
+    submitAll(matchingThread, executor,
+              {{CommandType::Add, Side::Sell, 10, 1000, -1, 0}, {CommandType::Add, Side::Buy, 4, 1001, -1, 0}}, done);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    matchingThread.stop();
+
+    ASSERT_TRUE(done);
+    const DepthView view = reader.read();
+    EXPECT_EQ(view.version, depth.getPublications());
+    EXPECT_EQ(depth.getPublications(), matchingThread.getBatches() + 1);
+    EXPECT_EQ(view.bidLevels, 0);
+    ASSERT_EQ(view.askLevels, 1);
+    EXPECT_EQ(view.asks[0].volume, 6);
+    EXPECT_TRUE(view.hasLastTrade);
+    EXPECT_EQ(view.lastTrade.shares, 4);
+}
+
+// readers racing with the writer only ever see complete views
+TEST_F(PublishedDepthTest, ConcurrentReadersSeeConsistentViews) {
+    PublishedDepth depth;
+    constexpr int publications = 20000;
+    std::atomic<bool> stop = false;
+    std::atomic<int> inconsistent = 0;
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&]() {
+            DepthReader reader(depth);
+            uint64_t lastVersion = 0;
+            while (!stop) {
+                const DepthView view = reader.read();
+                // the writer adds one level at price 1000 + version before each publication
+                const int expectedLevels = static_cast<int>(std::min<uint64_t>(view.version, publishedDepthLevels));
+                bool consistent = view.version >= lastVersion && view.bidLevels == expectedLevels;
+                for (int level = 0; consistent && level < view.bidLevels; ++level) {
+                    consistent = view.bids[level].price == static_cast<int>(1000 + view.version - level) && view.bids[level].volume == 1;
+                }
+                inconsistent += !consistent;
+                lastVersion = view.version;
+            }
+        });
+    }
+
+    int skipped = 0;
+    for (int i = 1; i <= publications; ++i) {
+        applyCommand(book, {CommandType::Add, Side::Buy, 1, 1000 + i, -1, 0}, orderIdSequence);
+        while (!depth.publish(book)) {
+            ++skipped;
+            std::this_thread::yield();
+        }
+    }
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(inconsistent, 0);
+    EXPECT_EQ(depth.getPublications(), publications);
+    EXPECT_EQ(depth.getSkippedPublications(), skipped);
+}
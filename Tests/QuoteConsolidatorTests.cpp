@@ -0,0 +1,108 @@
+#include "../src/QuoteConsolidator.h"
+#include "../src/Exchange.hpp"
+#include <gtest/gtest.h>
+#include <bit>
+#include <thread>
+
+class QuoteConsolidatorTest : public ::testing::Test {
+protected:
+    Exchange endex{"ENDEX"};
+    Exchange ice{"ICE"};
+    Exchange eex{"EEX"};
+    QuoteConsolidator consolidator;
+    uint32_t symbol = 0;
+
+    void SetUp() override {
+        for (Exchange* venue : {&endex, &ice, &eex}) {
+            venue->addInstrument("TTF 24Q");
+            consolidator.addVenue(*venue);
+        }
+        symbol = consolidator.addSymbol("TTF 24Q");
+    }
+};
+
+// the consolidated quote follows the best prices of every venue and the venues quoting them
+TEST_F(QuoteConsolidatorTest, ConsolidatesTopOfBookAcrossVenues) {
+    consolidator.applyCommand(0, symbol, {CommandType::Add, Side::Buy, 10, 990, -1, 0});
+    consolidator.applyCommand(1, symbol, {CommandType::Add, Side::Buy, 5, 995, -1, 0});
+    consolidator.applyCommand(2, symbol, {CommandType::Add, Side::Buy, 7, 995, -1, 0});
+    consolidator.applyCommand(0, symbol, {CommandType::Add, Side::Sell, 4, 1010, -1, 0});
+    consolidator.applyCommand(2, symbol, {CommandType::Add, Side::Sell, 6, 1005, -1, 0});
+
+    ConsolidatedQuote quote = consolidator.getQuote(symbol);
+    EXPECT_EQ(quote.bidPrice, 995);
+    EXPECT_EQ(quote.bidSize, 12);
+    EXPECT_EQ(quote.bidVenues, 0b110);
+    EXPECT_EQ(quote.askPrice, 1005);
+    EXPECT_EQ(quote.askSize, 6);
+    EXPECT_EQ(quote.askVenues, 0b100);
+    EXPECT_EQ(consolidator.getRescans(), 0);
+
+    // an improvement of ICE is cancelled: the venues back at the best bid come from a rescan
+    const CommandResult iceBid = consolidator.applyCommand(1, symbol, {CommandType::Add, Side::Buy, 1, 996, -1, 0});
+    ASSERT_TRUE(iceBid.orderId);
+    consolidator.applyCommand(1, symbol, {CommandType::Cancel, Side::Buy, 0, 0, *iceBid.orderId, 0});
+    EXPECT_EQ(consolidator.getQuote(symbol).bidVenues, 0b110);
+    EXPECT_EQ(consolidator.getRescans(), 1);
+
+    // a venue leaving a best bid still quoted by another venue only updates the set
+    consolidator.applyCommand(1, symbol, {CommandType::Market, Side::Sell, 5, 0, -1, 0});
+    quote = consolidator.getQuote(symbol);
+    EXPECT_EQ(quote.bidVenues, 0b100);
+    EXPECT_EQ(quote.bidSize, 7);
+    EXPECT_EQ(consolidator.getRescans(), 1);
+
+    // the only venue at the best ask is taken out: the next best ask comes from a rescan
+    consolidator.applyCommand(2, symbol, {CommandType::Market, Side::Buy, 6, 0, -1, 0});
+    quote = consolidator.getQuote(symbol);
+    EXPECT_EQ(quote.askPrice, 1010);
+    EXPECT_EQ(quote.askVenues, 0b001);
+    EXPECT_EQ(consolidator.getRescans(), 2);
+
+    // an unchanged top of book does not publish a new quote
+    const uint64_t version = quote.version;
+    consolidator.applyCommand(0, symbol, {CommandType::Add, Side::Buy, 3, 900, -1, 0});
+    EXPECT_EQ(consolidator.getQuote(symbol).version, version);
+}
+
+// executions at a price worse than another venue's quote are flagged for routing
+TEST_F(QuoteConsolidatorTest, DetectsTradeThroughs) {
+    consolidator.applyCommand(0, symbol, {CommandType::Add, Side::Sell, 10, 1010, -1, 0});
+    consolidator.applyCommand(1, symbol, {CommandType::Add, Side::Sell, 10, 1005, -1, 0});
+    consolidator.applyCommand(2, symbol, {CommandType::Add, Side::Buy, 10, 1000, -1, 0});
+
+    TradeThroughCheck check = consolidator.checkTradeThrough(symbol, 0, Side::Buy, 1010);
+    EXPECT_TRUE(check.tradesThrough);
+    EXPECT_EQ(check.awayPrice, 1005);
+    EXPECT_EQ(check.awayVenues, 0b010);
+    EXPECT_FALSE(consolidator.checkTradeThrough(symbol, 1, Side::Buy, 1005).tradesThrough);
+    EXPECT_FALSE(consolidator.checkTradeThrough(symbol, 0, Side::Buy, 1005).tradesThrough);
+    EXPECT_TRUE(consolidator.checkTradeThrough(symbol, 0, Side::Sell, 990).tradesThrough);
+    EXPECT_FALSE(consolidator.checkTradeThrough(symbol, 2, Side::Sell, 1000).tradesThrough);
+    EXPECT_THROW(consolidator.getQuote(symbol + 1), std::out_of_range);
+}
+
+// readers on another thread always see a quote published as a whole
+TEST_F(QuoteConsolidatorTest, ReadersSeeConsistentQuotes) {
+    std::atomic<bool> done = false;
+    std::atomic<int> torn = 0;
+    std::thread reader([&] {
+        while (!done) {
+            const ConsolidatedQuote quote = consolidator.getQuote(symbol);
+            if (quote.hasBid() && quote.bidSize != static_cast<int64_t>(quote.bidPrice) * std::popcount(quote.bidVenues)) {
+                ++torn;
+            }
+        }
+    });
+    for (int i = 0; i < 100000; ++i) {
+        const int price = 1 + i % 97;
+        VenueQuote venueQuote;
+        venueQuote.hasBid = true;
+        venueQuote.bidPrice = price;
+        venueQuote.bidSize = price;
+        consolidator.updateQuote(i % 3, symbol, venueQuote);
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(torn, 0);
+}
@@ -0,0 +1,113 @@
+#include "../src/Replay.h"
+#include "../src/WorkStealingPool.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+
+class ReplayTest : public ::testing::Test {
+protected:
+    // a few busy instruments and many quiet ones, with crossing orders and cancels of live orders
+    static ReplayInput makeInput(size_t instruments, size_t messages) {
+        std::mt19937 rng(7);
+        ReplayInput input;
+        for (size_t i = 0; i < instruments; ++i) {
+            input.tickers.push_back("SYM" + std::to_string(i));
+        }
+        std::vector<std::vector<int64_t>> live(instruments);
+        for (size_t i = 0; i < messages; ++i) {
+            const uint32_t instrument = (rng() % 4 == 0) ? rng() % instruments : rng() % 2;
+            const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+            BookCommand command{CommandType::Add, side, 1 + static_cast<int>(rng() % 20), 0, static_cast<int64_t>(i), static_cast<int>(i / 100)};
+            if (rng() % 4 == 0 && !live[instrument].empty()) {
+                command.type = CommandType::Cancel;
+                command.orderId = live[instrument].back();
+                live[instrument].pop_back();
+            } else {
+                const int distance = static_cast<int>(rng() % 10) - 2;
+                command.price = side == Side::Buy ? 1000 - distance : 1000 + distance;
+                live[instrument].push_back(command.orderId);
+            }
+            input.messages.push_back({instrument, command});
+        }
+        return input;
+    }
+};
+
+// every submitted task runs exactly once, and wait returns only when all are done
+TEST_F(ReplayTest, PoolRunsAllTasks) {
+    WorkStealingPool pool(4);
+    std::atomic<int> sum{0};
+    for (int i = 1; i <= 1000; ++i) {
+        pool.submit([&sum, i] { sum += i; });
+    }
+    pool.wait();
+    EXPECT_EQ(sum.load(), 500500);
+    EXPECT_EQ(pool.getThreadCount(), 4);
+}
+
+// an exception thrown by a task is rethrown by wait
+TEST_F(ReplayTest, PoolRethrowsTaskException) {
+    WorkStealingPool pool(2);
+    pool.submit([] { throw std::runtime_error("task failed"); });
+    pool.submit([] {});
+    EXPECT_THROW(pool.wait(), std::runtime_error);
+    pool.submit([] {});
+    EXPECT_NO_THROW(pool.wait());
+}
+
+// historical order ids are mapped to the ids assigned by the book
+TEST_F(ReplayTest, MapsFeedOrderIds) {
+    std::istringstream csv(
+        "1,AAA,add,B,10,100,500\n"
+        "1,BBB,add,S,10,105,600\n"
+        "2,AAA,add,B,5,101,501\n"
+        "3,AAA,cancel,,,,500\n"
+        "4,AAA,market,S,3,,\n"
+        "5,AAA,cancel,,,,999\n");
+    ReplayInput input = readReplayCsv(csv);
+    ASSERT_EQ(input.tickers.size(), 2);
+    EXPECT_EQ(input.tickers[0], "AAA");
+    ASSERT_EQ(input.messages.size(), 6);
+    EXPECT_EQ(input.messages[3].command.type, CommandType::Cancel);
+
+    ReplayResult result = replay(input, ReplayOptions{});
+    const InstrumentReplay& aaa = result.instruments[0];
+    EXPECT_EQ(aaa.commands, 5);
+    EXPECT_EQ(aaa.rejects, 1);
+    EXPECT_EQ(aaa.metrics.ordersCancelled, 1);
+    ASSERT_EQ(aaa.fills.size(), 1);
+    EXPECT_EQ(aaa.fills[0].restingOrderId, 1);
+    EXPECT_EQ(aaa.fills[0].price, 101);
+    EXPECT_EQ(aaa.fills[0].eventTime, 4);
+    EXPECT_EQ(result.instruments[1].metrics.restingOrders, 1);
+}
+
+// the output does not depend on the number of threads or on how instruments are batched
+TEST_F(ReplayTest, DeterministicAcrossThreadCounts) {
+    ReplayInput input = makeInput(50, 20000);
+
+    ReplayOptions serial;
+    ReplayResult reference = replay(input, serial);
+    std::vector<ReplayFill> referenceFills = reference.mergedFills();
+    ASSERT_FALSE(referenceFills.empty());
+
+    ReplayOptions parallel;
+    parallel.threads = 4;
+    parallel.taskMessages = 500;
+    ReplayResult result = replay(input, parallel);
+    std::vector<ReplayFill> fills = result.mergedFills();
+
+    EXPECT_GT(result.tasks, 2);
+    EXPECT_EQ(result.messages, 20000);
+    ASSERT_EQ(fills.size(), referenceFills.size());
+    for (size_t i = 0; i < fills.size(); ++i) {
+        EXPECT_EQ(fills[i].instrument, referenceFills[i].instrument);
+        EXPECT_EQ(fills[i].fill.sequence, referenceFills[i].fill.sequence);
+        EXPECT_EQ(fills[i].fill.restingOrderId, referenceFills[i].fill.restingOrderId);
+        EXPECT_EQ(fills[i].fill.shares, referenceFills[i].fill.shares);
+    }
+    for (size_t i = 0; i < input.tickers.size(); ++i) {
+        EXPECT_EQ(result.instruments[i].rejects, reference.instruments[i].rejects);
+        EXPECT_EQ(result.instruments[i].metrics.restingOrders, reference.instruments[i].metrics.restingOrders);
+    }
+}
@@ -0,0 +1,142 @@
+#include "../src/SharedMemoryOrderEntry.h"
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+class SharedMemoryOrderEntryTest : public ::testing::Test {
+protected:
+    Exchange exchange{"ENDEX"};
+    std::string gatewayName = "/exchange_order_entry_test_" + std::to_string(getpid());
+
+    void SetUp() override {
+        exchange.addInstrument("TTF 24Q-ICN");
+    }
+};
+
+// a client sends commands and receives their execution reports in order
+TEST_F(SharedMemoryOrderEntryTest, RoundTrip) {
+    SharedMemoryOrderGateway gateway(exchange, gatewayName);
+    gateway.start();
+
+    SharedMemoryOrderClient client(gatewayName, "strategy");
+    EXPECT_EQ(gateway.getActiveSessions(), 1);
+
+    ASSERT_TRUE(client.send(1, "TTF 24Q-ICN", {CommandType::Add, Side::Sell, 10, 4700, -1, 0}));
+    ASSERT_TRUE(client.send(2, "TTF 24Q-ICN", {CommandType::Add, Side::Buy, 4, 4701, -1, 0}));
+    ASSERT_TRUE(client.send(3, "TTF 24Z-ICN", {CommandType::Add, Side::Buy, 4, 4701, -1, 0}));
+
+    OrderEntryResponse response;
+    ASSERT_TRUE(client.receive(response, std::chrono::seconds(5)));
+    EXPECT_EQ(response.requestId, 1);
+    EXPECT_EQ(response.report.status, SubmitStatus::Accepted);
+    EXPECT_EQ(response.report.orderId, 0);
+
+    ASSERT_TRUE(client.receive(response, std::chrono::seconds(5)));
+    EXPECT_EQ(response.requestId, 2);
+    EXPECT_EQ(response.report.status, SubmitStatus::Accepted);
+    EXPECT_FALSE(response.report.orderId.has_value());
+    EXPECT_EQ(response.report.fills, 1);
+    EXPECT_EQ(response.report.filledShares, 4);
+    EXPECT_EQ(response.report.filledNotional, 4 * 4700);
+
+    ASSERT_TRUE(client.receive(response, std::chrono::seconds(5)));
+    EXPECT_EQ(response.requestId, 3);
+    EXPECT_EQ(response.report.status, SubmitStatus::Rejected);
+
+    EXPECT_FALSE(client.tryReceive(response));
+    EXPECT_EQ(gateway.getProcessedRequests(), 3);
+    EXPECT_EQ(exchange.getMetricsSnapshot().unknownInstrumentRejects, 1);
+}
+
+// a closed session frees its slot for the next client
+TEST_F(SharedMemoryOrderEntryTest, SessionsAreRecycled) {
+    SharedMemoryOrderGateway gateway(exchange, gatewayName);
+    gateway.start();
+
+    size_t firstSlot;
+    {
+        SharedMemoryOrderClient first(gatewayName, "first");
+        SharedMemoryOrderClient second(gatewayName, "second");
+        EXPECT_NE(first.getSlot(), second.getSlot());
+        firstSlot = first.getSlot();
+    }
+    for (int i = 0; i < 1000 && gateway.getActiveSessions() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(gateway.getActiveSessions(), 0);
+
+    SharedMemoryOrderClient third(gatewayName, "third");
+    EXPECT_EQ(third.getSlot(), firstSlot);
+}
+
+// a client in another process trades through the gateway
+TEST_F(SharedMemoryOrderEntryTest, ClientInAnotherProcess) {
+    SharedMemoryOrderGateway gateway(exchange, gatewayName);
+
+    // fork before the gateway thread exists, the child only needs the control block
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        int status = 1;
+        try {
+            SharedMemoryOrderClient client(gatewayName, "child");
+            OrderEntryResponse response;
+            if (client.send(7, "TTF 24Q-ICN", {CommandType::Add, Side::Buy, 5, 4600, -1, 0}) &&
+                client.receive(response, std::chrono::seconds(5)) && response.requestId == 7 &&
+                response.report.status == SubmitStatus::Accepted) {
+                status = 0;
+            }
+        } catch (...) {
+        }
+        _exit(status);
+    }
+
+    gateway.start();
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(exchange.getOrderBook("TTF 24Q-ICN")->getMetrics().snapshot().restingOrders, 1);
+}
+
+// connecting without a gateway fails
+TEST_F(SharedMemoryOrderEntryTest, NoGateway) {
+    EXPECT_THROW(SharedMemoryOrderClient(gatewayName, "orphan"), std::runtime_error);
+}
+
+// a client that gives up connecting releases its slot, which the gateway frees once it runs
+TEST_F(SharedMemoryOrderEntryTest, ConnectTimeoutReleasesSlot) {
+    SharedMemoryOrderGateway gateway(exchange, gatewayName);
+    EXPECT_THROW(SharedMemoryOrderClient(gatewayName, "impatient", {}, std::chrono::milliseconds(20)), std::runtime_error);
+
+    gateway.start();
+    SharedMemoryOrderClient client(gatewayName, "patient");
+    EXPECT_EQ(gateway.getActiveSessions(), 1);
+}
+
+// requests over the session's rate limit are answered as throttled and never reach the book
+TEST_F(SharedMemoryOrderEntryTest, FloodingSessionIsThrottled) {
+    OrderEntryOptions options;
+    options.sessionRateLimit = {1, 5};
+    SharedMemoryOrderGateway gateway(exchange, gatewayName, options);
+    gateway.start();
+    SharedMemoryOrderClient client(gatewayName, "flooder", options);
+
+    for (uint64_t i = 0; i < 20; ++i) {
+        ASSERT_TRUE(client.send(i, "TTF 24Q-ICN", {CommandType::Add, Side::Buy, 1, 4000, -1, 0}));
+    }
+    int accepted = 0, throttled = 0;
+    OrderEntryResponse response;
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(client.receive(response, std::chrono::seconds(5)));
+        accepted += response.report.status == SubmitStatus::Accepted;
+        throttled += response.report.status == SubmitStatus::Throttled;
+    }
+
+    // one token per second: a slow test run may earn one more
+    EXPECT_GE(accepted, 5);
+    EXPECT_LE(accepted, 6);
+    EXPECT_EQ(accepted + throttled, 20);
+    EXPECT_EQ(gateway.getThrottle().getSessionRejects(client.getSlot()), throttled);
+    EXPECT_EQ(exchange.getMetricsSnapshot().books["TTF 24Q-ICN"].ordersAdded, accepted);
+}
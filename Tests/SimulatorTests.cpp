@@ -0,0 +1,55 @@
+#include "../src/Simulator.h"
+#include <gtest/gtest.h>
+
+class SimulatorTest : public ::testing::Test {
+protected:
+    SimulationConfig config;
+
+    void SetUp() override {
+        config.steps = 2000;
+        config.population.noiseTraders = 64;
+    }
+};
+
+// the agents trade with each other and keep a two sided book
+TEST_F(SimulatorTest, AgentsTrade) {
+    Simulation simulation(config, 1);
+    SimulationResult result = simulation.run();
+
+    EXPECT_GT(result.ordersSubmitted, 0);
+    EXPECT_GT(result.cancels, 0);
+    EXPECT_GT(result.fills, 0);
+    EXPECT_EQ(result.trades.size(), result.fills);
+    EXPECT_EQ(result.metrics.sharesTraded, result.sharesTraded);
+    ASSERT_EQ(result.midPrices.size(), 2000);
+    EXPECT_GT(result.midPrices.back(), 0);
+    EXPECT_EQ(result.simulatedSeconds, 2000);
+    EXPECT_LE(result.trades.back().eventTime, 1999);
+}
+
+// the resting noise orders are bounded
+TEST_F(SimulatorTest, NoiseOrdersAreBounded) {
+    config.population.marketMakers = 0;
+    config.population.momentumTraders = 0;
+    config.maxNoiseOrders = 100;
+    Simulation simulation(config, 3);
+    SimulationResult result = simulation.run();
+
+    EXPECT_LE(result.metrics.restingOrders, 100);
+}
+
+// a seed always produces the same simulation, whatever the number of threads
+TEST_F(SimulatorTest, SeedsAreReproducible) {
+    std::vector<uint32_t> seeds = {1, 2, 3, 4};
+    std::vector<SimulationResult> serial = runSimulations(config, seeds, 1);
+    std::vector<SimulationResult> parallel = runSimulations(config, seeds, 4);
+
+    ASSERT_EQ(parallel.size(), 4);
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        EXPECT_EQ(parallel[i].seed, seeds[i]);
+        EXPECT_EQ(parallel[i].ordersSubmitted, serial[i].ordersSubmitted);
+        EXPECT_EQ(parallel[i].fills, serial[i].fills);
+        EXPECT_EQ(parallel[i].midPrices, serial[i].midPrices);
+    }
+    EXPECT_NE(serial[0].midPrices, serial[1].midPrices);
+}
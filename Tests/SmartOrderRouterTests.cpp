@@ -0,0 +1,137 @@
+#include "../src/SmartOrderRouter.h"
+#include <gtest/gtest.h>
+#include <chrono>
+
+namespace {
+
+// a coroutine that starts eagerly and is never awaited
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask routeParent(SmartOrderRouter& router, RoutePlan plan, Executor& executor, RouteReport& report, bool& done) {
+    report = co_await router.route(std::move(plan), executor);
+    done = true;
+}
+
+struct Venue {
+    Book book;
+    OrderIdSequence orderIdSequence;
+    PublishedDepth depth;
+    MatchingThread matchingThread{book, orderIdSequence};
+};
+
+} // namespace
+
+class SmartOrderRouterTest : public ::testing::Test {
+protected:
+    Venue venues[3];
+    SmartOrderRouter router;
+    EventLoopExecutor executor;
+
+    void SetUp() override {
+        const char* names[] = {"ENDEX", "ICE", "EEX"};
+        for (int i = 0; i < 3; ++i) {
+            venues[i].matchingThread.publishDepth(venues[i].depth);
+            router.addVenue(names[i], venues[i].matchingThread, venues[i].depth);
+        }
+    }
+
+    void addLevel(int venue, Side side, int shares, int price) {
+        applyCommand(venues[venue].book, {CommandType::Add, side, shares, price, -1, 0}, venues[venue].orderIdSequence);
+    }
+
+    RouteReport route(RoutePlan plan) {
+        for (Venue& venue : venues) {
+            venue.depth.publish(venue.book);
+            venue.matchingThread.start();
+        }
+        RouteReport report;
+        bool done = false;
+        routeParent(router, std::move(plan), executor, report, done);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!done && std::chrono::steady_clock::now() < deadline) {
+            if (!executor.runPending()) {
+                std::this_thread::yield();
+            }
+        }
+        for (Venue& venue : venues) {
+            venue.matchingThread.stop();
+        }
+        EXPECT_TRUE(done);
+        return report;
+    }
+};
+
+// a plan takes the best published prices across every venue, ties going to the first venue
+TEST_F(SmartOrderRouterTest, PlansBestPricesAcrossVenues) {
+    addLevel(0, Side::Sell, 10, 1002);
+    addLevel(1, Side::Sell, 5, 1001);
+    addLevel(1, Side::Sell, 10, 1003);
+    addLevel(2, Side::Sell, 10, 1002);
+    for (Venue& venue : venues) {
+        venue.depth.publish(venue.book);
+    }
+
+    const RoutePlan plan = router.plan(Side::Buy, 20, 1002);
+    EXPECT_EQ(plan.routedShares, 20);
+    ASSERT_EQ(plan.children.size(), 3);
+    EXPECT_EQ(plan.children[0].venue, 0);
+    EXPECT_EQ(plan.children[0].shares, 10);
+    EXPECT_EQ(plan.children[1].venue, 1);
+    EXPECT_EQ(plan.children[1].shares, 5);
+    EXPECT_EQ(plan.children[1].worstPrice, 1001);
+    EXPECT_EQ(plan.children[2].venue, 2);
+    EXPECT_EQ(plan.children[2].shares, 5);
+
+    const RoutePlan limited = router.plan(Side::Buy, 100, 1002);
+    EXPECT_EQ(limited.routedShares, 25);
+    EXPECT_TRUE(router.plan(Side::Sell, 10, 1).children.empty());
+    EXPECT_THROW(router.plan(Side::Buy, 0, 1002), std::invalid_argument);
+}
+
+// children are sent to every venue at once and their fills are aggregated
+TEST_F(SmartOrderRouterTest, RoutesChildrenAndAggregatesFills) {
+    addLevel(0, Side::Buy, 10, 998);
+    addLevel(1, Side::Buy, 10, 999);
+    addLevel(1, Side::Buy, 10, 997);
+    addLevel(2, Side::Buy, 4, 998);
+    for (Venue& venue : venues) {
+        venue.depth.publish(venue.book);
+    }
+
+    const RouteReport report = route(router.plan(Side::Sell, 25, 990));
+    EXPECT_EQ(report.requestedShares, 25);
+    EXPECT_EQ(report.filledShares, 25);
+    EXPECT_EQ(report.filledNotional, 999 * 10 + 998 * 14 + 997 * 1);
+    EXPECT_EQ(report.rejectedChildren, 0);
+    EXPECT_EQ(report.cancelledResiduals, 0);
+    EXPECT_TRUE(venues[2].book.getBuySide()->getSideTree().empty());
+    EXPECT_EQ(venues[1].book.getBuySide()->getBestLimit()->getTotalVolume(), 9);
+    EXPECT_TRUE(venues[1].book.getSellSide()->getSideTree().empty());
+}
+
+// a child finding less than the published depth does not rest in the book
+TEST_F(SmartOrderRouterTest, CancelsResidualsOfStaleDepth) {
+    addLevel(0, Side::Sell, 10, 1001);
+    addLevel(1, Side::Sell, 10, 1001);
+    for (Venue& venue : venues) {
+        venue.depth.publish(venue.book);
+    }
+    const RoutePlan plan = router.plan(Side::Buy, 20, 1001);
+    applyCommand(venues[1].book, {CommandType::Market, Side::Buy, 6, 0, -1, 0}, venues[1].orderIdSequence);
+
+    const RouteReport report = route(plan);
+    EXPECT_EQ(report.routedShares, 20);
+    EXPECT_EQ(report.filledShares, 14);
+    EXPECT_EQ(report.cancelledResiduals, 1);
+    EXPECT_TRUE(report.restingChildren.empty());
+    EXPECT_TRUE(venues[1].book.getBuySide()->getSideTree().empty());
+    EXPECT_TRUE(venues[1].book.getAllOrders()->empty());
+}
@@ -0,0 +1,79 @@
+#include "../src/Throttle.h"
+#include <gtest/gtest.h>
+
+constexpr int64_t millisecond = 1000000;
+
+// a bucket allows its burst at once and then refills at its rate, never beyond the burst
+TEST(ThrottleTest, TokenBucketBurstAndRefill) {
+    TokenBucket bucket({1000, 5});
+    int64_t now = 1;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(bucket.available(now));
+        bucket.take();
+    }
+    EXPECT_FALSE(bucket.available(now));
+
+    now += 2 * millisecond;
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_TRUE(bucket.available(now));
+        bucket.take();
+    }
+    EXPECT_FALSE(bucket.available(now));
+
+    now += 1000 * millisecond;
+    int allowed = 0;
+    while (bucket.available(now)) {
+        bucket.take();
+        ++allowed;
+    }
+    EXPECT_EQ(allowed, 5);
+
+    TokenBucket unlimited;
+    EXPECT_TRUE(unlimited.isUnlimited());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(unlimited.available(now));
+        unlimited.take();
+    }
+}
+
+// a message needs a token from its session and from its instrument, rejects are counted by limit
+TEST(ThrottleTest, SessionAndInstrumentLimits) {
+    IngressThrottle throttle({1000, 3}, {1000, 4}, 2, {"TTF 24Q-ICN"});
+    const int64_t now = 1;
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(throttle.admit(0, "TTF 24Q-ICN", CommandType::Add, now), ThrottleResult::Admitted);
+    }
+    EXPECT_EQ(throttle.admit(0, "TTF 24Q-ICN", CommandType::Add, now), ThrottleResult::SessionLimited);
+
+    // the other session still has tokens, but the instrument only has one left
+    EXPECT_EQ(throttle.admit(1, "TTF 24Q-ICN", CommandType::Add, now), ThrottleResult::Admitted);
+    EXPECT_EQ(throttle.admit(1, "TTF 24Q-ICN", CommandType::Add, now), ThrottleResult::InstrumentLimited);
+    EXPECT_EQ(throttle.admit(1, "TTF 24Z-ICN", CommandType::Add, now), ThrottleResult::Admitted);
+
+    throttle.resetSession(0);
+    EXPECT_EQ(throttle.admit(0, "TTF 24Z-ICN", CommandType::Add, now), ThrottleResult::Admitted);
+
+    EXPECT_EQ(throttle.getAdmittedMessages(), 6);
+    EXPECT_EQ(throttle.getSessionRejects(0), 1);
+    EXPECT_EQ(throttle.getSessionRejects(1), 0);
+    EXPECT_EQ(throttle.getInstrumentRejects("TTF 24Q-ICN"), 1);
+    EXPECT_EQ(throttle.getInstrumentRejects("TTF 24Z-ICN"), 0);
+}
+
+// cancels take no tokens and are admitted even when the session is over its rate
+TEST(ThrottleTest, CancelsAreNeverThrottled) {
+    IngressThrottle throttle({1000, 1}, {1000, 1}, 1, {"TTF 24Q-ICN"});
+    const int64_t now = 1;
+
+    EXPECT_EQ(throttle.admit(0, "TTF 24Q-ICN", CommandType::Add, now), ThrottleResult::Admitted);
+    EXPECT_EQ(throttle.admit(0, "TTF 24Q-ICN", CommandType::Add, now), ThrottleResult::SessionLimited);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(throttle.admit(0, "TTF 24Q-ICN", CommandType::Cancel, now), ThrottleResult::Admitted);
+    }
+    EXPECT_EQ(throttle.admit(0, "TTF 24Q-ICN", CommandType::ModifySize, now), ThrottleResult::SessionLimited);
+
+    EXPECT_EQ(throttle.getAdmittedMessages(), 4);
+    EXPECT_EQ(throttle.getSessionRejects(0), 2);
+    EXPECT_EQ(throttle.getInstrumentRejects("TTF 24Q-ICN"), 0);
+}
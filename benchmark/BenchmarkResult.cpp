@@ -0,0 +1,394 @@
+#include "BenchmarkResult.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @brief Returns the median of a set of values.
+ * @param values The values, taken by copy since they need to be partially sorted.
+ * @return The median, or 0 if there are no values.
+ */
+double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0;
+    }
+    const size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    double result = values[middle];
+    if (values.size() % 2 == 0) {
+        result = (result + *std::max_element(values.begin(), values.begin() + middle)) / 2;
+    }
+    return result;
+}
+
+/**
+ * @brief Returns the value at a given percentile using the nearest-rank method.
+ * @param sortedValues Values sorted in ascending order.
+ * @param fraction The percentile expressed as a fraction in [0, 1].
+ * @return The value at the percentile, or 0 if there are no values.
+ */
+double percentile(const std::vector<double>& sortedValues, double fraction) {
+    if (sortedValues.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sortedValues.size()));
+    rank = std::clamp<size_t>(rank, 1, sortedValues.size());
+    return sortedValues[rank - 1];
+}
+
+/**
+ * @brief Returns the median throughput of the workload repetitions.
+ * @return Median throughput in operations per second.
+ */
+double WorkloadResult::medianThroughput() const {
+    return median(throughputSamples);
+}
+
+/**
+ * @brief Estimates the run-to-run noise of the workload as the scaled median absolute deviation
+ *        of the throughput samples, relative to their median.
+ * @return The relative noise (0.01 means 1%), or 0 if there are fewer than two samples.
+ */
+double WorkloadResult::relativeNoise() const {
+    if (throughputSamples.size() < 2) {
+        return 0;
+    }
+    const double center = medianThroughput();
+    if (center == 0) {
+        return 0;
+    }
+    std::vector<double> deviations;
+    deviations.reserve(throughputSamples.size());
+    for (double sample : throughputSamples) {
+        deviations.push_back(std::abs(sample - center));
+    }
+    // 1.4826 scales the MAD to a standard deviation estimate for normally distributed samples
+    return 1.4826 * median(deviations) / center;
+}
+
+/**
+ * @brief Looks up a workload by name.
+ * @param name The name of the workload.
+ * @return Pointer to the workload result, or nullptr if the run does not contain it.
+ */
+const WorkloadResult* BenchmarkRun::findWorkload(const std::string& name) const {
+    for (const auto& workload : workloads) {
+        if (workload.name == name) {
+            return &workload;
+        }
+    }
+    return nullptr;
+}
+
+namespace {
+
+std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    std::ostringstream code;
+                    code << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+                    escaped += code.str();
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief A parsed JSON value. Only what is needed to read back benchmark results is supported.
+ */
+struct JsonValue {
+    enum class Kind { Null, Bool, Number, String, Array, Object };
+
+    Kind kind = Kind::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* find(const std::string& key) const {
+        for (const auto& [name, value] : object) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text(text), position(0) {}
+
+    JsonValue parse() {
+        JsonValue value = parseValue();
+        skipWhitespace();
+        if (position != text.size()) {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    const std::string& text;
+    size_t position;
+
+    [[noreturn]] void fail(const std::string& reason) const {
+        throw std::runtime_error("Invalid benchmark result json at offset " + std::to_string(position) + ": " + reason);
+    }
+
+    void skipWhitespace() {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+            ++position;
+        }
+    }
+
+    void expect(char c) {
+        skipWhitespace();
+        if (position >= text.size() || text[position] != c) {
+            fail(std::string("expected '") + c + "'");
+        }
+        ++position;
+    }
+
+    bool consume(const std::string& literal) {
+        if (text.compare(position, literal.size(), literal) == 0) {
+            position += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    JsonValue parseValue() {
+        skipWhitespace();
+        if (position >= text.size()) {
+            fail("unexpected end of input");
+        }
+        JsonValue value;
+        const char c = text[position];
+        if (c == '{') {
+            value.kind = JsonValue::Kind::Object;
+            ++position;
+            skipWhitespace();
+            if (position < text.size() && text[position] == '}') {
+                ++position;
+                return value;
+            }
+            do {
+                skipWhitespace();
+                std::string key = parseString();
+                expect(':');
+                value.object.emplace_back(std::move(key), parseValue());
+                skipWhitespace();
+            } while (position < text.size() && text[position] == ',' && ++position);
+            expect('}');
+        } else if (c == '[') {
+            value.kind = JsonValue::Kind::Array;
+            ++position;
+            skipWhitespace();
+            if (position < text.size() && text[position] == ']') {
+                ++position;
+                return value;
+            }
+            do {
+                value.array.push_back(parseValue());
+                skipWhitespace();
+            } while (position < text.size() && text[position] == ',' && ++position);
+            expect(']');
+        } else if (c == '"') {
+            value.kind = JsonValue::Kind::String;
+            value.string = parseString();
+        } else if (consume("true")) {
+            value.kind = JsonValue::Kind::Bool;
+            value.boolean = true;
+        } else if (consume("false")) {
+            value.kind = JsonValue::Kind::Bool;
+        } else if (consume("null")) {
+            value.kind = JsonValue::Kind::Null;
+        } else {
+            value.kind = JsonValue::Kind::Number;
+            const char* begin = text.c_str() + position;
+            char* end = nullptr;
+            value.number = std::strtod(begin, &end);
+            if (end == begin) {
+                fail("unexpected character");
+            }
+            position += static_cast<size_t>(end - begin);
+        }
+        return value;
+    }
+
+    std::string parseString() {
+        if (position >= text.size() || text[position] != '"') {
+            fail("expected string");
+        }
+        ++position;
+        std::string result;
+        while (position < text.size() && text[position] != '"') {
+            char c = text[position++];
+            if (c == '\\') {
+                if (position >= text.size()) {
+                    fail("unterminated escape");
+                }
+                char escaped = text[position++];
+                switch (escaped) {
+                    case 'n': result += '\n'; break;
+                    case 't': result += '\t'; break;
+                    case 'u':
+                        // only control characters are ever escaped this way by the writer
+                        result += static_cast<char>(std::stoi(text.substr(position, 4), nullptr, 16));
+                        position += 4;
+                        break;
+                    default: result += escaped;
+                }
+            } else {
+                result += c;
+            }
+        }
+        if (position >= text.size()) {
+            fail("unterminated string");
+        }
+        ++position;
+        return result;
+    }
+};
+
+double numberOf(const JsonValue* value) {
+    return (value && value->kind == JsonValue::Kind::Number) ? value->number : 0;
+}
+
+} // namespace
+
+/**
+ * @brief Serializes a benchmark run to JSON.
+ * @param run The benchmark run.
+ * @return The JSON document.
+ */
+std::string toJson(const BenchmarkRun& run) {
+    std::ostringstream out;
+    out << std::setprecision(12);
+    out << "{\n  \"metadata\": {";
+    bool first = true;
+    for (const auto& [key, value] : run.metadata) {
+        out << (first ? "\n" : ",\n") << "    \"" << escape(key) << "\": \"" << escape(value) << "\"";
+        first = false;
+    }
+    out << "\n  },\n  \"workloads\": [";
+    for (size_t i = 0; i < run.workloads.size(); ++i) {
+        const WorkloadResult& workload = run.workloads[i];
+        out << (i ? ",\n" : "\n") << "    {\n";
+        out << "      \"name\": \"" << escape(workload.name) << "\",\n";
+        out << "      \"operations\": " << workload.operations << ",\n";
+        out << "      \"throughput_ops_per_sec\": " << workload.medianThroughput() << ",\n";
+        out << "      \"throughput_samples\": [";
+        for (size_t s = 0; s < workload.throughputSamples.size(); ++s) {
+            out << (s ? ", " : "") << workload.throughputSamples[s];
+        }
+        out << "],\n";
+        out << "      \"relative_noise\": " << workload.relativeNoise() << ",\n";
+        out << "      \"latency_ns\": {\"p50\": " << workload.latency.p50 << ", \"p90\": " << workload.latency.p90
+            << ", \"p99\": " << workload.latency.p99 << ", \"p999\": " << workload.latency.p999
+            << ", \"max\": " << workload.latency.max << "},\n";
+        out << "      \"counters\": {";
+        bool firstCounter = true;
+        for (const auto& [key, value] : workload.counters) {
+            out << (firstCounter ? "" : ", ") << "\"" << escape(key) << "\": " << value;
+            firstCounter = false;
+        }
+        out << "}\n    }";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+/**
+ * @brief Parses a benchmark run previously written by toJson.
+ * @param json The JSON document.
+ * @return The benchmark run.
+ * @throws std::runtime_error if the document is not valid JSON.
+ */
+BenchmarkRun fromJson(const std::string& json) {
+    const JsonValue root = JsonParser(json).parse();
+    BenchmarkRun run;
+
+    if (const JsonValue* metadata = root.find("metadata")) {
+        for (const auto& [key, value] : metadata->object) {
+            run.metadata[key] = value.string;
+        }
+    }
+
+    if (const JsonValue* workloads = root.find("workloads")) {
+        for (const JsonValue& entry : workloads->array) {
+            WorkloadResult workload;
+            if (const JsonValue* name = entry.find("name")) {
+                workload.name = name->string;
+            }
+            workload.operations = static_cast<int64_t>(numberOf(entry.find("operations")));
+            if (const JsonValue* samples = entry.find("throughput_samples")) {
+                for (const JsonValue& sample : samples->array) {
+                    workload.throughputSamples.push_back(sample.number);
+                }
+            }
+            if (const JsonValue* latency = entry.find("latency_ns")) {
+                workload.latency.p50 = numberOf(latency->find("p50"));
+                workload.latency.p90 = numberOf(latency->find("p90"));
+                workload.latency.p99 = numberOf(latency->find("p99"));
+                workload.latency.p999 = numberOf(latency->find("p999"));
+                workload.latency.max = numberOf(latency->find("max"));
+            }
+            if (const JsonValue* counters = entry.find("counters")) {
+                for (const auto& [key, value] : counters->object) {
+                    workload.counters[key] = static_cast<int64_t>(value.number);
+                }
+            }
+            run.workloads.push_back(std::move(workload));
+        }
+    }
+    return run;
+}
+
+/**
+ * @brief Writes a benchmark run as JSON to a file.
+ * @param run The benchmark run.
+ * @param path Path of the output file.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void writeBenchmarkRun(const BenchmarkRun& run, const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Can't open benchmark result file for writing: " + path);
+    }
+    file << toJson(run);
+}
+
+/**
+ * @brief Reads a benchmark run from a JSON file.
+ * @param path Path of the result file.
+ * @return The benchmark run.
+ * @throws std::runtime_error if the file cannot be read or parsed.
+ */
+BenchmarkRun readBenchmarkRun(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Can't open benchmark result file: " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return fromJson(buffer.str());
+}
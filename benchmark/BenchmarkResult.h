@@ -0,0 +1,83 @@
+// Benchmark result model and JSON serialization
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @struct LatencyPercentiles
+ * @brief Per-operation latency percentiles of a workload, in nanoseconds.
+ */
+struct LatencyPercentiles {
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+};
+
+/**
+ * @struct WorkloadResult
+ * @brief The measurements collected for one benchmark workload over all of its repetitions.
+ */
+struct WorkloadResult {
+    std::string name;
+    /// number of book operations executed per repetition
+    int64_t operations = 0;
+    /// throughput of every repetition in operations per second, used to estimate the run-to-run noise
+    std::vector<double> throughputSamples;
+    /// latency percentiles computed over the operations of all repetitions
+    LatencyPercentiles latency;
+    /// workload specific counters (orders resting, levels crossed, ...)
+    std::map<std::string, int64_t> counters;
+
+    double medianThroughput() const;
+    double relativeNoise() const;
+};
+
+/**
+ * @struct BenchmarkRun
+ * @brief A full benchmark run: the machine and build it ran on plus the results of each workload.
+ */
+struct BenchmarkRun {
+    /// build and cpu metadata (compiler, build type, cpu model, ...)
+    std::map<std::string, std::string> metadata;
+    std::vector<WorkloadResult> workloads;
+
+    const WorkloadResult* findWorkload(const std::string& name) const;
+};
+
+// statistics helpers
+double median(std::vector<double> values);
+double percentile(const std::vector<double>& sortedValues, double fraction);
+
+// serialization
+std::string toJson(const BenchmarkRun& run);
+BenchmarkRun fromJson(const std::string& json);
+void writeBenchmarkRun(const BenchmarkRun& run, const std::string& path);
+BenchmarkRun readBenchmarkRun(const std::string& path);
@@ -0,0 +1,764 @@
+#include "../src/ArrowExport.h"
+#include "../src/BarAggregator.h"
+#include "../src/ImpactEstimator.h"
+#include "../src/Book.h"
+#include "../src/MappedBook.h"
+#include "../src/MatchingThread.h"
+#include "../src/PositionKeeper.h"
+#include "../src/SmartOrderRouter.h"
+#include "BenchmarkResult.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#ifndef EXCHANGE_BUILD_TYPE
+#ifdef NDEBUG
+#define EXCHANGE_BUILD_TYPE "Release"
+#else
+#define EXCHANGE_BUILD_TYPE "Debug"
+#endif
+#endif
+
+using Clock = std::chrono::steady_clock;
+using Counters = std::map<std::string, int64_t>;
+
+namespace {
+
+/**
+ * @brief A benchmark workload. Each repetition runs on a fresh book: the workload prepares the book
+ *        outside of the measured section and times every book operation individually.
+ */
+struct Workload {
+    std::string name;
+    std::string description;
+    std::function<Counters(Book&, OrderIdSequence&, int, std::vector<double>&)> run;
+};
+
+/**
+ * @brief Times a single book operation and records its latency in nanoseconds.
+ */
+template<typename F>
+void timeOperation(std::vector<double>& latencies, F&& operation) {
+    const auto start = Clock::now();
+    operation();
+    const auto end = Clock::now();
+    latencies.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+}
+
+/**
+ * @brief Times a batch of cheap operations and records their average latency once per operation,
+ *        for paths too short to be timed one call at a time.
+ */
+template<typename F>
+void timeBatch(std::vector<double>& latencies, int count, F&& batch) {
+    const auto start = Clock::now();
+    batch();
+    const auto end = Clock::now();
+    const double average = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / count;
+    latencies.insert(latencies.end(), count, average);
+}
+
+/**
+ * @brief Converts a price in cents to the float dollar price expected by OrderData.
+ */
+float dollars(int cents) {
+    return static_cast<float>(cents) / 100.0f;
+}
+
+Counters bookCounters(const Book& book) {
+    return {
+        {"orders_resting", static_cast<int64_t>(book.getAllOrders()->size())},
+        {"buy_levels", static_cast<int64_t>(book.getBuySide()->getSideTree().size())},
+        {"sell_levels", static_cast<int64_t>(book.getSellSide()->getSideTree().size())},
+    };
+}
+
+// passive limit orders spread over 200 price levels below the touch
+Counters addWorkload(Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> level(0, 199);
+    std::vector<OrderData> orders;
+    orders.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        orders.emplace_back(Side::Buy, 10, dollars(9000 + level(rng)), OrderType::Limit);
+    }
+
+    for (auto& order : orders) {
+        timeOperation(latencies, [&] { book.addOrderToBook(order, ids); });
+    }
+    return bookCounters(book);
+}
+
+// cancels of resting orders in random order
+Counters cancelWorkload(Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> level(0, 199);
+    std::vector<int64_t> orderIds;
+    orderIds.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        OrderData order(Side::Sell, 10, dollars(11000 + level(rng)), OrderType::Limit);
+        book.addOrderToBook(order, ids);
+    }
+    for (const auto& [orderId, order] : *book.getAllOrders()) {
+        orderIds.push_back(orderId);
+    }
+    std::sort(orderIds.begin(), orderIds.end());
+    std::shuffle(orderIds.begin(), orderIds.end(), rng);
+
+    for (int64_t orderId : orderIds) {
+        timeOperation(latencies, [&] { book.cancelOrder(orderId); });
+    }
+    return bookCounters(book);
+}
+
+// aggressive limit orders that each sweep a fixed number of full price levels
+Counters sweepWorkload(Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    constexpr int levelsPerSweep = 4;
+    constexpr int ordersPerLevel = 4;
+    constexpr int sharesPerOrder = 10;
+
+    const int levels = operations * levelsPerSweep;
+    for (int level = 0; level < levels; ++level) {
+        for (int i = 0; i < ordersPerLevel; ++i) {
+            OrderData order(Side::Sell, sharesPerOrder, dollars(10000 + level), OrderType::Limit);
+            book.addOrderToBook(order, ids);
+        }
+    }
+
+    std::vector<OrderData> sweeps;
+    sweeps.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        sweeps.emplace_back(Side::Buy, levelsPerSweep * ordersPerLevel * sharesPerOrder, dollars(10000 + levels + 1), OrderType::Limit);
+    }
+
+    for (auto& sweep : sweeps) {
+        timeOperation(latencies, [&] { book.addOrderToBook(sweep, ids); });
+    }
+
+    Counters counters = bookCounters(book);
+    counters["levels_crossed"] = levels - static_cast<int64_t>(book.getSellSide()->getSideTree().size());
+    return counters;
+}
+
+// market orders that alternate between partially and fully filling the head order
+Counters marketWorkload(Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    constexpr int sharesPerOrder = 10;
+    constexpr int marketOrderShares = 5;
+    constexpr int ordersPerLevel = 100;
+
+    const int orders = operations * marketOrderShares / sharesPerOrder + 1;
+    for (int i = 0; i < orders; ++i) {
+        OrderData order(Side::Buy, sharesPerOrder, dollars(9000 - i / ordersPerLevel), OrderType::Limit);
+        book.addOrderToBook(order, ids);
+    }
+
+    for (int i = 0; i < operations; ++i) {
+        timeOperation(latencies, [&] { book.placeMarketOrder(marketOrderShares, Side::Sell); });
+    }
+    return bookCounters(book);
+}
+
+// aggressive limit orders sweeping 4 levels whose queues start with a long run of all-or-none orders
+Counters constrainedSweepWorkload(Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    constexpr int levelsPerSweep = 4;
+    constexpr int allOrNonePerLevel = 1000;
+    constexpr int sharesPerOrder = 10;
+
+    for (int level = 0; level < levelsPerSweep; ++level) {
+        for (int i = 0; i < allOrNonePerLevel; ++i) {
+            OrderData order(Side::Sell, 100 * sharesPerOrder, dollars(10000 + level), OrderType::Limit);
+            order.minQuantity = allOrNoneQuantity;
+            book.addOrderToBook(order, ids);
+        }
+    }
+
+    OrderData sweep(Side::Buy, levelsPerSweep * sharesPerOrder, dollars(10000 + levelsPerSweep), OrderType::Limit);
+    for (int i = 0; i < operations; ++i) {
+        // one order each sweep can fill, queued behind the all-or-none orders of every level
+        for (int level = 0; level < levelsPerSweep; ++level) {
+            OrderData order(Side::Sell, sharesPerOrder, dollars(10000 + level), OrderType::Limit);
+            book.addOrderToBook(order, ids);
+        }
+        timeOperation(latencies, [&] { book.addOrderToBook(sweep, ids); });
+    }
+
+    Counters counters = bookCounters(book);
+    counters["shares_traded"] = static_cast<int64_t>(book.getMetrics().snapshot().sharesTraded);
+    return counters;
+}
+
+// fills spread over 1000 instruments aggregated into bars, one second of event time every 100000 fills
+Counters barsWorkload(Book&, OrderIdSequence&, int operations, std::vector<double>& latencies) {
+    constexpr int instruments = 1000;
+    constexpr int fillsPerSecond = 100000;
+    constexpr int batchSize = 1000;
+
+    class CountingSink : public BarSink {
+    public:
+        int64_t bars = 0;
+        void onBar(const Bar&) override { ++bars; }
+    };
+
+    BarAggregator aggregator;
+    CountingSink sink;
+    aggregator.addBarSink(&sink);
+    for (int i = 0; i < instruments; ++i) {
+        aggregator.addInstrument();
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> instrument(0, instruments - 1);
+    std::uniform_int_distribution<int> price(9900, 10100);
+    std::vector<std::pair<uint32_t, Fill>> fills;
+    fills.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        fills.push_back({instrument(rng), Fill{static_cast<uint64_t>(i), i, price(rng), 10, Side::Buy, i / fillsPerSecond}});
+    }
+
+    for (int first = 0; first < operations; first += batchSize) {
+        const int last = std::min(first + batchSize, operations);
+        timeBatch(latencies, last - first, [&] {
+            for (int i = first; i < last; ++i) {
+                aggregator.onFill(fills[i].first, fills[i].second);
+            }
+            if (last % fillsPerSecond == 0) {
+                aggregator.onTimer(last / fillsPerSecond);
+            }
+        });
+    }
+    return {{"instruments", instruments}, {"bars", sink.bars}};
+}
+
+// account fills over 1000 accounts and 100 instruments handed to the position keeper thread; the
+// latency is the cost on the publishing matching thread, the keeper has to drain them all before the end
+Counters positionsWorkload(Book&, OrderIdSequence&, int operations, std::vector<double>& latencies) {
+    constexpr uint32_t accounts = 1000;
+    constexpr uint32_t instruments = 100;
+    constexpr int batchSize = 1000;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> account(0, accounts - 1);
+    std::uniform_int_distribution<uint32_t> instrument(0, instruments - 1);
+    std::uniform_int_distribution<int> price(9900, 10100);
+    std::vector<AccountFill> fills;
+    fills.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        fills.push_back({account(rng), instrument(rng), i % 2 ? Side::Buy : Side::Sell, price(rng), 10});
+    }
+
+    PositionKeeper keeper(accounts, instruments);
+    keeper.start();
+    for (int first = 0; first < operations; first += batchSize) {
+        const int last = std::min(first + batchSize, operations);
+        timeBatch(latencies, last - first, [&] {
+            for (int i = first; i < last; ++i) {
+                keeper.publish(fills[i]);
+            }
+        });
+    }
+    keeper.stop();
+    return {{"accounts", accounts}, {"fills_applied", static_cast<int64_t>(keeper.getProcessedFills())},
+            {"full_queue_waits", static_cast<int64_t>(keeper.getFullQueueWaits())}};
+}
+
+// a coroutine that starts eagerly and is never awaited
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask submitCommand(MatchingThread& matchingThread, Executor& executor, BookCommand command, uint32_t session,
+                           std::atomic<int>& pending) {
+    co_await matchingThread.submit(command, executor, session);
+    pending.fetch_sub(1, std::memory_order_release);
+}
+
+DetachedTask submitTimedCancel(MatchingThread& matchingThread, Executor& executor, BookCommand command, uint32_t session,
+                               std::atomic<int>& pending, double& latency) {
+    const auto start = Clock::now();
+    co_await matchingThread.submit(command, executor, session);
+    latency = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    pending.fetch_sub(1, std::memory_order_release);
+}
+
+// a market maker cancels one quote after each burst of 255 aggressive orders from another session,
+// each filling two resting orders; the latency is the cancel's, from submission to execution report
+Counters cancelBurstWorkload(BatchScheduling scheduling, Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    constexpr int burst = 255;
+    const int rounds = std::max(operations / (burst + 1), 1);
+
+    std::vector<int64_t> quotes;
+    for (int i = 0; i < rounds; ++i) {
+        quotes.push_back(*applyCommand(book, {CommandType::Add, Side::Buy, 10, 500, -1, 0}, ids).orderId);
+    }
+    for (int i = 0; i < 2 * burst * rounds; ++i) {
+        applyCommand(book, {CommandType::Add, Side::Sell, 1, 1000, -1, 0}, ids);
+    }
+
+    InlineExecutor executor;
+    MatchingThread matchingThread(book, ids);
+    matchingThread.setBatchScheduling(scheduling);
+    matchingThread.start();
+
+    std::vector<double> cancelLatencies(rounds);
+    std::atomic<int> pending = 0;
+    for (int round = 0; round < rounds; ++round) {
+        pending.store(burst + 1, std::memory_order_relaxed);
+        for (int i = 0; i < burst; ++i) {
+            submitCommand(matchingThread, executor, {CommandType::Add, Side::Buy, 2, 1001, -1, 0}, 1, pending);
+        }
+        submitTimedCancel(matchingThread, executor, {CommandType::Cancel, Side::Buy, 0, 0, quotes[round], 0}, 0, pending,
+                          cancelLatencies[round]);
+        while (pending.load(std::memory_order_acquire) > 0) {
+            std::this_thread::yield();
+        }
+    }
+    matchingThread.stop();
+
+    latencies.insert(latencies.end(), cancelLatencies.begin(), cancelLatencies.end());
+    Counters counters = bookCounters(book);
+    counters["cancels"] = rounds;
+    counters["batches"] = static_cast<int64_t>(matchingThread.getBatches());
+    return counters;
+}
+
+// passive orders added near the touch of a venue, each cancelling the oldest order of its ring
+// once full, until stopped; it resumes on the matching thread and keeps one command in flight
+DetachedTask churnVenue(MatchingThread& matchingThread, Executor& executor, uint32_t seed, const std::atomic<bool>& stop,
+                        std::atomic<int>& active) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> tick(0, 9);
+    std::vector<int64_t> ring(128, -1);
+    for (size_t next = 0; !stop.load(std::memory_order_relaxed); next = (next + 1) % ring.size()) {
+        if (ring[next] >= 0) {
+            co_await matchingThread.submit({CommandType::Cancel, Side::Buy, 0, 0, ring[next], 0}, executor, 1);
+        }
+        const Side side = rng() % 2 ? Side::Buy : Side::Sell;
+        const int price = side == Side::Buy ? 9999 - tick(rng) : 10001 + tick(rng);
+        const ExecutionReport report = co_await matchingThread.submit({CommandType::Add, side, 10, price, -1, 0}, executor, 1);
+        ring[next] = report.orderId.value_or(-1);
+    }
+    active.fetch_sub(1, std::memory_order_release);
+}
+
+DetachedTask routeParentOrder(SmartOrderRouter& router, RoutePlan plan, Executor& executor, RouteReport& report, bool& done) {
+    report = co_await router.route(std::move(plan), executor);
+    done = true;
+}
+
+// parent orders of 100 to 400 shares split across 4 venues whose matching threads are kept busy by
+// passive order churn; the latency is the routing decision's or, end to end, until every child reported
+Counters routerWorkload(bool endToEnd, Book&, OrderIdSequence&, int operations, std::vector<double>& latencies) {
+    constexpr int venueCount = 4;
+    constexpr int churnersPerVenue = 4;
+    struct Venue {
+        Book book;
+        OrderIdSequence ids;
+        PublishedDepth depth;
+        MatchingThread matchingThread{book, ids};
+    };
+    std::vector<std::unique_ptr<Venue>> venues;
+    SmartOrderRouter router;
+    for (int i = 0; i < venueCount; ++i) {
+        venues.push_back(std::make_unique<Venue>());
+        Venue& venue = *venues.back();
+        for (int level = 0; level < 50; ++level) {
+            applyCommand(venue.book, {CommandType::Add, Side::Buy, 100, 9999 - level, -1, 0}, venue.ids);
+            applyCommand(venue.book, {CommandType::Add, Side::Sell, 100, 10001 + level, -1, 0}, venue.ids);
+        }
+        venue.depth.publish(venue.book);
+        venue.matchingThread.publishDepth(venue.depth);
+        router.addVenue("VENUE" + std::to_string(i), venue.matchingThread, venue.depth);
+        venue.matchingThread.start();
+    }
+
+    InlineExecutor churnExecutor;
+    std::atomic<bool> stop = false;
+    std::atomic<int> active = venueCount * churnersPerVenue;
+    for (int i = 0; i < venueCount * churnersPerVenue; ++i) {
+        churnVenue(venues[i % venueCount]->matchingThread, churnExecutor, 42 + i, stop, active);
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> shares(100, 400);
+    EventLoopExecutor executor;
+    int64_t routedShares = 0, filledShares = 0, children = 0;
+    for (int i = 0; i < operations; ++i) {
+        const Side side = i % 2 ? Side::Buy : Side::Sell;
+        const auto start = Clock::now();
+        RoutePlan plan = router.plan(side, shares(rng), side == Side::Buy ? 10100 : 9900);
+        if (!endToEnd) {
+            latencies.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+        }
+        children += static_cast<int64_t>(plan.children.size());
+        RouteReport report;
+        bool done = false;
+        routeParentOrder(router, std::move(plan), executor, report, done);
+        while (!done) {
+            if (!executor.runPending()) {
+                std::this_thread::yield();
+            }
+        }
+        if (endToEnd) {
+            latencies.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+        }
+        routedShares += report.routedShares;
+        filledShares += report.filledShares;
+    }
+
+    stop = true;
+    while (active.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+    int64_t churnCommands = 0;
+    for (auto& venue : venues) {
+        venue->matchingThread.stop();
+        churnCommands += static_cast<int64_t>(venue->matchingThread.getProcessedCommands());
+    }
+    return {{"children", children}, {"routed_shares", routedShares}, {"filled_shares", filledShares},
+            {"venue_commands", churnCommands}};
+}
+
+// bursts of 1000 buy and sell orders around a common price, half of which cross the other side;
+// in batch auction mode each burst ends with its auction, timed with the orders
+Counters burstWorkload(MatchingMode mode, Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    constexpr int burst = 1000;
+    book.setMatchingMode(mode);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> offset(-20, 20);
+    std::vector<BookCommand> commands;
+    commands.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        commands.push_back({CommandType::Add, i % 2 ? Side::Buy : Side::Sell, 10, 10000 + offset(rng), -1, 0});
+    }
+
+    int64_t auctions = 0;
+    for (int first = 0; first < operations; first += burst) {
+        const int last = std::min(first + burst, operations);
+        timeBatch(latencies, last - first, [&] {
+            for (int i = first; i < last; ++i) {
+                applyCommand(book, commands[i], ids);
+            }
+            if (mode == MatchingMode::BatchAuction) {
+                auctions += book.uncross(0).crossed;
+            }
+        });
+    }
+    Counters counters = bookCounters(book);
+    counters["auctions"] = auctions;
+    return counters;
+}
+
+Counters mappedBookCounters(const MappedBook& book) {
+    return {
+        {"orders_resting", static_cast<int64_t>(book.getOrderCount())},
+        {"levels", static_cast<int64_t>(book.getLevelCount())},
+    };
+}
+
+// the add workload on a book stored in a memory-mapped file
+Counters mappedAddWorkload(Book&, OrderIdSequence&, int operations, std::vector<double>& latencies) {
+    const std::string path = (std::filesystem::temp_directory_path() / "exchange_benchmark_book.bin").string();
+    MappedBook book(path, static_cast<uint32_t>(operations), 1024);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> level(0, 199);
+    std::vector<BookCommand> commands;
+    commands.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        commands.push_back({CommandType::Add, Side::Buy, 10, 9000 + level(rng), -1, 0});
+    }
+
+    for (const BookCommand& command : commands) {
+        timeOperation(latencies, [&] { book.apply(command); });
+    }
+    Counters counters = mappedBookCounters(book);
+    std::filesystem::remove(path);
+    return counters;
+}
+
+// reopening a mapped book holding every order of the workload, as after a restart
+Counters mappedReopenWorkload(Book&, OrderIdSequence&, int operations, std::vector<double>& latencies) {
+    const std::string path = (std::filesystem::temp_directory_path() / "exchange_benchmark_book.bin").string();
+    {
+        MappedBook book(path, static_cast<uint32_t>(operations), 1024);
+        for (int i = 0; i < operations; ++i) {
+            book.apply({CommandType::Add, i % 2 ? Side::Buy : Side::Sell, 10, i % 2 ? 9000 - i % 200 : 11000 + i % 200, -1, 0});
+        }
+    }
+
+    Counters counters;
+    for (int i = 0; i < 100; ++i) {
+        timeOperation(latencies, [&] {
+            MappedBook book(path);
+            counters = mappedBookCounters(book);
+        });
+    }
+    std::filesystem::remove(path);
+    return counters;
+}
+
+// level 3 snapshots of a book captured and written as Arrow files, timed per order
+Counters level3ExportWorkload(Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> level(0, 199);
+    for (int i = 0; i < operations; ++i) {
+        const Side side = i % 2 ? Side::Buy : Side::Sell;
+        applyCommand(book, {CommandType::Add, side, 10, side == Side::Buy ? 9000 - level(rng) : 11000 + level(rng), -1, 0}, ids);
+    }
+
+    const std::string path = (std::filesystem::temp_directory_path() / "exchange_benchmark_level3.arrow").string();
+    Level3Snapshot snapshot;
+    ArrowExportStats stats;
+    for (int i = 0; i < 5; ++i) {
+        timeBatch(latencies, operations, [&] {
+            snapshot.clear();
+            captureLevel3(book, "BENCH", snapshot);
+            stats = writeArrowIpc(snapshot, path);
+        });
+    }
+    std::filesystem::remove(path);
+    Counters counters = bookCounters(book);
+    counters["file_bytes"] = static_cast<int64_t>(stats.bytes);
+    return counters;
+}
+
+// execution cost queries over the published depth of 16 books, timed per query
+Counters impactWorkload(Book&, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+    constexpr int books = 16;
+    constexpr int batchSize = 1024;
+    std::mt19937 rng(42);
+    std::vector<std::unique_ptr<Book>> bookList;
+    std::vector<std::unique_ptr<PublishedDepth>> depths;
+    ImpactEstimator estimator;
+    for (int i = 0; i < books; ++i) {
+        bookList.push_back(std::make_unique<Book>());
+        depths.push_back(std::make_unique<PublishedDepth>());
+        for (int level = 0; level < 20; ++level) {
+            applyCommand(*bookList.back(), {CommandType::Add, Side::Buy, 100, 9999 - level, -1, 0}, ids);
+            applyCommand(*bookList.back(), {CommandType::Add, Side::Sell, 100, 10001 + level, -1, 0}, ids);
+        }
+        depths.back()->publish(*bookList.back());
+        estimator.addBook("BOOK" + std::to_string(i), *depths.back());
+    }
+
+    std::uniform_int_distribution<uint32_t> instrument(0, books - 1);
+    std::uniform_int_distribution<int64_t> shares(1, 1200);
+    std::vector<ImpactQuery> queries(batchSize);
+    for (ImpactQuery& query : queries) {
+        query = {instrument(rng), rng() % 2 ? Side::Buy : Side::Sell, shares(rng)};
+    }
+    std::vector<ImpactEstimate> estimates(batchSize);
+    int64_t levels = 0;
+    for (int done = 0; done < operations; done += batchSize) {
+        const int count = std::min(batchSize, operations - done);
+        timeBatch(latencies, count, [&] { estimator.estimate(queries.data(), count, estimates.data()); });
+        levels += estimates[0].levelsConsumed;
+    }
+    return {{"view_refreshes", static_cast<int64_t>(estimator.getViewRefreshes())}, {"levels", levels}};
+}
+
+WorkloadResult runWorkload(const Workload& workload, int operations, int repetitions) {
+    WorkloadResult result;
+    result.name = workload.name;
+    result.operations = operations;
+
+    std::vector<double> allLatencies;
+    allLatencies.reserve(static_cast<size_t>(operations) * repetitions);
+
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+        Book book;
+        OrderIdSequence ids;
+        std::vector<double> latencies;
+        latencies.reserve(operations);
+
+        result.counters = workload.run(book, ids, operations, latencies);
+
+        double totalNanos = 0;
+        for (double latency : latencies) {
+            totalNanos += latency;
+        }
+        result.throughputSamples.push_back(totalNanos > 0 ? latencies.size() * 1e9 / totalNanos : 0);
+        allLatencies.insert(allLatencies.end(), latencies.begin(), latencies.end());
+    }
+
+    std::sort(allLatencies.begin(), allLatencies.end());
+    result.latency.p50 = percentile(allLatencies, 0.50);
+    result.latency.p90 = percentile(allLatencies, 0.90);
+    result.latency.p99 = percentile(allLatencies, 0.99);
+    result.latency.p999 = percentile(allLatencies, 0.999);
+    result.latency.max = allLatencies.empty() ? 0 : allLatencies.back();
+    return result;
+}
+
+std::string cpuModel() {
+#if defined(__APPLE__)
+    char brand[256];
+    size_t size = sizeof(brand);
+    if (sysctlbyname("machdep.cpu.brand_string", brand, &size, nullptr, 0) == 0) {
+        return brand;
+    }
+#else
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            auto colon = line.find(':');
+            if (colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+    }
+#endif
+    return "unknown";
+}
+
+std::map<std::string, std::string> collectMetadata(int operations, int repetitions) {
+    std::map<std::string, std::string> metadata;
+
+#if defined(__clang__)
+    metadata["compiler"] = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    metadata["compiler"] = std::string("gcc ") + __VERSION__;
+#else
+    metadata["compiler"] = "unknown";
+#endif
+    metadata["build_type"] = EXCHANGE_BUILD_TYPE;
+    metadata["cxx_standard"] = std::to_string(__cplusplus);
+    metadata["cpu_model"] = cpuModel();
+    metadata["hardware_threads"] = std::to_string(std::thread::hardware_concurrency());
+
+    char hostname[256] = {};
+    if (gethostname(hostname, sizeof(hostname) - 1) == 0) {
+        metadata["hostname"] = hostname;
+    }
+
+    const std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    metadata["timestamp"] = timestamp;
+
+    metadata["operations"] = std::to_string(operations);
+    metadata["repetitions"] = std::to_string(repetitions);
+    return metadata;
+}
+
+void printUsage(const std::vector<Workload>& workloads) {
+    std::cout << "usage: exchange_benchmark [--json <file>] [--operations <n>] [--repetitions <n>] [--workload <name>]...\n\n";
+    std::cout << "workloads:\n";
+    for (const auto& workload : workloads) {
+        std::cout << "  " << std::left << std::setw(14) << workload.name << workload.description << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::vector<Workload> workloads = {
+        {"add", "passive limit orders over 200 price levels", addWorkload},
+        {"cancel", "cancels of resting orders in random order", cancelWorkload},
+        {"sweep", "aggressive limit orders sweeping 4 full levels", sweepWorkload},
+        {"market", "market orders partially and fully filling resting orders", marketWorkload},
+        {"constrained_sweep", "aggressive limit orders sweeping 4 levels past 1000 all-or-none orders each",
+         constrainedSweepWorkload},
+        {"bars", "fills over 1000 instruments aggregated into OHLCV bars", barsWorkload},
+        {"positions", "account fills handed to the position keeper thread", positionsWorkload},
+        {"mapped_add", "passive limit orders over 200 price levels of a memory-mapped book", mappedAddWorkload},
+        {"mapped_reopen", "reopening a memory-mapped book holding every order of the workload", mappedReopenWorkload},
+        {"level3_export", "level 3 snapshots of a book written as Arrow IPC files", level3ExportWorkload},
+        {"impact", "execution cost queries over the published depth of 16 books", impactWorkload},
+        {"burst_continuous", "bursts of crossing limit orders matched on arrival",
+         [](Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+             return burstWorkload(MatchingMode::Continuous, book, ids, operations, latencies);
+         }},
+        {"burst_auction", "the same bursts matched by one batch auction each",
+         [](Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+             return burstWorkload(MatchingMode::BatchAuction, book, ids, operations, latencies);
+         }},
+        {"route_plan", "routing decisions splitting parent orders across 4 busy venues",
+         [](Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+             return routerWorkload(false, book, ids, operations, latencies);
+         }},
+        {"route_fill", "parent orders routed to 4 busy venues, until every child reported",
+         [](Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+             return routerWorkload(true, book, ids, operations, latencies);
+         }},
+        {"cancel_fifo", "cancel latency behind bursts of aggressive orders, arrival order batches",
+         [](Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+             return cancelBurstWorkload(BatchScheduling::Arrival, book, ids, operations, latencies);
+         }},
+        {"cancel_first", "cancel latency behind bursts of aggressive orders, cancels first batches",
+         [](Book& book, OrderIdSequence& ids, int operations, std::vector<double>& latencies) {
+             return cancelBurstWorkload(BatchScheduling::CancelsFirst, book, ids, operations, latencies);
+         }},
+    };
+
+    std::string jsonPath;
+    int operations = 100000;
+    int repetitions = 5;
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--operations" && hasValue) {
+            operations = std::stoi(argv[++i]);
+        } else if (arg == "--repetitions" && hasValue) {
+            repetitions = std::stoi(argv[++i]);
+        } else if (arg == "--workload" && hasValue) {
+            selected.push_back(argv[++i]);
+        } else {
+            printUsage(workloads);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (operations <= 0 || repetitions <= 0) {
+        std::cerr << "operations and repetitions must be positive\n";
+        return 1;
+    }
+
+    BenchmarkRun run;
+    run.metadata = collectMetadata(operations, repetitions);
+
+    std::cout << std::left << std::setw(14) << "workload" << std::right << std::setw(16) << "ops/sec"
+              << std::setw(10) << "noise" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+              << std::setw(12) << "p99.9 ns" << "\n";
+
+    for (const auto& workload : workloads) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), workload.name) == selected.end()) {
+            continue;
+        }
+        WorkloadResult result = runWorkload(workload, operations, repetitions);
+        std::cout << std::left << std::setw(14) << result.name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << result.medianThroughput() << std::setprecision(2) << std::setw(9)
+                  << result.relativeNoise() * 100 << "%" << std::setprecision(0) << std::setw(10) << result.latency.p50
+                  << std::setw(10) << result.latency.p99 << std::setw(12) << result.latency.p999 << "\n";
+        run.workloads.push_back(std::move(result));
+    }
+
+    if (!jsonPath.empty()) {
+        writeBenchmarkRun(run, jsonPath);
+        std::cout << "results written to " << jsonPath << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "BenchmarkResult.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+/**
+ * @brief Relative change from a baseline value to a candidate value.
+ */
+double relativeChange(double baseline, double candidate) {
+    return baseline == 0 ? 0 : (candidate - baseline) / baseline;
+}
+
+void printUsage() {
+    std::cout << "usage: exchange_benchmark_compare <baseline.json> <candidate.json> "
+                 "[--threshold <fraction>] [--noise-multiplier <k>]\n\n"
+                 "A workload is reported faster or slower only when its median throughput changed by more than\n"
+                 "max(threshold, k * noise), where noise is the larger relative MAD of the two runs' repetitions.\n"
+                 "Exits with status 2 if any workload regressed.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    double minThreshold = 0.02;
+    double noiseMultiplier = 3.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--threshold" && hasValue) {
+            minThreshold = std::stod(argv[++i]);
+        } else if (arg == "--noise-multiplier" && hasValue) {
+            noiseMultiplier = std::stod(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-') {
+            paths.push_back(arg);
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (paths.size() != 2) {
+        printUsage();
+        return 1;
+    }
+
+    BenchmarkRun baseline;
+    BenchmarkRun candidate;
+    try {
+        baseline = readBenchmarkRun(paths[0]);
+        candidate = readBenchmarkRun(paths[1]);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    // results are only comparable when produced on the same machine with the same build
+    for (const char* key : {"cpu_model", "hostname", "compiler", "build_type", "operations"}) {
+        auto before = baseline.metadata.find(key);
+        auto after = candidate.metadata.find(key);
+        if (before != baseline.metadata.end() && after != candidate.metadata.end() && before->second != after->second) {
+            std::cout << "warning: " << key << " differs (" << before->second << " vs " << after->second << ")\n";
+        }
+    }
+
+    std::cout << std::left << std::setw(10) << "workload" << std::right << std::setw(16) << "baseline"
+              << std::setw(16) << "candidate" << std::setw(10) << "change" << std::setw(11) << "threshold"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << "  verdict\n";
+
+    bool regressed = false;
+    for (const WorkloadResult& before : baseline.workloads) {
+        const WorkloadResult* after = candidate.findWorkload(before.name);
+        if (!after) {
+            std::cout << std::left << std::setw(10) << before.name << "  missing from candidate\n";
+            continue;
+        }
+
+        const double change = relativeChange(before.medianThroughput(), after->medianThroughput());
+        const double noise = std::max(before.relativeNoise(), after->relativeNoise());
+        const double threshold = std::max(minThreshold, noiseMultiplier * noise);
+
+        std::string verdict = "unchanged";
+        if (change > threshold) {
+            verdict = "faster";
+        } else if (change < -threshold) {
+            verdict = "SLOWER";
+            regressed = true;
+        }
+
+        std::cout << std::left << std::setw(10) << before.name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << before.medianThroughput() << std::setw(16) << after->medianThroughput()
+                  << std::showpos << std::setprecision(1) << std::setw(9) << change * 100 << "%" << std::noshowpos
+                  << std::setw(10) << threshold * 100 << "%" << std::showpos
+                  << std::setw(9) << relativeChange(before.latency.p50, after->latency.p50) * 100 << "%"
+                  << std::setw(9) << relativeChange(before.latency.p99, after->latency.p99) * 100 << "%"
+                  << std::noshowpos << "  " << verdict << "\n";
+    }
+
+    for (const WorkloadResult& after : candidate.workloads) {
+        if (!baseline.findWorkload(after.name)) {
+            std::cout << std::left << std::setw(10) << after.name << "  missing from baseline\n";
+        }
+    }
+
+    return regressed ? 2 : 0;
+}
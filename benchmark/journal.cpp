@@ -0,0 +1,86 @@
+#include "../src/Journal.h"
+#include "../src/Replay.h"
+
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+void printUsage() {
+    std::cout << "usage: exchange_journal write <csv> <journal>\n"
+                 "       exchange_journal compact <journal> <compacted journal>\n\n"
+                 "write encodes a replay CSV file (eventTime,ticker,action,side,shares,price,orderId) as a\n"
+                 "journal, compact rewrites a journal as the live orders of each of its books.\n";
+}
+
+int write(const std::string& csvPath, const std::string& journalPath) {
+    std::ifstream file(csvPath);
+    if (!file) {
+        std::cerr << "can't open " << csvPath << "\n";
+        return 1;
+    }
+    const ReplayInput input = readReplayCsv(file);
+    const auto csvBytes = static_cast<uint64_t>(file.clear(), file.seekg(0, std::ios::end), file.tellg());
+
+    // the journal records commands as the matching thread applies them, with the ids assigned by the
+    // books, so the feed ids are mapped by applying the messages to a book per instrument
+    JournalWriter writer(journalPath);
+    std::vector<RecoveredBook> books;
+    std::vector<std::unordered_map<int64_t, int64_t>> bookIds(input.tickers.size());
+    for (const std::string& ticker : input.tickers) {
+        writer.addInstrument(ticker);
+        books.push_back({ticker, std::make_unique<Book>(), std::make_unique<OrderIdSequence>()});
+    }
+    for (const ReplayMessage& message : input.messages) {
+        BookCommand command = message.command;
+        std::unordered_map<int64_t, int64_t>& ids = bookIds[message.instrument];
+        if (command.type == CommandType::Cancel || command.type == CommandType::ModifySize) {
+            const auto id = ids.find(command.orderId);
+            if (id == ids.end()) {
+                continue;
+            }
+            command.orderId = id->second;
+        }
+        const CommandResult result = applyCommand(*books[message.instrument].book, command,
+                                                  *books[message.instrument].orderIdSequence);
+        if (command.type == CommandType::Add && command.orderId >= 0 && result.orderId) {
+            ids[command.orderId] = *result.orderId;
+        }
+        writer.append(message.instrument, command);
+    }
+    writer.flush();
+    std::cout << input.messages.size() << " messages: " << csvBytes << " bytes of CSV, " << writer.getBytesWritten()
+              << " bytes of journal\n";
+    return 0;
+}
+
+int compact(const std::string& inputPath, const std::string& outputPath) {
+    const CompactionStats stats = compactJournal(inputPath, outputPath);
+    std::cout << stats.inputRecords << " records, " << stats.inputBytes << " bytes -> " << stats.outputRecords
+              << " records, " << stats.outputBytes << " bytes (" << stats.liveOrders << " live orders)\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        printUsage();
+        return argc == 2 && std::string(argv[1]) == "--help" ? 0 : 1;
+    }
+    const std::string command = argv[1];
+    try {
+        if (command == "write") {
+            return write(argv[2], argv[3]);
+        }
+        if (command == "compact") {
+            return compact(argv[2], argv[3]);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,212 @@
+#include "../src/SharedMemoryOrderEntry.h"
+#include "BenchmarkResult.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const std::string ticker = "TTF 24Q-ICN";
+
+/**
+ * @brief The command sent for the i-th round trip: alternately a passive order and its cancel, so
+ *        the book stays small and every round trip does comparable work.
+ */
+BookCommand commandFor(int i, std::optional<int64_t> lastOrderId) {
+    if (i % 2 == 1 && lastOrderId) {
+        return {CommandType::Cancel, Side::Buy, 0, 0, *lastOrderId, 0};
+    }
+    return {CommandType::Add, Side::Buy, 10, 9000 + i % 100, -1, 0};
+}
+
+bool writeAll(int socket, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t written = send(socket, bytes, size, 0);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int socket, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        const ssize_t received = recv(socket, bytes, size, 0);
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+/**
+ * @brief A loopback TCP order entry server with the same records and the same matching as the
+ *        shared memory gateway, serving one connection.
+ */
+class TcpOrderServer {
+public:
+    explicit TcpOrderServer(Exchange& exchange) : exchange(exchange) {
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listenSocket, 1) < 0) {
+            throw std::runtime_error("Can't bind the TCP order server");
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listenSocket, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+        thread = std::thread(&TcpOrderServer::serve, this);
+    }
+
+    ~TcpOrderServer() {
+        thread.join();
+        close(listenSocket);
+    }
+
+    uint16_t port;
+
+private:
+    void serve() {
+        const int connection = accept(listenSocket, nullptr, nullptr);
+        int noDelay = 1;
+        setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        OrderEntryRequest request;
+        while (readAll(connection, &request, sizeof(request))) {
+            OrderEntryResponse response{request.requestId, ExecutionReport{}};
+            const CommandResult result = exchange.applyCommand(request.ticker, request.command);
+            response.report.status = result.accepted ? SubmitStatus::Accepted : SubmitStatus::Rejected;
+            response.report.orderId = result.orderId;
+            if (!writeAll(connection, &response, sizeof(response))) {
+                break;
+            }
+        }
+        close(connection);
+    }
+
+    Exchange& exchange;
+    int listenSocket;
+    std::thread thread;
+};
+
+LatencyPercentiles summarize(std::vector<double>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    LatencyPercentiles result;
+    result.p50 = percentile(latencies, 0.50);
+    result.p90 = percentile(latencies, 0.90);
+    result.p99 = percentile(latencies, 0.99);
+    result.p999 = percentile(latencies, 0.999);
+    result.max = latencies.empty() ? 0 : latencies.back();
+    return result;
+}
+
+std::vector<double> sharedMemoryRoundTrips(int roundTrips, bool useFutex) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument(ticker);
+    OrderEntryOptions options;
+    options.useFutex = useFutex;
+
+    const std::string name = "/exchange_order_entry_benchmark_" + std::to_string(getpid());
+    SharedMemoryOrderGateway gateway(exchange, name, options);
+    gateway.start();
+    SharedMemoryOrderClient client(name, "benchmark", options);
+
+    std::vector<double> latencies;
+    latencies.reserve(roundTrips);
+    std::optional<int64_t> lastOrderId;
+    OrderEntryResponse response;
+    for (int i = 0; i < roundTrips; ++i) {
+        const BookCommand command = commandFor(i, lastOrderId);
+        const auto start = Clock::now();
+        client.send(i, ticker, command);
+        client.receive(response, std::chrono::seconds(1));
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        lastOrderId = response.report.orderId;
+    }
+    return latencies;
+}
+
+std::vector<double> tcpRoundTrips(int roundTrips) {
+    Exchange exchange("ENDEX");
+    exchange.addInstrument(ticker);
+    TcpOrderServer server(exchange);
+
+    const int client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(server.port);
+    if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error("Can't connect to the TCP order server");
+    }
+    int noDelay = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    std::vector<double> latencies;
+    latencies.reserve(roundTrips);
+    std::optional<int64_t> lastOrderId;
+    OrderEntryResponse response;
+    for (int i = 0; i < roundTrips; ++i) {
+        OrderEntryRequest request{static_cast<uint64_t>(i), {}, commandFor(i, lastOrderId)};
+        std::strncpy(request.ticker, ticker.c_str(), orderEntryTickerSize - 1);
+        const auto start = Clock::now();
+        writeAll(client, &request, sizeof(request));
+        readAll(client, &response, sizeof(response));
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        lastOrderId = response.report.orderId;
+    }
+    close(client);
+    return latencies;
+}
+
+void printRow(const std::string& transport, std::vector<double> latencies) {
+    const LatencyPercentiles percentiles = summarize(latencies);
+    std::cout << std::left << std::setw(20) << transport << std::right << std::fixed << std::setprecision(0)
+              << std::setw(10) << percentiles.p50 << std::setw(10) << percentiles.p90 << std::setw(10)
+              << percentiles.p99 << std::setw(12) << percentiles.p999 << std::setw(12) << percentiles.max << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int roundTrips = 100000;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--round-trips" && i + 1 < argc) {
+            roundTrips = std::stoi(argv[++i]);
+        } else {
+            std::cout << "usage: exchange_order_entry_benchmark [--round-trips <n>]\n\n"
+                         "Measures the round trip latency of a command and its execution report over the\n"
+                         "shared memory channel (spinning, then with futex wakeups) and over loopback TCP.\n";
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::cout << std::left << std::setw(20) << "transport" << std::right << std::setw(10) << "p50 ns" << std::setw(10)
+              << "p90 ns" << std::setw(10) << "p99 ns" << std::setw(12) << "p99.9 ns" << std::setw(12) << "max ns" << "\n";
+    if (std::thread::hardware_concurrency() > 1) {
+        printRow("shm spin", sharedMemoryRoundTrips(roundTrips, false));
+    } else {
+        // a busy-polling gateway and client would only hand the single core over on preemption
+        std::cout << std::left << std::setw(20) << "shm spin" << "skipped, needs at least two cores\n";
+    }
+    printRow("shm futex", sharedMemoryRoundTrips(roundTrips, true));
+    printRow("tcp loopback", tcpRoundTrips(roundTrips));
+    return 0;
+}
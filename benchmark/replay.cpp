@@ -0,0 +1,176 @@
+#include "../src/Replay.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief Generates a synthetic trading day. Instrument activity follows a 1/rank distribution, so a
+ *        few instruments carry most of the messages, like on a real venue. Orders are placed around a
+ *        per instrument mid, a tenth of them crossing the spread, and live orders are cancelled or
+ *        resized at random.
+ */
+ReplayInput generateDay(size_t instruments, size_t messages, uint32_t seed) {
+    std::mt19937 rng(seed);
+    ReplayInput input;
+    for (size_t i = 0; i < instruments; ++i) {
+        input.tickers.push_back("SYM" + std::to_string(i));
+    }
+
+    std::vector<double> weights(instruments);
+    for (size_t i = 0; i < instruments; ++i) {
+        weights[i] = 1.0 / static_cast<double>(i + 1);
+    }
+    std::discrete_distribution<uint32_t> instrument(weights.begin(), weights.end());
+    std::uniform_int_distribution<int> action(0, 99);
+    std::uniform_int_distribution<int> offset(1, 50);
+    std::uniform_int_distribution<int> shares(1, 100);
+
+    std::vector<std::vector<int64_t>> liveOrders(instruments);
+    int64_t nextOrderId = 0;
+    input.messages.reserve(messages);
+
+    for (size_t i = 0; i < messages; ++i) {
+        const uint32_t target = instrument(rng);
+        const int eventTime = static_cast<int>(i * 86400 / messages);
+        const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+        std::vector<int64_t>& live = liveOrders[target];
+        const int roll = action(rng);
+
+        BookCommand command{CommandType::Add, side, shares(rng), 0, -1, eventTime};
+        if (roll < 30 && !live.empty()) {
+            const size_t index = rng() % live.size();
+            command.orderId = live[index];
+            if (roll < 25) {
+                command.type = CommandType::Cancel;
+                live[index] = live.back();
+                live.pop_back();
+            } else {
+                command.type = CommandType::ModifySize;
+            }
+        } else {
+            const bool crossing = roll >= 90;
+            const int distance = crossing ? -offset(rng) / 10 - 1 : offset(rng);
+            command.price = side == Side::Buy ? 10000 - distance : 10000 + distance;
+            command.orderId = nextOrderId++;
+            live.push_back(command.orderId);
+        }
+        input.messages.push_back({target, command});
+    }
+    return input;
+}
+
+/**
+ * @brief Hashes the merged fills, to check that every thread count produced the same output.
+ */
+uint64_t digest(const std::vector<ReplayFill>& fills) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    for (const ReplayFill& fill : fills) {
+        mix(fill.instrument);
+        mix(fill.fill.sequence);
+        mix(static_cast<uint64_t>(fill.fill.restingOrderId));
+        mix(static_cast<uint64_t>(fill.fill.price));
+        mix(static_cast<uint64_t>(fill.fill.shares));
+    }
+    return hash;
+}
+
+void printUsage() {
+    std::cout << "usage: exchange_replay [--input <csv>] [--instruments <n>] [--messages <n>] [--seed <n>]\n"
+                 "                       [--threads <n>]... [--task-messages <n>]\n\n"
+                 "Replays a CSV file, or a synthetic day when no input is given, once per thread count\n"
+                 "(1, 2, 4, ... up to the hardware threads by default) and reports messages/second.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string inputPath;
+    size_t instruments = 5000;
+    size_t messages = 5000000;
+    uint32_t seed = 42;
+    std::vector<size_t> threadCounts;
+    ReplayOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--input" && hasValue) {
+            inputPath = argv[++i];
+        } else if (arg == "--instruments" && hasValue) {
+            instruments = std::stoul(argv[++i]);
+        } else if (arg == "--messages" && hasValue) {
+            messages = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            threadCounts.push_back(std::stoul(argv[++i]));
+        } else if (arg == "--task-messages" && hasValue) {
+            options.taskMessages = std::stoul(argv[++i]);
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (threadCounts.empty()) {
+        const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t threads = 1; threads < hardware; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(hardware);
+    }
+
+    ReplayInput input;
+    if (!inputPath.empty()) {
+        std::ifstream file(inputPath);
+        if (!file) {
+            std::cerr << "can't open " << inputPath << "\n";
+            return 1;
+        }
+        input = readReplayCsv(file);
+    } else {
+        input = generateDay(instruments, messages, seed);
+    }
+    std::cout << input.messages.size() << " messages over " << input.tickers.size() << " instruments\n\n";
+
+    std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(16) << "msgs/sec"
+              << std::setw(10) << "speedup" << std::setw(8) << "tasks" << std::setw(8) << "stolen"
+              << std::setw(20) << "output digest" << "\n";
+
+    double singleThreadRate = 0;
+    uint64_t referenceDigest = 0;
+    bool deterministic = true;
+    for (size_t threads : threadCounts) {
+        options.threads = threads;
+        ReplayResult result = replay(input, options);
+        const uint64_t outputDigest = digest(result.mergedFills());
+
+        if (singleThreadRate == 0) {
+            singleThreadRate = result.messagesPerSecond();
+            referenceDigest = outputDigest;
+        }
+        deterministic = deterministic && outputDigest == referenceDigest;
+
+        std::cout << std::left << std::setw(10) << result.threads << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << result.messagesPerSecond() << std::setprecision(2) << std::setw(9)
+                  << result.messagesPerSecond() / singleThreadRate << "x" << std::setw(8) << result.tasks
+                  << std::setw(8) << result.stolenTasks << std::setw(20) << std::hex << outputDigest << std::dec << "\n";
+    }
+
+    if (!deterministic) {
+        std::cerr << "replay output differs between thread counts\n";
+        return 2;
+    }
+    return 0;
+}
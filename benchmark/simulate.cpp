@@ -0,0 +1,85 @@
+#include "../src/Simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+void printUsage() {
+    std::cout << "usage: exchange_simulate [--seeds <n>] [--threads <n>] [--steps <n>] [--makers <n>]\n"
+                 "                         [--momentum <n>] [--noise <n>] [--trades <csv>]\n\n"
+                 "Runs one agent-based simulation per seed in parallel and reports the order rate and how\n"
+                 "much faster than real time the simulations ran. --trades writes the fills of every seed.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SimulationConfig config;
+    size_t seedCount = 8;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string tradesPath;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--seeds" && hasValue) {
+            seedCount = std::stoul(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            threads = std::stoul(argv[++i]);
+        } else if (arg == "--steps" && hasValue) {
+            config.steps = std::stoi(argv[++i]);
+        } else if (arg == "--makers" && hasValue) {
+            config.population.marketMakers = std::stoul(argv[++i]);
+        } else if (arg == "--momentum" && hasValue) {
+            config.population.momentumTraders = std::stoul(argv[++i]);
+        } else if (arg == "--noise" && hasValue) {
+            config.population.noiseTraders = std::stoul(argv[++i]);
+        } else if (arg == "--trades" && hasValue) {
+            tradesPath = argv[++i];
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    config.recordFills = !tradesPath.empty();
+
+    std::vector<uint32_t> seeds(seedCount);
+    for (size_t i = 0; i < seedCount; ++i) {
+        seeds[i] = static_cast<uint32_t>(i + 1);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<SimulationResult> results = runSimulations(config, seeds, threads);
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::left << std::setw(8) << "seed" << std::right << std::setw(12) << "orders" << std::setw(12)
+              << "cancels" << std::setw(12) << "fills" << std::setw(12) << "final mid" << std::setw(14) << "x real time" << "\n";
+    uint64_t orders = 0;
+    for (const SimulationResult& result : results) {
+        orders += result.ordersSubmitted + result.cancels;
+        std::cout << std::left << std::setw(8) << result.seed << std::right << std::setw(12) << result.ordersSubmitted
+                  << std::setw(12) << result.cancels << std::setw(12) << result.fills << std::setw(12)
+                  << (result.midPrices.empty() ? 0 : result.midPrices.back()) << std::fixed << std::setprecision(0)
+                  << std::setw(14) << result.speedup() << "\n";
+    }
+    std::cout << "\n" << results.size() << " simulations on " << threads << " threads: " << std::fixed
+              << std::setprecision(0) << orders / wallSeconds << " orders and cancels/sec\n";
+
+    if (!tradesPath.empty()) {
+        std::ofstream out(tradesPath);
+        out << "seed,sequence,eventTime,price,shares,aggressor\n";
+        for (const SimulationResult& result : results) {
+            for (const Fill& fill : result.trades) {
+                out << result.seed << "," << fill.sequence << "," << fill.eventTime << "," << fill.price << ","
+                    << fill.shares << "," << (fill.aggressorSide == Side::Buy ? "B" : "S") << "\n";
+            }
+        }
+        std::cout << "trades written to " << tradesPath << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,313 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "../src/CommandBatch.h"
+
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace {
+
+/**
+ * @enum EngineBufferKind
+ * @brief The engine-owned buffers a Python view can refer to.
+ */
+enum EngineBufferKind {
+    ResultsBuffer,
+    FillsBuffer,
+    DepthBuffer,
+    EngineBufferKinds
+};
+
+constexpr Py_ssize_t bufferColumns[EngineBufferKinds] = {commandResultColumns, fillRecordColumns, depthRecordColumns};
+
+/**
+ * @struct ExchangeObject
+ * @brief The Python Exchange: an exchange, the batch session driving it, and the number of views
+ *        exported on each of its buffers. A buffer cannot change while views on it exist, the same
+ *        rule bytearray follows.
+ */
+struct ExchangeObject {
+    PyObject_HEAD
+    Exchange* exchange;
+    CommandBatchSession* session;
+    Py_ssize_t exports[EngineBufferKinds];
+};
+
+/**
+ * @struct EngineBufferObject
+ * @brief A view over one buffer of an exchange, exported through the buffer protocol as a 2-D
+ *        C-contiguous int64 array. It keeps its exchange alive.
+ */
+struct EngineBufferObject {
+    PyObject_HEAD
+    ExchangeObject* owner;
+    EngineBufferKind kind;
+    Py_ssize_t shape[2];
+    Py_ssize_t strides[2];
+};
+
+// zeroed here and filled by PyInit_exchange
+PyTypeObject ExchangeType{};
+PyTypeObject EngineBufferType{};
+
+const std::vector<int64_t>& engineVector(ExchangeObject* owner, EngineBufferKind kind) {
+    switch (kind) {
+        case ResultsBuffer: return owner->session->getResults();
+        case FillsBuffer: return owner->session->getFills();
+        default: return owner->session->getDepth();
+    }
+}
+
+// fails with BufferError if views on the given buffer are still exported
+bool checkNoExports(ExchangeObject* self, EngineBufferKind kind, const char* name) {
+    if (self->exports[kind] > 0) {
+        PyErr_Format(PyExc_BufferError, "release the views on %s before changing them", name);
+        return false;
+    }
+    return true;
+}
+
+PyObject* newEngineBuffer(ExchangeObject* owner, EngineBufferKind kind) {
+    auto* buffer = PyObject_New(EngineBufferObject, &EngineBufferType);
+    if (!buffer) {
+        return nullptr;
+    }
+    Py_INCREF(owner);
+    buffer->owner = owner;
+    buffer->kind = kind;
+    return reinterpret_cast<PyObject*>(buffer);
+}
+
+int engineBufferGetBuffer(PyObject* object, Py_buffer* view, int flags) {
+    auto* self = reinterpret_cast<EngineBufferObject*>(object);
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "engine buffers are read-only");
+        view->obj = nullptr;
+        return -1;
+    }
+    const std::vector<int64_t>& data = engineVector(self->owner, self->kind);
+    self->shape[1] = bufferColumns[self->kind];
+    self->shape[0] = static_cast<Py_ssize_t>(data.size()) / self->shape[1];
+    self->strides[1] = sizeof(int64_t);
+    self->strides[0] = self->shape[1] * static_cast<Py_ssize_t>(sizeof(int64_t));
+
+    view->obj = object;
+    Py_INCREF(object);
+    view->buf = const_cast<int64_t*>(data.data());
+    view->len = static_cast<Py_ssize_t>(data.size() * sizeof(int64_t));
+    view->readonly = 1;
+    view->itemsize = sizeof(int64_t);
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>("q") : nullptr;
+    view->ndim = 2;
+    view->shape = (flags & PyBUF_ND) ? self->shape : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    ++self->owner->exports[self->kind];
+    return 0;
+}
+
+void engineBufferReleaseBuffer(PyObject* object, Py_buffer*) {
+    auto* self = reinterpret_cast<EngineBufferObject*>(object);
+    --self->owner->exports[self->kind];
+}
+
+void engineBufferDealloc(PyObject* object) {
+    auto* self = reinterpret_cast<EngineBufferObject*>(object);
+    Py_DECREF(self->owner);
+    PyObject_Free(object);
+}
+
+PyBufferProcs engineBufferProcs = {engineBufferGetBuffer, engineBufferReleaseBuffer};
+
+PyObject* exchangeNew(PyTypeObject* type, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"name", nullptr};
+    const char* name = "EXCHANGE";
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|s", const_cast<char**>(keywords), &name)) {
+        return nullptr;
+    }
+    auto* self = reinterpret_cast<ExchangeObject*>(type->tp_alloc(type, 0));
+    if (!self) {
+        return nullptr;
+    }
+    try {
+        self->exchange = new Exchange(name);
+        self->session = new CommandBatchSession(*self->exchange);
+    } catch (const std::exception& e) {
+        Py_DECREF(self);
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void exchangeDealloc(PyObject* object) {
+    auto* self = reinterpret_cast<ExchangeObject*>(object);
+    delete self->session;
+    delete self->exchange;
+    Py_TYPE(object)->tp_free(object);
+}
+
+PyObject* exchangeAddInstrument(PyObject* object, PyObject* args) {
+    auto* self = reinterpret_cast<ExchangeObject*>(object);
+    const char* ticker;
+    if (!PyArg_ParseTuple(args, "s", &ticker)) {
+        return nullptr;
+    }
+    return PyLong_FromUnsignedLong(self->session->addInstrument(ticker));
+}
+
+PyObject* exchangeTickers(PyObject* object, PyObject*) {
+    auto* self = reinterpret_cast<ExchangeObject*>(object);
+    const std::vector<std::string>& tickers = self->session->getTickers();
+    PyObject* list = PyList_New(static_cast<Py_ssize_t>(tickers.size()));
+    for (size_t i = 0; list && i < tickers.size(); ++i) {
+        PyList_SET_ITEM(list, static_cast<Py_ssize_t>(i), PyUnicode_FromString(tickers[i].c_str()));
+    }
+    return list;
+}
+
+/**
+ * @brief submit(commands) applies a batch of commands, read in place from any C-contiguous buffer
+ *        of int64 with 7 columns: instrument, type, side, shares, price, order id, event time.
+ */
+PyObject* exchangeSubmit(PyObject* object, PyObject* args) {
+    auto* self = reinterpret_cast<ExchangeObject*>(object);
+    PyObject* commands;
+    if (!PyArg_ParseTuple(args, "O", &commands)) {
+        return nullptr;
+    }
+    if (!checkNoExports(self, ResultsBuffer, "results") || !checkNoExports(self, FillsBuffer, "fills")) {
+        return nullptr;
+    }
+    Py_buffer view;
+    if (PyObject_GetBuffer(commands, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        return nullptr;
+    }
+    const char* format = view.format ? view.format : "B";
+    if (format[0] == '<' || format[0] == '=' || format[0] == '@') {
+        ++format;
+    }
+    const bool int64Format = view.itemsize == 8 && (std::strcmp(format, "q") == 0 || std::strcmp(format, "l") == 0);
+    const Py_ssize_t values = view.len / static_cast<Py_ssize_t>(sizeof(int64_t));
+    const bool rowShape = view.ndim == 2 ? view.shape[1] == static_cast<Py_ssize_t>(commandBatchColumns)
+                                         : view.ndim == 1 && values % static_cast<Py_ssize_t>(commandBatchColumns) == 0;
+    if (!int64Format || !rowShape) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "commands must be a C-contiguous int64 array with 7 columns");
+        return nullptr;
+    }
+    const size_t accepted = self->session->submit(static_cast<const int64_t*>(view.buf),
+                                                  static_cast<size_t>(values) / commandBatchColumns);
+    PyBuffer_Release(&view);
+    return PyLong_FromSize_t(accepted);
+}
+
+PyObject* exchangeClearFills(PyObject* object, PyObject*) {
+    auto* self = reinterpret_cast<ExchangeObject*>(object);
+    if (!checkNoExports(self, FillsBuffer, "fills")) {
+        return nullptr;
+    }
+    self->session->clearFills();
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief depth(instrument, levels=10) captures the best levels of a book and returns a view of
+ *        2 * levels rows of price, volume and orders, bids then asks.
+ */
+PyObject* exchangeDepth(PyObject* object, PyObject* args) {
+    auto* self = reinterpret_cast<ExchangeObject*>(object);
+    unsigned int instrument;
+    Py_ssize_t levels = 10;
+    if (!PyArg_ParseTuple(args, "I|n", &instrument, &levels)) {
+        return nullptr;
+    }
+    if (levels < 0 || !checkNoExports(self, DepthBuffer, "depth")) {
+        return levels < 0 ? PyErr_Format(PyExc_ValueError, "levels must not be negative") : nullptr;
+    }
+    try {
+        self->session->captureDepth(instrument, static_cast<size_t>(levels));
+    } catch (const std::out_of_range& e) {
+        PyErr_SetString(PyExc_IndexError, e.what());
+        return nullptr;
+    }
+    return newEngineBuffer(self, DepthBuffer);
+}
+
+PyObject* exchangeResults(PyObject* object, void*) {
+    return newEngineBuffer(reinterpret_cast<ExchangeObject*>(object), ResultsBuffer);
+}
+
+PyObject* exchangeFills(PyObject* object, void*) {
+    return newEngineBuffer(reinterpret_cast<ExchangeObject*>(object), FillsBuffer);
+}
+
+PyMethodDef exchangeMethods[] = {
+    {"add_instrument", exchangeAddInstrument, METH_VARARGS, "add_instrument(ticker) -> index of the instrument"},
+    {"tickers", exchangeTickers, METH_NOARGS, "tickers() -> tickers in instrument index order"},
+    {"submit", exchangeSubmit, METH_VARARGS,
+     "submit(commands) -> accepted count; commands is an int64 array of rows "
+     "(instrument, type, side, shares, price, order_id, event_time)"},
+    {"clear_fills", exchangeClearFills, METH_NOARGS, "clear_fills() drops the collected fills"},
+    {"depth", exchangeDepth, METH_VARARGS, "depth(instrument, levels=10) -> view of (price, volume, orders) rows, bids then asks"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyGetSetDef exchangeGetters[] = {
+    {"results", exchangeResults, nullptr, "view of the (accepted, order_id) rows of the last batch", nullptr},
+    {"fills", exchangeFills, nullptr,
+     "view of the (instrument, sequence, resting_order_id, price, shares, aggressor_side, event_time) fill rows", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+PyModuleDef exchangeModule{};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_exchange() {
+    Py_SET_REFCNT(&EngineBufferType, 1);
+    EngineBufferType.tp_name = "exchange.EngineBuffer";
+    EngineBufferType.tp_basicsize = sizeof(EngineBufferObject);
+    EngineBufferType.tp_flags = Py_TPFLAGS_DEFAULT;
+    EngineBufferType.tp_doc = "A read-only int64 view over a buffer owned by an Exchange.";
+    EngineBufferType.tp_dealloc = engineBufferDealloc;
+    EngineBufferType.tp_as_buffer = &engineBufferProcs;
+
+    Py_SET_REFCNT(&ExchangeType, 1);
+    ExchangeType.tp_name = "exchange.Exchange";
+    ExchangeType.tp_basicsize = sizeof(ExchangeObject);
+    ExchangeType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ExchangeType.tp_doc = "An exchange driven by batches of commands.";
+    ExchangeType.tp_new = exchangeNew;
+    ExchangeType.tp_dealloc = exchangeDealloc;
+    ExchangeType.tp_methods = exchangeMethods;
+    ExchangeType.tp_getset = exchangeGetters;
+
+    if (PyType_Ready(&EngineBufferType) < 0 || PyType_Ready(&ExchangeType) < 0) {
+        return nullptr;
+    }
+    exchangeModule.m_base = PyModuleDef_HEAD_INIT;
+    exchangeModule.m_name = "exchange";
+    exchangeModule.m_doc = "Batch access to the order book engine with zero-copy result views.";
+    exchangeModule.m_size = -1;
+    PyObject* module = PyModule_Create(&exchangeModule);
+    if (!module) {
+        return nullptr;
+    }
+    Py_INCREF(&ExchangeType);
+    if (PyModule_AddObject(module, "Exchange", reinterpret_cast<PyObject*>(&ExchangeType)) < 0) {
+        Py_DECREF(&ExchangeType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    PyModule_AddIntConstant(module, "ADD", static_cast<long>(CommandType::Add));
+    PyModule_AddIntConstant(module, "CANCEL", static_cast<long>(CommandType::Cancel));
+    PyModule_AddIntConstant(module, "MODIFY_SIZE", static_cast<long>(CommandType::ModifySize));
+    PyModule_AddIntConstant(module, "MARKET", static_cast<long>(CommandType::Market));
+    PyModule_AddIntConstant(module, "BUY", 0);
+    PyModule_AddIntConstant(module, "SELL", 1);
+    return module;
+}
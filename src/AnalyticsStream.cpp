@@ -0,0 +1,50 @@
+#include "AnalyticsStream.h"
+#include "Exchange.hpp"
+
+/**
+ * @brief Constructs an analytics stream for an exchange.
+ * @param exchange The exchange whose books are published.
+ * @param interval Minimum time between two publications.
+ */
+AnalyticsStream::AnalyticsStream(const Exchange& exchange, std::chrono::milliseconds interval)
+    : exchange(exchange), interval(interval) {}
+
+/**
+ * @brief Registers a callback receiving every publication.
+ * @param subscriber The callback.
+ */
+void AnalyticsStream::subscribe(Subscriber subscriber) {
+    subscribers.push_back(std::move(subscriber));
+}
+
+/**
+ * @brief Publishes the analytics of the books that changed, if the publication interval has elapsed.
+ * @param now The current time.
+ * @return The number of books published, 0 if it was not yet time to publish or nothing changed.
+ */
+size_t AnalyticsStream::poll(std::chrono::steady_clock::time_point now) {
+    
+    if (lastPublication && now - *lastPublication < interval) {
+        return 0;
+    }
+    lastPublication = now;
+
+    std::vector<AnalyticsUpdate> updates;
+    for (const std::string& ticker : exchange.getTickerList()) {
+        const Book* book = exchange.getOrderBook(ticker);
+        const uint64_t version = book->getAnalyticsVersion();
+        auto published = publishedVersions.find(ticker);
+        if (published != publishedVersions.end() && published->second == version) {
+            continue;
+        }
+        publishedVersions[ticker] = version;
+        updates.push_back({ticker, book->getAnalytics()});
+    }
+
+    if (!updates.empty()) {
+        for (const auto& subscriber : subscribers) {
+            subscriber(updates);
+        }
+    }
+    return updates.size();
+}
@@ -0,0 +1,71 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BookAnalytics.h"
+
+class Exchange;
+
+/**
+ * @struct AnalyticsUpdate
+ * @brief The analytics of one book at publication time.
+ */
+struct AnalyticsUpdate {
+    std::string ticker;
+    BookAnalytics analytics;
+};
+
+/**
+ * @class AnalyticsStream
+ * @brief Publishes the analytics of the books of an exchange at a low, fixed rate. Each publication
+ *        only carries the books whose analytics changed since the previous one. The stream is polled
+ *        from the thread that mutates the books, so reading them needs no synchronization.
+ */
+class AnalyticsStream {
+public:
+    using Subscriber = std::function<void(const std::vector<AnalyticsUpdate>&)>;
+
+    AnalyticsStream(const Exchange& exchange, std::chrono::milliseconds interval);
+
+    void subscribe(Subscriber subscriber);
+    size_t poll(std::chrono::steady_clock::time_point now);
+
+private:
+    /// the exchange whose books are published
+    const Exchange& exchange;
+    /// minimum time between two publications
+    std::chrono::milliseconds interval;
+    /// time of the last publication
+    std::optional<std::chrono::steady_clock::time_point> lastPublication;
+    /// analytics version of each book at its last publication
+    std::unordered_map<std::string, uint64_t> publishedVersions;
+    std::vector<Subscriber> subscribers;
+};
@@ -0,0 +1,504 @@
+#include "ArrowExport.h"
+#include "Exchange.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr char arrowMagic[6] = {'A', 'R', 'R', 'O', 'W', '1'};
+constexpr uint32_t continuationMarker = 0xFFFFFFFF;
+/// MetadataVersion::V5
+constexpr int16_t metadataVersion = 4;
+/// MessageHeader union members
+constexpr uint8_t messageHeaderSchema = 1;
+constexpr uint8_t messageHeaderRecordBatch = 3;
+/// Type union members
+constexpr uint8_t typeInt = 2;
+constexpr uint8_t typeUtf8 = 5;
+/// alignment of the buffers of a record batch body, as recommended by the Arrow format
+constexpr size_t bodyAlignment = 64;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @class FlatBufferBuilder
+ * @brief Builds the few flatbuffers of the Arrow metadata front to back: parents are written before
+ *        their children and their offset slots are patched once the children are placed, which keeps
+ *        every offset pointing forward as flatbuffers requires.
+ */
+class FlatBufferBuilder {
+public:
+    std::vector<uint8_t> bytes;
+
+    FlatBufferBuilder() : bytes(4, 0) {}
+
+    void pad(size_t alignment) {
+        bytes.resize(alignUp(bytes.size(), alignment), 0);
+    }
+
+    template<typename T>
+    void write(T value) {
+        const size_t position = bytes.size();
+        bytes.resize(position + sizeof(T));
+        std::memcpy(bytes.data() + position, &value, sizeof(T));
+    }
+
+    void patch(size_t slot, size_t target) {
+        const uint32_t relative = static_cast<uint32_t>(target - slot);
+        std::memcpy(bytes.data() + slot, &relative, sizeof(relative));
+    }
+
+    size_t string(const std::string& value) {
+        pad(4);
+        const size_t position = bytes.size();
+        write(static_cast<uint32_t>(value.size()));
+        bytes.insert(bytes.end(), value.begin(), value.end());
+        bytes.push_back(0);
+        return position;
+    }
+
+    // a vector of structs, whose elements must be 8 byte aligned
+    size_t structVector(const void* data, size_t count, size_t elementSize) {
+        while ((bytes.size() + 4) % 8 != 0) {
+            bytes.push_back(0);
+        }
+        const size_t position = bytes.size();
+        write(static_cast<uint32_t>(count));
+        const auto* begin = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), begin, begin + count * elementSize);
+        return position;
+    }
+
+    // a vector of offsets, element i is patched at the returned position + 4 + 4 * i
+    size_t offsetVector(size_t count) {
+        pad(4);
+        const size_t position = bytes.size();
+        write(static_cast<uint32_t>(count));
+        bytes.resize(bytes.size() + 4 * count, 0);
+        return position;
+    }
+
+    void finish(size_t root) {
+        patch(0, root);
+        pad(8);
+    }
+};
+
+/**
+ * @class TableBuilder
+ * @brief Collects the fields of a flatbuffer table and writes its vtable followed by the table.
+ */
+class TableBuilder {
+public:
+    explicit TableBuilder(FlatBufferBuilder& builder) : builder(builder) {}
+
+    template<typename T>
+    void scalar(uint16_t id, T value) {
+        Field field{id, sizeof(T), false, {}, 0};
+        std::memcpy(field.value, &value, sizeof(T));
+        fields.push_back(field);
+    }
+
+    void offset(uint16_t id) {
+        fields.push_back({id, 4, true, {}, 0});
+    }
+
+    /**
+     * @brief Writes the vtable and the table, the table starting on an 8 byte boundary so that the
+     *        natural alignment of its fields holds in the whole buffer.
+     * @return The position of the table.
+     */
+    size_t finish() {
+        uint16_t slots = 0;
+        size_t size = 4;
+        for (Field& field : fields) {
+            slots = std::max<uint16_t>(slots, field.id + 1);
+            size = alignUp(size, field.size);
+            field.position = size;
+            size += field.size;
+        }
+        size = alignUp(size, 4);
+        const size_t vtableSize = 4 + 2 * size_t{slots};
+        while ((builder.bytes.size() + vtableSize) % 8 != 0) {
+            builder.bytes.push_back(0);
+        }
+
+        const size_t vtable = builder.bytes.size();
+        builder.write(static_cast<uint16_t>(vtableSize));
+        builder.write(static_cast<uint16_t>(size));
+        std::vector<uint16_t> slotOffsets(slots, 0);
+        for (const Field& field : fields) {
+            slotOffsets[field.id] = static_cast<uint16_t>(field.position);
+        }
+        for (uint16_t slotOffset : slotOffsets) {
+            builder.write(slotOffset);
+        }
+
+        table = builder.bytes.size();
+        builder.write(static_cast<int32_t>(table - vtable));
+        builder.bytes.resize(table + size, 0);
+        for (const Field& field : fields) {
+            if (!field.isOffset) {
+                std::memcpy(builder.bytes.data() + table + field.position, field.value, field.size);
+            }
+        }
+        return table;
+    }
+
+    // the position of the offset slot of a field, once the table is written
+    size_t slot(uint16_t id) const {
+        for (const Field& field : fields) {
+            if (field.id == id) {
+                return table + field.position;
+            }
+        }
+        throw std::logic_error("No such field in the flatbuffer table.");
+    }
+
+private:
+    struct Field {
+        uint16_t id;
+        size_t size;
+        bool isOffset;
+        uint8_t value[8];
+        size_t position;
+    };
+
+    FlatBufferBuilder& builder;
+    std::vector<Field> fields;
+    size_t table = 0;
+};
+
+/**
+ * @struct Column
+ * @brief A column of the level 3 schema: its name and its Arrow type, utf8 or a signed integer.
+ */
+struct Column {
+    const char* name;
+    uint8_t type;
+    int32_t bitWidth;
+};
+
+constexpr Column columns[] = {
+    {"ticker", typeUtf8, 0},
+    {"order_id", typeInt, 64},
+    {"side", typeInt, 8},
+    {"price", typeInt, 32},
+    {"shares", typeInt, 32},
+    {"queue_position", typeInt, 32},
+    {"entry_time", typeInt, 32},
+    {"event_time", typeInt, 32},
+};
+
+// Schema { endianness, fields: [Field] }
+size_t writeSchema(FlatBufferBuilder& builder) {
+    TableBuilder schema(builder);
+    schema.scalar<int16_t>(0, 0);
+    schema.offset(1);
+    const size_t table = schema.finish();
+
+    const size_t fields = builder.offsetVector(std::size(columns));
+    builder.patch(schema.slot(1), fields);
+    for (size_t i = 0; i < std::size(columns); ++i) {
+        // Field { name, nullable, type_type, type, children }
+        TableBuilder field(builder);
+        field.offset(0);
+        field.scalar<uint8_t>(1, 0);
+        field.scalar<uint8_t>(2, columns[i].type);
+        field.offset(3);
+        field.offset(5);
+        builder.patch(fields + 4 + 4 * i, field.finish());
+
+        builder.patch(field.slot(0), builder.string(columns[i].name));
+        TableBuilder type(builder);
+        if (columns[i].type == typeInt) {
+            type.scalar<int32_t>(0, columns[i].bitWidth);
+            type.scalar<uint8_t>(1, 1);
+        }
+        builder.patch(field.slot(3), type.finish());
+        builder.patch(field.slot(5), builder.offsetVector(0));
+    }
+    return table;
+}
+
+/**
+ * @struct FieldNode
+ * @brief The FieldNode struct of a record batch.
+ */
+struct FieldNode {
+    int64_t length;
+    int64_t nullCount;
+};
+
+/**
+ * @struct BodyBuffer
+ * @brief The Buffer struct of a record batch, with the memory it describes.
+ */
+struct BodyBuffer {
+    int64_t offset;
+    int64_t length;
+};
+
+/**
+ * @struct Block
+ * @brief The Block struct of the file footer, locating a record batch message.
+ */
+struct Block {
+    int64_t offset;
+    int32_t metaDataLength;
+    int32_t padding;
+    int64_t bodyLength;
+};
+
+// Message { version, header_type, header, bodyLength } with its header written by the callback
+template<typename Header>
+std::vector<uint8_t> buildMessage(uint8_t headerType, int64_t bodyLength, Header&& writeHeader) {
+    FlatBufferBuilder builder;
+    TableBuilder message(builder);
+    message.scalar<int16_t>(0, metadataVersion);
+    message.scalar<uint8_t>(1, headerType);
+    message.offset(2);
+    message.scalar<int64_t>(3, bodyLength);
+    const size_t table = message.finish();
+    builder.patch(message.slot(2), writeHeader(builder));
+    builder.finish(table);
+    return std::move(builder.bytes);
+}
+
+/**
+ * @class ArrowFileWriter
+ * @brief Writes the messages of an Arrow IPC file and keeps the blocks for its footer.
+ */
+class ArrowFileWriter {
+public:
+    explicit ArrowFileWriter(const std::string& path) : file(path, std::ios::binary | std::ios::trunc), position(0) {
+        if (!file) {
+            throw std::runtime_error("Can't create Arrow file " + path);
+        }
+        write(arrowMagic, sizeof(arrowMagic));
+        writeZeros(2);
+    }
+
+    // writes an encapsulated message: continuation marker, metadata length, metadata, then the body
+    size_t writeMessage(const std::vector<uint8_t>& metadata) {
+        const size_t offset = position;
+        const int32_t length = static_cast<int32_t>(metadata.size());
+        write(&continuationMarker, sizeof(continuationMarker));
+        write(&length, sizeof(length));
+        write(metadata.data(), metadata.size());
+        return offset;
+    }
+
+    void write(const void* data, size_t size) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        position += size;
+    }
+
+    void writeZeros(size_t size) {
+        static constexpr char zeros[bodyAlignment] = {};
+        while (size > 0) {
+            const size_t chunk = std::min(size, sizeof(zeros));
+            write(zeros, chunk);
+            size -= chunk;
+        }
+    }
+
+    void close() {
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Can't write Arrow file.");
+        }
+    }
+
+    std::ofstream file;
+    size_t position;
+    std::vector<Block> blocks;
+};
+
+/**
+ * @brief Writes the rows [begin, end) of a book as one record batch. The integer columns are
+ *        written straight from the snapshot; only the ticker column is generated.
+ */
+void writeRecordBatch(ArrowFileWriter& writer, const Level3Snapshot& snapshot, const std::string& ticker,
+                      size_t begin, size_t end) {
+    const size_t rows = end - begin;
+    std::vector<int32_t> tickerOffsets(rows + 1);
+    for (size_t i = 0; i <= rows; ++i) {
+        tickerOffsets[i] = static_cast<int32_t>(i * ticker.size());
+    }
+    std::string tickerData;
+    tickerData.reserve(rows * ticker.size());
+    for (size_t i = 0; i < rows; ++i) {
+        tickerData += ticker;
+    }
+
+    // validity buffers are empty as no column has nulls
+    const std::pair<const void*, size_t> data[] = {
+        {nullptr, 0},
+        {tickerOffsets.data(), tickerOffsets.size() * sizeof(int32_t)},
+        {tickerData.data(), tickerData.size()},
+        {nullptr, 0},
+        {snapshot.orderIds.data() + begin, rows * sizeof(int64_t)},
+        {nullptr, 0},
+        {snapshot.sides.data() + begin, rows * sizeof(int8_t)},
+        {nullptr, 0},
+        {snapshot.prices.data() + begin, rows * sizeof(int32_t)},
+        {nullptr, 0},
+        {snapshot.shares.data() + begin, rows * sizeof(int32_t)},
+        {nullptr, 0},
+        {snapshot.queuePositions.data() + begin, rows * sizeof(int32_t)},
+        {nullptr, 0},
+        {snapshot.entryTimes.data() + begin, rows * sizeof(int32_t)},
+        {nullptr, 0},
+        {snapshot.eventTimes.data() + begin, rows * sizeof(int32_t)},
+    };
+    std::vector<BodyBuffer> buffers;
+    int64_t bodyLength = 0;
+    for (const auto& [pointer, size] : data) {
+        buffers.push_back({bodyLength, static_cast<int64_t>(size)});
+        bodyLength += static_cast<int64_t>(alignUp(size, bodyAlignment));
+    }
+    const std::vector<FieldNode> nodes(std::size(columns), FieldNode{static_cast<int64_t>(rows), 0});
+
+    const std::vector<uint8_t> metadata = buildMessage(messageHeaderRecordBatch, bodyLength, [&](FlatBufferBuilder& builder) {
+        // RecordBatch { length, nodes: [FieldNode], buffers: [Buffer] }
+        TableBuilder batch(builder);
+        batch.scalar<int64_t>(0, static_cast<int64_t>(rows));
+        batch.offset(1);
+        batch.offset(2);
+        const size_t table = batch.finish();
+        builder.patch(batch.slot(1), builder.structVector(nodes.data(), nodes.size(), sizeof(FieldNode)));
+        builder.patch(batch.slot(2), builder.structVector(buffers.data(), buffers.size(), sizeof(BodyBuffer)));
+        return table;
+    });
+
+    const size_t offset = writer.writeMessage(metadata);
+    for (const auto& [pointer, size] : data) {
+        writer.write(pointer, size);
+        writer.writeZeros(alignUp(size, bodyAlignment) - size);
+    }
+    writer.blocks.push_back({static_cast<int64_t>(offset), static_cast<int32_t>(metadata.size() + 8), 0, bodyLength});
+}
+
+} // namespace
+
+void Level3Snapshot::clear() {
+    books.clear();
+    orderIds.clear();
+    sides.clear();
+    prices.clear();
+    shares.clear();
+    queuePositions.clear();
+    entryTimes.clear();
+    eventTimes.clear();
+}
+
+void Level3Snapshot::reserve(size_t orders) {
+    orderIds.reserve(orders);
+    sides.reserve(orders);
+    prices.reserve(orders);
+    shares.reserve(orders);
+    queuePositions.reserve(orders);
+    entryTimes.reserve(orders);
+    eventTimes.reserve(orders);
+}
+
+namespace {
+
+template<typename Iterator>
+void captureSide(Iterator begin, Iterator end, int8_t side, Level3Snapshot& snapshot) {
+    for (auto level = begin; level != end; ++level) {
+        int32_t queuePosition = 0;
+        for (const Order* order = level->second->getHeadOrder(); order; order = order->getNextOrder()) {
+            snapshot.orderIds.push_back(order->getOrderId());
+            snapshot.sides.push_back(side);
+            snapshot.prices.push_back(order->getLimit());
+            snapshot.shares.push_back(order->getShares());
+            snapshot.queuePositions.push_back(queuePosition++);
+            snapshot.entryTimes.push_back(order->getEntryTime());
+            snapshot.eventTimes.push_back(order->getEventTime());
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Appends every resting order of a book to a snapshot. This only copies the orders into the
+ *        columns, so the thread that owns the book is held for as little as possible; the snapshot
+ *        can then be written by any other thread.
+ * @param book The book.
+ * @param ticker The ticker written in the rows of the book.
+ * @param snapshot The snapshot to append to.
+ */
+void captureLevel3(const Book& book, const std::string& ticker, Level3Snapshot& snapshot) {
+    const size_t begin = snapshot.size();
+    snapshot.reserve(begin + book.getAllOrders()->size());
+    const auto& bids = book.getBuySide()->getSideTree();
+    const auto& asks = book.getSellSide()->getSideTree();
+    captureSide(bids.rbegin(), bids.rend(), 0, snapshot);
+    captureSide(asks.begin(), asks.end(), 1, snapshot);
+    snapshot.books.push_back({ticker, begin, snapshot.size()});
+}
+
+/**
+ * @brief Appends every resting order of every book of an exchange to a snapshot, book by book.
+ *        Like the other readers of the exchange it must not run while the books are mutated.
+ * @param exchange The exchange.
+ * @param snapshot The snapshot to append to.
+ */
+void captureLevel3(const Exchange& exchange, Level3Snapshot& snapshot) {
+    for (const std::string& ticker : exchange.getTickerList()) {
+        captureLevel3(*exchange.getOrderBook(ticker), ticker, snapshot);
+    }
+}
+
+/**
+ * @brief Writes a snapshot as an Arrow IPC file (the random access format, readable by pyarrow,
+ *        polars or DuckDB without conversion). Each book is written as one record batch, or several
+ *        of at most arrowMaxBatchRows rows, and every column buffer is padded to 64 bytes.
+ * @param snapshot The snapshot.
+ * @param path The path of the file, truncated if it exists.
+ * @return The number of rows, record batches and bytes written.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+ArrowExportStats writeArrowIpc(const Level3Snapshot& snapshot, const std::string& path) {
+    ArrowFileWriter writer(path);
+    const auto schemaMessage = buildMessage(messageHeaderSchema, 0, [](FlatBufferBuilder& builder) { return writeSchema(builder); });
+    writer.writeMessage(schemaMessage);
+
+    for (const Level3BookRange& book : snapshot.books) {
+        for (size_t begin = book.begin; begin < book.end; begin += arrowMaxBatchRows) {
+            writeRecordBatch(writer, snapshot, book.ticker, begin, std::min(book.end, begin + arrowMaxBatchRows));
+        }
+    }
+    const uint32_t endOfStream[2] = {continuationMarker, 0};
+    writer.write(endOfStream, sizeof(endOfStream));
+
+    // Footer { version, schema, dictionaries, recordBatches: [Block] }
+    FlatBufferBuilder builder;
+    TableBuilder footer(builder);
+    footer.scalar<int16_t>(0, metadataVersion);
+    footer.offset(1);
+    footer.offset(3);
+    const size_t table = footer.finish();
+    builder.patch(footer.slot(1), writeSchema(builder));
+    builder.patch(footer.slot(3), builder.structVector(writer.blocks.data(), writer.blocks.size(), sizeof(Block)));
+    builder.finish(table);
+    const int32_t footerLength = static_cast<int32_t>(builder.bytes.size());
+    writer.write(builder.bytes.data(), builder.bytes.size());
+    writer.write(&footerLength, sizeof(footerLength));
+    writer.write(arrowMagic, sizeof(arrowMagic));
+    writer.close();
+
+    ArrowExportStats stats;
+    stats.rows = snapshot.size();
+    stats.recordBatches = writer.blocks.size();
+    stats.bytes = writer.position;
+    return stats;
+}
@@ -0,0 +1,90 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Book.h"
+
+class Exchange;
+
+/**
+ * @struct Level3BookRange
+ * @brief The rows of one book in a level 3 snapshot.
+ */
+struct Level3BookRange {
+    std::string ticker;
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * @struct Level3Snapshot
+ * @brief Every resting order of one or more books, stored by column so that the Arrow writer can
+ *        write each column with a single copy. Rows of a book are ordered by side, buy first, then
+ *        from the best price to the worst and in time priority within a level.
+ */
+struct Level3Snapshot {
+    std::vector<Level3BookRange> books;
+    std::vector<int64_t> orderIds;
+    /// 0 for buy orders, 1 for sell orders
+    std::vector<int8_t> sides;
+    /// limit prices in cents
+    std::vector<int32_t> prices;
+    std::vector<int32_t> shares;
+    /// position in the queue of the level, 0 for the order executed first
+    std::vector<int32_t> queuePositions;
+    std::vector<int32_t> entryTimes;
+    std::vector<int32_t> eventTimes;
+
+    size_t size() const {
+        return orderIds.size();
+    }
+
+    void clear();
+    void reserve(size_t orders);
+};
+
+/**
+ * @struct ArrowExportStats
+ * @brief What an Arrow export wrote.
+ */
+struct ArrowExportStats {
+    uint64_t rows = 0;
+    uint64_t recordBatches = 0;
+    uint64_t bytes = 0;
+};
+
+/// rows of a record batch, larger books are split in several batches
+constexpr size_t arrowMaxBatchRows = size_t{1} << 20;
+
+// appends every resting order of a book to a snapshot, on the thread that owns the book
+void captureLevel3(const Book& book, const std::string& ticker, Level3Snapshot& snapshot);
+// appends every resting order of every book of an exchange to a snapshot
+void captureLevel3(const Exchange& exchange, Level3Snapshot& snapshot);
+// writes a snapshot as an Arrow IPC file, one record batch per book or part of a book
+ArrowExportStats writeArrowIpc(const Level3Snapshot& snapshot, const std::string& path);
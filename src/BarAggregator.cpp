@@ -0,0 +1,124 @@
+#include "BarAggregator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Registers a new instrument.
+ * @return The index of the instrument, used to tag its fills and bars.
+ */
+uint32_t BarAggregator::addInstrument() {
+    const auto instrument = static_cast<uint32_t>(totals.size());
+    openBars.resize(openBars.size() + barResolutions.size(), OpenBar{});
+    totals.emplace_back();
+    fillSinks.push_back(std::make_unique<InstrumentFillSink>(*this, instrument));
+    return instrument;
+}
+
+/**
+ * @brief Returns a fill sink feeding the given instrument, to be registered on its book.
+ * @param instrument The index of the instrument.
+ * @return The fill sink, valid as long as the aggregator.
+ * @throws std::out_of_range if the instrument was not added.
+ */
+FillSink& BarAggregator::getFillSink(uint32_t instrument) {
+    return *fillSinks.at(instrument);
+}
+
+/**
+ * @brief Registers a sink for the completed bars. The sink must outlive the aggregator.
+ * @param sink The sink.
+ */
+void BarAggregator::addBarSink(BarSink* sink) {
+    barSinks.push_back(sink);
+}
+
+/**
+ * @brief Adds a fill to the open bars of an instrument. A fill belonging to a later period than an
+ *        open bar completes that bar first, so bars also roll without timer ticks.
+ * @param instrument The index of the instrument.
+ * @param fill The fill.
+ */
+void BarAggregator::onFill(uint32_t instrument, const Fill& fill) {
+    const int64_t notional = static_cast<int64_t>(fill.price) * fill.shares;
+
+    TradingTotals& total = totals[instrument];
+    total.volume += fill.shares;
+    total.notional += notional;
+    ++total.trades;
+
+    OpenBar* bars = &openBars[instrument * barResolutions.size()];
+    for (size_t i = 0; i < barResolutions.size(); ++i) {
+        OpenBar& bar = bars[i];
+        const int64_t start = fill.eventTime - fill.eventTime % barResolutions[i];
+
+        // a late fill is folded into the open bar rather than reopening a completed period
+        if (bar.trades != 0 && start > bar.start) {
+            emit(instrument, barResolutions[i], bar);
+        }
+        if (bar.trades == 0) {
+            bar = OpenBar{start, fill.price, fill.price, fill.price, fill.price, 0, 0, 0};
+        }
+        bar.high = std::max(bar.high, fill.price);
+        bar.low = std::min(bar.low, fill.price);
+        bar.close = fill.price;
+        bar.volume += fill.shares;
+        bar.notional += notional;
+        ++bar.trades;
+    }
+}
+
+/**
+ * @brief Completes every open bar whose period ended at or before the given time.
+ * @param now The current time, in seconds.
+ * @return The number of bars completed.
+ */
+size_t BarAggregator::onTimer(int64_t now) {
+    size_t completed = 0;
+    for (size_t index = 0; index < openBars.size(); ++index) {
+        OpenBar& bar = openBars[index];
+        const uint32_t resolution = barResolutions[index % barResolutions.size()];
+        if (bar.trades != 0 && bar.start + resolution <= now) {
+            emit(static_cast<uint32_t>(index / barResolutions.size()), resolution, bar);
+            ++completed;
+        }
+    }
+    return completed;
+}
+
+/**
+ * @brief Returns the running totals of an instrument.
+ * @param instrument The index of the instrument.
+ * @return The totals.
+ * @throws std::out_of_range if the instrument was not added.
+ */
+const TradingTotals& BarAggregator::getTotals(uint32_t instrument) const {
+    return totals.at(instrument);
+}
+
+/**
+ * @brief Returns the number of instruments added to the aggregator.
+ * @return The number of instruments.
+ */
+size_t BarAggregator::getInstrumentCount() const {
+    return totals.size();
+}
+
+/**
+ * @brief Hands a completed bar to the sinks and marks it closed.
+ */
+void BarAggregator::emit(uint32_t instrument, uint32_t resolution, OpenBar& bar) {
+    const Bar completed{instrument, resolution, bar.start, bar.open, bar.high, bar.low, bar.close,
+                        bar.volume, bar.notional, bar.trades};
+    for (BarSink* sink : barSinks) {
+        sink->onBar(completed);
+    }
+    bar.trades = 0;
+}
+
+BarAggregator::InstrumentFillSink::InstrumentFillSink(BarAggregator& aggregator, uint32_t instrument)
+    : aggregator(aggregator), instrument(instrument) {}
+
+void BarAggregator::InstrumentFillSink::onFill(const Fill& fill) {
+    aggregator.onFill(instrument, fill);
+}
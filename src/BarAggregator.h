@@ -0,0 +1,142 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "Fill.h"
+
+/**
+ * @struct Bar
+ * @brief An OHLCV bar of one instrument over one period. Prices and notional are in cents.
+ */
+struct Bar {
+    /// index of the instrument in the aggregator
+    uint32_t instrument;
+    /// length of the period, in seconds
+    uint32_t resolution;
+    /// start of the period, in seconds
+    int64_t start;
+    int open;
+    int high;
+    int low;
+    int close;
+    /// shares traded during the period
+    int64_t volume;
+    /// sum of price * shares of the fills of the period, so vwap = notional / volume
+    int64_t notional;
+    /// number of fills in the period
+    uint32_t trades;
+};
+
+/**
+ * @class BarSink
+ * @brief Receives the bars completed by a BarAggregator.
+ */
+class BarSink {
+public:
+    virtual ~BarSink() = default;
+    virtual void onBar(const Bar& bar) = 0;
+};
+
+/**
+ * @struct TradingTotals
+ * @brief Running totals of the fills of an instrument since it was added to the aggregator.
+ */
+struct TradingTotals {
+    int64_t volume = 0;
+    int64_t notional = 0;
+    uint64_t trades = 0;
+
+    /**
+     * @brief Returns the volume weighted average price, in cents.
+     * @return The vwap, empty if nothing traded.
+     */
+    std::optional<double> vwap() const {
+        return volume == 0 ? std::nullopt : std::optional<double>(static_cast<double>(notional) / static_cast<double>(volume));
+    }
+};
+
+/// bar resolutions maintained for every instrument, in seconds
+constexpr std::array<uint32_t, 2> barResolutions = {1, 60};
+
+/**
+ * @class BarAggregator
+ * @brief Builds OHLCV bars and running VWAP totals from the fill streams of many instruments.
+ *        The open bars of all instruments live in one flat array, so a fill touches a single cache
+ *        line per resolution and closing bars on a timer is a linear scan. Nothing is allocated
+ *        after the instruments have been added. Fills and timer ticks must come from the same thread.
+ */
+class BarAggregator {
+public:
+    uint32_t addInstrument();
+    FillSink& getFillSink(uint32_t instrument);
+    void addBarSink(BarSink* sink);
+
+    void onFill(uint32_t instrument, const Fill& fill);
+    size_t onTimer(int64_t now);
+
+    const TradingTotals& getTotals(uint32_t instrument) const;
+    size_t getInstrumentCount() const;
+
+private:
+    /**
+     * @brief The bar being built for one instrument and resolution. trades == 0 means no open bar.
+     */
+    struct OpenBar {
+        int64_t start;
+        int open;
+        int high;
+        int low;
+        int close;
+        int64_t volume;
+        int64_t notional;
+        uint32_t trades;
+    };
+
+    /**
+     * @brief Forwards the fills of one book to the aggregator, tagged with the instrument index.
+     */
+    class InstrumentFillSink : public FillSink {
+    public:
+        InstrumentFillSink(BarAggregator& aggregator, uint32_t instrument);
+        void onFill(const Fill& fill) override;
+
+    private:
+        BarAggregator& aggregator;
+        uint32_t instrument;
+    };
+
+    void emit(uint32_t instrument, uint32_t resolution, OpenBar& bar);
+
+    /// open bars, barResolutions.size() consecutive entries per instrument
+    std::vector<OpenBar> openBars;
+    std::vector<TradingTotals> totals;
+    std::vector<std::unique_ptr<InstrumentFillSink>> fillSinks;
+    std::vector<BarSink*> barSinks;
+};
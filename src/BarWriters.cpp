@@ -0,0 +1,186 @@
+#include "BarWriters.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+template<typename T>
+void writeColumn(std::ofstream& file, const std::vector<T>& column) {
+    file.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(T)));
+}
+
+template<typename T>
+void readColumn(std::ifstream& file, std::vector<Bar>& bars, size_t first, T Bar::*field) {
+    std::vector<T> column(bars.size() - first);
+    file.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(T)));
+    for (size_t i = 0; i < column.size(); ++i) {
+        bars[first + i].*field = column[i];
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Creates the file and writes its magic.
+ * @param path The path of the file, truncated if it exists.
+ * @param blockRows Number of bars buffered before a block is written.
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+ColumnarBarWriter::ColumnarBarWriter(const std::string& path, size_t blockRows)
+    : file(path, std::ios::binary | std::ios::trunc), blockRows(blockRows), barsWritten(0) {
+    if (!file) {
+        throw std::runtime_error("Can't open bar file " + path);
+    }
+    file.write(magic, sizeof(magic));
+
+    instrument.reserve(blockRows);
+    resolution.reserve(blockRows);
+    start.reserve(blockRows);
+    open.reserve(blockRows);
+    high.reserve(blockRows);
+    low.reserve(blockRows);
+    close.reserve(blockRows);
+    volume.reserve(blockRows);
+    notional.reserve(blockRows);
+    trades.reserve(blockRows);
+}
+
+/**
+ * @brief Writes the bars still buffered.
+ */
+ColumnarBarWriter::~ColumnarBarWriter() {
+    flush();
+}
+
+/**
+ * @brief Buffers a bar, writing a block when the buffer is full.
+ * @param bar The completed bar.
+ */
+void ColumnarBarWriter::onBar(const Bar& bar) {
+    instrument.push_back(bar.instrument);
+    resolution.push_back(bar.resolution);
+    start.push_back(bar.start);
+    open.push_back(bar.open);
+    high.push_back(bar.high);
+    low.push_back(bar.low);
+    close.push_back(bar.close);
+    volume.push_back(bar.volume);
+    notional.push_back(bar.notional);
+    trades.push_back(bar.trades);
+
+    if (instrument.size() == blockRows) {
+        flush();
+    }
+}
+
+/**
+ * @brief Writes the buffered bars as one block. Clearing keeps the capacity of the columns.
+ */
+void ColumnarBarWriter::flush() {
+    if (instrument.empty()) {
+        return;
+    }
+
+    const auto rows = static_cast<uint32_t>(instrument.size());
+    file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    writeColumn(file, instrument);
+    writeColumn(file, resolution);
+    writeColumn(file, start);
+    writeColumn(file, open);
+    writeColumn(file, high);
+    writeColumn(file, low);
+    writeColumn(file, close);
+    writeColumn(file, volume);
+    writeColumn(file, notional);
+    writeColumn(file, trades);
+    file.flush();
+    barsWritten += rows;
+
+    instrument.clear();
+    resolution.clear();
+    start.clear();
+    open.clear();
+    high.clear();
+    low.clear();
+    close.clear();
+    volume.clear();
+    notional.clear();
+    trades.clear();
+}
+
+/**
+ * @brief Returns the number of bars written to the file, excluding the ones still buffered.
+ * @return The number of bars.
+ */
+uint64_t ColumnarBarWriter::getBarsWritten() const {
+    return barsWritten;
+}
+
+/**
+ * @brief Reads back every bar of a file written by ColumnarBarWriter.
+ * @param path The path of the file.
+ * @return The bars, in the order they were written.
+ * @throws std::runtime_error if the file cannot be opened or is not a bar file.
+ */
+std::vector<Bar> readColumnarBars(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char header[sizeof(ColumnarBarWriter::magic)];
+    if (!file.read(header, sizeof(header)) || !std::equal(header, header + sizeof(header), ColumnarBarWriter::magic)) {
+        throw std::runtime_error("Not a bar file: " + path);
+    }
+
+    std::vector<Bar> bars;
+    uint32_t rows;
+    while (file.read(reinterpret_cast<char*>(&rows), sizeof(rows))) {
+        const size_t first = bars.size();
+        bars.resize(first + rows);
+        readColumn(file, bars, first, &Bar::instrument);
+        readColumn(file, bars, first, &Bar::resolution);
+        readColumn(file, bars, first, &Bar::start);
+        readColumn(file, bars, first, &Bar::open);
+        readColumn(file, bars, first, &Bar::high);
+        readColumn(file, bars, first, &Bar::low);
+        readColumn(file, bars, first, &Bar::close);
+        readColumn(file, bars, first, &Bar::volume);
+        readColumn(file, bars, first, &Bar::notional);
+        readColumn(file, bars, first, &Bar::trades);
+        if (!file) {
+            throw std::runtime_error("Truncated bar file: " + path);
+        }
+    }
+    return bars;
+}
+
+/**
+ * @brief Creates the shared memory ring the bars are published to.
+ * @param name Name of the shared memory object, starting with '/'.
+ * @param capacity Number of bars the ring can hold, a power of two.
+ */
+SharedMemoryBarSink::SharedMemoryBarSink(const std::string& name, size_t capacity)
+    : ring(SharedMemoryRing<Bar>::create(name, capacity)) {}
+
+/**
+ * @brief Removes the name of the ring. Consumers that already mapped it can still drain it.
+ */
+SharedMemoryBarSink::~SharedMemoryBarSink() {
+    SharedMemoryRing<Bar>::unlink(ring.getName());
+}
+
+/**
+ * @brief Publishes a bar, dropping it if the consumer is too far behind.
+ * @param bar The completed bar.
+ */
+void SharedMemoryBarSink::onBar(const Bar& bar) {
+    if (!ring.tryPush(bar)) {
+        dropped.increment();
+    }
+}
+
+/**
+ * @brief Returns the number of bars dropped because the ring was full.
+ * @return The number of dropped bars.
+ */
+uint64_t SharedMemoryBarSink::getDropped() const {
+    return dropped.get();
+}
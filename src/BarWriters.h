@@ -0,0 +1,94 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "BarAggregator.h"
+#include "Metrics.h"
+#include "SharedMemoryRing.hpp"
+
+/**
+ * @class ColumnarBarWriter
+ * @brief Writes bars to a file in column-major blocks: after an 8 byte "BARS0001" magic, each block
+ *        holds a uint32 row count followed by one contiguous array per Bar field, in declaration order.
+ *        The column buffers are sized once, so writing a bar is a few stores until a block is full.
+ */
+class ColumnarBarWriter : public BarSink {
+public:
+    static constexpr char magic[8] = {'B', 'A', 'R', 'S', '0', '0', '0', '1'};
+
+    explicit ColumnarBarWriter(const std::string& path, size_t blockRows = 4096);
+    ~ColumnarBarWriter() override;
+
+    void onBar(const Bar& bar) override;
+    void flush();
+
+    uint64_t getBarsWritten() const;
+
+    ColumnarBarWriter(const ColumnarBarWriter&) = delete;
+    ColumnarBarWriter& operator=(const ColumnarBarWriter&) = delete;
+
+private:
+    std::ofstream file;
+    size_t blockRows;
+    uint64_t barsWritten;
+
+    std::vector<uint32_t> instrument;
+    std::vector<uint32_t> resolution;
+    std::vector<int64_t> start;
+    std::vector<int> open;
+    std::vector<int> high;
+    std::vector<int> low;
+    std::vector<int> close;
+    std::vector<int64_t> volume;
+    std::vector<int64_t> notional;
+    std::vector<uint32_t> trades;
+};
+
+// reads back every bar of a file written by ColumnarBarWriter
+std::vector<Bar> readColumnarBars(const std::string& path);
+
+/**
+ * @class SharedMemoryBarSink
+ * @brief Publishes bars to a shared memory ring, for consumers in other processes. A slow consumer
+ *        never blocks the aggregator: bars that do not fit in the ring are dropped and counted.
+ */
+class SharedMemoryBarSink : public BarSink {
+public:
+    SharedMemoryBarSink(const std::string& name, size_t capacity);
+    ~SharedMemoryBarSink() override;
+
+    void onBar(const Bar& bar) override;
+
+    uint64_t getDropped() const;
+
+private:
+    SharedMemoryRing<Bar> ring;
+    /// bars dropped because the ring was full
+    MetricsCounter dropped;
+};
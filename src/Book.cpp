@@ -1,9 +1,13 @@
 #include "Book.h"
 
+#include <algorithm>
+
 /**
  * @brief Constructor that initializes the buy and sell sides of the order book.
  */
-Book::Book() : sellSide(std::make_unique<LOBSide<Side::Sell>>(*this)), buySide(std::make_unique<LOBSide<Side::Buy>>(*this)) {}
+Book::Book() : sellSide(std::make_unique<LOBSide<Side::Sell>>(*this, metrics, statistics)), buySide(std::make_unique<LOBSide<Side::Buy>>(*this, metrics, statistics)),
+               fillSequence(0), currentEventTime(0), matchingMode(MatchingMode::Continuous),
+               auctionInterval(std::chrono::milliseconds(100)) {}
 
 /**
  * @brief Template function to add an order to the correct side of the order book.
@@ -11,10 +15,11 @@ Book::Book() : sellSide(std::make_unique<LOBSide<Side::Sell>>(*this)), buySide(s
  * @param side Reference to the side of the order book.
  * @param orderData Reference to the order data containing the order details.
  * @param orderIdSequence Reference to the OrderIdSequence for generating a unique order ID.
+ * @return The ID assigned to the order.
  */
 template<Side S>
-void addOrderToSide(LOBSide<S>& side, OrderData orderData, OrderIdSequence& orderIdSequence) {
-    side.addOrderToSide(orderData, orderIdSequence);
+int64_t addOrderToSide(LOBSide<S>& side, OrderData orderData, OrderIdSequence& orderIdSequence) {
+    return side.addOrderToSide(orderData, orderIdSequence);
 }
 
 /**
@@ -32,27 +37,90 @@ void placeMktOrder(LOBSide<S>& side, int volume) {
  * @brief Adds an order to the order book, placing it on the correct side and executing against opposing orders if necessary.
  * @param orderData Reference to the order data containing the order details.
  * @param orderIdSequence Reference to the OrderIdSequence for generating a unique order ID.
+ * @return The ID of the order if a remainder rests in the book, empty if it was completely executed.
+ * @throws std::invalid_argument if the limit price is missing or not positive, or if the order size or minimum quantity is invalid.
+ * @throws std::runtime_error if the order crosses the spread but can't execute its minimum quantity.
  */
-void Book::addOrderToBook(OrderData orderData, OrderIdSequence& orderIdSequence) {
-    
-    Limit* bestLimitOppositeSide = (orderData.orderSide == Side::Buy) ? sellSide->getBestLimit() : buySide->getBestLimit();
+std::optional<int64_t> Book::addOrderToBook(OrderData orderData, OrderIdSequence& orderIdSequence) {
+
+    validateOrder(orderData);
+
+    // In batch auction mode the order rests as it is until the next auction
+    Limit* bestLimitOppositeSide = nullptr;
+    if (matchingMode == MatchingMode::Continuous) {
+        bestLimitOppositeSide = (orderData.orderSide == Side::Buy) ? sellSide->getBestLimit() : buySide->getBestLimit();
+    }
+    auto crosses = [&orderData](const Limit* limit) {
+        return (orderData.orderSide == Side::Buy) ? orderData.limit > limit->getLimitPrice() : orderData.limit < limit->getLimitPrice();
+    };
+
+    metrics.ordersAdded.increment();
+    currentEventTime = orderData.eventTime;
+    int levelsCrossed = 0;
 
     // Check if the new limit order crosses the spread. If so, start executing the order until it stops crossing the spread
-    while (bestLimitOppositeSide &&
-           ((orderData.orderSide == Side::Buy && sellSide && sellSide->getBestLimit() && orderData.limit > sellSide->getBestLimit()->getLimitPrice()) ||
-            (orderData.orderSide == Side::Sell && buySide && buySide->getBestLimit() && orderData.limit < buySide->getBestLimit()->getLimitPrice()))) {
+    while (bestLimitOppositeSide && crosses(bestLimitOppositeSide)) {
         if (orderData.orderSide == Side::Buy) {
             sellSide->executeOrder(orderData.shares, bestLimitOppositeSide);
         } else {
             buySide->executeOrder(orderData.shares, bestLimitOppositeSide);
         }
-        if (!orderData.shares) return; // Exit the loop if the order volume is completely executed
+        ++levelsCrossed;
+        if (!orderData.shares) break; // Exit the loop if the order volume is completely executed
+    }
+
+    if (levelsCrossed) {
+        metrics.sweepDepth.observe(levelsCrossed);
     }
+    if (!orderData.shares) return std::nullopt;
 
     if (orderData.orderSide == Side::Buy) {
-        addOrderToSide(*buySide, orderData, orderIdSequence);
-    } else {
-        addOrderToSide(*sellSide, orderData, orderIdSequence);
+        return addOrderToSide(*buySide, orderData, orderIdSequence);
+    }
+    return addOrderToSide(*sellSide, orderData, orderIdSequence);
+}
+
+/**
+ * @brief Checks that a limit order can enter the book, before it executes against the opposite side.
+ * @param orderData The order data.
+ * @throws std::invalid_argument if the limit price is missing or not positive, or if the order size or minimum quantity is invalid.
+ * @throws std::runtime_error if the order crosses the spread but can't execute its minimum quantity.
+ */
+void Book::validateOrder(const OrderData& orderData) {
+    if (!orderData.limit.has_value()) {
+        metrics.recordReject(RejectReason::MissingLimitPrice);
+        throw std::invalid_argument("Limit price must be provided for limit orders.");
+    }
+    if (orderData.limit.value() <= 0) {
+        metrics.recordReject(RejectReason::InvalidPrice);
+        throw std::invalid_argument("The price must be positive");
+    }
+    if (orderData.shares <= 0) {
+        metrics.recordReject(RejectReason::InvalidSize);
+        throw std::invalid_argument("The order size must be positive");
+    }
+    if (orderData.minQuantity < 0) {
+        metrics.recordReject(RejectReason::InvalidSize);
+        throw std::invalid_argument("The minimum quantity can't be negative");
+    }
+    if (matchingMode != MatchingMode::Continuous) {
+        return;
+    }
+
+    // An order that executes on entry must get its minimum quantity, or all its shares if all-or-none
+    const int minimumExecution = std::min(orderData.minQuantity, orderData.shares);
+    const Limit* bestLimitOppositeSide = (orderData.orderSide == Side::Buy) ? sellSide->getBestLimit() : buySide->getBestLimit();
+    const bool crosses = bestLimitOppositeSide &&
+        ((orderData.orderSide == Side::Buy) ? orderData.limit > bestLimitOppositeSide->getLimitPrice()
+                                            : orderData.limit < bestLimitOppositeSide->getLimitPrice());
+    if (minimumExecution > 1 && crosses) {
+        const int matchable = (orderData.orderSide == Side::Buy)
+            ? sellSide->getMatchableVolume(orderData.shares, orderData.limit.value())
+            : buySide->getMatchableVolume(orderData.shares, orderData.limit.value());
+        if (matchable < minimumExecution) {
+            metrics.recordReject(RejectReason::InsufficientLiquidity);
+            throw std::runtime_error("The order can't execute its minimum quantity against the opposite side.");
+        }
     }
 }
 
@@ -62,15 +130,22 @@ void Book::addOrderToBook(OrderData orderData, OrderIdSequence& orderIdSequence)
  */
 void Book::addOrderToAllOrders(std::unique_ptr<Order> order) {
     allOrders.insert({order->getOrderId(), std::move(order)});
+    metrics.restingOrders.set(allOrders.size());
 }
 
 /**
  * @brief Places a market order, executing it against the existing limit orders on the opposing side.
  * @param volume Volume of the market order.
  * @param orderSide The side of the market order (buy or sell).
+ * @param eventTime Event time of the market order in seconds, stamped on the fills it produces.
  */
-void Book::placeMarketOrder(const int volume, Side orderSide) {
+void Book::placeMarketOrder(const int volume, Side orderSide, int eventTime) {
     
+    if (matchingMode == MatchingMode::BatchAuction) {
+        metrics.recordReject(RejectReason::MissingLimitPrice);
+        throw std::runtime_error("Market orders can't take part in a batch auction, which needs a limit price.");
+    }
+    currentEventTime = eventTime;
     if (orderSide == Side::Buy) {
         placeMktOrder(*sellSide, volume);
     } else {
@@ -93,6 +168,10 @@ void Book::removeOrderFromLimit(Order* orderToCancel) {
     bool isFirstOrder = (nxtOrder && !prevOrder);
     bool isMiddleOrder = (nxtOrder && prevOrder);
 
+    if (!isOnlyOrder) {
+        parent->detachOrder(orderToCancel);
+    }
+
     if (isOnlyOrder) {
         // Order to cancel is the only order in the limit
         if (orderToCancel->getOrderSide() == Side::Buy) {
@@ -118,6 +197,11 @@ void Book::removeOrderFromLimit(Order* orderToCancel) {
     if (!isOnlyOrder) {
         parent->decreaseSize();
         parent->setTotalVolume(parent->getTotalVolume() - orderToCancel->getShares());
+        if (orderToCancel->getOrderSide() == Side::Buy) {
+            buySide->adjustTopDepth(parent->getLimitPrice(), -orderToCancel->getShares());
+        } else {
+            sellSide->adjustTopDepth(parent->getLimitPrice(), -orderToCancel->getShares());
+        }
     }
 }
 
@@ -127,6 +211,7 @@ void Book::removeOrderFromLimit(Order* orderToCancel) {
  */
 void Book::removeOrderFromAllOrders(int64_t orderId) {
     allOrders.erase(orderId);
+    metrics.restingOrders.set(allOrders.size());
 }
 
 /**
@@ -138,12 +223,14 @@ void Book::cancelOrder(int64_t orderId) {
     
     auto pairToCancel = allOrders.find(orderId);
     if (pairToCancel == allOrders.end()) {
+        metrics.recordReject(RejectReason::UnknownOrder);
         throw std::invalid_argument("Invalid order to cancel: the order is not in the Book");
     }
 
     auto orderToCancel = pairToCancel->second.get();
     removeOrderFromLimit(orderToCancel);
-    allOrders.erase(orderId);  // Ensure this happens after the order is fully unlinked
+    removeOrderFromAllOrders(orderId);  // Ensure this happens after the order is fully unlinked
+    metrics.ordersCancelled.increment();
 }
 
 /**
@@ -151,12 +238,15 @@ void Book::cancelOrder(int64_t orderId) {
  * @param orderId ID of the order to be modified.
  * @param newLimitPrice The new limit price for the order.
  * @param orderIdSequence Reference to the OrderIdSequence for generating a new unique order ID.
- * @throws std::invalid_argument if the order ID is not found in the book.
+ * @throws std::invalid_argument if the order ID is not found in the book, or if the new price is not positive.
+ * @throws std::runtime_error if the order would cross the spread but can't execute its minimum quantity.
+ *         A rejected modification leaves the order as it was.
  */
 void Book::modifyOrderLimitPrice(int64_t orderId, float newLimitPrice, OrderIdSequence& orderIdSequence) {
     
     auto it = allOrders.find(orderId);
     if (it == allOrders.end()) {
+        metrics.recordReject(RejectReason::UnknownOrder);
         throw std::invalid_argument("Invalid order to modify: the order is not in the Book");
     }
 
@@ -164,31 +254,245 @@ void Book::modifyOrderLimitPrice(int64_t orderId, float newLimitPrice, OrderIdSe
     auto orderToModify = it->second.get();
 
     OrderData modifiedOrderData = OrderData(orderToModify->getOrderSide(), orderToModify->getShares(), newLimitPrice, orderToModify->getOrderType());
-    
+    modifiedOrderData.minQuantity = orderToModify->getMinQuantity();
+    validateOrder(modifiedOrderData);
+
     // Cancel the order and ensure it does not leave a dangling pointer
     removeOrderFromLimit(orderToModify);
     
-    // Add the modified order back to the book
+    // Add the modified order back to the book, then drop the old one, whose limit may be gone
     addOrderToBook(modifiedOrderData, orderIdSequence);
+    removeOrderFromAllOrders(orderId);
 }
 
 /**
  * @brief Modifies the size (volume) of an order in the order book.
  * @param orderId ID of the order to be modified.
  * @param newSize The new size (volume) for the order.
- * @throws std::invalid_argument if the order ID is not found in the book.
+ * @throws std::invalid_argument if the order ID is not found in the book or the new size is not positive.
  */
 void Book::modifyOrderSize(int64_t orderId, int newSize) {
     auto it = allOrders.find(orderId);
     if (it == allOrders.end()) {
+        metrics.recordReject(RejectReason::UnknownOrder);
         throw std::invalid_argument("Invalid order to modify: the order is not in the Book");
     }
+    if (newSize <= 0) {
+        metrics.recordReject(RejectReason::InvalidSize);
+        throw std::invalid_argument("The order size must be positive");
+    }
     auto orderToModify = it->second.get();
     int oldSize = orderToModify->getShares();
     orderToModify->setShares(newSize);
 
     Limit* parent = orderToModify->getParentLimit();
     parent->setTotalVolume(parent->getTotalVolume() - oldSize + newSize);
+    parent->resizeOrder(orderToModify, oldSize);
+    if (orderToModify->getOrderSide() == Side::Buy) {
+        buySide->adjustTopDepth(parent->getLimitPrice(), newSize - oldSize);
+    } else {
+        sellSide->adjustTopDepth(parent->getLimitPrice(), newSize - oldSize);
+    }
+}
+
+/**
+ * @brief Records that a resting order has been completely filled.
+ */
+void Book::recordOrderFilled() {
+    metrics.ordersFilled.increment();
+}
+
+/**
+ * @brief Publishes the execution of a resting order against the aggressive order being matched.
+ *        During an auction the execution is kept until the other side executed.
+ * @param restingOrder The resting order, before its remaining shares are updated.
+ * @param shares The executed volume.
+ */
+void Book::recordExecution(const Order& restingOrder, int shares) {
+
+    // in an auction both orders rest, so the executions of each side are paired once both executed
+    if (auctionPrice) {
+        (restingOrder.getOrderSide() == Side::Buy ? auctionBuys : auctionSells).emplace_back(restingOrder.getOrderId(), shares);
+        return;
+    }
+    if (fillSinks.empty()) {
+        ++fillSequence;
+        return;
+    }
+    const Side aggressorSide = (restingOrder.getOrderSide() == Side::Buy) ? Side::Sell : Side::Buy;
+    const Fill fill{fillSequence++, restingOrder.getOrderId(), restingOrder.getLimit(), shares, aggressorSide, currentEventTime};
+    for (FillSink* sink : fillSinks) {
+        sink->onFill(fill);
+    }
+}
+
+/**
+ * @brief Switches between continuous matching and periodic batch auctions. Leaving batch auctions
+ *        runs a last auction, so that a continuous book is never crossed.
+ * @param mode The matching mode.
+ * @param auctionInterval The time between two auctions run by uncrossIfDue.
+ */
+void Book::setMatchingMode(MatchingMode mode, std::chrono::milliseconds auctionInterval) {
+    if (matchingMode == MatchingMode::BatchAuction && mode == MatchingMode::Continuous) {
+        uncross(currentEventTime);
+    }
+    if (mode == MatchingMode::BatchAuction && matchingMode != mode) {
+        nextAuction = std::chrono::steady_clock::now() + auctionInterval;
+    }
+    matchingMode = mode;
+    this->auctionInterval = auctionInterval;
+}
+
+/**
+ * @brief Runs a uniform-price auction over the resting orders. The volume that can trade comes
+ *        from a single merge of the demand of the buy levels, best first, with the supply of the
+ *        sell levels, best first, which stops at the first pair of levels that do not cross. Both
+ *        sides then execute that volume level by level in price-time priority, every fill at the
+ *        midpoint of the last buy and sell levels matched, rounded down to the cent. All-or-none and
+ *        minimum quantity orders don't add to the volume, they only take the part of it they accept.
+ * @param eventTime Event time of the auction in seconds, stamped on its fills.
+ * @return The result of the auction.
+ */
+AuctionResult Book::uncross(int eventTime) {
+    AuctionResult result;
+    const auto& bids = buySide->getSideTree();
+    const auto& asks = sellSide->getSideTree();
+    auto bid = bids.rbegin();
+    auto ask = asks.begin();
+    if (bid == bids.rend() || ask == asks.end() || bid->first < ask->first) {
+        return result;
+    }
+
+    auto auctionVolume = [](const Limit& limit) {
+        return limit.getTotalVolume() - limit.getConstrainedVolume();
+    };
+    int bidLeft = auctionVolume(*bid->second);
+    int askLeft = auctionVolume(*ask->second);
+    int lastBid = bid->first;
+    int lastAsk = ask->first;
+    result.buyLevels = 1;
+    result.sellLevels = 1;
+    while (true) {
+        const int shares = std::min(bidLeft, askLeft);
+        result.shares += shares;
+        bidLeft -= shares;
+        askLeft -= shares;
+        if (bidLeft == 0) {
+            if (++bid == bids.rend() || bid->first < ask->first) {
+                break;
+            }
+            bidLeft = auctionVolume(*bid->second);
+            lastBid = bid->first;
+            ++result.buyLevels;
+        }
+        if (askLeft == 0) {
+            if (++ask == asks.end() || bid->first < ask->first) {
+                break;
+            }
+            askLeft = auctionVolume(*ask->second);
+            lastAsk = ask->first;
+            ++result.sellLevels;
+        }
+    }
+    result.crossed = true;
+    result.price = lastAsk + (lastBid - lastAsk) / 2;
+
+    currentEventTime = eventTime;
+    auctionPrice = result.price;
+    const uint64_t sharesTraded = metrics.sharesTraded.get();
+    // each level executes at most its unconstrained volume, which its eligible orders always cover
+    auto execute = [&](auto& side) {
+        int volume = result.shares;
+        for (Limit* limit = side.getBestLimit(); volume > 0 && limit;) {
+            int levelVolume = std::min(volume, auctionVolume(*limit));
+            volume -= levelVolume;
+            if (levelVolume == limit->getTotalVolume()) {
+                side.executeOrder(levelVolume, limit);
+            } else {
+                Limit* nextLimit = side.getNextLimit(limit);
+                side.executeOrder(levelVolume, limit);
+                limit = nextLimit;
+            }
+        }
+    };
+    execute(*buySide);
+    execute(*sellSide);
+    publishAuctionFills();
+    auctionPrice.reset();
+    // both sides executed as resting orders, but each share changed hands once
+    metrics.sharesTraded.set(sharesTraded + result.shares);
+    return result;
+}
+
+/**
+ * @brief Pairs the executions of both sides of an auction, each in the order it executed, and
+ *        publishes one fill per pair at the auction price, so each share traded is reported once.
+ */
+void Book::publishAuctionFills() {
+    size_t buy = 0;
+    size_t sell = 0;
+    while (buy < auctionBuys.size() && sell < auctionSells.size()) {
+        const int shares = std::min(auctionBuys[buy].second, auctionSells[sell].second);
+        const Fill fill{fillSequence++, auctionSells[sell].first, *auctionPrice, shares, Side::Buy, currentEventTime,
+                        auctionBuys[buy].first};
+        for (FillSink* sink : fillSinks) {
+            sink->onFill(fill);
+        }
+        if (!(auctionBuys[buy].second -= shares)) {
+            ++buy;
+        }
+        if (!(auctionSells[sell].second -= shares)) {
+            ++sell;
+        }
+    }
+    auctionBuys.clear();
+    auctionSells.clear();
+}
+
+/**
+ * @brief Runs the auction of the current interval if the book is in batch auction mode and the
+ *        interval ended. Intervals missed entirely are skipped rather than caught up.
+ * @param now The current time.
+ * @param eventTime Event time of the auction in seconds.
+ * @return The result of the auction, empty if none was due.
+ */
+std::optional<AuctionResult> Book::uncrossIfDue(std::chrono::steady_clock::time_point now, int eventTime) {
+    if (matchingMode != MatchingMode::BatchAuction || now < nextAuction) {
+        return std::nullopt;
+    }
+    nextAuction += auctionInterval;
+    if (nextAuction <= now) {
+        nextAuction = now + auctionInterval;
+    }
+    return uncross(eventTime);
+}
+
+MatchingMode Book::getMatchingMode() const {
+    return matchingMode;
+}
+
+/**
+ * @brief Returns when the next auction is due, in batch auction mode.
+ * @return The time of the next auction.
+ */
+std::chrono::steady_clock::time_point Book::getNextAuctionTime() const {
+    return nextAuction;
+}
+
+/**
+ * @brief Registers a receiver of the fills of the book. The sink must outlive its registration.
+ * @param sink Pointer to the fill sink.
+ */
+void Book::addFillSink(FillSink* sink) {
+    fillSinks.push_back(sink);
+}
+
+/**
+ * @brief Unregisters a receiver of the fills of the book.
+ * @param sink Pointer to the fill sink.
+ */
+void Book::removeFillSink(FillSink* sink) {
+    fillSinks.erase(std::remove(fillSinks.begin(), fillSinks.end(), sink), fillSinks.end());
 }
 
 /**
@@ -214,3 +518,36 @@ LOBSide<Side::Buy>* Book::getBuySide() const {
 const std::unordered_map<int64_t, std::unique_ptr<Order>>* Book::getAllOrders() const {
     return &allOrders;
 }
+
+/**
+ * @brief Returns the runtime counters of the order book.
+ * @return Reference to the book metrics.
+ */
+const BookMetrics& Book::getMetrics() const {
+    return metrics;
+}
+
+/**
+ * @brief Returns a snapshot of the workload statistics of the order book.
+ * @return The statistics snapshot.
+ */
+BookStatisticsSnapshot Book::getStatisticsSnapshot() const {
+    return statistics.snapshot(metrics);
+}
+
+/**
+ * @brief Returns the microstructure analytics of the order book. They are derived from aggregates
+ *        maintained as the best levels change, so the cost is O(1).
+ * @return The analytics of the book.
+ */
+BookAnalytics Book::getAnalytics() const {
+    return computeAnalytics(buySide->getTopDepth(), sellSide->getTopDepth(), buySide->getBestLimit(), sellSide->getBestLimit());
+}
+
+/**
+ * @brief Returns a counter that changes every time the analytics of the book may have changed.
+ * @return The analytics version.
+ */
+uint64_t Book::getAnalyticsVersion() const {
+    return buySide->getTopDepthVersion() + sellSide->getTopDepthVersion();
+}
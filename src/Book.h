@@ -29,8 +29,38 @@
 #include <chrono>
 #include <unordered_map>
 #include <memory>
+#include <optional>
+#include <vector>
+#include "Fill.h"
 #include "LOBSide.hpp"
 
+/**
+ * @enum MatchingMode
+ * @brief How a book matches the orders it receives.
+ */
+enum class MatchingMode : uint8_t {
+    /// each order executes against the opposite side on arrival
+    Continuous,
+    /// orders rest, even through the opposite side, until the next uniform-price auction
+    BatchAuction
+};
+
+/**
+ * @struct AuctionResult
+ * @brief The outcome of a batch auction.
+ */
+struct AuctionResult {
+    /// whether the book was crossed, so that orders executed
+    bool crossed = false;
+    /// the uniform price of every fill of the auction, in cents
+    int price = 0;
+    /// shares bought, which is also the shares sold
+    int shares = 0;
+    /// price levels executed on each side, the last one possibly partially
+    int buyLevels = 0;
+    int sellLevels = 0;
+};
+
 /**
  * @class Book
  * @brief Represents an order book that manages buy and sell orders, allowing for placing, canceling, and modifying orders.
@@ -41,10 +71,10 @@ public:
     Book();
 
     // functions for adding limit orders to the book
-    void addOrderToBook(OrderData orderData, OrderIdSequence& orderIdSequence);
+    std::optional<int64_t> addOrderToBook(OrderData orderData, OrderIdSequence& orderIdSequence);
 
     // placing market orders
-    void placeMarketOrder(int volume, Side orderSide);
+    void placeMarketOrder(int volume, Side orderSide, int eventTime = getCurrentTimeSeconds());
 
     // canceling orders
     void removeOrderFromLimit(Order* orderToCancel);
@@ -57,19 +87,57 @@ public:
     // modify allOrders map
     void addOrderToAllOrders(std::unique_ptr<Order> order);
     void removeOrderFromAllOrders(int64_t orderId);
+
+    // batch auctions
+    void setMatchingMode(MatchingMode mode, std::chrono::milliseconds auctionInterval = std::chrono::milliseconds(100));
+    AuctionResult uncross(int eventTime = getCurrentTimeSeconds());
+    std::optional<AuctionResult> uncrossIfDue(std::chrono::steady_clock::time_point now, int eventTime = getCurrentTimeSeconds());
+    MatchingMode getMatchingMode() const;
+    std::chrono::steady_clock::time_point getNextAuctionTime() const;
+
+    // metrics and fill stream
+    void recordOrderFilled();
+    void recordExecution(const Order& restingOrder, int shares);
+    void addFillSink(FillSink* sink);
+    void removeFillSink(FillSink* sink);
     
     // getters
     LOBSide<Side::Sell>* getSellSide() const;
     LOBSide<Side::Buy>* getBuySide() const;
     const std::unordered_map<int64_t, std::unique_ptr<Order>>* getAllOrders() const;
+    const BookMetrics& getMetrics() const;
+    BookStatisticsSnapshot getStatisticsSnapshot() const;
+    BookAnalytics getAnalytics() const;
+    uint64_t getAnalyticsVersion() const;
     
 private:
+    void validateOrder(const OrderData& orderData);
+    void publishAuctionFills();
+
+    /// runtime counters of the order book, declared first as both sides update them
+    BookMetrics metrics;
+    /// workload statistics of the order book, updated by both sides
+    BookStatistics statistics;
     /// the sell side of the order book
     std::unique_ptr<LOBSide<Side::Sell>> sellSide;
     /// the buy side of the order book
     std::unique_ptr<LOBSide<Side::Buy>> buySide;
     /// a map of all orders in the order book
     std::unordered_map<int64_t, std::unique_ptr<Order>> allOrders;
+    /// receivers of the fills produced by the book
+    std::vector<FillSink*> fillSinks;
+    /// sequence number of the next fill
+    uint64_t fillSequence;
+    /// event time of the aggressive order being matched
+    int currentEventTime;
+    MatchingMode matchingMode;
+    std::chrono::milliseconds auctionInterval;
+    std::chrono::steady_clock::time_point nextAuction;
+    /// the price of the fills of the auction being executed, empty outside auctions
+    std::optional<int> auctionPrice;
+    /// executions of the auction being run, as (order id, shares), paired into fills once both sides executed
+    std::vector<std::pair<int64_t, int>> auctionBuys;
+    std::vector<std::pair<int64_t, int>> auctionSells;
 
     Book& operator=(const Book&) = delete;
     Book(const Book&) = delete;
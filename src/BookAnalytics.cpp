@@ -0,0 +1,47 @@
+#include "BookAnalytics.h"
+#include "Limit.h"
+
+/**
+ * @brief Computes the analytics of a book from the running aggregates of its sides. Nothing is
+ *        walked, so the cost does not depend on the size of the book.
+ * @param bids Aggregates of the best bid levels.
+ * @param asks Aggregates of the best ask levels.
+ * @param bestBid Pointer to the best bid limit, nullptr if there are no bids.
+ * @param bestAsk Pointer to the best ask limit, nullptr if there are no asks.
+ * @return The analytics of the book.
+ */
+BookAnalytics computeAnalytics(const TopDepth& bids, const TopDepth& asks, const Limit* bestBid, const Limit* bestAsk) {
+    
+    BookAnalytics analytics;
+    analytics.bidDepthVolume = bids.volume;
+    analytics.askDepthVolume = asks.volume;
+
+    if (bestBid) {
+        analytics.bestBid = bestBid->getLimitPrice();
+        analytics.bestBidVolume = bestBid->getTotalVolume();
+    }
+    if (bestAsk) {
+        analytics.bestAsk = bestAsk->getLimitPrice();
+        analytics.bestAskVolume = bestAsk->getTotalVolume();
+    }
+
+    const int64_t depthVolume = bids.volume + asks.volume;
+    if (depthVolume > 0) {
+        analytics.imbalance = static_cast<double>(bids.volume - asks.volume) / static_cast<double>(depthVolume);
+    }
+
+    const int touchVolume = analytics.bestBidVolume + analytics.bestAskVolume;
+    if (bestBid && bestAsk && touchVolume > 0) {
+        analytics.microprice = (static_cast<double>(*analytics.bestBid) * analytics.bestAskVolume +
+                                static_cast<double>(*analytics.bestAsk) * analytics.bestBidVolume) / touchVolume;
+    }
+
+    if (bids.volume > 0 && asks.volume > 0) {
+        const double bidPrice = static_cast<double>(bids.notional) / static_cast<double>(bids.volume);
+        const double askPrice = static_cast<double>(asks.notional) / static_cast<double>(asks.volume);
+        analytics.weightedMid = (bidPrice + askPrice) / 2;
+        analytics.depthWeightedSpread = askPrice - bidPrice;
+    }
+
+    return analytics;
+}
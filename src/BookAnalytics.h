@@ -0,0 +1,71 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+class Limit;
+
+/// number of price levels per side included in the depth based analytics
+constexpr int analyticsDepth = 5;
+
+/**
+ * @struct TopDepth
+ * @brief Running aggregates over the best analyticsDepth levels of one side of a book.
+ */
+struct TopDepth {
+    /// number of levels aggregated, less than analyticsDepth only if the side is that shallow
+    int levels = 0;
+    /// total volume of the aggregated levels
+    int64_t volume = 0;
+    /// sum of price times volume of the aggregated levels, in cents
+    int64_t notional = 0;
+};
+
+/**
+ * @struct BookAnalytics
+ * @brief Microstructure analytics of a book. Prices are in cents like the limit prices of the book.
+ */
+struct BookAnalytics {
+    std::optional<int> bestBid;
+    std::optional<int> bestAsk;
+    int bestBidVolume = 0;
+    int bestAskVolume = 0;
+    /// volume of the best analyticsDepth bid levels
+    int64_t bidDepthVolume = 0;
+    /// volume of the best analyticsDepth ask levels
+    int64_t askDepthVolume = 0;
+    /// (bid depth - ask depth) / (bid depth + ask depth), 0 when both sides are empty
+    double imbalance = 0;
+    /// best prices weighted by the volume on the opposite side of the touch
+    std::optional<double> microprice;
+    /// average of the volume weighted prices of the bid and ask depth
+    std::optional<double> weightedMid;
+    /// difference between the volume weighted prices of the ask and bid depth
+    std::optional<double> depthWeightedSpread;
+};
+
+BookAnalytics computeAnalytics(const TopDepth& bids, const TopDepth& asks, const Limit* bestBid, const Limit* bestAsk);
@@ -0,0 +1,36 @@
+#include "BookCommand.h"
+
+#include <stdexcept>
+
+/**
+ * @brief Applies a command to a book. Rejections are already counted by the book's metrics.
+ * @param book The book the command targets.
+ * @param command The command.
+ * @param orderIdSequence The sequence assigning ids to the orders that rest in the book.
+ * @return Whether the command was accepted and, for Add, the id of the resting remainder if any.
+ */
+CommandResult applyCommand(Book& book, const BookCommand& command, OrderIdSequence& orderIdSequence) {
+    try {
+        switch (command.type) {
+            case CommandType::Add: {
+                OrderData orderData(command.side, command.shares, OrderType::Limit);
+                orderData.limit = command.price;
+                orderData.entryTime = command.eventTime;
+                orderData.eventTime = command.eventTime;
+                orderData.minQuantity = command.minQuantity;
+                return {true, book.addOrderToBook(orderData, orderIdSequence)};
+            }
+            case CommandType::Cancel:
+                book.cancelOrder(command.orderId);
+                return {true, std::nullopt};
+            case CommandType::ModifySize:
+                book.modifyOrderSize(command.orderId, command.shares);
+                return {true, command.orderId};
+            case CommandType::Market:
+                book.placeMarketOrder(command.shares, command.side, command.eventTime);
+                return {true, std::nullopt};
+        }
+    } catch (const std::exception&) {
+    }
+    return {false, std::nullopt};
+}
@@ -0,0 +1,73 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include "Book.h"
+
+/**
+ * @enum CommandType
+ * @brief The operations a BookCommand can perform on a book.
+ */
+enum class CommandType : uint8_t {
+    Add,
+    Cancel,
+    ModifySize,
+    Market
+};
+
+/**
+ * @struct BookCommand
+ * @brief A self-contained request to a single book, small enough to be queued and replayed by value.
+ *        Prices are in cents, like the limits stored in the book.
+ */
+struct BookCommand {
+    CommandType type;
+    Side side;
+    /// order size for Add and Market, new size for ModifySize
+    int shares;
+    /// limit price for Add
+    int price;
+    /// target order for Cancel and ModifySize
+    int64_t orderId;
+    /// event time in seconds, stamped on the fills the command produces
+    int eventTime;
+    /// minimum execution of an Add, allOrNoneQuantity for all-or-none, 0 for none
+    int minQuantity = 0;
+};
+
+/**
+ * @struct CommandResult
+ * @brief The outcome of a BookCommand.
+ */
+struct CommandResult {
+    bool accepted;
+    /// id of the order resting in the book after the command, empty if none
+    std::optional<int64_t> orderId;
+};
+
+// applies a command to a book, turning the book's exceptions into a rejected result
+CommandResult applyCommand(Book& book, const BookCommand& command, OrderIdSequence& orderIdSequence);
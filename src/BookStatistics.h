@@ -0,0 +1,83 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Metrics.h"
+
+/// buckets of the level lifetime histogram, in orders accepted by the book: 0, 1, 2-3, ... , 2^22+
+constexpr size_t levelLifetimeBuckets = 24;
+/// buckets of the queue length histogram: 0, 1, 2-3, ... , 2^14+ orders
+constexpr size_t queueLengthBuckets = 16;
+/// buckets of the distance from touch histogram: 0, 1, 2-3, ... , 2^18+ ticks
+constexpr size_t touchDistanceBuckets = 20;
+
+/**
+ * @struct BookStatisticsSnapshot
+ * @brief A point-in-time copy of the workload statistics of a book.
+ */
+struct BookStatisticsSnapshot {
+    uint64_t levelCreations = 0;
+    uint64_t levelJoins = 0;
+    HistogramSnapshot<sweepDepthBuckets> sweepDepth;
+    HistogramSnapshot<levelLifetimeBuckets> levelLifetime;
+    HistogramSnapshot<queueLengthBuckets> queueLength;
+    HistogramSnapshot<touchDistanceBuckets> touchDistance;
+};
+
+/**
+ * @class BookStatistics
+ * @brief Describes the shape of the workload of a book: how often orders open a new level rather
+ *        than join one, how long levels live, how long their queues get and how far from the touch
+ *        orders are placed. Like BookMetrics it is written only by the thread mutating the book.
+ */
+class BookStatistics {
+public:
+    /// orders that created a new price level
+    MetricsCounter levelCreations;
+    /// orders that joined an existing price level
+    MetricsCounter levelJoins;
+    /// lifetime of removed levels, counted in orders accepted by the book after the level was created
+    Log2Histogram<levelLifetimeBuckets> levelLifetime;
+    /// length of the level's queue right after an order joins it
+    Log2Histogram<queueLengthBuckets> queueLength;
+    /// ticks between a new order and the best price of its side, 0 when it sets or improves the touch
+    Log2Histogram<touchDistanceBuckets> touchDistance;
+
+    /**
+     * @brief Takes a snapshot of the statistics.
+     * @param metrics The counters of the same book, which hold the sweep depth histogram.
+     * @return The snapshot.
+     */
+    BookStatisticsSnapshot snapshot(const BookMetrics& metrics) const {
+        BookStatisticsSnapshot result;
+        result.levelCreations = levelCreations.get();
+        result.levelJoins = levelJoins.get();
+        result.sweepDepth = metrics.sweepDepth.snapshot();
+        result.levelLifetime = levelLifetime.snapshot();
+        result.queueLength = queueLength.snapshot();
+        result.touchDistance = touchDistance.snapshot();
+        return result;
+    }
+};
@@ -0,0 +1,143 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+ * @class BoundedQueue
+ * @brief A fixed capacity multi-producer multi-consumer queue. Each cell carries a sequence number
+ *        telling producers and consumers whose turn it is, so pushing and popping take one compare
+ *        and swap on the shared index and never allocate.
+ * @tparam T Element type.
+ */
+template<typename T>
+class BoundedQueue {
+    static_assert(std::is_nothrow_move_assignable_v<T>, "elements are moved in and out of the cells");
+
+public:
+    explicit BoundedQueue(size_t capacity);
+
+    bool tryPush(T value);
+    bool tryPop(T& value);
+
+    size_t capacity() const;
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePosition;
+    alignas(64) std::atomic<size_t> dequeuePosition;
+};
+
+/**
+ * @brief Allocates the cells of the queue.
+ * @param capacity Number of elements the queue can hold, a power of two.
+ * @throws std::invalid_argument if the capacity is not a power of two.
+ */
+template<typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity)
+    : cells(new Cell[capacity]), mask(capacity - 1), enqueuePosition(0), dequeuePosition(0) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("The queue capacity must be a power of two");
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Appends an element.
+ * @param value The element.
+ * @return False if the queue is full.
+ */
+template<typename T>
+bool BoundedQueue<T>::tryPush(T value) {
+    size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[position & mask];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.value = std::move(value);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Removes the oldest element.
+ * @param value Receives the element.
+ * @return False if the queue is empty.
+ */
+template<typename T>
+bool BoundedQueue<T>::tryPop(T& value) {
+    size_t position = dequeuePosition.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[position & mask];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+        if (difference == 0) {
+            if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                value = std::move(cell.value);
+                cell.sequence.store(position + mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = dequeuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Returns the number of elements the queue can hold.
+ * @return The capacity.
+ */
+template<typename T>
+size_t BoundedQueue<T>::capacity() const {
+    return mask + 1;
+}
@@ -0,0 +1,149 @@
+#include "CommandBatch.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+bool fitsInt(int64_t value) {
+    return value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max();
+}
+
+} // namespace
+
+/**
+ * @brief Appends a fill row.
+ * @param fill The fill.
+ */
+void CommandBatchSession::InstrumentFillSink::onFill(const Fill& fill) {
+    fills.insert(fills.end(), {instrument, static_cast<int64_t>(fill.sequence), fill.restingOrderId, fill.price, fill.shares,
+                               static_cast<int64_t>(fill.aggressorSide), fill.eventTime});
+}
+
+/**
+ * @brief Attaches a session to an exchange. Instruments already covered by the exchange are
+ *        numbered in the order of getTickerList.
+ * @param exchange The exchange, which must outlive the session.
+ */
+CommandBatchSession::CommandBatchSession(Exchange& exchange) : exchange(exchange) {
+    for (const std::string& ticker : exchange.getTickerList()) {
+        addInstrument(ticker);
+    }
+}
+
+/**
+ * @brief Detaches the fill sinks from the books.
+ */
+CommandBatchSession::~CommandBatchSession() {
+    for (size_t i = 0; i < books.size(); ++i) {
+        books[i]->removeFillSink(sinks[i].get());
+    }
+}
+
+/**
+ * @brief Adds an instrument to the session, and to the exchange if it does not cover it yet.
+ * @param ticker The ticker of the instrument.
+ * @return The index of the instrument in command and fill rows.
+ */
+uint32_t CommandBatchSession::addInstrument(const std::string& ticker) {
+    for (size_t i = 0; i < tickers.size(); ++i) {
+        if (tickers[i] == ticker) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    if (!exchange.getOrderBook(ticker)) {
+        exchange.addInstrument(ticker);
+    }
+    const auto instrument = static_cast<uint32_t>(tickers.size());
+    tickers.push_back(ticker);
+    books.push_back(exchange.getOrderBook(ticker));
+    sinks.push_back(std::make_unique<InstrumentFillSink>(fills, instrument));
+    books.back()->addFillSink(sinks.back().get());
+    return instrument;
+}
+
+/**
+ * @brief Applies a batch of commands in order. The results replace those of the previous batch,
+ *        one row per command; the fills are appended to the fill rows.
+ * @param commands count rows of commandBatchColumns values.
+ * @param count The number of commands.
+ * @return The number of accepted commands. Rows with an unknown instrument, type or side, or with
+ *         shares, price or event time out of the range of int, are rejected.
+ */
+size_t CommandBatchSession::submit(const int64_t* commands, size_t count) {
+    results.resize(count * commandResultColumns);
+    OrderIdSequence& orderIdSequence = exchange.getOrderIdSequence();
+    size_t accepted = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const int64_t* row = commands + i * commandBatchColumns;
+        int64_t* result = results.data() + i * commandResultColumns;
+        result[0] = 0;
+        result[1] = -1;
+        if (row[0] < 0 || static_cast<uint64_t>(row[0]) >= books.size() || row[1] < 0 ||
+            row[1] > static_cast<int64_t>(CommandType::Market) || (row[2] != 0 && row[2] != 1) || !fitsInt(row[3]) ||
+            !fitsInt(row[4]) || !fitsInt(row[6])) {
+            continue;
+        }
+        const BookCommand command{static_cast<CommandType>(row[1]), row[2] == 0 ? Side::Buy : Side::Sell,
+                                  static_cast<int>(row[3]), static_cast<int>(row[4]), row[5], static_cast<int>(row[6])};
+        const CommandResult commandResult = applyCommand(*books[row[0]], command, orderIdSequence);
+        if (commandResult.accepted) {
+            result[0] = 1;
+            ++accepted;
+        }
+        if (commandResult.orderId) {
+            result[1] = *commandResult.orderId;
+        }
+    }
+    return accepted;
+}
+
+/**
+ * @brief Writes the best levels of a book to the depth rows: levels rows of bids from the best
+ *        down, then levels rows of asks from the best up, missing levels left at zero.
+ * @param instrument The index of the instrument.
+ * @param levels The number of levels per side.
+ * @return The depth rows.
+ * @throws std::out_of_range if the instrument is unknown.
+ */
+const std::vector<int64_t>& CommandBatchSession::captureDepth(uint32_t instrument, size_t levels) {
+    if (instrument >= books.size()) {
+        throw std::out_of_range("Unknown instrument index.");
+    }
+    depth.assign(2 * levels * depthRecordColumns, 0);
+    auto writeLevels = [&](auto begin, auto end, int64_t* out) {
+        for (size_t i = 0; i < levels && begin != end; ++i, ++begin) {
+            out[i * depthRecordColumns] = begin->second->getLimitPrice();
+            out[i * depthRecordColumns + 1] = begin->second->getTotalVolume();
+            out[i * depthRecordColumns + 2] = begin->second->getSize();
+        }
+    };
+    const auto& bids = books[instrument]->getBuySide()->getSideTree();
+    const auto& asks = books[instrument]->getSellSide()->getSideTree();
+    writeLevels(bids.rbegin(), bids.rend(), depth.data());
+    writeLevels(asks.begin(), asks.end(), depth.data() + levels * depthRecordColumns);
+    return depth;
+}
+
+/**
+ * @brief Drops the fill rows collected so far.
+ */
+void CommandBatchSession::clearFills() {
+    fills.clear();
+}
+
+const std::vector<std::string>& CommandBatchSession::getTickers() const {
+    return tickers;
+}
+
+const std::vector<int64_t>& CommandBatchSession::getResults() const {
+    return results;
+}
+
+const std::vector<int64_t>& CommandBatchSession::getFills() const {
+    return fills;
+}
+
+const std::vector<int64_t>& CommandBatchSession::getDepth() const {
+    return depth;
+}
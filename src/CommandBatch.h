@@ -0,0 +1,92 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Exchange.hpp"
+
+/// columns of a command row: instrument, type, side, shares, price, order id, event time
+constexpr size_t commandBatchColumns = 7;
+/// columns of a result row: accepted, id of the resting order or -1
+constexpr size_t commandResultColumns = 2;
+/// columns of a fill row: instrument, sequence, resting order id, price, shares, aggressor side, event time
+constexpr size_t fillRecordColumns = 7;
+/// columns of a depth row: price, volume, orders
+constexpr size_t depthRecordColumns = 3;
+
+/**
+ * @class CommandBatchSession
+ * @brief Drives an exchange with batches of commands laid out as rows of int64 columns, and collects
+ *        results, fills and depth in buffers of the same layout. Callers that cross a language
+ *        boundary, like the Python bindings, pay one call per batch instead of one per order and
+ *        read the output in place. Enum columns use the values of CommandType and Side, prices are
+ *        in cents, and instruments are the indices returned by addInstrument. Instruments must not be
+ *        removed from the exchange while a session uses them.
+ */
+class CommandBatchSession {
+public:
+    explicit CommandBatchSession(Exchange& exchange);
+    ~CommandBatchSession();
+
+    uint32_t addInstrument(const std::string& ticker);
+    size_t submit(const int64_t* commands, size_t count);
+    const std::vector<int64_t>& captureDepth(uint32_t instrument, size_t levels);
+    void clearFills();
+
+    const std::vector<std::string>& getTickers() const;
+    const std::vector<int64_t>& getResults() const;
+    const std::vector<int64_t>& getFills() const;
+    const std::vector<int64_t>& getDepth() const;
+
+    CommandBatchSession(const CommandBatchSession&) = delete;
+    CommandBatchSession& operator=(const CommandBatchSession&) = delete;
+
+private:
+    /**
+     * @class InstrumentFillSink
+     * @brief Appends the fills of one book to the fill rows, tagged with its instrument.
+     */
+    class InstrumentFillSink : public FillSink {
+    public:
+        InstrumentFillSink(std::vector<int64_t>& fills, uint32_t instrument) : fills(fills), instrument(instrument) {}
+        void onFill(const Fill& fill) override;
+
+    private:
+        std::vector<int64_t>& fills;
+        uint32_t instrument;
+    };
+
+    Exchange& exchange;
+    std::vector<std::string> tickers;
+    std::vector<Book*> books;
+    std::vector<std::unique_ptr<InstrumentFillSink>> sinks;
+    std::vector<int64_t> results;
+    std::vector<int64_t> fills;
+    std::vector<int64_t> depth;
+};
@@ -0,0 +1,272 @@
+#include "DarkPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Constructs an empty dark pool.
+ * @param orderIdSequence The sequence assigning ids to the orders, usually shared with the lit books of the venue.
+ * @param priority The priority of the orders of a side.
+ * @param crossInterval The minimum time between two crosses run by crossIfDue.
+ */
+DarkPool::DarkPool(OrderIdSequence& orderIdSequence, DarkPriority priority, std::chrono::milliseconds crossInterval)
+    : orderIdSequence(orderIdSequence), priority(priority), crossInterval(crossInterval),
+      lastCross(std::chrono::steady_clock::now()), buyPool(0, 0), sellPool(0, 0) {}
+
+/**
+ * @brief Adds an order to the pool of its side, where it waits for the next cross.
+ * @param side The side of the order.
+ * @param shares The shares of the order.
+ * @param limitPrice The worst midpoint the order accepts, in cents.
+ * @param eventTime Event time of the order in seconds.
+ * @return The id of the order.
+ * @throws std::invalid_argument if the price or the size is not positive.
+ */
+int64_t DarkPool::addOrder(Side side, int shares, int limitPrice, int eventTime) {
+    if (limitPrice <= 0) {
+        metrics.recordReject(RejectReason::InvalidPrice);
+        throw std::invalid_argument("The price must be positive");
+    }
+    if (shares <= 0) {
+        metrics.recordReject(RejectReason::InvalidSize);
+        throw std::invalid_argument("The order size must be positive");
+    }
+    OrderData orderData(side, shares, OrderType::Limit);
+    orderData.limit = limitPrice;
+    orderData.entryTime = eventTime;
+    orderData.eventTime = eventTime;
+
+    Limit& queue = pool(side);
+    auto order = std::make_unique<Order>(orderData, &queue, orderIdSequence);
+    const int64_t orderId = order->getOrderId();
+    link(queue, order.get());
+    allOrders.emplace(orderId, std::move(order));
+    metrics.ordersAdded.increment();
+    metrics.restingOrders.set(allOrders.size());
+    return orderId;
+}
+
+/**
+ * @brief Removes an order from the pool.
+ * @param orderId The id of the order.
+ * @throws std::invalid_argument if the order is not in the pool.
+ */
+void DarkPool::cancelOrder(int64_t orderId) {
+    auto it = allOrders.find(orderId);
+    if (it == allOrders.end()) {
+        metrics.recordReject(RejectReason::UnknownOrder);
+        throw std::invalid_argument("Invalid order to cancel: the order is not in the dark pool");
+    }
+    unlink(it->second.get());
+    allOrders.erase(it);
+    metrics.ordersCancelled.increment();
+    metrics.restingOrders.set(allOrders.size());
+}
+
+/**
+ * @brief Applies a command to the pool. Adds rest with the command's price as their limit and
+ *        cancels remove them; other commands have no meaning without a price ladder and are rejected.
+ *        Adds with a minQuantity are rejected as well, since crosses don't honour minimums.
+ * @param command The command.
+ * @return Whether the command was accepted and, for Add, the id of the order.
+ */
+CommandResult DarkPool::apply(const BookCommand& command) {
+    try {
+        switch (command.type) {
+            case CommandType::Add:
+                if (command.minQuantity != 0) {
+                    break;
+                }
+                return {true, addOrder(command.side, command.shares, command.price, command.eventTime)};
+            case CommandType::Cancel:
+                cancelOrder(command.orderId);
+                return {true, std::nullopt};
+            default:
+                break;
+        }
+    } catch (const std::exception&) {
+    }
+    return {false, std::nullopt};
+}
+
+/**
+ * @brief Crosses the accumulated orders at the midpoint of a reference quote. The buys accepting
+ *        the midpoint are matched against the sells accepting it, each side in its priority, until
+ *        one side runs out. An odd spread gives a midpoint rounded down to the cent.
+ * @param reference The reference quote. There is no cross if a side is missing or the quote is locked or crossed.
+ * @param eventTime Event time of the cross in seconds, stamped on its fills.
+ * @return The report of the cross.
+ */
+DarkCrossReport DarkPool::cross(const ConsolidatedQuote& reference, int eventTime) {
+    DarkCrossReport report;
+    if (!reference.hasBid() || !reference.hasAsk() || reference.bidPrice >= reference.askPrice) {
+        return report;
+    }
+    report.crossed = true;
+    report.price = (reference.bidPrice + reference.askPrice) / 2;
+    currentEventTime = eventTime;
+    ++crosses;
+
+    const int price = report.price;
+    auto nextBuy = [price](Order* order) {
+        while (order && order->getLimit() < price) {
+            order = order->getNextOrder();
+        }
+        return order;
+    };
+    auto nextSell = [price](Order* order) {
+        while (order && order->getLimit() > price) {
+            order = order->getNextOrder();
+        }
+        return order;
+    };
+
+    Order* buy = nextBuy(buyPool.getHeadOrder());
+    Order* sell = nextSell(sellPool.getHeadOrder());
+    while (buy && sell) {
+        const int shares = std::min(buy->getShares(), sell->getShares());
+        Order* followingBuy = buy->getShares() == shares ? nextBuy(buy->getNextOrder()) : buy;
+        Order* followingSell = sell->getShares() == shares ? nextSell(sell->getNextOrder()) : sell;
+        publishFill(*buy, *sell, shares, price);
+        execute(buy, shares);
+        execute(sell, shares);
+        metrics.sharesTraded.increment(shares);
+        report.shares += shares;
+        ++report.matches;
+        buy = followingBuy;
+        sell = followingSell;
+    }
+    return report;
+}
+
+/**
+ * @brief Crosses the pool if the cross interval elapsed since the last cross run by this function.
+ * @param now The current time.
+ * @param reference The reference quote.
+ * @param eventTime Event time of the cross in seconds.
+ * @return The report of the cross, empty if it was not due.
+ */
+std::optional<DarkCrossReport> DarkPool::crossIfDue(std::chrono::steady_clock::time_point now,
+                                                    const ConsolidatedQuote& reference, int eventTime) {
+    if (now - lastCross < crossInterval) {
+        return std::nullopt;
+    }
+    lastCross = now;
+    return cross(reference, eventTime);
+}
+
+/**
+ * @brief Registers a receiver of the fills of the pool. The sink must outlive its registration.
+ * @param sink Pointer to the fill sink.
+ */
+void DarkPool::addFillSink(FillSink* sink) {
+    fillSinks.push_back(sink);
+}
+
+/**
+ * @brief Unregisters a receiver of the fills of the pool.
+ * @param sink Pointer to the fill sink.
+ */
+void DarkPool::removeFillSink(FillSink* sink) {
+    fillSinks.erase(std::remove(fillSinks.begin(), fillSinks.end(), sink), fillSinks.end());
+}
+
+const Limit& DarkPool::getPool(Side side) const {
+    return side == Side::Buy ? buyPool : sellPool;
+}
+
+const std::unordered_map<int64_t, std::unique_ptr<Order>>& DarkPool::getAllOrders() const {
+    return allOrders;
+}
+
+const BookMetrics& DarkPool::getMetrics() const {
+    return metrics;
+}
+
+/**
+ * @brief Returns the number of crosses run, including those that matched nothing.
+ * @return The number of crosses.
+ */
+uint64_t DarkPool::getCrosses() const {
+    return crosses;
+}
+
+Limit& DarkPool::pool(Side side) {
+    return side == Side::Buy ? buyPool : sellPool;
+}
+
+/**
+ * @brief Links an order into its queue: at the tail in time priority, after the last order at
+ *        least as large in size priority.
+ */
+void DarkPool::link(Limit& queue, Order* order) {
+    Order* previous = queue.getTailOrder();
+    if (priority == DarkPriority::SizeTime) {
+        while (previous && previous->getShares() < order->getShares()) {
+            previous = previous->getPrevOrder();
+        }
+    }
+    Order* next = previous ? previous->getNextOrder() : queue.getHeadOrder();
+    order->setPrevOrder(previous);
+    order->setNextOrder(next);
+    if (previous) {
+        previous->setNextOrder(order);
+    } else {
+        queue.setHeadOrder(order);
+    }
+    if (next) {
+        next->setPrevOrder(order);
+    } else {
+        queue.setTailOrder(order);
+    }
+    queue.increaseSize();
+    queue.setTotalVolume(queue.getTotalVolume() + order->getShares());
+}
+
+/**
+ * @brief Unlinks an order from its queue.
+ */
+void DarkPool::unlink(Order* order) {
+    Limit* queue = order->getParentLimit();
+    Order* previous = order->getPrevOrder();
+    Order* next = order->getNextOrder();
+    if (previous) {
+        previous->setNextOrder(next);
+    } else {
+        queue->setHeadOrder(next);
+    }
+    if (next) {
+        next->setPrevOrder(previous);
+    } else {
+        queue->setTailOrder(previous);
+    }
+    queue->decreaseSize();
+    queue->setTotalVolume(queue->getTotalVolume() - order->getShares());
+}
+
+/**
+ * @brief Publishes a match as a single fill. Both orders rest, so like in a batch auction the sell
+ *        is the resting order and the buy its contra order.
+ */
+void DarkPool::publishFill(const Order& buy, const Order& sell, int shares, int price) {
+    const Fill fill{fillSequence++, sell.getOrderId(), price, shares, Side::Buy, currentEventTime, buy.getOrderId()};
+    for (FillSink* sink : fillSinks) {
+        sink->onFill(fill);
+    }
+}
+
+/**
+ * @brief Executes shares of an order, removing the order once filled.
+ */
+void DarkPool::execute(Order* order, int shares) {
+    if (shares == order->getShares()) {
+        unlink(order);
+        allOrders.erase(order->getOrderId());
+        metrics.ordersFilled.increment();
+        metrics.restingOrders.set(allOrders.size());
+    } else {
+        order->setShares(order->getShares() - shares);
+        Limit* queue = order->getParentLimit();
+        queue->setTotalVolume(queue->getTotalVolume() - shares);
+    }
+}
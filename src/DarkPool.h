@@ -0,0 +1,121 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "BookCommand.h"
+#include "Fill.h"
+#include "Limit.h"
+#include "Metrics.h"
+#include "Order.h"
+#include "QuoteConsolidator.h"
+
+/**
+ * @enum DarkPriority
+ * @brief Order in which the resting orders of a side of a dark pool are crossed.
+ */
+enum class DarkPriority : uint8_t {
+    /// in arrival order
+    Time,
+    /// larger orders first, in arrival order among orders of the same size at entry
+    SizeTime
+};
+
+/**
+ * @struct DarkCrossReport
+ * @brief The outcome of a batch cross of a dark pool.
+ */
+struct DarkCrossReport {
+    /// whether the reference quote allowed a cross, which needs a bid below the ask
+    bool crossed = false;
+    /// the midpoint the orders crossed at, in cents
+    int price = 0;
+    int shares = 0;
+    /// pairs of buy and sell orders matched
+    uint32_t matches = 0;
+};
+
+/**
+ * @class DarkPool
+ * @brief A book whose orders are never displayed: each side is a single queue of orders pegged to
+ *        the midpoint of a reference quote, typically a consolidated quote, instead of a price
+ *        ladder. Orders accumulate between crosses, and each cross matches the buys and sells
+ *        whose limit price accepts the midpoint, in the priority of the pool. Orders live in the
+ *        same Order objects linked in the same Limit queues as in Book, and the pool reports the
+ *        same BookMetrics and fills. Like Book, it is used by a single thread.
+ */
+class DarkPool {
+public:
+    explicit DarkPool(OrderIdSequence& orderIdSequence, DarkPriority priority = DarkPriority::SizeTime,
+                      std::chrono::milliseconds crossInterval = std::chrono::milliseconds(100));
+
+    int64_t addOrder(Side side, int shares, int limitPrice, int eventTime = 0);
+    void cancelOrder(int64_t orderId);
+    CommandResult apply(const BookCommand& command);
+
+    DarkCrossReport cross(const ConsolidatedQuote& reference, int eventTime = 0);
+    std::optional<DarkCrossReport> crossIfDue(std::chrono::steady_clock::time_point now, const ConsolidatedQuote& reference,
+                                              int eventTime = 0);
+
+    void addFillSink(FillSink* sink);
+    void removeFillSink(FillSink* sink);
+
+    const Limit& getPool(Side side) const;
+    const std::unordered_map<int64_t, std::unique_ptr<Order>>& getAllOrders() const;
+    const BookMetrics& getMetrics() const;
+    uint64_t getCrosses() const;
+
+    DarkPool(const DarkPool&) = delete;
+    DarkPool& operator=(const DarkPool&) = delete;
+
+private:
+    Limit& pool(Side side);
+    void link(Limit& queue, Order* order);
+    void unlink(Order* order);
+    void publishFill(const Order& buy, const Order& sell, int shares, int price);
+    void execute(Order* order, int shares);
+
+    OrderIdSequence& orderIdSequence;
+    DarkPriority priority;
+    std::chrono::milliseconds crossInterval;
+    std::chrono::steady_clock::time_point lastCross;
+
+    /// resting buys and sells, each a single queue whose price is unused
+    Limit buyPool;
+    Limit sellPool;
+    std::unordered_map<int64_t, std::unique_ptr<Order>> allOrders;
+
+    std::vector<FillSink*> fillSinks;
+    uint64_t fillSequence = 0;
+    int currentEventTime = 0;
+    BookMetrics metrics;
+    uint64_t crosses = 0;
+};
@@ -0,0 +1,118 @@
+#include "DepthConflator.h"
+
+#include <algorithm>
+#include <iterator>
+
+/**
+ * @brief Adds a book to the conflated set. Subscribers receive its view at their next delivery.
+ * @param ticker The ticker identifying the book in the updates.
+ * @param depth The published depth of the book.
+ * @throws std::runtime_error if the published depth has no reader slot left.
+ */
+void DepthConflator::addBook(const std::string& ticker, PublishedDepth& depth) {
+    books.push_back({ticker, std::make_unique<DepthReader>(depth), DepthView{}});
+    for (Subscription& subscription : subscriptions) {
+        subscription.deliveredVersions.emplace_back();
+    }
+    for (Subscription& subscription : pendingSubscriptions) {
+        subscription.deliveredVersions.emplace_back();
+    }
+}
+
+/**
+ * @brief Registers a consumer. Its first delivery, at the next poll, carries every book. May be
+ *        called from a subscriber callback, the consumer then joins at the following poll.
+ * @param interval Minimum time between two deliveries to this consumer.
+ * @param subscriber The callback receiving the updates.
+ * @return The id to unsubscribe with.
+ */
+DepthConflator::SubscriptionId DepthConflator::subscribe(std::chrono::milliseconds interval, Subscriber subscriber) {
+    const SubscriptionId id = nextSubscriptionId++;
+    pendingSubscriptions.push_back({id, interval, std::move(subscriber), std::nullopt,
+                             std::vector<std::optional<uint64_t>>(books.size())});
+    return id;
+}
+
+/**
+ * @brief Removes a consumer. Unknown ids are ignored. Must not be called from a subscriber callback.
+ * @param id The id returned by subscribe.
+ */
+void DepthConflator::unsubscribe(SubscriptionId id) {
+    const auto matches = [id](const Subscription& subscription) { return subscription.id == id; };
+    std::erase_if(subscriptions, matches);
+    std::erase_if(pendingSubscriptions, matches);
+}
+
+/**
+ * @brief Reads the latest view of every book and delivers the changed ones to each subscriber
+ *        whose interval has elapsed.
+ * @param now The current time.
+ * @return The number of book updates delivered over all subscribers.
+ */
+size_t DepthConflator::poll(std::chrono::steady_clock::time_point now) {
+    std::move(pendingSubscriptions.begin(), pendingSubscriptions.end(), std::back_inserter(subscriptions));
+    pendingSubscriptions.clear();
+
+    const bool anyDue = std::any_of(subscriptions.begin(), subscriptions.end(), [now](const Subscription& subscription) {
+        return !subscription.lastDelivery || now - *subscription.lastDelivery >= subscription.interval;
+    });
+    if (!anyDue) {
+        return 0;
+    }
+
+    for (ConflatedBook& book : books) {
+        book.latest = book.reader->read();
+    }
+
+    size_t delivered = 0;
+    for (Subscription& subscription : subscriptions) {
+        if (subscription.lastDelivery && now - *subscription.lastDelivery < subscription.interval) {
+            continue;
+        }
+        subscription.lastDelivery = now;
+
+        updates.clear();
+        for (size_t i = 0; i < books.size(); ++i) {
+            const DepthView& view = books[i].latest;
+            std::optional<uint64_t>& deliveredVersion = subscription.deliveredVersions[i];
+            if (deliveredVersion && *deliveredVersion == view.version) {
+                continue;
+            }
+            const uint64_t skipped = deliveredVersion ? view.version - *deliveredVersion - 1 : 0;
+            deliveredVersion = view.version;
+            updates.push_back({books[i].ticker, view, skipped});
+            skippedViews += skipped;
+        }
+
+        if (!updates.empty()) {
+            subscription.subscriber(updates);
+            delivered += updates.size();
+        }
+    }
+    deliveredUpdates += delivered;
+    return delivered;
+}
+
+/**
+ * @brief Returns the number of registered consumers.
+ * @return The number of subscribers.
+ */
+size_t DepthConflator::getSubscriberCount() const {
+    return subscriptions.size() + pendingSubscriptions.size();
+}
+
+/**
+ * @brief Returns the number of book updates delivered so far over all subscribers.
+ * @return The number of updates.
+ */
+uint64_t DepthConflator::getDeliveredUpdates() const {
+    return deliveredUpdates;
+}
+
+/**
+ * @brief Returns the number of published views that subscribers skipped because of conflation.
+ * @return The number of skipped views.
+ */
+uint64_t DepthConflator::getSkippedViews() const {
+    return skippedViews;
+}
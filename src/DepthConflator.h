@@ -0,0 +1,103 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "PublishedDepth.h"
+
+/**
+ * @struct DepthUpdate
+ * @brief The latest depth view of one book as delivered to a subscriber.
+ */
+struct DepthUpdate {
+    std::string ticker;
+    DepthView view;
+    /// publications of the book the subscriber never saw since its previous update of this book
+    uint64_t skippedViews = 0;
+};
+
+/**
+ * @class DepthConflator
+ * @brief Delivers the depth of a set of books to slow consumers, each at its own rate. Only the
+ *        latest view of each book is kept: a subscriber due for an update receives the current view
+ *        of every book that changed since its previous delivery, and whatever was published in
+ *        between is skipped. Memory is one view per book plus one version per book and subscriber,
+ *        however far behind the subscribers are, and the books are read through their published
+ *        depth so the matching threads never wait on the conflator. The conflator is polled from
+ *        a single thread of the caller's choice, which also runs the subscriber callbacks.
+ */
+class DepthConflator {
+public:
+    using Subscriber = std::function<void(const std::vector<DepthUpdate>&)>;
+    using SubscriptionId = uint64_t;
+
+    DepthConflator() = default;
+
+    void addBook(const std::string& ticker, PublishedDepth& depth);
+    SubscriptionId subscribe(std::chrono::milliseconds interval, Subscriber subscriber);
+    void unsubscribe(SubscriptionId id);
+
+    size_t poll(std::chrono::steady_clock::time_point now);
+
+    size_t getSubscriberCount() const;
+    uint64_t getDeliveredUpdates() const;
+    uint64_t getSkippedViews() const;
+
+    DepthConflator(const DepthConflator&) = delete;
+    DepthConflator& operator=(const DepthConflator&) = delete;
+
+private:
+    struct ConflatedBook {
+        std::string ticker;
+        std::unique_ptr<DepthReader> reader;
+        /// the latest view read from the book
+        DepthView latest;
+    };
+
+    struct Subscription {
+        SubscriptionId id;
+        std::chrono::milliseconds interval;
+        Subscriber subscriber;
+        std::optional<std::chrono::steady_clock::time_point> lastDelivery;
+        /// version of each book at its last delivery, indexed like books
+        std::vector<std::optional<uint64_t>> deliveredVersions;
+    };
+
+    std::vector<ConflatedBook> books;
+    std::vector<Subscription> subscriptions;
+    /// subscribed since the last poll, kept apart so a callback can subscribe while poll iterates
+    std::vector<Subscription> pendingSubscriptions;
+    SubscriptionId nextSubscriptionId = 0;
+    std::vector<DepthUpdate> updates;
+
+    uint64_t deliveredUpdates = 0;
+    uint64_t skippedViews = 0;
+};
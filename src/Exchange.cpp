@@ -10,27 +10,55 @@ Exchange::Exchange(const std::string& exchangeName) : exchangeName(exchangeName)
  * @brief Adds an order to the order book of a specific ticker. Supports both limit and market orders.
  * @param ticker The ticker symbol of the instrument.
  * @param orderData Reference to the order data containing the order details.
+ * @return The ID of the order if a remainder of a limit order rests in the book, empty otherwise.
  * @throws std::invalid_argument if a limit price is not provided for limit orders and std::runtime_error if the instrument is not available on the exchange.
  */
-void Exchange::addOrder(const std::string& ticker, OrderData& orderData) {
+std::optional<int64_t> Exchange::addOrder(const std::string& ticker, OrderData& orderData) {
     
     Book* instrumentBook = getOrderBook(ticker);
-    assert(instrumentBook != nullptr);
     
     if (instrumentBook){
         if (orderData.orderType == OrderType::Limit){
-            if (!orderData.limit.has_value()) {
-                throw std::invalid_argument("Limit price must be provided for limit orders.");
-            }
-            
-            instrumentBook->addOrderToBook(orderData, globalOrderId);
+            // the book validates the limit price before matching
+            return instrumentBook->addOrderToBook(orderData, globalOrderId);
         } else if (orderData.orderType == OrderType::Market){
             
-            instrumentBook->placeMarketOrder(orderData.shares, orderData.orderSide);
+            instrumentBook->placeMarketOrder(orderData.shares, orderData.orderSide, orderData.eventTime);
         }
     } else {
+        unknownInstrumentRejects.increment();
         throw std::runtime_error("Can't add order to Exchange. The insturment is not covered by the exchange.");
     }
+    return std::nullopt;
+}
+
+/**
+ * @brief Cancels a resting order.
+ * @param ticker The ticker symbol of the instrument.
+ * @param orderId The ID of the order to be cancelled.
+ * @throws std::invalid_argument if the order is not in the book.
+ */
+void Exchange::cancelOrder(const std::string& ticker, int64_t orderId) {
+    
+    Book* instrumentBook = getOrderBook(ticker);
+    assert(instrumentBook != nullptr);
+    instrumentBook->cancelOrder(orderId);
+}
+
+/**
+ * @brief Applies a command to the book of an instrument, without throwing on rejects.
+ * @param ticker The ticker symbol of the instrument.
+ * @param command The command.
+ * @return Whether the command was accepted and the id of the resting order, if any.
+ */
+CommandResult Exchange::applyCommand(const std::string& ticker, const BookCommand& command) {
+    
+    Book* instrumentBook = getOrderBook(ticker);
+    if (!instrumentBook) {
+        unknownInstrumentRejects.increment();
+        return {false, std::nullopt};
+    }
+    return ::applyCommand(*instrumentBook, command, globalOrderId);
 }
 
 /**
@@ -106,7 +134,8 @@ Book* Exchange::getOrderBook(const std::string& ticker) const {
 }
 
 /**
- * @brief Retrieves the National Best Bid and Offer (NBBO) for a specific instrument.
+ * @brief Retrieves the best bid and offer of an instrument on this exchange. The best bid and offer
+ *        across several exchanges is maintained by a QuoteConsolidator.
  * @param ticker The ticker symbol of the instrument.
  * @return A pair of optional integers representing the best bid and best offer prices.
  *         If either the bid or offer is unavailable, the corresponding optional will be nullopt.
@@ -138,3 +167,50 @@ std::pair<std::optional<int>, std::optional<int>> Exchange::getNBBO(const std::s
 
     return {bestBid, bestOffer};
 }
+
+/**
+ * @brief Returns the name of the exchange.
+ * @return The exchange name.
+ */
+const std::string& Exchange::getExchangeName() const {
+    return exchangeName;
+}
+
+/**
+ * @brief Returns the sequence assigning ids to the orders of every book, for callers that apply
+ *        commands to the books directly.
+ * @return The order id sequence.
+ */
+OrderIdSequence& Exchange::getOrderIdSequence() {
+    return globalOrderId;
+}
+
+/**
+ * @brief Takes a snapshot of the counters of every order book. The counters are read without
+ *        stopping the threads updating them, so the values of different books are not taken at the
+ *        same instant. Instruments must not be added or removed while a snapshot is being taken.
+ * @return The counters of the exchange and of each of its books, keyed by ticker.
+ */
+ExchangeMetricsSnapshot Exchange::getMetricsSnapshot() const {
+    
+    ExchangeMetricsSnapshot snapshot;
+    snapshot.exchangeName = exchangeName;
+    snapshot.unknownInstrumentRejects = unknownInstrumentRejects.get();
+    for (const auto& [ticker, book] : tickerLob) {
+        snapshot.books.emplace(ticker, book->getMetrics().snapshot());
+    }
+    return snapshot;
+}
+
+/**
+ * @brief Recommends a level storage policy for every instrument from the workload observed by its book.
+ * @return The recommendations keyed by ticker.
+ */
+std::map<std::string, StorageRecommendation> Exchange::getStorageRecommendations() const {
+    
+    std::map<std::string, StorageRecommendation> recommendations;
+    for (const auto& [ticker, book] : tickerLob) {
+        recommendations.emplace(ticker, StorageAdvisor::recommend(book->getStatisticsSnapshot()));
+    }
+    return recommendations;
+}
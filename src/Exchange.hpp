@@ -28,10 +28,13 @@
 #define Exchange_hpp
 
 #include "Book.h"
+#include "BookCommand.h"
+#include "StorageAdvisor.h"
 #include <cassert>
 #include <utility>
 #include <optional>
 #include <vector>
+#include <map>
 #include <unordered_map>
 #include <string>
 
@@ -44,7 +47,9 @@ class Exchange {
 public:
     Exchange(const std::string& exchangeName);
     
-    void addOrder(const std::string& ticker, OrderData& orderData);
+    std::optional<int64_t> addOrder(const std::string& ticker, OrderData& orderData);
+    void cancelOrder(const std::string& ticker, int64_t orderId);
+    CommandResult applyCommand(const std::string& ticker, const BookCommand& command);
     
     void modifyLimitPrice(const std::string& ticker, int64_t orderId, int newLimitPrice);
     void modifyOrderSize(const std::string& ticker, int64_t orderId, int newSize);
@@ -55,6 +60,12 @@ public:
     Book* getOrderBook(const std::string& ticker) const;
     std::vector<std::string> getTickerList() const;
     std::pair<std::optional<int>, std::optional<int>> getNBBO(const std::string& ticker) const;
+    const std::string& getExchangeName() const;
+    OrderIdSequence& getOrderIdSequence();
+    
+    // metrics
+    ExchangeMetricsSnapshot getMetricsSnapshot() const;
+    std::map<std::string, StorageRecommendation> getStorageRecommendations() const;
     
     // Deleted copy constructor and assignment operator to prevent copying
     Exchange(const Exchange&) = delete;
@@ -67,6 +78,8 @@ private:
     std::string exchangeName;
     /// Order ID sequence generator
     OrderIdSequence globalOrderId;
+    /// orders rejected because their instrument is not covered by the exchange
+    MetricsCounter unknownInstrumentRejects;
 };
 
 #endif /* Exchange_hpp */
@@ -0,0 +1,54 @@
+#include "Executor.h"
+
+/**
+ * @brief Resumes the coroutine right away.
+ * @param task The task to resume.
+ */
+void InlineExecutor::post(ExecutorTask* task) {
+    task->handle.resume();
+}
+
+/**
+ * @brief Queues a coroutine for the owning thread.
+ * @param task The task to resume, which must stay valid until it is resumed.
+ */
+void EventLoopExecutor::post(ExecutorTask* task) {
+    task->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(task->next, task, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Resumes every queued coroutine, in the order they were posted.
+ * @return The number of coroutines resumed.
+ */
+size_t EventLoopExecutor::runPending() {
+    ExecutorTask* posted = head.exchange(nullptr, std::memory_order_acquire);
+
+    // the list is newest first, reverse it to resume in posting order
+    ExecutorTask* ordered = nullptr;
+    while (posted) {
+        ExecutorTask* next = posted->next;
+        posted->next = ordered;
+        ordered = posted;
+        posted = next;
+    }
+
+    size_t resumed = 0;
+    while (ordered) {
+        // the task may be reused as soon as its coroutine runs, so read the link first
+        ExecutorTask* next = ordered->next;
+        ordered->handle.resume();
+        ordered = next;
+        ++resumed;
+    }
+    return resumed;
+}
+
+/**
+ * @brief Tells whether coroutines are waiting to be resumed.
+ * @return True if runPending would resume at least one coroutine.
+ */
+bool EventLoopExecutor::hasPending() const {
+    return head.load(std::memory_order_acquire) != nullptr;
+}
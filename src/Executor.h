@@ -0,0 +1,76 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+
+/**
+ * @struct ExecutorTask
+ * @brief A coroutine waiting to be resumed by an executor. Tasks are linked intrusively, so posting
+ *        one never allocates: the task lives in the record of the operation that completed.
+ */
+struct ExecutorTask {
+    std::coroutine_handle<> handle;
+    ExecutorTask* next = nullptr;
+};
+
+/**
+ * @class Executor
+ * @brief Decides on which thread a completed operation resumes its coroutine.
+ */
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual void post(ExecutorTask* task) = 0;
+};
+
+/**
+ * @class InlineExecutor
+ * @brief Resumes coroutines immediately on the thread completing the operation, typically a matching
+ *        thread. Only suitable for coroutines that do very little before awaiting again.
+ */
+class InlineExecutor : public Executor {
+public:
+    void post(ExecutorTask* task) override;
+};
+
+/**
+ * @class EventLoopExecutor
+ * @brief Collects the coroutines to resume until the owning thread runs them. Any thread can post,
+ *        with a single compare and swap; only the owning thread calls runPending.
+ */
+class EventLoopExecutor : public Executor {
+public:
+    void post(ExecutorTask* task) override;
+
+    size_t runPending();
+    bool hasPending() const;
+
+private:
+    /// most recently posted task, linked to the previously posted ones
+    std::atomic<ExecutorTask*> head{nullptr};
+};
@@ -0,0 +1,61 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include "Side.hpp"
+
+/**
+ * @struct Fill
+ * @brief An execution of an aggressive order against a resting order, or of a resting buy against
+ *        a resting sell in a batch auction or a dark cross. Prices are in cents.
+ */
+struct Fill {
+    /// position of the fill in the book's fill stream, starting at 0
+    uint64_t sequence;
+    /// id of the resting order that was executed
+    int64_t restingOrderId;
+    /// execution price, the limit price of the resting order
+    int price;
+    /// executed volume
+    int shares;
+    /// side of the aggressive order
+    Side aggressorSide;
+    /// event time of the aggressive order, in seconds like OrderData::eventTime
+    int eventTime;
+    /// id of the buy order when both orders were resting: restingOrderId is then the sell order and
+    /// aggressorSide is Buy. -1 when an aggressive order took the liquidity
+    int64_t contraOrderId = -1;
+};
+
+/**
+ * @class FillSink
+ * @brief Receives the fills of a book, in order, on the thread that performs the matching.
+ */
+class FillSink {
+public:
+    virtual ~FillSink() = default;
+    virtual void onFill(const Fill& fill) = 0;
+};
@@ -0,0 +1,137 @@
+#include "ImpactEstimator.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+size_t queryIndex(Side side) {
+    return side == Side::Buy ? 0 : 1;
+}
+
+} // namespace
+
+/**
+ * @brief Registers a reader on the published depth of a book.
+ * @param ticker The ticker of the book.
+ * @param depth The published depth, which must outlive the estimator.
+ * @return The index of the instrument in queries.
+ * @throws std::runtime_error if the published depth has no free reader slot.
+ */
+uint32_t ImpactEstimator::addBook(const std::string& ticker, PublishedDepth& depth) {
+    Instrument instrument;
+    instrument.ticker = ticker;
+    instrument.reader = std::make_unique<DepthReader>(depth);
+    instruments.push_back(std::move(instrument));
+    return static_cast<uint32_t>(instruments.size() - 1);
+}
+
+/**
+ * @brief Estimates a batch of queries.
+ * @param queries The queries.
+ * @param count The number of queries.
+ * @param estimates Receives one estimate per query.
+ * @throws std::out_of_range if a query refers to an unknown instrument.
+ */
+void ImpactEstimator::estimate(const ImpactQuery* queries, size_t count, ImpactEstimate* estimates) {
+    ++batch;
+    for (size_t i = 0; i < count; ++i) {
+        if (queries[i].instrument >= instruments.size()) {
+            throw std::out_of_range("Unknown instrument in impact query.");
+        }
+        Instrument& instrument = instruments[queries[i].instrument];
+        if (instrument.readInBatch != batch) {
+            refresh(instrument);
+        }
+        estimateOne(instrument, queries[i], estimates[i]);
+    }
+}
+
+/**
+ * @brief Estimates a batch of queries.
+ * @param queries The queries.
+ * @return One estimate per query.
+ * @throws std::out_of_range if a query refers to an unknown instrument.
+ */
+std::vector<ImpactEstimate> ImpactEstimator::estimate(const std::vector<ImpactQuery>& queries) {
+    std::vector<ImpactEstimate> estimates(queries.size());
+    estimate(queries.data(), queries.size(), estimates.data());
+    return estimates;
+}
+
+const std::string& ImpactEstimator::getTicker(uint32_t instrument) const {
+    return instruments.at(instrument).ticker;
+}
+
+/**
+ * @brief Returns how many times a new view was turned into cumulative depth.
+ * @return The number of refreshes.
+ */
+uint64_t ImpactEstimator::getViewRefreshes() const {
+    return viewRefreshes;
+}
+
+/**
+ * @brief Reads the current view of an instrument and, if it is a new one, rebuilds the running
+ *        volume and notional of both sides.
+ */
+void ImpactEstimator::refresh(Instrument& instrument) {
+    instrument.readInBatch = batch;
+    const DepthView view = instrument.reader->read();
+    if (instrument.hasView && view.version == instrument.version) {
+        return;
+    }
+    instrument.hasView = true;
+    instrument.version = view.version;
+    ++viewRefreshes;
+
+    instrument.midPrice = (view.bidLevels > 0 && view.askLevels > 0)
+                              ? (static_cast<double>(view.bids[0].price) + view.asks[0].price) / 2
+                              : std::numeric_limits<double>::quiet_NaN();
+    auto accumulate = [](const std::array<DepthLevel, publishedDepthLevels>& levels, int count, CumulativeSide& side) {
+        side.levels = count;
+        int64_t volume = 0;
+        double notional = 0;
+        for (int i = 0; i < count; ++i) {
+            volume += levels[i].volume;
+            notional += static_cast<double>(levels[i].price) * levels[i].volume;
+            side.prices[i] = levels[i].price;
+            side.volume[i] = volume;
+            side.notional[i] = notional;
+        }
+    };
+    accumulate(view.asks, view.askLevels, instrument.consumed[queryIndex(Side::Buy)]);
+    accumulate(view.bids, view.bidLevels, instrument.consumed[queryIndex(Side::Sell)]);
+}
+
+/**
+ * @brief Walks the cumulative levels consumed by a query until they hold its shares.
+ */
+void ImpactEstimator::estimateOne(const Instrument& instrument, const ImpactQuery& query, ImpactEstimate& estimate) {
+    const CumulativeSide& side = instrument.consumed[queryIndex(query.side)];
+    estimate = ImpactEstimate{};
+    estimate.midPrice = instrument.midPrice;
+    if (query.shares <= 0 || side.levels == 0) {
+        estimate.complete = query.shares <= 0;
+        estimate.slippage = std::numeric_limits<double>::quiet_NaN();
+        estimate.slippageBps = std::numeric_limits<double>::quiet_NaN();
+        return;
+    }
+
+    int level = 0;
+    while (level < side.levels - 1 && side.volume[level] < query.shares) {
+        ++level;
+    }
+    const int64_t before = level > 0 ? side.volume[level - 1] : 0;
+    const double notionalBefore = level > 0 ? side.notional[level - 1] : 0;
+    estimate.complete = side.volume[level] >= query.shares;
+    estimate.filledShares = estimate.complete ? query.shares : side.volume[level];
+    const double notional = notionalBefore + static_cast<double>(estimate.filledShares - before) * side.prices[level];
+    estimate.averagePrice = notional / static_cast<double>(estimate.filledShares);
+    estimate.levelsConsumed = level + 1;
+    estimate.worstPrice = side.prices[level];
+    estimate.slippage = query.side == Side::Buy ? estimate.averagePrice - estimate.midPrice
+                                                : estimate.midPrice - estimate.averagePrice;
+    estimate.slippageBps = estimate.slippage / estimate.midPrice * 10000;
+}
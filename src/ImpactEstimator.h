@@ -0,0 +1,122 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PublishedDepth.h"
+
+/**
+ * @struct ImpactQuery
+ * @brief How much would it cost to execute shares on one side of an instrument right now.
+ */
+struct ImpactQuery {
+    /// index returned by ImpactEstimator::addBook
+    uint32_t instrument;
+    /// side of the order to execute: buys consume the asks, sells the bids
+    Side side;
+    int64_t shares;
+};
+
+/**
+ * @struct ImpactEstimate
+ * @brief The cost of executing a query against the displayed depth. Prices are in cents.
+ */
+struct ImpactEstimate {
+    /// whether the displayed depth holds the whole quantity
+    bool complete = false;
+    /// shares the displayed depth can fill, the query's shares when complete
+    int64_t filledShares = 0;
+    /// average execution price of the filled shares, 0 if nothing can be filled
+    double averagePrice = 0;
+    /// midpoint of the best bid and ask, NaN if either side is empty
+    double midPrice = 0;
+    /// how much worse than the mid the average price is, in cents and in basis points of the mid
+    double slippage = 0;
+    double slippageBps = 0;
+    /// price levels touched, the last one possibly partially
+    int levelsConsumed = 0;
+    /// price of the last level touched
+    int worstPrice = 0;
+};
+
+/**
+ * @class ImpactEstimator
+ * @brief Estimates execution costs from the depth views published by the matching threads, never
+ *        from the books themselves. Each batch reads the view of every instrument it queries once,
+ *        so all queries of a batch see the same depth, and rebuilds the cumulative volume and
+ *        notional of the view only when a new one was published; each query is then a scan over
+ *        at most publishedDepthLevels cumulative levels. An estimator registers a DepthReader on
+ *        each book and is used by a single thread.
+ */
+class ImpactEstimator {
+public:
+    ImpactEstimator() = default;
+
+    uint32_t addBook(const std::string& ticker, PublishedDepth& depth);
+    void estimate(const ImpactQuery* queries, size_t count, ImpactEstimate* estimates);
+    std::vector<ImpactEstimate> estimate(const std::vector<ImpactQuery>& queries);
+
+    const std::string& getTicker(uint32_t instrument) const;
+    uint64_t getViewRefreshes() const;
+
+    ImpactEstimator(const ImpactEstimator&) = delete;
+    ImpactEstimator& operator=(const ImpactEstimator&) = delete;
+
+private:
+    /**
+     * @struct CumulativeSide
+     * @brief Running totals over the levels of one side of a view, best level first.
+     */
+    struct CumulativeSide {
+        int levels = 0;
+        std::array<int, publishedDepthLevels> prices{};
+        std::array<int64_t, publishedDepthLevels> volume{};
+        std::array<double, publishedDepthLevels> notional{};
+    };
+
+    struct Instrument {
+        std::string ticker;
+        std::unique_ptr<DepthReader> reader;
+        /// batch in which the view was last read
+        uint64_t readInBatch = 0;
+        bool hasView = false;
+        uint64_t version = 0;
+        double midPrice = 0;
+        /// asks then bids, indexed by the side of the queries that consume them
+        CumulativeSide consumed[2];
+    };
+
+    void refresh(Instrument& instrument);
+    static void estimateOne(const Instrument& instrument, const ImpactQuery& query, ImpactEstimate& estimate);
+
+    std::vector<Instrument> instruments;
+    uint64_t batch = 0;
+    uint64_t viewRefreshes = 0;
+};
@@ -0,0 +1,407 @@
+#include "Journal.h"
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint8_t typeMask = 0x07;
+constexpr uint8_t sellFlag = 0x08;
+constexpr uint8_t instrumentFlag = 0x10;
+constexpr uint8_t eventTimeFlag = 0x20;
+constexpr uint8_t minQuantityFlag = 0x40;
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+} // namespace
+
+/**
+ * @brief Creates the journal and writes its magic.
+ * @param path The path of the journal, truncated if it exists.
+ * @param bufferBytes Bytes buffered before they are written to the file.
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+JournalWriter::JournalWriter(const std::string& path, size_t bufferBytes)
+    : file(path, std::ios::binary | std::ios::trunc), bufferBytes(bufferBytes), lastInstrument(UINT32_MAX),
+      lastEventTime(0), recordsWritten(0), bytesWritten(sizeof(magic)) {
+    if (!file) {
+        throw std::runtime_error("Can't open journal " + path);
+    }
+    file.write(magic, sizeof(magic));
+    buffer.reserve(bufferBytes + 64);
+}
+
+/**
+ * @brief Writes the records still buffered.
+ */
+JournalWriter::~JournalWriter() {
+    flush();
+}
+
+/**
+ * @brief Declares an instrument. Its records refer to it by the returned index.
+ * @param ticker The ticker of the instrument.
+ * @return The index of the instrument, the number of instruments declared before it.
+ */
+uint32_t JournalWriter::addInstrument(const std::string& ticker) {
+    buffer.push_back(static_cast<uint8_t>(JournalRecordType::Instrument));
+    putVarint(ticker.size());
+    buffer.insert(buffer.end(), ticker.begin(), ticker.end());
+    instruments.emplace_back();
+    ++recordsWritten;
+    return static_cast<uint32_t>(instruments.size() - 1);
+}
+
+/**
+ * @brief Appends a book command.
+ * @param instrument The index of the instrument, as returned by addInstrument.
+ * @param command The command.
+ */
+void JournalWriter::append(uint32_t instrument, const BookCommand& command) {
+    switch (command.type) {
+        case CommandType::Add:
+            beginRecord(JournalRecordType::Add, command.side, instrument, command.eventTime, command.minQuantity ? minQuantityFlag : 0);
+            putVarint(static_cast<uint64_t>(command.shares));
+            putPrice(instrument, command.price);
+            if (command.minQuantity) {
+                putSigned(command.minQuantity);
+            }
+            break;
+        case CommandType::Cancel:
+            beginRecord(JournalRecordType::Cancel, command.side, instrument, command.eventTime);
+            putOrderId(instrument, command.orderId);
+            break;
+        case CommandType::ModifySize:
+            beginRecord(JournalRecordType::ModifySize, command.side, instrument, command.eventTime);
+            putOrderId(instrument, command.orderId);
+            putVarint(static_cast<uint64_t>(command.shares));
+            break;
+        case CommandType::Market:
+            beginRecord(JournalRecordType::Market, command.side, instrument, command.eventTime);
+            putVarint(static_cast<uint64_t>(command.shares));
+            break;
+    }
+    if (buffer.size() >= bufferBytes) {
+        flush();
+    }
+}
+
+/**
+ * @brief Appends a live order with its id, for compacted journals.
+ */
+void JournalWriter::appendRestore(uint32_t instrument, int64_t orderId, Side side, int shares, int price, int minQuantity) {
+    beginRecord(JournalRecordType::Restore, side, instrument, lastEventTime, minQuantity ? minQuantityFlag : 0);
+    putOrderId(instrument, orderId);
+    putVarint(static_cast<uint64_t>(shares));
+    putPrice(instrument, price);
+    if (minQuantity) {
+        putSigned(minQuantity);
+    }
+    if (buffer.size() >= bufferBytes) {
+        flush();
+    }
+}
+
+/**
+ * @brief Appends the next order id of an instrument, for compacted journals.
+ */
+void JournalWriter::appendNextOrderId(uint32_t instrument, int64_t nextOrderId) {
+    beginRecord(JournalRecordType::NextOrderId, Side::Buy, instrument, lastEventTime);
+    putVarint(static_cast<uint64_t>(nextOrderId));
+}
+
+/**
+ * @brief Writes the buffered records to the file.
+ */
+void JournalWriter::flush() {
+    if (buffer.empty()) {
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    file.flush();
+    bytesWritten += buffer.size();
+    buffer.clear();
+}
+
+/**
+ * @brief Returns the number of records appended, instrument declarations included.
+ * @return The number of records.
+ */
+uint64_t JournalWriter::getRecordsWritten() const {
+    return recordsWritten;
+}
+
+/**
+ * @brief Returns the size of the journal once flushed.
+ * @return The number of bytes, magic included.
+ */
+uint64_t JournalWriter::getBytesWritten() const {
+    return bytesWritten + buffer.size();
+}
+
+void JournalWriter::beginRecord(JournalRecordType type, Side side, uint32_t instrument, int eventTime, uint8_t flags) {
+    if (instrument >= instruments.size()) {
+        throw std::out_of_range("Journal record for an undeclared instrument.");
+    }
+    uint8_t tag = static_cast<uint8_t>(type) | flags;
+    if (side == Side::Sell) {
+        tag |= sellFlag;
+    }
+    if (instrument != lastInstrument) {
+        tag |= instrumentFlag;
+    }
+    if (eventTime != lastEventTime) {
+        tag |= eventTimeFlag;
+    }
+    buffer.push_back(tag);
+    if (instrument != lastInstrument) {
+        putVarint(instrument);
+        lastInstrument = instrument;
+    }
+    if (eventTime != lastEventTime) {
+        putSigned(static_cast<int64_t>(eventTime) - lastEventTime);
+        lastEventTime = eventTime;
+    }
+    ++recordsWritten;
+}
+
+void JournalWriter::putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void JournalWriter::putSigned(int64_t value) {
+    putVarint(zigzag(value));
+}
+
+void JournalWriter::putOrderId(uint32_t instrument, int64_t orderId) {
+    putSigned(orderId - instruments[instrument].lastOrderId);
+    instruments[instrument].lastOrderId = orderId;
+}
+
+void JournalWriter::putPrice(uint32_t instrument, int price) {
+    putSigned(static_cast<int64_t>(price) - instruments[instrument].lastPrice);
+    instruments[instrument].lastPrice = price;
+}
+
+/**
+ * @brief Opens a journal and checks its magic.
+ * @param path The path of the journal.
+ * @throws std::runtime_error if the file cannot be opened or is not a journal.
+ */
+JournalReader::JournalReader(const std::string& path)
+    : file(path, std::ios::binary), position(0), lastInstrument(0), lastEventTime(0), truncated(false) {
+    char header[sizeof(JournalWriter::magic)];
+    if (!file || !file.read(header, sizeof(header)) || std::memcmp(header, JournalWriter::magic, sizeof(header)) != 0) {
+        throw std::runtime_error("Not a journal: " + path);
+    }
+}
+
+/**
+ * @brief Decodes the next record. A record cut short by the end of the file, as left by a crash
+ *        in the middle of a write, ends the journal.
+ * @param record Receives the record.
+ * @return False at the end of the journal.
+ */
+bool JournalReader::next(JournalRecord& record) {
+    uint8_t tag;
+    if (!getByte(tag)) {
+        return false;
+    }
+    truncated = false;
+    record = JournalRecord{};
+    record.type = static_cast<JournalRecordType>(tag & typeMask);
+
+    if (record.type == JournalRecordType::Instrument) {
+        const uint64_t length = getVarint();
+        for (uint64_t i = 0; i < length && !truncated; ++i) {
+            uint8_t byte;
+            if (getByte(byte)) {
+                record.ticker.push_back(static_cast<char>(byte));
+            }
+        }
+        record.instrument = static_cast<uint32_t>(instruments.size());
+        instruments.emplace_back();
+        return !truncated;
+    }
+
+    if (tag & instrumentFlag) {
+        lastInstrument = static_cast<uint32_t>(getVarint());
+    }
+    if (tag & eventTimeFlag) {
+        lastEventTime += static_cast<int>(getSigned());
+    }
+    if (truncated || lastInstrument >= instruments.size()) {
+        return false;
+    }
+    record.instrument = lastInstrument;
+    InstrumentState& state = instruments[lastInstrument];
+
+    BookCommand& command = record.command;
+    command.side = (tag & sellFlag) ? Side::Sell : Side::Buy;
+    command.orderId = -1;
+    command.eventTime = lastEventTime;
+    switch (record.type) {
+        case JournalRecordType::Add:
+            command.type = CommandType::Add;
+            command.shares = static_cast<int>(getVarint());
+            state.lastPrice += static_cast<int>(getSigned());
+            command.price = state.lastPrice;
+            if (tag & minQuantityFlag) {
+                command.minQuantity = static_cast<int>(getSigned());
+            }
+            break;
+        case JournalRecordType::Cancel:
+            command.type = CommandType::Cancel;
+            state.lastOrderId += getSigned();
+            command.orderId = state.lastOrderId;
+            break;
+        case JournalRecordType::ModifySize:
+            command.type = CommandType::ModifySize;
+            state.lastOrderId += getSigned();
+            command.orderId = state.lastOrderId;
+            command.shares = static_cast<int>(getVarint());
+            break;
+        case JournalRecordType::Market:
+            command.type = CommandType::Market;
+            command.shares = static_cast<int>(getVarint());
+            break;
+        case JournalRecordType::Restore:
+            command.type = CommandType::Add;
+            state.lastOrderId += getSigned();
+            command.orderId = state.lastOrderId;
+            command.shares = static_cast<int>(getVarint());
+            state.lastPrice += static_cast<int>(getSigned());
+            command.price = state.lastPrice;
+            if (tag & minQuantityFlag) {
+                command.minQuantity = static_cast<int>(getSigned());
+            }
+            break;
+        case JournalRecordType::NextOrderId:
+            command.orderId = static_cast<int64_t>(getVarint());
+            break;
+        default:
+            return false;
+    }
+    return !truncated;
+}
+
+bool JournalReader::fill() {
+    buffer.resize(1 << 16);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    buffer.resize(static_cast<size_t>(file.gcount()));
+    position = 0;
+    return !buffer.empty();
+}
+
+bool JournalReader::getByte(uint8_t& byte) {
+    if (position == buffer.size() && !fill()) {
+        truncated = true;
+        return false;
+    }
+    byte = buffer[position++];
+    return true;
+}
+
+uint64_t JournalReader::getVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte;
+        if (!getByte(byte)) {
+            return 0;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+int64_t JournalReader::getSigned() {
+    return unzigzag(getVarint());
+}
+
+/**
+ * @brief Rebuilds the books of a journal. Commands are applied like the matching thread did, so
+ *        resting orders get the ids they had; restored orders get their recorded ids.
+ * @param path The path of the journal.
+ * @return The books, one per instrument declared in the journal.
+ * @throws std::runtime_error if the file is not a journal.
+ */
+JournalRecovery recoverJournal(const std::string& path) {
+    JournalReader reader(path);
+    JournalRecovery recovery;
+    JournalRecord record;
+    while (reader.next(record)) {
+        ++recovery.records;
+        if (record.type == JournalRecordType::Instrument) {
+            recovery.books.push_back({record.ticker, std::make_unique<Book>(), std::make_unique<OrderIdSequence>()});
+            continue;
+        }
+
+        RecoveredBook& book = recovery.books[record.instrument];
+        if (record.type == JournalRecordType::NextOrderId) {
+            book.orderIdSequence->restore(record.command.orderId);
+            continue;
+        }
+        if (record.type == JournalRecordType::Restore) {
+            book.orderIdSequence->restore(record.command.orderId);
+        }
+        if (!applyCommand(*book.book, record.command, *book.orderIdSequence).accepted) {
+            ++recovery.rejectedCommands;
+        }
+    }
+    return recovery;
+}
+
+/**
+ * @brief Rewrites a journal as the state it leads to: for each instrument its live orders, in id
+ *        order so that they keep their time priority within their level, and its next order id.
+ *        Recovering the compacted journal gives the same books, with the same order ids, as
+ *        recovering the original one.
+ * @param inputPath The journal to compact.
+ * @param outputPath The compacted journal, truncated if it exists.
+ * @return The sizes of both journals.
+ * @throws std::runtime_error if a file cannot be opened or the input is not a journal.
+ */
+CompactionStats compactJournal(const std::string& inputPath, const std::string& outputPath) {
+    JournalRecovery recovery = recoverJournal(inputPath);
+    CompactionStats stats;
+    stats.inputRecords = recovery.records;
+    {
+        std::ifstream input(inputPath, std::ios::binary | std::ios::ate);
+        stats.inputBytes = static_cast<uint64_t>(input.tellg());
+    }
+
+    JournalWriter writer(outputPath);
+    for (const RecoveredBook& book : recovery.books) {
+        writer.addInstrument(book.ticker);
+    }
+    for (uint32_t instrument = 0; instrument < recovery.books.size(); ++instrument) {
+        const RecoveredBook& book = recovery.books[instrument];
+        std::map<int64_t, const Order*> liveOrders;
+        for (const auto& [orderId, order] : *book.book->getAllOrders()) {
+            liveOrders.emplace(orderId, order.get());
+        }
+        for (const auto& [orderId, order] : liveOrders) {
+            writer.appendRestore(instrument, orderId, order->getOrderSide(), order->getShares(), order->getLimit(), order->getMinQuantity());
+        }
+        writer.appendNextOrderId(instrument, book.orderIdSequence->peekNextId());
+        stats.liveOrders += liveOrders.size();
+    }
+    writer.flush();
+    stats.outputRecords = writer.getRecordsWritten();
+    stats.outputBytes = writer.getBytesWritten();
+    return stats;
+}
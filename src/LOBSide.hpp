@@ -25,9 +25,13 @@
 #ifndef LOBSIDE_HPP
 #define LOBSIDE_HPP
 
+#include <iterator>
 #include <map>
 #include <memory>
 #include "Limit.h"
+#include "BookAnalytics.h"
+#include "BookStatistics.h"
+#include "Metrics.h"
 #include "Side.hpp"
 
 class Book;
@@ -41,13 +45,16 @@ class Limit;
 template<Side S>
 class LOBSide {
 public:
-    LOBSide(Book& book);
+    LOBSide(Book& book, BookMetrics& metrics, BookStatistics& statistics);
 
     Limit* findLimit(int limitPrice) const;
-    void addOrderToSide(OrderData& orderData, OrderIdSequence& orderIdSequence);
+    Limit* getNextLimit(const Limit* limit) const;
+    int getMatchableVolume(int volume, int limitPrice) const;
+    int64_t addOrderToSide(OrderData& orderData, OrderIdSequence& orderIdSequence);
     void placeMarketOrder(int volume);
     void executeOrder(int& volume, Limit*& LimitToExecute);
     void cancelLimit(Limit* limitToCancel);
+    void adjustTopDepth(int limitPrice, int volumeChange);
 
     LOBSide(const LOBSide&) = delete;
     LOBSide& operator=(const LOBSide&) = delete;
@@ -56,6 +63,8 @@ public:
     Limit* getBestLimit() const;
     int getSideVolume() const;
     const std::map<int, std::unique_ptr<Limit>>& getSideTree() const;
+    const TopDepth& getTopDepth() const;
+    uint64_t getTopDepthVersion() const;
     
 private:
     /// Stores all limits for this side, mapped by limit price
@@ -64,10 +73,22 @@ private:
     int sideVolume;
     /// Pointer to the best limit for this side
     Limit* bestLimit;
+    /// Running aggregates over the best analyticsDepth levels
+    TopDepth topDepth;
+    /// Price of the worst level included in topDepth
+    int topDepthBoundary;
+    /// Incremented every time topDepth changes
+    uint64_t topDepthVersion;
     
     Book& book;
+    /// Counters of the book this side belongs to
+    BookMetrics& metrics;
+    /// Workload statistics of the book this side belongs to
+    BookStatistics& statistics;
     
     void updateBestLimit();
+    bool isWithinTopDepth(int limitPrice) const;
+    void recomputeTopDepth();
     
     static int getCurrentTimeSeconds();
 };
@@ -75,28 +96,51 @@ private:
 /**
  * @brief Constructor that initializes the side of the order book.
  * @param book Reference to the order book to which this side belongs.
+ * @param metrics Reference to the counters of the order book.
+ * @param statistics Reference to the workload statistics of the order book.
  */
 template<Side S>
-LOBSide<S>::LOBSide(Book& book) : sideVolume(0), bestLimit(nullptr), book(book) {}
+LOBSide<S>::LOBSide(Book& book, BookMetrics& metrics, BookStatistics& statistics)
+    : sideVolume(0), bestLimit(nullptr), topDepthBoundary(0), topDepthVersion(0), book(book), metrics(metrics), statistics(statistics) {}
 
 /**
  * @brief Adds an order to the side of the order book.
  * @param orderData Reference to the order data containing the order details.
  * @param orderIdSequence Reference to the OrderIdSequence for generating a unique order ID.
+ * @return The ID assigned to the order.
  */
 template<Side S>
-void LOBSide<S>::addOrderToSide(OrderData& orderData, OrderIdSequence& orderIdSequence) {
+int64_t LOBSide<S>::addOrderToSide(OrderData& orderData, OrderIdSequence& orderIdSequence) {
     
     sideVolume += orderData.shares;
-    Limit* limitToAdd = findLimit(orderData.limit.value());
+    const int limitPrice = orderData.limit.value();
+
+    // Distance from the touch in ticks, 0 when the order sets or improves the best price
+    int ticksFromTouch = 0;
+    if (bestLimit) {
+        ticksFromTouch = (S == Side::Buy) ? bestLimit->getLimitPrice() - limitPrice : limitPrice - bestLimit->getLimitPrice();
+    }
+    statistics.touchDistance.observe(ticksFromTouch > 0 ? ticksFromTouch : 0);
+
+    Limit* limitToAdd = findLimit(limitPrice);
     if (!limitToAdd) {
-        auto newLimit = std::make_unique<Limit>(orderData.limit.value());
+        auto newLimit = std::make_unique<Limit>(limitPrice, metrics.ordersAdded.get());
         limitToAdd = newLimit.get();
-        sideTree.emplace(orderData.limit.value(), std::move(newLimit));
+        sideTree.emplace(limitPrice, std::move(newLimit));
         updateBestLimit();
+        if (isWithinTopDepth(limitPrice)) {
+            recomputeTopDepth();
+        }
+        metrics.levelsCreated.increment();
+        statistics.levelCreations.increment();
+    } else {
+        statistics.levelJoins.increment();
     }
 
-    limitToAdd->addOrderToLimit(orderData, book, orderIdSequence);
+    const int64_t orderId = limitToAdd->addOrderToLimit(orderData, book, orderIdSequence);
+    adjustTopDepth(limitPrice, orderData.shares);
+    statistics.queueLength.observe(limitToAdd->getSize());
+    return orderId;
 }
 
 /**
@@ -115,6 +159,51 @@ Limit* LOBSide<S>::findLimit(int limitPrice) const {
     }
 }
 
+/**
+ * @brief Finds the limit that comes after a given one in price priority.
+ * @param limit A limit of this side.
+ * @return Pointer to the next worse limit, nullptr if the given one is the worst.
+ */
+template<Side S>
+Limit* LOBSide<S>::getNextLimit(const Limit* limit) const {
+    
+    if constexpr (S == Side::Buy) {
+        auto it = sideTree.find(limit->getLimitPrice());
+        return it == sideTree.begin() ? nullptr : std::prev(it)->second.get();
+    } else {
+        auto it = sideTree.upper_bound(limit->getLimitPrice());
+        return it == sideTree.end() ? nullptr : it->second.get();
+    }
+}
+
+/**
+ * @brief Computes how much of an incoming limit order would execute against this side, taking the
+ *        all-or-none and minimum quantity orders that would refuse it into account.
+ * @param volume Volume of the incoming order.
+ * @param limitPrice Limit price of the incoming order, which executes against the levels it crosses.
+ * @return The volume that would execute.
+ */
+template<Side S>
+int LOBSide<S>::getMatchableVolume(int volume, int limitPrice) const {
+    
+    int matchable = 0;
+    auto accumulate = [&](const auto& level) {
+        const bool crosses = (S == Side::Sell) ? limitPrice > level.first : limitPrice < level.first;
+        if (!crosses) {
+            return false;
+        }
+        matchable += level.second->getEligibleVolume(volume - matchable);
+        return matchable < volume;
+    };
+
+    if constexpr (S == Side::Buy) {
+        for (auto it = sideTree.rbegin(); it != sideTree.rend() && accumulate(*it); ++it) {}
+    } else {
+        for (auto it = sideTree.begin(); it != sideTree.end() && accumulate(*it); ++it) {}
+    }
+    return matchable;
+}
+
 /**
  * @brief Updates the best limit for the side, which is the highest price for buy side
  *        and the lowest price for sell side.
@@ -134,7 +223,8 @@ void LOBSide<S>::updateBestLimit() {
 }
 
 /**
- * @brief Places a market order, executing it against existing limit orders on the side.
+ * @brief Places a market order, executing it against existing limit orders on the side. Volume
+ *        refused by every all-or-none and minimum quantity order left is not executed.
  * @param volume Volume of the market order.
  * @throws std::runtime_error if the market order size is too large to be executed
  *         or if no corresponding orders are available.
@@ -142,40 +232,62 @@ void LOBSide<S>::updateBestLimit() {
 template<Side S>
 void LOBSide<S>::placeMarketOrder(int volume) {
     if (volume > sideVolume) {
+        metrics.recordReject(RejectReason::InsufficientLiquidity);
         throw std::runtime_error("The market order size is too big and it can't be executed right now.");
     }
 
     Limit* limitToExecute = bestLimit;
 
     if (limitToExecute == nullptr) {
+        metrics.recordReject(RejectReason::InsufficientLiquidity);
         throw std::runtime_error("No corresponding orders available to match the market order.");
     }
 
+    int levelsCrossed = 0;
     while (volume > 0 && limitToExecute) {
         executeOrder(volume, limitToExecute);
+        ++levelsCrossed;
     }
+    metrics.sweepDepth.observe(levelsCrossed);
 }
 
 /**
- * @brief Executes an order against a specified limit.
+ * @brief Executes an order against a specified limit. A limit holding all-or-none or minimum
+ *        quantity orders that refuse part of the volume is left in the book, and the remaining volume
+ *        moves on to the next limit.
  * @param volume Volume of the order to execute.
- * @param limitToExecute Pointer to the limit to execute against.
+ * @param limitToExecute Pointer to the limit to execute against, set to the next limit to try.
  */
 template<Side S>
 void LOBSide<S>::executeOrder(int& volume, Limit*& limitToExecute) {
     const int limitVolume = limitToExecute->getTotalVolume();
-    if (limitVolume > volume) {
-        limitToExecute->partialFill(volume);
+    if (limitVolume > volume && limitToExecute->hasConstrainedOrders()) {
+        const int executed = limitToExecute->fillEligible(volume, book);
+        adjustTopDepth(limitToExecute->getLimitPrice(), -executed);
+        sideVolume -= executed;
+        metrics.sharesTraded.increment(executed);
+        volume -= executed;
+        if (volume) {
+            limitToExecute = getNextLimit(limitToExecute);
+        }
+    } else if (limitVolume > volume) {
+        limitToExecute->partialFill(volume, book);
+        adjustTopDepth(limitToExecute->getLimitPrice(), -volume);
         sideVolume -= volume;
+        metrics.sharesTraded.increment(volume);
         volume = 0;
     } else {
+        // limits skipped before this one are still in the book, so the next one is not always the best
+        const bool isBestLimit = limitToExecute == bestLimit;
+        Limit* nextLimit = isBestLimit ? nullptr : getNextLimit(limitToExecute);
         int orderVolume = limitVolume;
         limitToExecute->fullFill(book);
         volume -= orderVolume;
+        metrics.sharesTraded.increment(orderVolume);
         sideVolume -= orderVolume;
 
         cancelLimit(limitToExecute);
-        limitToExecute = bestLimit;
+        limitToExecute = isBestLimit ? bestLimit : nextLimit;
     }
 }
 
@@ -191,13 +303,81 @@ void LOBSide<S>::cancelLimit(Limit* limitToCancel) {
     // Update the volume of the side tree
     sideVolume -= limitToCancel->getTotalVolume();
 
+    statistics.levelLifetime.observe(metrics.ordersAdded.get() - limitToCancel->getCreationSequence());
+    const bool affectsTopDepth = isWithinTopDepth(limitToCancel->getLimitPrice());
+
     // Erase the limit from the side tree
     sideTree.erase(limitToCancel->getLimitPrice());
+    metrics.levelsDestroyed.increment();
 
     limitToCancel = nullptr;
 
     // Update best limit after erasing
     updateBestLimit();
+
+    // A removed top level lets the next level in, so the aggregates are rebuilt
+    if (affectsTopDepth) {
+        recomputeTopDepth();
+    }
+}
+
+/**
+ * @brief Checks whether a price level is one of the best analyticsDepth levels of the side.
+ * @param limitPrice Price of the level.
+ * @return True if the level is aggregated in the top depth.
+ */
+template<Side S>
+bool LOBSide<S>::isWithinTopDepth(int limitPrice) const {
+    
+    if (topDepth.levels < analyticsDepth) {
+        return true;
+    }
+    if constexpr (S == Side::Buy) {
+        return limitPrice >= topDepthBoundary;
+    } else {
+        return limitPrice <= topDepthBoundary;
+    }
+}
+
+/**
+ * @brief Updates the top depth aggregates for a volume change of an existing level. Changes outside
+ *        the best analyticsDepth levels are ignored, so this is O(1).
+ * @param limitPrice Price of the level whose volume changed.
+ * @param volumeChange Signed change of the level's volume.
+ */
+template<Side S>
+void LOBSide<S>::adjustTopDepth(int limitPrice, int volumeChange) {
+    
+    if (!isWithinTopDepth(limitPrice)) {
+        return;
+    }
+    topDepth.volume += volumeChange;
+    topDepth.notional += static_cast<int64_t>(limitPrice) * volumeChange;
+    ++topDepthVersion;
+}
+
+/**
+ * @brief Rebuilds the top depth aggregates by walking the best analyticsDepth levels. Only needed
+ *        when a level enters or leaves the top of the side.
+ */
+template<Side S>
+void LOBSide<S>::recomputeTopDepth() {
+    
+    topDepth = TopDepth();
+    auto aggregate = [this](const auto& level) {
+        const Limit* limit = level.second.get();
+        topDepth.volume += limit->getTotalVolume();
+        topDepth.notional += static_cast<int64_t>(limit->getLimitPrice()) * limit->getTotalVolume();
+        topDepthBoundary = limit->getLimitPrice();
+        return ++topDepth.levels < analyticsDepth;
+    };
+
+    if constexpr (S == Side::Buy) {
+        for (auto it = sideTree.rbegin(); it != sideTree.rend() && aggregate(*it); ++it) {}
+    } else {
+        for (auto it = sideTree.begin(); it != sideTree.end() && aggregate(*it); ++it) {}
+    }
+    ++topDepthVersion;
 }
 
 /**
@@ -227,4 +407,22 @@ const std::map<int, std::unique_ptr<Limit>>& LOBSide<S>::getSideTree() const {
     return sideTree;
 }
 
+/**
+ * @brief Returns the running aggregates over the best levels of the side.
+ * @return Reference to the top depth.
+ */
+template<Side S>
+const TopDepth& LOBSide<S>::getTopDepth() const {
+    return topDepth;
+}
+
+/**
+ * @brief Returns a counter incremented every time the top depth changes.
+ * @return The top depth version.
+ */
+template<Side S>
+uint64_t LOBSide<S>::getTopDepthVersion() const {
+    return topDepthVersion;
+}
+
 #endif // LOBSIDE_HPP
@@ -1,24 +1,30 @@
 #include "Limit.h"
 #include "Book.h"
 
+#include <algorithm>
+#include <limits>
+
 /**
  * @brief Constructs a new Limit object representing a price level in the order book.
  * @param limitPrice The price associated with this limit.
+ * @param creationSequence Number of orders the book had accepted when the limit was created.
  */
-Limit::Limit(int limitPrice)
-    : limitPrice(limitPrice), size(0), totalVolume(0),
-      headOrder(nullptr), tailOrder(nullptr) {}
+Limit::Limit(int limitPrice, uint64_t creationSequence)
+    : limitPrice(limitPrice), size(0), totalVolume(0), constrainedVolume(0),
+      headOrder(nullptr), tailOrder(nullptr), creationSequence(creationSequence) {}
 
 /**
  * @brief Adds an order to this limit and updates the order book.
  * @param orderData The data associated with the order.
  * @param book Reference to the order book, used for updating the global order list.
  * @param idSequence Reference to the OrderIdSequence for generating a unique order ID.
+ * @return The ID assigned to the new order.
  */
-void Limit::addOrderToLimit(const OrderData& orderData, Book& book, OrderIdSequence& idSequence) {
+int64_t Limit::addOrderToLimit(const OrderData& orderData, Book& book, OrderIdSequence& idSequence) {
     // This will create a new Order and add it to the Limit
     auto newOrder = std::make_unique<Order>(orderData, this, idSequence);
     Order* newOrderPtr = newOrder.get();
+    const int64_t orderId = newOrderPtr->getOrderId();
 
     // Increment totalVolume and size for the Limit
     totalVolume += orderData.shares;
@@ -34,15 +40,40 @@ void Limit::addOrderToLimit(const OrderData& orderData, Book& book, OrderIdSeque
         tailOrder = newOrderPtr; // tailOrder now points to the new order
     }
 
+    if (newOrderPtr->isConstrained()) {
+        constrainedVolume += orderData.shares;
+        if (!runs) {
+            runs = std::make_unique<ConstrainedRuns>();
+        }
+        auto previousRun = runs->firstByLast.end();
+        if (Order* previous = newOrderPtr->getPrevOrder()) {
+            previousRun = runs->firstByLast.find(previous);
+        }
+        if (previousRun != runs->firstByLast.end()) {
+            // the new order extends the run that ended at the previous tail
+            Order* runFirst = previousRun->second;
+            runs->firstByLast.erase(previousRun);
+            runs->firstByLast.emplace(newOrderPtr, runFirst);
+            ConstrainedRun& run = runs->byFirst.at(runFirst);
+            run.last = newOrderPtr;
+            run.minExecution = std::min(run.minExecution, newOrderPtr->getMinExecution());
+        } else {
+            runs->byFirst.emplace(newOrderPtr, ConstrainedRun{newOrderPtr, newOrderPtr->getMinExecution()});
+            runs->firstByLast.emplace(newOrderPtr, newOrderPtr);
+        }
+    }
+
     // Use book.addOrderToAllOrders to update the allOrders map
     book.addOrderToAllOrders(std::move(newOrder));
+    return orderId;
 }
 
 /**
  * @brief Partially fills orders at this limit until the remaining volume is zero or no more orders are left.
  * @param remainingVolume The volume that still needs to be filled.
+ * @param book Reference to the order book, used for removing completely filled orders from the order map.
  */
-void Limit::partialFill(int remainingVolume) {
+void Limit::partialFill(int remainingVolume, Book& book) {
     
     totalVolume -= remainingVolume;
     while (remainingVolume > 0 && headOrder) {
@@ -50,6 +81,7 @@ void Limit::partialFill(int remainingVolume) {
         int orderShares = order->getShares();
 
         if (remainingVolume >= orderShares) {
+            book.recordExecution(*order, orderShares);
             remainingVolume -= orderShares;
             decreaseSize();
             Order* nxtOrder = order->getNextOrder();
@@ -59,7 +91,10 @@ void Limit::partialFill(int remainingVolume) {
             } else {
                 tailOrder = nullptr;
             }
+            book.recordOrderFilled();
+            book.removeOrderFromAllOrders(order->getOrderId());
         } else {
+            book.recordExecution(*order, remainingVolume);
             order->setShares(orderShares - remainingVolume);
             remainingVolume = 0;
         }
@@ -79,6 +114,8 @@ void Limit::fullFill(Book& book) {
         }
         
         // Use book.removeOrderFromAllOrders to update the allOrders map
+        book.recordExecution(*headOrder, headOrder->getShares());
+        book.recordOrderFilled();
         book.removeOrderFromAllOrders(headOrder->getOrderId());
         headOrder = nullptr;
         headOrder = nxtOrder;
@@ -86,6 +123,202 @@ void Limit::fullFill(Book& book) {
 
     size = 0;
     totalVolume = 0;
+    constrainedVolume = 0;
+    runs.reset();
+}
+
+/**
+ * @brief Executes an incoming volume against the orders of this limit that accept it, in time
+ *        priority. An all-or-none order accepts the volume only if it covers all its shares and a
+ *        minimum quantity order only if it reaches its minimum, capped by its shares left. Runs of
+ *        constrained orders whose bound is above the volume are stepped over in one go; runs walked
+ *        to their end get their bound refreshed with the minimum execution of the orders left.
+ * @param volume The incoming volume, smaller than the total volume of the limit.
+ * @param book Reference to the order book, used for publishing the executions and removing filled orders.
+ * @return The executed volume. Less than the incoming volume if no other order here can take the rest.
+ */
+int Limit::fillEligible(int volume, Book& book) {
+    const int incomingVolume = volume;
+    Order* order = headOrder;
+    // first and last order of the run being walked and the smallest minimum execution of its orders left
+    Order* runFirst = nullptr;
+    Order* runLast = nullptr;
+    int runMinimum = std::numeric_limits<int>::max();
+
+    while (order && volume > 0) {
+        if (order->isConstrained() && !runLast) {
+            const ConstrainedRun& run = runs->byFirst.at(order);
+            if (volume < run.minExecution) {
+                order = run.last->getNextOrder();
+                continue;
+            }
+            runFirst = order;
+            runLast = run.last;
+            runMinimum = std::numeric_limits<int>::max();
+        }
+        Order* nextOrder = order->getNextOrder();
+        const bool endsRun = order == runLast;
+        const int orderShares = order->getShares();
+
+        if (order->isConstrained() && volume < order->getMinExecution()) {
+            runMinimum = std::min(runMinimum, order->getMinExecution());
+        } else if (volume >= orderShares) {
+            book.recordExecution(*order, orderShares);
+            volume -= orderShares;
+            if (order == runFirst) {
+                // the next order of the run takes over its bound
+                runFirst = endsRun ? nullptr : nextOrder;
+            }
+            unlinkOrder(order);
+            book.recordOrderFilled();
+            book.removeOrderFromAllOrders(order->getOrderId());
+        } else {
+            book.recordExecution(*order, volume);
+            order->setShares(orderShares - volume);
+            totalVolume -= volume;
+            if (order->isConstrained()) {
+                constrainedVolume -= volume;
+                runMinimum = std::min(runMinimum, order->getMinExecution());
+            }
+            volume = 0;
+        }
+
+        if (endsRun) {
+            if (runFirst) {
+                runs->byFirst.at(runFirst).minExecution = runMinimum;
+            }
+            runFirst = nullptr;
+            runLast = nullptr;
+        }
+        order = nextOrder;
+    }
+
+    // stopped inside a run: a partial fill may have lowered the minimum execution of one of its orders
+    if (runFirst) {
+        int& minExecution = runs->byFirst.at(runFirst).minExecution;
+        minExecution = std::min(minExecution, runMinimum);
+    }
+    return incomingVolume - volume;
+}
+
+/**
+ * @brief Computes the volume fillEligible would execute, without changing the limit.
+ * @param volume The incoming volume.
+ * @return The volume that would execute.
+ */
+int Limit::getEligibleVolume(int volume) const {
+    if (!hasConstrainedOrders()) {
+        return std::min(volume, totalVolume);
+    }
+
+    int eligibleVolume = 0;
+    const Order* order = headOrder;
+    const Order* runLast = nullptr;
+    while (order && volume > 0) {
+        if (order->isConstrained() && !runLast) {
+            const ConstrainedRun& run = runs->byFirst.at(order);
+            if (volume < run.minExecution) {
+                order = run.last->getNextOrder();
+                continue;
+            }
+            runLast = run.last;
+        }
+        if (!order->isConstrained() || volume >= order->getMinExecution()) {
+            const int shares = std::min(volume, order->getShares());
+            eligibleVolume += shares;
+            volume -= shares;
+        }
+        if (order == runLast) {
+            runLast = nullptr;
+        }
+        order = order->getNextOrder();
+    }
+    return eligibleVolume;
+}
+
+/**
+ * @brief Updates the runs of constrained orders for an order about to be unlinked from this limit.
+ *        Removing the first or last order of a run hands its role over to its neighbour in the run.
+ *        Runs around a removed unconstrained order are not merged, they are just stepped over one
+ *        after the other.
+ * @param order The order about to be unlinked.
+ */
+void Limit::detachOrder(Order* order) {
+    if (!order->isConstrained()) {
+        return;
+    }
+    constrainedVolume -= order->getShares();
+
+    auto first = runs->byFirst.find(order);
+    auto last = runs->firstByLast.find(order);
+    const bool isFirst = first != runs->byFirst.end();
+    const bool isLast = last != runs->firstByLast.end();
+    if (isFirst && isLast) {
+        runs->byFirst.erase(first);
+        runs->firstByLast.erase(last);
+    } else if (isFirst) {
+        const ConstrainedRun run = first->second;
+        runs->byFirst.erase(first);
+        runs->byFirst.emplace(order->getNextOrder(), run);
+        runs->firstByLast[run.last] = order->getNextOrder();
+    } else if (isLast) {
+        Order* runFirst = last->second;
+        runs->firstByLast.erase(last);
+        runs->firstByLast.emplace(order->getPrevOrder(), runFirst);
+        runs->byFirst.at(runFirst).last = order->getPrevOrder();
+    }
+}
+
+/**
+ * @brief Updates the constrained volume and the bound of the run of an order whose size changed.
+ *        A smaller minimum execution lowers the bound of the run, found by walking back to its
+ *        first order.
+ * @param order The resized order.
+ * @param oldShares The shares of the order before the change.
+ */
+void Limit::resizeOrder(Order* order, int oldShares) {
+    if (!order->isConstrained()) {
+        return;
+    }
+    constrainedVolume += order->getShares() - oldShares;
+
+    const Order* runFirst = order;
+    auto run = runs->byFirst.find(runFirst);
+    while (run == runs->byFirst.end()) {
+        runFirst = runFirst->getPrevOrder();
+        run = runs->byFirst.find(runFirst);
+    }
+    run->second.minExecution = std::min(run->second.minExecution, order->getMinExecution());
+}
+
+/**
+ * @brief Unlinks a completely filled order from this limit.
+ * @param order The order to unlink.
+ */
+void Limit::unlinkOrder(Order* order) {
+    detachOrder(order);
+
+    Order* nextOrder = order->getNextOrder();
+    Order* prevOrder = order->getPrevOrder();
+    if (prevOrder) {
+        prevOrder->setNextOrder(nextOrder);
+    } else {
+        headOrder = nextOrder;
+    }
+    if (nextOrder) {
+        nextOrder->setPrevOrder(prevOrder);
+    } else {
+        tailOrder = prevOrder;
+    }
+    totalVolume -= order->getShares();
+    decreaseSize();
+}
+
+/**
+ * @brief Increases the size of the limit, for queues that link their orders themselves.
+ */
+void Limit::increaseSize() {
+    size += 1;
 }
 
 /**
@@ -122,6 +355,38 @@ int Limit::getTotalVolume() const {
     return totalVolume;
 }
 
+/**
+ * @brief Returns the number of orders the book had accepted when this limit was created.
+ * @return The creation sequence.
+ */
+uint64_t Limit::getCreationSequence() const {
+    return creationSequence;
+}
+
+/**
+ * @brief Returns whether all-or-none or minimum quantity orders rest at this limit.
+ * @return True if some orders at this limit are constrained.
+ */
+bool Limit::hasConstrainedOrders() const {
+    return runs && !runs->byFirst.empty();
+}
+
+/**
+ * @brief Returns the volume of the all-or-none and minimum quantity orders at this limit.
+ * @return The constrained volume.
+ */
+int Limit::getConstrainedVolume() const {
+    return constrainedVolume;
+}
+
+/**
+ * @brief Returns the number of runs of consecutive constrained orders at this limit.
+ * @return The number of runs.
+ */
+int Limit::getConstrainedRuns() const {
+    return runs ? static_cast<int>(runs->byFirst.size()) : 0;
+}
+
 /**
  * @brief Returns the first order in the linked list at this limit.
  * @return Pointer to the head order.
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 #include <memory>
@@ -38,20 +39,32 @@ class Order;
 /**
  * @class Limit
  * @brief Represents a price level in the order book, managing orders at that specific price level.
+ *        Consecutive all-or-none and minimum quantity orders in the queue form runs that carry a lower
+ *        bound of the minimum execution of their orders, so matching steps over a whole run that can't
+ *        execute instead of checking its orders one by one.
  */
 class Limit {
 public:
-    Limit(int limitPrice);
+    Limit(int limitPrice, uint64_t creationSequence);
 
-    void addOrderToLimit(const OrderData& orderData, Book& book, OrderIdSequence& idSequence);
-    void partialFill(int remainingVolume);
+    int64_t addOrderToLimit(const OrderData& orderData, Book& book, OrderIdSequence& idSequence);
+    void partialFill(int remainingVolume, Book& book);
     void fullFill(Book& book);
+    int fillEligible(int volume, Book& book);
+    int getEligibleVolume(int volume) const;
+    void detachOrder(Order* order);
+    void resizeOrder(Order* order, int oldShares);
+    void increaseSize();
     void decreaseSize();
 
     // getters and setters
     int getLimitPrice() const;
     int getSize() const;
     int getTotalVolume() const;
+    uint64_t getCreationSequence() const;
+    bool hasConstrainedOrders() const;
+    int getConstrainedVolume() const;
+    int getConstrainedRuns() const;
 
     Order* getHeadOrder() const;
     Order* getTailOrder() const;
@@ -67,8 +80,31 @@ private:
     int size;
     /// Total volume of shares at this price level
     int totalVolume;
+    /// Volume of the all-or-none and minimum quantity orders at this price level
+    int constrainedVolume;
     /// Pointer to the first order in the doubly  linked list at this price level
     Order* headOrder;
     /// Pointer to the last order in the doubly linked list at this price level
     Order* tailOrder;
+    /// Number of orders the book had accepted when this limit was created, used to measure its lifetime
+    const uint64_t creationSequence;
+
+    /**
+     * @struct ConstrainedRun
+     * @brief A run of consecutive constrained orders in the queue.
+     */
+    struct ConstrainedRun {
+        Order* last;
+        /// lower bound of the minimum execution of the orders in the run
+        int minExecution;
+    };
+    /// the runs keyed by their first order, and the first order of each run keyed by its last one
+    struct ConstrainedRuns {
+        std::unordered_map<const Order*, ConstrainedRun> byFirst;
+        std::unordered_map<const Order*, Order*> firstByLast;
+    };
+    /// Runs of constrained orders, allocated with the first one so that levels without any stay small
+    std::unique_ptr<ConstrainedRuns> runs;
+
+    void unlinkOrder(Order* order);
 };
@@ -0,0 +1,676 @@
+#include "MappedBook.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * @struct MappedBookLayout
+ * @brief The offsets of the regions of a mapped book file, each aligned to a cache line.
+ */
+struct MappedBookLayout {
+    uint32_t orderIndexBits;
+    uint32_t levelIndexBits;
+    uint64_t levelsOffset;
+    uint64_t ordersOffset;
+    uint64_t orderIndexOffset;
+    uint64_t levelIndexOffset;
+    uint64_t fileSize;
+};
+
+uint64_t alignToCacheLine(uint64_t offset) {
+    return (offset + 63) & ~uint64_t{63};
+}
+
+// hash tables get at least twice as many slots as entries, so probe sequences stay short
+uint32_t indexBits(uint32_t capacity) {
+    uint32_t bits = 1;
+    while ((uint64_t{1} << bits) < uint64_t{2} * capacity) {
+        ++bits;
+    }
+    return bits;
+}
+
+MappedBookLayout computeLayout(uint32_t orderCapacity, uint32_t levelCapacity) {
+    MappedBookLayout layout;
+    layout.orderIndexBits = indexBits(orderCapacity);
+    layout.levelIndexBits = indexBits(levelCapacity);
+    layout.levelsOffset = alignToCacheLine(sizeof(MappedBookHeader));
+    layout.ordersOffset = alignToCacheLine(layout.levelsOffset + uint64_t{levelCapacity} * sizeof(MappedLevel));
+    layout.orderIndexOffset = alignToCacheLine(layout.ordersOffset + uint64_t{orderCapacity} * sizeof(MappedOrder));
+    layout.levelIndexOffset = alignToCacheLine(layout.orderIndexOffset + (uint64_t{4} << layout.orderIndexBits));
+    layout.fileSize = alignToCacheLine(layout.levelIndexOffset + (uint64_t{4} << layout.levelIndexBits));
+    return layout;
+}
+
+size_t sideIndex(Side side) {
+    return side == Side::Buy ? 0 : 1;
+}
+
+Side opposite(Side side) {
+    return side == Side::Buy ? Side::Sell : Side::Buy;
+}
+
+// whether a level at price a has priority over one at price b on the given side
+bool isBetter(Side side, int a, int b) {
+    return side == Side::Buy ? a > b : a < b;
+}
+
+uint64_t hashKey(uint64_t key, uint32_t bits) {
+    return (key * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+}
+
+} // namespace
+
+/**
+ * @brief Creates a mapped book file, replacing any file at the same path, with empty storage for
+ *        the given number of resting orders and price levels.
+ * @param path The path of the file.
+ * @param orderCapacity Maximum number of resting orders.
+ * @param levelCapacity Maximum number of price levels, both sides together.
+ * @throws std::invalid_argument if a capacity is 0 or too large.
+ * @throws std::runtime_error if the file cannot be created or mapped.
+ */
+MappedBook::MappedBook(const std::string& path, uint32_t orderCapacity, uint32_t levelCapacity)
+    : mapping(nullptr), mappingSize(0) {
+    if (orderCapacity == 0 || levelCapacity == 0 || orderCapacity >= (1u << 30) || levelCapacity >= (1u << 30)) {
+        throw std::invalid_argument("Mapped book capacities must be between 1 and 2^30.");
+    }
+    const MappedBookLayout layout = computeLayout(orderCapacity, levelCapacity);
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Can't create mapped book " + path);
+    }
+    if (ftruncate(fd, static_cast<off_t>(layout.fileSize)) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Can't size mapped book " + path);
+    }
+    map(path, fd, layout.fileSize);
+
+    std::memcpy(header->magic, magic, sizeof(magic));
+    header->version = version;
+    header->orderCapacity = orderCapacity;
+    header->levelCapacity = levelCapacity;
+    header->orderIndexBits = layout.orderIndexBits;
+    header->levelIndexBits = layout.levelIndexBits;
+    header->fileSize = layout.fileSize;
+    header->levelsOffset = layout.levelsOffset;
+    header->ordersOffset = layout.ordersOffset;
+    header->orderIndexOffset = layout.orderIndexOffset;
+    header->levelIndexOffset = layout.levelIndexOffset;
+    levels = reinterpret_cast<MappedLevel*>(static_cast<char*>(mapping) + layout.levelsOffset);
+    orders = reinterpret_cast<MappedOrder*>(static_cast<char*>(mapping) + layout.ordersOffset);
+    orderIndex = reinterpret_cast<uint32_t*>(static_cast<char*>(mapping) + layout.orderIndexOffset);
+    levelIndex = reinterpret_cast<uint32_t*>(static_cast<char*>(mapping) + layout.levelIndexOffset);
+
+    for (uint32_t i = 0; i < orderCapacity; ++i) {
+        orders[i].next = i + 1 < orderCapacity ? i + 1 : mappedNullIndex;
+    }
+    for (uint32_t i = 0; i < levelCapacity; ++i) {
+        levels[i].worse = i + 1 < levelCapacity ? i + 1 : mappedNullIndex;
+    }
+    std::memset(orderIndex, 0xff, size_t{4} << layout.orderIndexBits);
+    std::memset(levelIndex, 0xff, size_t{4} << layout.levelIndexBits);
+    header->freeOrder = 0;
+    header->freeLevel = 0;
+    header->bestLevel[0] = mappedNullIndex;
+    header->bestLevel[1] = mappedNullIndex;
+    endCommand();
+}
+
+/**
+ * @brief Reopens a mapped book file in place. Only the header is read: the book is ready as soon
+ *        as the file is mapped and its checksum verified, whatever its size.
+ * @param path The path of the file.
+ * @throws std::runtime_error if the file cannot be mapped, is not a mapped book, or was left in the
+ *         middle of a command or corrupted, in which case the book must be rebuilt another way.
+ */
+MappedBook::MappedBook(const std::string& path) : mapping(nullptr), mappingSize(0) {
+    const int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open mapped book " + path);
+    }
+    struct stat status;
+    if (fstat(fd, &status) < 0 || static_cast<size_t>(status.st_size) < sizeof(MappedBookHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Not a mapped book: " + path);
+    }
+    map(path, fd, static_cast<size_t>(status.st_size));
+
+    std::string error;
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version) {
+        error = "Not a mapped book: ";
+    } else if (header->dirty) {
+        error = "Mapped book left in the middle of a command: ";
+    } else if (header->checksum != headerChecksum()) {
+        error = "Corrupted mapped book header: ";
+    } else {
+        const MappedBookLayout layout = computeLayout(header->orderCapacity, header->levelCapacity);
+        if (header->fileSize != mappingSize || layout.fileSize != mappingSize ||
+            layout.levelsOffset != header->levelsOffset || layout.ordersOffset != header->ordersOffset ||
+            layout.orderIndexOffset != header->orderIndexOffset || layout.levelIndexOffset != header->levelIndexOffset ||
+            layout.orderIndexBits != header->orderIndexBits || layout.levelIndexBits != header->levelIndexBits) {
+            error = "Corrupted mapped book layout: ";
+        }
+    }
+    if (!error.empty()) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        throw std::runtime_error(error + path);
+    }
+
+    levels = reinterpret_cast<MappedLevel*>(static_cast<char*>(mapping) + header->levelsOffset);
+    orders = reinterpret_cast<MappedOrder*>(static_cast<char*>(mapping) + header->ordersOffset);
+    orderIndex = reinterpret_cast<uint32_t*>(static_cast<char*>(mapping) + header->orderIndexOffset);
+    levelIndex = reinterpret_cast<uint32_t*>(static_cast<char*>(mapping) + header->levelIndexOffset);
+}
+
+/**
+ * @brief Unmaps the file. The book stays in the page cache and is written back by the kernel.
+ */
+MappedBook::~MappedBook() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+}
+
+/**
+ * @brief Applies a command. Commands that cannot be applied, including limit orders that would not
+ *        find a free order or level slot, are rejected without changing the book. The mapped layout
+ *        has no minimum quantities, so adds with a minQuantity are rejected too.
+ * @param command The command, prices in cents.
+ * @return Whether the command was accepted and, for Add, the id of the resting remainder if any.
+ */
+CommandResult MappedBook::apply(const BookCommand& command) {
+    beginCommand();
+    CommandResult result{false, std::nullopt};
+    switch (command.type) {
+        case CommandType::Add:
+            if (command.shares > 0 && command.price > 0 && command.minQuantity == 0 && header->orderCount < header->orderCapacity &&
+                (header->levelCount < header->levelCapacity || findLevel(command.side, command.price) != mappedNullIndex)) {
+                result = {true, addOrder(command.side, command.shares, command.price, command.eventTime)};
+            }
+            break;
+        case CommandType::Cancel:
+            result.accepted = cancelOrder(command.orderId);
+            break;
+        case CommandType::ModifySize:
+            result.accepted = modifyOrderSize(command.orderId, command.shares);
+            if (result.accepted) {
+                result.orderId = command.orderId;
+            }
+            break;
+        case CommandType::Market:
+            result.accepted = placeMarketOrder(command.side, command.shares, command.eventTime);
+            break;
+    }
+    ++header->appliedCommands;
+    if (!result.accepted) {
+        ++header->rejectedCommands;
+    }
+    endCommand();
+    return result;
+}
+
+/**
+ * @brief Registers a receiver of the fills produced by the book.
+ * @param sink The receiver, which must outlive its registration.
+ */
+void MappedBook::addFillSink(FillSink* sink) {
+    fillSinks.push_back(sink);
+}
+
+/**
+ * @brief Unregisters a receiver of fills.
+ * @param sink The receiver.
+ */
+void MappedBook::removeFillSink(FillSink* sink) {
+    fillSinks.erase(std::remove(fillSinks.begin(), fillSinks.end(), sink), fillSinks.end());
+}
+
+/**
+ * @brief Writes the book back to the file and waits for it, so that it survives a crash of the machine.
+ * @throws std::runtime_error if the file cannot be synced.
+ */
+void MappedBook::sync() {
+    if (msync(mapping, mappingSize, MS_SYNC) < 0) {
+        throw std::runtime_error("Can't sync mapped book.");
+    }
+}
+
+/**
+ * @brief Walks the whole book and checks that its links, counts, volumes and indices agree. This is
+ *        not needed to reopen a book, but can check a file whose integrity is in doubt.
+ * @return Whether the book is consistent.
+ */
+bool MappedBook::verify() const {
+    uint32_t orderCount = 0;
+    uint32_t levelCount = 0;
+    for (Side side : {Side::Buy, Side::Sell}) {
+        int64_t sideVolume = 0;
+        uint32_t better = mappedNullIndex;
+        for (uint32_t l = header->bestLevel[sideIndex(side)]; l != mappedNullIndex; l = levels[l].worse) {
+            const MappedLevel& level = levels[l];
+            if (l >= header->levelCapacity || level.side != sideIndex(side) || level.better != better ||
+                (better != mappedNullIndex && !isBetter(side, levels[better].price, level.price)) ||
+                findLevel(side, level.price) != l || ++levelCount > header->levelCapacity) {
+                return false;
+            }
+            int64_t volume = 0;
+            uint32_t queued = 0;
+            uint32_t previous = mappedNullIndex;
+            for (uint32_t o = level.head; o != mappedNullIndex; o = orders[o].next) {
+                if (o >= header->orderCapacity || orders[o].level != l || orders[o].previous != previous ||
+                    orders[o].shares <= 0 || findOrderSlot(orders[o].orderId) != o || ++queued > header->orderCapacity) {
+                    return false;
+                }
+                volume += orders[o].shares;
+                previous = o;
+            }
+            if (level.tail != previous || level.orders != queued || level.volume != volume || queued == 0) {
+                return false;
+            }
+            orderCount += queued;
+            sideVolume += volume;
+            better = l;
+        }
+        if (sideVolume != header->sideVolume[sideIndex(side)]) {
+            return false;
+        }
+    }
+    return orderCount == header->orderCount && levelCount == header->levelCount;
+}
+
+/**
+ * @brief Returns the best price of a side.
+ * @param side The side.
+ * @return The price in cents, empty if the side is empty.
+ */
+std::optional<int> MappedBook::getBestPrice(Side side) const {
+    const uint32_t best = header->bestLevel[sideIndex(side)];
+    if (best == mappedNullIndex) {
+        return std::nullopt;
+    }
+    return levels[best].price;
+}
+
+/**
+ * @brief Returns the volume resting at a price.
+ * @param side The side.
+ * @param price The price in cents.
+ * @return The volume, 0 if there is no level at that price.
+ */
+int64_t MappedBook::getLevelVolume(Side side, int price) const {
+    const uint32_t level = findLevel(side, price);
+    return level == mappedNullIndex ? 0 : levels[level].volume;
+}
+
+/**
+ * @brief Returns the volume resting on a side.
+ * @param side The side.
+ * @return The volume.
+ */
+int64_t MappedBook::getSideVolume(Side side) const {
+    return header->sideVolume[sideIndex(side)];
+}
+
+/**
+ * @brief Looks up a resting order.
+ * @param orderId The id of the order.
+ * @return A copy of the order, empty if it is not resting in the book.
+ */
+std::optional<MappedOrderView> MappedBook::findOrder(int64_t orderId) const {
+    const uint32_t slot = findOrderSlot(orderId);
+    if (slot == mappedNullIndex) {
+        return std::nullopt;
+    }
+    const MappedLevel& level = levels[orders[slot].level];
+    return MappedOrderView{orderId, level.side == 0 ? Side::Buy : Side::Sell, orders[slot].shares, level.price};
+}
+
+/**
+ * @brief Returns the resting orders of a side, from the best level to the worst and in time
+ *        priority within each level.
+ * @param side The side.
+ * @return Copies of the orders.
+ */
+std::vector<MappedOrderView> MappedBook::getOrders(Side side) const {
+    std::vector<MappedOrderView> result;
+    for (uint32_t l = header->bestLevel[sideIndex(side)]; l != mappedNullIndex; l = levels[l].worse) {
+        for (uint32_t o = levels[l].head; o != mappedNullIndex; o = orders[o].next) {
+            result.push_back({orders[o].orderId, side, orders[o].shares, levels[l].price});
+        }
+    }
+    return result;
+}
+
+uint32_t MappedBook::getOrderCount() const {
+    return header->orderCount;
+}
+
+uint32_t MappedBook::getLevelCount() const {
+    return header->levelCount;
+}
+
+/**
+ * @brief Returns the id the next resting order will get. Ids continue across reopenings.
+ */
+int64_t MappedBook::getNextOrderId() const {
+    return header->nextOrderId;
+}
+
+/**
+ * @brief Returns the sequence number of the next fill. Fill sequences continue across reopenings.
+ */
+uint64_t MappedBook::getFillSequence() const {
+    return header->fillSequence;
+}
+
+uint64_t MappedBook::getAppliedCommands() const {
+    return header->appliedCommands;
+}
+
+uint64_t MappedBook::getRejectedCommands() const {
+    return header->rejectedCommands;
+}
+
+/**
+ * @brief Maps an open file and closes the descriptor, which the mapping does not need.
+ */
+void MappedBook::map(const std::string& path, int fd, size_t size) {
+    mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Can't map mapped book " + path);
+    }
+    mappingSize = size;
+    header = static_cast<MappedBookHeader*>(mapping);
+}
+
+/**
+ * @brief Marks the book as being modified. The signal fences keep the compiler from moving stores
+ *        of the command across the marks; the process itself never sees them out of order.
+ */
+void MappedBook::beginCommand() {
+    header->dirty = 1;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+void MappedBook::endCommand() {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    header->dirty = 0;
+    header->checksum = headerChecksum();
+}
+
+uint64_t MappedBook::headerChecksum() const {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(header);
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < offsetof(MappedBookHeader, checksum); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Matches a limit order against the opposite side, then rests its remainder at the back of
+ *        its level. Like Book, the order only executes against prices strictly better than its limit.
+ */
+std::optional<int64_t> MappedBook::addOrder(Side side, int shares, int price, int eventTime) {
+    const Side oppositeSide = opposite(side);
+    uint32_t best = header->bestLevel[sideIndex(oppositeSide)];
+    while (shares > 0 && best != mappedNullIndex && isBetter(side, price, levels[best].price)) {
+        executeAtLevel(best, shares, side, eventTime);
+        best = header->bestLevel[sideIndex(oppositeSide)];
+    }
+    if (shares == 0) {
+        return std::nullopt;
+    }
+
+    uint32_t l = findLevel(side, price);
+    if (l == mappedNullIndex) {
+        l = insertLevel(side, price);
+    }
+    const uint32_t o = header->freeOrder;
+    header->freeOrder = orders[o].next;
+    MappedOrder& order = orders[o];
+    MappedLevel& level = levels[l];
+    order.orderId = header->nextOrderId++;
+    order.shares = shares;
+    order.level = l;
+    order.previous = level.tail;
+    order.next = mappedNullIndex;
+    if (level.tail == mappedNullIndex) {
+        level.head = o;
+    } else {
+        orders[level.tail].next = o;
+    }
+    level.tail = o;
+    ++level.orders;
+    level.volume += shares;
+    header->sideVolume[sideIndex(side)] += shares;
+    ++header->orderCount;
+    indexInsert(orderIndex, header->orderIndexBits, orderHome(order.orderId), o);
+    return order.orderId;
+}
+
+bool MappedBook::cancelOrder(int64_t orderId) {
+    const uint32_t o = findOrderSlot(orderId);
+    if (o == mappedNullIndex) {
+        return false;
+    }
+    unlinkOrder(o);
+    return true;
+}
+
+bool MappedBook::modifyOrderSize(int64_t orderId, int shares) {
+    const uint32_t o = findOrderSlot(orderId);
+    if (o == mappedNullIndex || shares <= 0) {
+        return false;
+    }
+    MappedLevel& level = levels[orders[o].level];
+    level.volume += shares - orders[o].shares;
+    header->sideVolume[level.side] += shares - orders[o].shares;
+    orders[o].shares = shares;
+    return true;
+}
+
+/**
+ * @brief Executes a market order. Like Book, an order larger than the opposite side is rejected
+ *        rather than partially filled.
+ */
+bool MappedBook::placeMarketOrder(Side side, int shares, int eventTime) {
+    const Side oppositeSide = opposite(side);
+    if (shares <= 0 || shares > header->sideVolume[sideIndex(oppositeSide)]) {
+        return false;
+    }
+    while (shares > 0) {
+        executeAtLevel(header->bestLevel[sideIndex(oppositeSide)], shares, side, eventTime);
+    }
+    return true;
+}
+
+/**
+ * @brief Executes an aggressive order against the queue of a level, in time priority, until either
+ *        is exhausted. A level left empty is removed.
+ */
+void MappedBook::executeAtLevel(uint32_t levelIndex, int& shares, Side aggressorSide, int eventTime) {
+    MappedLevel& level = levels[levelIndex];
+    while (shares > 0) {
+        const uint32_t o = level.head;
+        MappedOrder& order = orders[o];
+        const int executed = std::min(shares, order.shares);
+        const Fill fill{header->fillSequence++, order.orderId, level.price, executed, aggressorSide, eventTime};
+        for (FillSink* sink : fillSinks) {
+            sink->onFill(fill);
+        }
+        order.shares -= executed;
+        level.volume -= executed;
+        header->sideVolume[level.side] -= executed;
+        shares -= executed;
+        if (order.shares == 0) {
+            const bool lastOrder = level.orders == 1;
+            unlinkOrder(o);
+            if (lastOrder) {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Removes an order from its level queue and from the order index and frees its slot, and
+ *        removes its level if it was the last order in it.
+ */
+void MappedBook::unlinkOrder(uint32_t slot) {
+    MappedOrder& order = orders[slot];
+    const uint32_t l = order.level;
+    MappedLevel& level = levels[l];
+    if (order.previous == mappedNullIndex) {
+        level.head = order.next;
+    } else {
+        orders[order.previous].next = order.next;
+    }
+    if (order.next == mappedNullIndex) {
+        level.tail = order.previous;
+    } else {
+        orders[order.next].previous = order.previous;
+    }
+    --level.orders;
+    level.volume -= order.shares;
+    header->sideVolume[level.side] -= order.shares;
+
+    indexErase(orderIndex, header->orderIndexBits, slot, orderHome(order.orderId),
+               [this](uint32_t entry) { return orderHome(orders[entry].orderId); });
+    order.next = header->freeOrder;
+    header->freeOrder = slot;
+    --header->orderCount;
+
+    if (level.orders == 0) {
+        removeLevel(l);
+    }
+}
+
+uint32_t MappedBook::findLevel(Side side, int price) const {
+    const uint64_t mask = (uint64_t{1} << header->levelIndexBits) - 1;
+    for (uint64_t i = levelHome(side, price);; i = (i + 1) & mask) {
+        const uint32_t l = levelIndex[i];
+        if (l == mappedNullIndex || (levels[l].price == price && levels[l].side == sideIndex(side))) {
+            return l;
+        }
+    }
+}
+
+/**
+ * @brief Takes a free level slot and links it in price order, walking from the best level. New
+ *        levels mostly open near the touch, so the walk is short.
+ */
+uint32_t MappedBook::insertLevel(Side side, int price) {
+    const uint32_t l = header->freeLevel;
+    header->freeLevel = levels[l].worse;
+    MappedLevel& level = levels[l];
+    level.price = price;
+    level.side = static_cast<uint32_t>(sideIndex(side));
+    level.head = mappedNullIndex;
+    level.tail = mappedNullIndex;
+    level.orders = 0;
+    level.volume = 0;
+
+    uint32_t better = mappedNullIndex;
+    uint32_t worse = header->bestLevel[sideIndex(side)];
+    while (worse != mappedNullIndex && isBetter(side, levels[worse].price, price)) {
+        better = worse;
+        worse = levels[worse].worse;
+    }
+    level.better = better;
+    level.worse = worse;
+    if (better == mappedNullIndex) {
+        header->bestLevel[sideIndex(side)] = l;
+    } else {
+        levels[better].worse = l;
+    }
+    if (worse != mappedNullIndex) {
+        levels[worse].better = l;
+    }
+    ++header->levelCount;
+    indexInsert(levelIndex, header->levelIndexBits, levelHome(side, price), l);
+    return l;
+}
+
+void MappedBook::removeLevel(uint32_t l) {
+    MappedLevel& level = levels[l];
+    const Side side = level.side == 0 ? Side::Buy : Side::Sell;
+    if (level.better == mappedNullIndex) {
+        header->bestLevel[level.side] = level.worse;
+    } else {
+        levels[level.better].worse = level.worse;
+    }
+    if (level.worse != mappedNullIndex) {
+        levels[level.worse].better = level.better;
+    }
+    indexErase(levelIndex, header->levelIndexBits, l, levelHome(side, level.price), [this](uint32_t entry) {
+        return levelHome(levels[entry].side == 0 ? Side::Buy : Side::Sell, levels[entry].price);
+    });
+    level.worse = header->freeLevel;
+    header->freeLevel = l;
+    --header->levelCount;
+}
+
+uint32_t MappedBook::findOrderSlot(int64_t orderId) const {
+    const uint64_t mask = (uint64_t{1} << header->orderIndexBits) - 1;
+    for (uint64_t i = orderHome(orderId);; i = (i + 1) & mask) {
+        const uint32_t o = orderIndex[i];
+        if (o == mappedNullIndex || orders[o].orderId == orderId) {
+            return o;
+        }
+    }
+}
+
+uint64_t MappedBook::orderHome(int64_t orderId) const {
+    return hashKey(static_cast<uint64_t>(orderId), header->orderIndexBits);
+}
+
+uint64_t MappedBook::levelHome(Side side, int price) const {
+    return hashKey((uint64_t{static_cast<uint32_t>(price)} << 1) | sideIndex(side), header->levelIndexBits);
+}
+
+void MappedBook::indexInsert(uint32_t* table, uint32_t bits, uint64_t home, uint32_t value) {
+    const uint64_t mask = (uint64_t{1} << bits) - 1;
+    uint64_t i = home;
+    while (table[i] != mappedNullIndex) {
+        i = (i + 1) & mask;
+    }
+    table[i] = value;
+}
+
+/**
+ * @brief Removes a value from a linear probing table, shifting back the entries of its probe
+ *        sequence so that lookups never need tombstones.
+ */
+template<typename Home>
+void MappedBook::indexErase(uint32_t* table, uint32_t bits, uint32_t value, uint64_t home, Home&& homeOf) {
+    const uint64_t mask = (uint64_t{1} << bits) - 1;
+    uint64_t hole = home;
+    while (table[hole] != value) {
+        hole = (hole + 1) & mask;
+    }
+    for (uint64_t next = (hole + 1) & mask; table[next] != mappedNullIndex; next = (next + 1) & mask) {
+        const uint64_t nextHome = homeOf(table[next]);
+        // the entry can fill the hole unless its home lies cyclically in (hole, next]
+        const bool staysPut = hole <= next ? (hole < nextHome && nextHome <= next) : (hole < nextHome || nextHome <= next);
+        if (!staysPut) {
+            table[hole] = table[next];
+            hole = next;
+        }
+    }
+    table[hole] = mappedNullIndex;
+}
@@ -0,0 +1,193 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "BookCommand.h"
+#include "Fill.h"
+
+/// link value of the mapped book meaning "no slot"
+constexpr uint32_t mappedNullIndex = UINT32_MAX;
+
+/**
+ * @struct MappedBookHeader
+ * @brief The first bytes of a mapped book file. Every region of the file is found through the
+ *        offsets stored here and every link is a slot index, so the file can be mapped at any address.
+ */
+struct MappedBookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t orderCapacity;
+    uint32_t levelCapacity;
+    /// log2 of the slots of the order id and level price hash tables
+    uint32_t orderIndexBits;
+    uint32_t levelIndexBits;
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint64_t levelsOffset;
+    uint64_t ordersOffset;
+    uint64_t orderIndexOffset;
+    uint64_t levelIndexOffset;
+
+    /// set while a command is being applied, so that a file left by a crash in the middle of one is refused
+    uint32_t dirty;
+    uint32_t freeOrder;
+    uint32_t freeLevel;
+    uint32_t orderCount;
+    uint32_t levelCount;
+    /// best level of the buy and sell side
+    uint32_t bestLevel[2];
+    uint32_t padding;
+    int64_t sideVolume[2];
+    int64_t nextOrderId;
+    uint64_t fillSequence;
+    uint64_t appliedCommands;
+    uint64_t rejectedCommands;
+    /// FNV-1a of the bytes above, updated at the end of every command
+    uint64_t checksum;
+};
+
+/**
+ * @struct MappedLevel
+ * @brief A price level of a mapped book. Levels of a side are linked from the best to the worst price.
+ */
+struct MappedLevel {
+    int price;
+    uint32_t side;
+    uint32_t better;
+    uint32_t worse;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t orders;
+    uint32_t padding;
+    int64_t volume;
+};
+
+/**
+ * @struct MappedOrder
+ * @brief A resting order of a mapped book, linked in the time priority queue of its level.
+ */
+struct MappedOrder {
+    int64_t orderId;
+    int shares;
+    uint32_t level;
+    uint32_t previous;
+    uint32_t next;
+};
+
+/**
+ * @struct MappedOrderView
+ * @brief A copy of a resting order of a mapped book.
+ */
+struct MappedOrderView {
+    int64_t orderId;
+    Side side;
+    int shares;
+    int price;
+
+    bool operator==(const MappedOrderView&) const = default;
+};
+
+/**
+ * @class MappedBook
+ * @brief A book whose orders, levels and indices live in a memory-mapped file, for books that must
+ *        survive a restart without being rebuilt. The storage is fixed at creation: a pool of order
+ *        slots, a pool of level slots and two open addressing hash tables, all linked by slot index
+ *        rather than by pointer. Reopening the file maps it back and checks the header checksum, in
+ *        constant time whatever the size of the book.
+ *
+ *        Commands match like Book: price-time priority, executions at the resting price, fills
+ *        published to the registered sinks. The file is written through the page cache, so it
+ *        survives a crash of the process as soon as a command returns; sync() also makes it survive
+ *        a crash of the machine.
+ */
+class MappedBook {
+public:
+    static constexpr char magic[8] = {'M', 'B', 'O', 'O', 'K', '0', '0', '1'};
+    static constexpr uint32_t version = 1;
+
+    MappedBook(const std::string& path, uint32_t orderCapacity, uint32_t levelCapacity);
+    explicit MappedBook(const std::string& path);
+    ~MappedBook();
+
+    CommandResult apply(const BookCommand& command);
+    void addFillSink(FillSink* sink);
+    void removeFillSink(FillSink* sink);
+    void sync();
+    bool verify() const;
+
+    std::optional<int> getBestPrice(Side side) const;
+    int64_t getLevelVolume(Side side, int price) const;
+    int64_t getSideVolume(Side side) const;
+    std::optional<MappedOrderView> findOrder(int64_t orderId) const;
+    std::vector<MappedOrderView> getOrders(Side side) const;
+    uint32_t getOrderCount() const;
+    uint32_t getLevelCount() const;
+    int64_t getNextOrderId() const;
+    uint64_t getFillSequence() const;
+    uint64_t getAppliedCommands() const;
+    uint64_t getRejectedCommands() const;
+
+    MappedBook(const MappedBook&) = delete;
+    MappedBook& operator=(const MappedBook&) = delete;
+
+private:
+    void map(const std::string& path, int fd, size_t size);
+    void beginCommand();
+    void endCommand();
+    uint64_t headerChecksum() const;
+
+    std::optional<int64_t> addOrder(Side side, int shares, int price, int eventTime);
+    bool cancelOrder(int64_t orderId);
+    bool modifyOrderSize(int64_t orderId, int shares);
+    bool placeMarketOrder(Side side, int shares, int eventTime);
+    void executeAtLevel(uint32_t levelIndex, int& shares, Side aggressorSide, int eventTime);
+    void unlinkOrder(uint32_t slot);
+
+    uint32_t findLevel(Side side, int price) const;
+    uint32_t insertLevel(Side side, int price);
+    void removeLevel(uint32_t levelIndex);
+    uint32_t findOrderSlot(int64_t orderId) const;
+
+    uint64_t orderHome(int64_t orderId) const;
+    uint64_t levelHome(Side side, int price) const;
+    void indexInsert(uint32_t* table, uint32_t bits, uint64_t home, uint32_t value);
+    template<typename Home>
+    void indexErase(uint32_t* table, uint32_t bits, uint32_t value, uint64_t home, Home&& homeOf);
+
+    void* mapping;
+    size_t mappingSize;
+    MappedBookHeader* header;
+    MappedLevel* levels;
+    MappedOrder* orders;
+    uint32_t* orderIndex;
+    uint32_t* levelIndex;
+    std::vector<FillSink*> fillSinks;
+};
@@ -0,0 +1,414 @@
+#include "MatchingThread.h"
+#include "Futex.h"
+
+#include <algorithm>
+#include <bit>
+
+/**
+ * @brief Takes a completion record for the command. If the command is shed or no record is free it
+ *        is not submitted, and awaiting completes immediately with a Shed or Busy report.
+ */
+SubmitAwaitable::SubmitAwaitable(MatchingThread& matchingThread, const BookCommand& command, Executor& executor, uint32_t session)
+    : matchingThread(matchingThread), record(nullptr), immediateStatus(SubmitStatus::Busy), submitted(false) {
+    record = matchingThread.acquireRecord(command, immediateStatus);
+    if (record) {
+        record->command = command;
+        record->report = ExecutionReport{};
+        record->executor = &executor;
+        record->session = session;
+    }
+}
+
+/**
+ * @brief Gives back a record that was taken but never submitted.
+ */
+SubmitAwaitable::~SubmitAwaitable() {
+    if (record && !submitted) {
+        matchingThread.releaseRecord(record);
+    }
+}
+
+bool SubmitAwaitable::await_ready() const noexcept {
+    return record == nullptr;
+}
+
+/**
+ * @brief Queues the command. The report may be delivered, and the coroutine resumed, before this
+ *        returns, so nothing is touched after the record is queued.
+ */
+void SubmitAwaitable::await_suspend(std::coroutine_handle<> handle) noexcept {
+    submitted = true;
+    record->task.handle = handle;
+    matchingThread.enqueue(record);
+}
+
+/**
+ * @brief Returns the execution report and recycles the record.
+ */
+ExecutionReport SubmitAwaitable::await_resume() noexcept {
+    if (!record) {
+        ExecutionReport report;
+        report.status = immediateStatus;
+        return report;
+    }
+    ExecutionReport report = record->report;
+    matchingThread.releaseRecord(record);
+    record = nullptr;
+    return report;
+}
+
+/**
+ * @brief Allocates the completion records. The thread is only started by start.
+ * @param book The book matched by the thread.
+ * @param orderIdSequence The sequence assigning ids to resting orders.
+ * @param maxInFlight Maximum number of commands submitted and not yet completed.
+ * @param batchSize Maximum number of commands applied before checking for new ones.
+ */
+MatchingThread::MatchingThread(Book& book, OrderIdSequence& orderIdSequence, size_t maxInFlight, size_t batchSize)
+    : book(book), orderIdSequence(orderIdSequence), batchSize(batchSize), records(maxInFlight),
+      freeRecords(std::bit_ceil(std::max<size_t>(maxInFlight, 1))), cancelRecords(std::bit_ceil(std::max<size_t>(maxInFlight, 1))),
+      commands(std::bit_ceil(std::max<size_t>(maxInFlight, 1))), scheduling(BatchScheduling::Arrival), queueDepth(0),
+      shedding(false), shedCommands(0), depth(nullptr), running(false), sleeping(false), wakeups(0) {
+    batch.reserve(batchSize);
+    deferredSessions.reserve(batchSize);
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i].index = static_cast<uint32_t>(i);
+        freeRecords.tryPush(static_cast<uint32_t>(i));
+    }
+    book.addFillSink(&fillSink);
+}
+
+/**
+ * @brief Stops the thread, completing the commands already queued.
+ */
+MatchingThread::~MatchingThread() {
+    stop();
+    book.removeFillSink(&fillSink);
+    if (depth) {
+        book.removeFillSink(depth);
+    }
+}
+
+/**
+ * @brief Starts matching on a dedicated thread.
+ */
+void MatchingThread::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    thread = std::thread(&MatchingThread::run, this);
+}
+
+/**
+ * @brief Stops the thread once every queued command has been executed.
+ */
+void MatchingThread::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    wake();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Prepares the submission of a command, to be awaited by a coroutine.
+ * @param command The command for the book.
+ * @param executor The executor resuming the coroutine once the command was executed.
+ * @param session The client session sending the command, whose own commands are never reordered.
+ * @return The awaitable yielding the execution report.
+ */
+SubmitAwaitable MatchingThread::submit(const BookCommand& command, Executor& executor, uint32_t session) {
+    return SubmitAwaitable(*this, command, executor, session);
+}
+
+/**
+ * @brief Publishes the depth of the book after every batch from now on, starting with the current
+ *        book. Must be called before the thread is started.
+ * @param publishedDepth The published depth, which also receives the fills of the book.
+ */
+void MatchingThread::publishDepth(PublishedDepth& publishedDepth) {
+    depth = &publishedDepth;
+    book.addFillSink(depth);
+    depth->publish(book);
+}
+
+/**
+ * @brief Sets how the thread sheds load. Must be called before the thread is started.
+ * @param sheddingPolicy The policy. Its cancel reserve is taken from the completion records, at
+ *        most all of them.
+ */
+void MatchingThread::setLoadShedding(const LoadSheddingPolicy& sheddingPolicy) {
+    uint32_t index;
+    while (cancelRecords.tryPop(index)) {
+        records[index].cancelReserve = false;
+        freeRecords.tryPush(index);
+    }
+    for (size_t i = 0; i < sheddingPolicy.cancelReserve && freeRecords.tryPop(index); ++i) {
+        records[index].cancelReserve = true;
+        cancelRecords.tryPush(index);
+    }
+    policy = sheddingPolicy;
+}
+
+/**
+ * @brief Sets the order in which the commands of each batch are executed. Must be called before the
+ *        thread is started.
+ * @param batchScheduling The scheduling.
+ */
+void MatchingThread::setBatchScheduling(BatchScheduling batchScheduling) {
+    scheduling = batchScheduling;
+}
+
+/**
+ * @brief Returns the number of commands executed so far.
+ * @return The number of commands.
+ */
+uint64_t MatchingThread::getProcessedCommands() const {
+    return processedCommands.get();
+}
+
+/**
+ * @brief Returns the number of non-empty batches executed so far.
+ * @return The number of batches.
+ */
+uint64_t MatchingThread::getBatches() const {
+    return batches.get();
+}
+
+/**
+ * @brief Returns the number of batch auctions run by the thread.
+ * @return The number of auctions.
+ */
+uint64_t MatchingThread::getAuctions() const {
+    return auctions.get();
+}
+
+/**
+ * @brief Returns the number of commands queued and not yet taken by a batch.
+ * @return The queue depth.
+ */
+size_t MatchingThread::getQueueDepth() const {
+    return queueDepth.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the deepest queue seen by the matching thread when starting a batch.
+ * @return The maximum queue depth.
+ */
+uint64_t MatchingThread::getMaxQueueDepth() const {
+    return maxQueueDepth.get();
+}
+
+/**
+ * @brief Returns the number of commands refused because the thread was shedding load.
+ * @return The number of commands.
+ */
+uint64_t MatchingThread::getShedCommands() const {
+    return shedCommands.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Tells whether commands other than cancels are currently shed.
+ * @return True while shedding.
+ */
+bool MatchingThread::isShedding() const {
+    return shedding.load(std::memory_order_relaxed) ||
+        (policy.shedAbove && queueDepth.load(std::memory_order_relaxed) >= policy.shedAbove);
+}
+
+/**
+ * @brief Admits a command and takes a record for it. Cancels are always admitted and may use the
+ *        records kept for them; other commands are shed while the queue is too deep.
+ * @param command The command to submit.
+ * @param status Set to Shed or Busy when no record is returned.
+ * @return The record, null if the command is not admitted.
+ */
+CompletionRecord* MatchingThread::acquireRecord(const BookCommand& command, SubmitStatus& status) {
+    const bool cancel = command.type == CommandType::Cancel;
+    if (!cancel && policy.shedAbove &&
+        (shedding.load(std::memory_order_relaxed) || queueDepth.load(std::memory_order_relaxed) >= policy.shedAbove)) {
+        shedCommands.fetch_add(1, std::memory_order_relaxed);
+        status = SubmitStatus::Shed;
+        return nullptr;
+    }
+
+    uint32_t index;
+    if (freeRecords.tryPop(index) || (cancel && cancelRecords.tryPop(index))) {
+        return &records[index];
+    }
+    status = SubmitStatus::Busy;
+    return nullptr;
+}
+
+void MatchingThread::releaseRecord(CompletionRecord* record) {
+    (record->cancelReserve ? cancelRecords : freeRecords).tryPush(record->index);
+}
+
+/**
+ * @brief Queues a record for the matching thread, waking it if it sleeps. The queue holds as many
+ *        entries as there are records, so it is never full.
+ */
+void MatchingThread::enqueue(CompletionRecord* record) {
+    queueDepth.fetch_add(1, std::memory_order_relaxed);
+    commands.tryPush(record);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_seq_cst)) {
+        wake();
+    }
+}
+
+/**
+ * @brief Wakes the matching thread, whether it waits for commands indefinitely or, in batch auction
+ *        mode, until the next auction.
+ */
+void MatchingThread::wake() {
+    wakeups.fetch_add(1);
+    wakeups.notify_one();
+    if (book.getMatchingMode() == MatchingMode::BatchAuction) {
+        futexWake(wakeups);
+    }
+}
+
+/**
+ * @brief Thread loop: executes batches of commands, and sleeps when the queue is empty.
+ */
+void MatchingThread::run() {
+    while (running.load(std::memory_order_relaxed)) {
+        if (processBatch()) {
+            continue;
+        }
+
+        const uint32_t seen = wakeups.load();
+        sleeping.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (processBatch() == 0 && running.load()) {
+            if (book.getMatchingMode() == MatchingMode::BatchAuction) {
+                const auto untilAuction = std::chrono::duration_cast<std::chrono::microseconds>(
+                    book.getNextAuctionTime() - std::chrono::steady_clock::now());
+                if (untilAuction.count() > 0) {
+                    futexWait(wakeups, seen, untilAuction);
+                }
+            } else {
+                wakeups.wait(seen);
+            }
+        }
+        sleeping.store(false, std::memory_order_relaxed);
+        runDueAuction();
+    }
+
+    // complete what was queued before stopping, so no coroutine is left suspended
+    while (processBatch()) {
+    }
+}
+
+/**
+ * @brief Executes up to batchSize queued commands, then republishes the depth of the book. With
+ *        CancelsFirst scheduling, or while shedding load, cancels may overtake the other commands.
+ * @return The number of commands executed.
+ */
+size_t MatchingThread::processBatch() {
+    batch.clear();
+    CompletionRecord* record;
+    while (batch.size() < batchSize && commands.tryPop(record)) {
+        batch.push_back(record);
+    }
+    if (batch.empty()) {
+        return 0;
+    }
+    const size_t depthAtStart = queueDepth.fetch_sub(batch.size(), std::memory_order_relaxed);
+    if (depthAtStart > maxQueueDepth.get()) {
+        maxQueueDepth.set(depthAtStart);
+    }
+    if (policy.shedAbove && depthAtStart >= policy.shedAbove) {
+        shedding.store(true, std::memory_order_relaxed);
+    }
+
+    const size_t executed = batch.size();
+    if (scheduling == BatchScheduling::CancelsFirst || (policy.cancelsFirstUnderLoad && shedding.load(std::memory_order_relaxed))) {
+        executeCancelsFirst();
+    }
+    for (CompletionRecord* command : batch) {
+        if (command) {
+            execute(*command);
+        }
+    }
+
+    updateShedding();
+    if (!runDueAuction() && depth) {
+        depth->publish(book);
+    }
+    batches.increment();
+    return executed;
+}
+
+/**
+ * @brief Runs the auction of the book if it is in batch auction mode and the interval ended, then
+ *        republishes its depth.
+ * @return Whether an auction ran.
+ */
+bool MatchingThread::runDueAuction() {
+    if (book.getMatchingMode() != MatchingMode::BatchAuction || !book.uncrossIfDue(std::chrono::steady_clock::now())) {
+        return false;
+    }
+    auctions.increment();
+    if (depth) {
+        depth->publish(book);
+    }
+    return true;
+}
+
+/**
+ * @brief Executes the cancels of the batch that can overtake the commands before them: a cancel is
+ *        only held back by an earlier command of its own session, so every session still sees its
+ *        commands executed in the order it sent them. It overtakes the commands of other sessions
+ *        whether or not they cross the spread, passive adds and modifies included. Executed commands are removed from the batch,
+ *        since an inline executor may recycle their record at once.
+ */
+void MatchingThread::executeCancelsFirst() {
+    deferredSessions.clear();
+    for (CompletionRecord*& command : batch) {
+        const uint32_t session = command->session;
+        const bool deferred = std::find(deferredSessions.begin(), deferredSessions.end(), session) != deferredSessions.end();
+        if (command->command.type == CommandType::Cancel && !deferred) {
+            execute(*command);
+            command = nullptr;
+        } else if (!deferred) {
+            deferredSessions.push_back(session);
+        }
+    }
+}
+
+/**
+ * @brief Stops shedding once the queue is back to the resume threshold.
+ */
+void MatchingThread::updateShedding() {
+    if (shedding.load(std::memory_order_relaxed) && queueDepth.load(std::memory_order_relaxed) <= policy.resumeBelow) {
+        shedding.store(false, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Applies a command to the book and hands its report to the submitter's executor.
+ */
+void MatchingThread::execute(CompletionRecord& record) {
+    fillSink.report = &record.report;
+    const CommandResult result = applyCommand(book, record.command, orderIdSequence);
+    fillSink.report = nullptr;
+
+    record.report.status = result.accepted ? SubmitStatus::Accepted : SubmitStatus::Rejected;
+    record.report.orderId = result.orderId;
+    processedCommands.increment();
+    record.executor->post(&record.task);
+}
+
+void MatchingThread::ReportFillSink::onFill(const Fill& fill) {
+    if (report) {
+        ++report->fills;
+        report->filledShares += fill.shares;
+        report->filledNotional += static_cast<int64_t>(fill.price) * fill.shares;
+    }
+}
@@ -0,0 +1,236 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "BookCommand.h"
+#include "BoundedQueue.hpp"
+#include "Executor.h"
+#include "PublishedDepth.h"
+
+/**
+ * @enum SubmitStatus
+ * @brief Outcome of a command submitted to a matching thread.
+ */
+enum class SubmitStatus : uint8_t {
+    Accepted,
+    Rejected,
+    /// every completion record was in use, the command was not sent to the book
+    Busy,
+    /// the sender exceeded its message rate, the command was not sent to the book
+    Throttled,
+    /// the book's queue was over its load shedding threshold, the command was not sent to the book
+    Shed
+};
+
+/**
+ * @enum BatchScheduling
+ * @brief Order in which a matching thread executes the commands of a batch.
+ */
+enum class BatchScheduling : uint8_t {
+    /// in arrival order
+    Arrival,
+    /// cancels first: a cancel overtakes every command of the other sessions in the batch, whether or
+    /// not it crosses the spread, but never an earlier command of its own session
+    CancelsFirst
+};
+
+/**
+ * @struct LoadSheddingPolicy
+ * @brief How a matching thread protects its latency when commands queue up faster than it matches.
+ *        Cancels are never shed, so clients can always take risk off the book.
+ */
+struct LoadSheddingPolicy {
+    /// commands other than cancels are shed once this many commands are queued, 0 to never shed
+    size_t shedAbove = 0;
+    /// shedding stops once the queue is back to this many commands
+    size_t resumeBelow = 0;
+    /// completion records kept for cancels only, so cancels are admitted when all others are in use
+    size_t cancelReserve = 0;
+    /// while shedding, schedule each batch as BatchScheduling::CancelsFirst
+    bool cancelsFirstUnderLoad = true;
+};
+
+/**
+ * @struct ExecutionReport
+ * @brief The ack of a command and the fills it produced.
+ */
+struct ExecutionReport {
+    SubmitStatus status = SubmitStatus::Busy;
+    /// id of the order resting in the book after the command, empty if none
+    std::optional<int64_t> orderId;
+    uint32_t fills = 0;
+    int filledShares = 0;
+    /// sum of price * shares of the fills, in cents
+    int64_t filledNotional = 0;
+};
+
+/**
+ * @struct CompletionRecord
+ * @brief A command in flight: the command, its report once executed, and the coroutine to resume.
+ *        Records are preallocated by the matching thread and recycled after every command.
+ */
+struct CompletionRecord {
+    BookCommand command;
+    ExecutionReport report;
+    ExecutorTask task;
+    Executor* executor = nullptr;
+    /// the session that submitted the command
+    uint32_t session = 0;
+    uint32_t index = 0;
+    /// the record belongs to the records kept for cancels
+    bool cancelReserve = false;
+};
+
+class MatchingThread;
+
+/**
+ * @class SubmitAwaitable
+ * @brief Awaiting it sends a command to the matching thread and suspends the coroutine until the
+ *        execution report is ready; the coroutine then resumes on the executor given to submit.
+ */
+class SubmitAwaitable {
+public:
+    SubmitAwaitable(MatchingThread& matchingThread, const BookCommand& command, Executor& executor, uint32_t session);
+    ~SubmitAwaitable();
+
+    bool await_ready() const noexcept;
+    void await_suspend(std::coroutine_handle<> handle) noexcept;
+    ExecutionReport await_resume() noexcept;
+
+    SubmitAwaitable(const SubmitAwaitable&) = delete;
+    SubmitAwaitable& operator=(const SubmitAwaitable&) = delete;
+
+private:
+    MatchingThread& matchingThread;
+    /// the record carrying the command, null if the command was not admitted
+    CompletionRecord* record;
+    /// the status reported when the command was not admitted
+    SubmitStatus immediateStatus;
+    bool submitted;
+};
+
+/**
+ * @class MatchingThread
+ * @brief Owns the matching of one book: commands from any thread are queued to a dedicated thread,
+ *        which applies them in batches and hands each report back through the submitter's executor.
+ *        The number of commands in flight is bounded by a pool of completion records allocated up
+ *        front, so submitting never allocates. The book must not be touched by other threads while
+ *        the matching thread runs. If the book is in batch auction mode, which must be set before
+ *        the thread starts, the thread also runs its auctions when they are due, even while idle.
+ */
+class MatchingThread {
+public:
+    MatchingThread(Book& book, OrderIdSequence& orderIdSequence, size_t maxInFlight = 4096, size_t batchSize = 64);
+    ~MatchingThread();
+
+    void start();
+    void stop();
+
+    SubmitAwaitable submit(const BookCommand& command, Executor& executor, uint32_t session = 0);
+    void publishDepth(PublishedDepth& depth);
+    void setLoadShedding(const LoadSheddingPolicy& policy);
+    void setBatchScheduling(BatchScheduling scheduling);
+
+    uint64_t getProcessedCommands() const;
+    uint64_t getBatches() const;
+    uint64_t getAuctions() const;
+    size_t getQueueDepth() const;
+    uint64_t getMaxQueueDepth() const;
+    uint64_t getShedCommands() const;
+    bool isShedding() const;
+
+    MatchingThread(const MatchingThread&) = delete;
+    MatchingThread& operator=(const MatchingThread&) = delete;
+
+private:
+    friend class SubmitAwaitable;
+
+    /**
+     * @brief Adds the fills of the command being executed to its report.
+     */
+    class ReportFillSink : public FillSink {
+    public:
+        void onFill(const Fill& fill) override;
+        ExecutionReport* report = nullptr;
+    };
+
+    CompletionRecord* acquireRecord(const BookCommand& command, SubmitStatus& status);
+    void releaseRecord(CompletionRecord* record);
+    void enqueue(CompletionRecord* record);
+    void wake();
+
+    void run();
+    size_t processBatch();
+    void execute(CompletionRecord& record);
+    void executeCancelsFirst();
+    void updateShedding();
+    bool runDueAuction();
+
+    Book& book;
+    OrderIdSequence& orderIdSequence;
+    size_t batchSize;
+
+    std::vector<CompletionRecord> records;
+    /// indices of the records not in flight
+    BoundedQueue<uint32_t> freeRecords;
+    /// indices of the records kept for cancels and not in flight
+    BoundedQueue<uint32_t> cancelRecords;
+    /// records whose command waits for the matching thread
+    BoundedQueue<CompletionRecord*> commands;
+    /// the commands of the batch being executed
+    std::vector<CompletionRecord*> batch;
+    /// sessions with a command of the batch that cancels may not overtake
+    std::vector<uint32_t> deferredSessions;
+    BatchScheduling scheduling;
+
+    LoadSheddingPolicy policy;
+    /// commands queued and not yet taken by a batch
+    std::atomic<size_t> queueDepth;
+    /// written by the matching thread only: set when a batch starts with shedAbove commands queued,
+    /// cleared once the queue is back to resumeBelow. Submitters also shed while the queue is over
+    /// shedAbove, so a flag set by an idle thread can never outlive the burst
+    std::atomic<bool> shedding;
+    std::atomic<uint64_t> shedCommands;
+    MetricsCounter maxQueueDepth;
+
+    ReportFillSink fillSink;
+    /// republished at the end of every batch, null if not set
+    PublishedDepth* depth;
+    std::thread thread;
+    std::atomic<bool> running;
+    /// set while the matching thread waits for commands, so submitters only wake it when needed
+    std::atomic<bool> sleeping;
+    std::atomic<uint32_t> wakeups;
+
+    MetricsCounter processedCommands;
+    MetricsCounter batches;
+    MetricsCounter auctions;
+};
@@ -0,0 +1,233 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * @enum RejectReason
+ * @brief The reasons for which a book can reject an order or a command.
+ */
+enum class RejectReason {
+    InvalidPrice,
+    InvalidSize,
+    MissingLimitPrice,
+    InsufficientLiquidity,
+    UnknownOrder,
+    Count
+};
+
+/**
+ * @brief Returns the name of a reject reason, as used in the metrics labels.
+ * @param reason The reject reason.
+ * @return The name of the reason.
+ */
+inline const char* toString(RejectReason reason) {
+    switch (reason) {
+        case RejectReason::InvalidPrice: return "invalid_price";
+        case RejectReason::InvalidSize: return "invalid_size";
+        case RejectReason::MissingLimitPrice: return "missing_limit_price";
+        case RejectReason::InsufficientLiquidity: return "insufficient_liquidity";
+        case RejectReason::UnknownOrder: return "unknown_order";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @class MetricsCounter
+ * @brief A single-writer counter. Only the thread that owns the book increments it, so the
+ *        increment is a plain load and store without a locked read-modify-write, while any other
+ *        thread can still read a consistent value at any time.
+ */
+class MetricsCounter {
+public:
+    void increment(uint64_t amount = 1) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void set(uint64_t newValue) {
+        value.store(newValue, std::memory_order_relaxed);
+    }
+
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+/**
+ * @struct HistogramSnapshot
+ * @brief A point-in-time copy of a Log2Histogram.
+ * @tparam Buckets Number of buckets of the histogram.
+ */
+template<size_t Buckets>
+struct HistogramSnapshot {
+    /// number of observations per bucket (not cumulative)
+    std::array<uint64_t, Buckets> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    /**
+     * @brief Returns the inclusive upper bound of a bucket. The last bucket is unbounded.
+     */
+    static constexpr uint64_t upperBound(size_t bucket) {
+        return bucket == 0 ? 0 : (uint64_t{1} << bucket) - 1;
+    }
+
+    /**
+     * @brief Returns the bucket holding the given percentile of the observations.
+     * @param fraction The percentile expressed as a fraction in [0, 1].
+     * @return The bucket index, 0 if there are no observations.
+     */
+    size_t percentileBucket(double fraction) const {
+        const double rank = fraction * static_cast<double>(count);
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket < Buckets; ++bucket) {
+            cumulative += buckets[bucket];
+            if (cumulative > 0 && static_cast<double>(cumulative) >= rank) {
+                return bucket;
+            }
+        }
+        return 0;
+    }
+};
+
+/**
+ * @class Log2Histogram
+ * @brief A single-writer histogram with power of two buckets: bucket 0 holds zeros, bucket i holds
+ *        values in [2^(i-1), 2^i - 1] and the last bucket holds everything larger.
+ * @tparam Buckets Number of buckets of the histogram.
+ */
+template<size_t Buckets>
+class Log2Histogram {
+public:
+    void observe(uint64_t value) {
+        size_t bucket = std::bit_width(value);
+        if (bucket >= Buckets) {
+            bucket = Buckets - 1;
+        }
+        buckets[bucket].increment();
+        sum.increment(value);
+    }
+
+    HistogramSnapshot<Buckets> snapshot() const {
+        HistogramSnapshot<Buckets> result;
+        for (size_t i = 0; i < Buckets; ++i) {
+            result.buckets[i] = buckets[i].get();
+            result.count += result.buckets[i];
+        }
+        result.sum = sum.get();
+        return result;
+    }
+
+private:
+    std::array<MetricsCounter, Buckets> buckets;
+    MetricsCounter sum;
+};
+
+/// buckets of the sweep depth histogram: 0, 1, 2-3, 4-7, ... , 64+ levels
+constexpr size_t sweepDepthBuckets = 8;
+
+/**
+ * @struct BookMetricsSnapshot
+ * @brief A point-in-time copy of the counters of a book.
+ */
+struct BookMetricsSnapshot {
+    uint64_t ordersAdded = 0;
+    uint64_t ordersCancelled = 0;
+    uint64_t ordersFilled = 0;
+    uint64_t sharesTraded = 0;
+    uint64_t levelsCreated = 0;
+    uint64_t levelsDestroyed = 0;
+    uint64_t restingOrders = 0;
+    std::array<uint64_t, static_cast<size_t>(RejectReason::Count)> rejects{};
+    HistogramSnapshot<sweepDepthBuckets> sweepDepth;
+};
+
+/**
+ * @struct ExchangeMetricsSnapshot
+ * @brief A point-in-time copy of the counters of every book of an exchange.
+ */
+struct ExchangeMetricsSnapshot {
+    std::string exchangeName;
+    /// orders sent for an instrument that is not covered by the exchange
+    uint64_t unknownInstrumentRejects = 0;
+    std::map<std::string, BookMetricsSnapshot> books;
+};
+
+/**
+ * @class BookMetrics
+ * @brief The runtime counters of a book. They are updated by the thread that mutates the book and
+ *        only aggregated when a reader asks for a snapshot.
+ */
+class BookMetrics {
+public:
+    /// limit orders accepted by the book
+    MetricsCounter ordersAdded;
+    /// orders removed by a cancel
+    MetricsCounter ordersCancelled;
+    /// resting orders completely filled
+    MetricsCounter ordersFilled;
+    /// shares executed against resting orders
+    MetricsCounter sharesTraded;
+    /// price levels inserted in either side
+    MetricsCounter levelsCreated;
+    /// price levels removed from either side
+    MetricsCounter levelsDestroyed;
+    /// size of the book's allOrders map
+    MetricsCounter restingOrders;
+    /// number of price levels crossed by each aggressive order
+    Log2Histogram<sweepDepthBuckets> sweepDepth;
+
+    void recordReject(RejectReason reason) {
+        rejects[static_cast<size_t>(reason)].increment();
+    }
+
+    BookMetricsSnapshot snapshot() const {
+        BookMetricsSnapshot result;
+        result.ordersAdded = ordersAdded.get();
+        result.ordersCancelled = ordersCancelled.get();
+        result.ordersFilled = ordersFilled.get();
+        result.sharesTraded = sharesTraded.get();
+        result.levelsCreated = levelsCreated.get();
+        result.levelsDestroyed = levelsDestroyed.get();
+        result.restingOrders = restingOrders.get();
+        for (size_t i = 0; i < rejects.size(); ++i) {
+            result.rejects[i] = rejects[i].get();
+        }
+        result.sweepDepth = sweepDepth.snapshot();
+        return result;
+    }
+
+private:
+    std::array<MetricsCounter, static_cast<size_t>(RejectReason::Count)> rejects;
+};
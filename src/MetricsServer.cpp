@@ -0,0 +1,250 @@
+#include "MetricsServer.h"
+#include "Exchange.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+constexpr int sendFlags = 0;
+#endif
+
+/// how long a scrape may take to send its request before the connection is dropped
+constexpr int requestTimeoutMs = 1000;
+/// how often a connection waiting for its request checks whether the server is stopping
+constexpr int pollIntervalMs = 100;
+
+namespace {
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void writeHeader(std::ostringstream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+/**
+ * @brief Writes one sample per book for a counter or gauge of the book snapshot.
+ */
+template<typename Getter>
+void writeBookMetric(std::ostringstream& out, const ExchangeMetricsSnapshot& snapshot, const char* name,
+                     const char* type, const char* help, Getter getter) {
+    writeHeader(out, name, type, help);
+    const std::string exchange = escapeLabel(snapshot.exchangeName);
+    for (const auto& [ticker, book] : snapshot.books) {
+        out << name << "{exchange=\"" << exchange << "\",instrument=\"" << escapeLabel(ticker) << "\"} "
+            << getter(book) << "\n";
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Renders a metrics snapshot in the Prometheus text exposition format.
+ * @param snapshot The snapshot of the exchange metrics.
+ * @return The exposition text.
+ */
+std::string formatPrometheusMetrics(const ExchangeMetricsSnapshot& snapshot) {
+    std::ostringstream out;
+    const std::string exchange = escapeLabel(snapshot.exchangeName);
+
+    writeBookMetric(out, snapshot, "exchange_orders_added_total", "counter", "Limit orders accepted by the book.",
+                    [](const BookMetricsSnapshot& book) { return book.ordersAdded; });
+    writeBookMetric(out, snapshot, "exchange_orders_cancelled_total", "counter", "Orders removed by a cancel.",
+                    [](const BookMetricsSnapshot& book) { return book.ordersCancelled; });
+    writeBookMetric(out, snapshot, "exchange_orders_filled_total", "counter", "Resting orders completely filled.",
+                    [](const BookMetricsSnapshot& book) { return book.ordersFilled; });
+    writeBookMetric(out, snapshot, "exchange_shares_traded_total", "counter", "Shares executed against resting orders.",
+                    [](const BookMetricsSnapshot& book) { return book.sharesTraded; });
+    writeBookMetric(out, snapshot, "exchange_levels_created_total", "counter", "Price levels inserted in the book.",
+                    [](const BookMetricsSnapshot& book) { return book.levelsCreated; });
+    writeBookMetric(out, snapshot, "exchange_levels_destroyed_total", "counter", "Price levels removed from the book.",
+                    [](const BookMetricsSnapshot& book) { return book.levelsDestroyed; });
+    writeBookMetric(out, snapshot, "exchange_resting_orders", "gauge", "Orders currently stored in the book.",
+                    [](const BookMetricsSnapshot& book) { return book.restingOrders; });
+
+    writeHeader(out, "exchange_rejects_total", "counter", "Orders and commands rejected, by reason.");
+    out << "exchange_rejects_total{exchange=\"" << exchange << "\",instrument=\"\",reason=\"unknown_instrument\"} "
+        << snapshot.unknownInstrumentRejects << "\n";
+    for (const auto& [ticker, book] : snapshot.books) {
+        for (size_t reason = 0; reason < book.rejects.size(); ++reason) {
+            out << "exchange_rejects_total{exchange=\"" << exchange << "\",instrument=\"" << escapeLabel(ticker)
+                << "\",reason=\"" << toString(static_cast<RejectReason>(reason)) << "\"} " << book.rejects[reason] << "\n";
+        }
+    }
+
+    writeHeader(out, "exchange_sweep_depth_levels", "histogram", "Price levels crossed by each aggressive order.");
+    for (const auto& [ticker, book] : snapshot.books) {
+        const std::string labels = "exchange=\"" + exchange + "\",instrument=\"" + escapeLabel(ticker) + "\"";
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket + 1 < book.sweepDepth.buckets.size(); ++bucket) {
+            cumulative += book.sweepDepth.buckets[bucket];
+            out << "exchange_sweep_depth_levels_bucket{" << labels << ",le=\""
+                << HistogramSnapshot<sweepDepthBuckets>::upperBound(bucket) << "\"} " << cumulative << "\n";
+        }
+        out << "exchange_sweep_depth_levels_bucket{" << labels << ",le=\"+Inf\"} " << book.sweepDepth.count << "\n";
+        out << "exchange_sweep_depth_levels_sum{" << labels << "} " << book.sweepDepth.sum << "\n";
+        out << "exchange_sweep_depth_levels_count{" << labels << "} " << book.sweepDepth.count << "\n";
+    }
+
+    return out.str();
+}
+
+/**
+ * @brief Constructs a metrics server for an exchange. The server does not listen until started.
+ * @param exchange The exchange whose metrics are served.
+ * @param port The localhost port to listen on, 0 to let the system pick a free one.
+ */
+MetricsServer::MetricsServer(const Exchange& exchange, uint16_t port)
+    : exchange(exchange), port(port), listenSocket(-1), running(false) {}
+
+/**
+ * @brief Stops the server if it is still running.
+ */
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+/**
+ * @brief Binds the listening socket to 127.0.0.1 and starts serving scrapes on a background thread.
+ * @throws std::runtime_error if the socket cannot be created or bound.
+ */
+void MetricsServer::start() {
+    if (running) {
+        return;
+    }
+
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
+        throw std::runtime_error("Can't create the metrics server socket.");
+    }
+
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listenSocket, 16) < 0) {
+        close(listenSocket);
+        listenSocket = -1;
+        throw std::runtime_error("Can't bind the metrics server to port " + std::to_string(port) + ".");
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(listenSocket, reinterpret_cast<sockaddr*>(&address), &length);
+    port = ntohs(address.sin_port);
+
+    running = true;
+    serverThread = std::thread(&MetricsServer::serve, this);
+}
+
+/**
+ * @brief Stops serving scrapes and closes the listening socket.
+ */
+void MetricsServer::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    if (serverThread.joinable()) {
+        serverThread.join();
+    }
+    close(listenSocket);
+    listenSocket = -1;
+}
+
+/**
+ * @brief Returns the port the server listens on. Once started, this is the actual port even if 0 was requested.
+ * @return The port.
+ */
+uint16_t MetricsServer::getPort() const {
+    return port;
+}
+
+/**
+ * @brief Accepts connections until the server is stopped, waking up periodically to check for it.
+ */
+void MetricsServer::serve() {
+    pollfd listener{listenSocket, POLLIN, 0};
+    while (running) {
+        if (poll(&listener, 1, 100) <= 0) {
+            continue;
+        }
+        int connection = accept(listenSocket, nullptr, nullptr);
+        if (connection >= 0) {
+            handleConnection(connection);
+            close(connection);
+        }
+    }
+}
+
+/**
+ * @brief Answers a single HTTP request: GET /metrics returns the exposition text, anything else a 404.
+ *        The connection is dropped if the request doesn't arrive within requestTimeoutMs.
+ * @param connection The accepted connection socket.
+ */
+void MetricsServer::handleConnection(int connection) const {
+    // a client that connects and sends nothing must not hold up other scrapes or stop()
+    pollfd client{connection, POLLIN, 0};
+    for (int waited = 0; poll(&client, 1, pollIntervalMs) <= 0; waited += pollIntervalMs) {
+        if (!running || waited + pollIntervalMs >= requestTimeoutMs) {
+            return;
+        }
+    }
+    timeval sendTimeout{requestTimeoutMs / 1000, 0};
+    setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+    char request[1024];
+    const ssize_t received = recv(connection, request, sizeof(request) - 1, 0);
+    if (received <= 0) {
+        return;
+    }
+    request[received] = '\0';
+
+    const std::string requestLine(request);
+    std::string status = "200 OK";
+    std::string body;
+    if (requestLine.rfind("GET /metrics ", 0) == 0 || requestLine.rfind("GET / ", 0) == 0) {
+        body = formatPrometheusMetrics(exchange.getMetricsSnapshot());
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    const std::string response = "HTTP/1.1 " + status + "\r\n"
+                                 "Content-Type: text/plain; version=0.0.4\r\n"
+                                 "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                 "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        const ssize_t written = send(connection, response.data() + sent, response.size() - sent, sendFlags);
+        if (written <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(written);
+    }
+}
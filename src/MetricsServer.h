@@ -0,0 +1,68 @@
+// A metrics scrape endpoint for the exchange
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "Metrics.h"
+
+class Exchange;
+
+// renders a metrics snapshot in the Prometheus text exposition format
+std::string formatPrometheusMetrics(const ExchangeMetricsSnapshot& snapshot);
+
+/**
+ * @class MetricsServer
+ * @brief Serves the metrics of an exchange in the Prometheus text format on a localhost HTTP port.
+ *        Each scrape takes a fresh snapshot from its own thread, so the matching path never waits on it.
+ */
+class MetricsServer {
+public:
+    MetricsServer(const Exchange& exchange, uint16_t port);
+    ~MetricsServer();
+
+    void start();
+    void stop();
+
+    uint16_t getPort() const;
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+private:
+    /// the exchange whose metrics are served
+    const Exchange& exchange;
+    /// the port to listen on, 0 to let the system pick one
+    uint16_t port;
+    /// the listening socket, -1 when the server is stopped
+    int listenSocket;
+    std::atomic<bool> running;
+    std::thread serverThread;
+
+    void serve();
+    void handleConnection(int connection) const;
+};
@@ -1,5 +1,7 @@
 #include "Order.h"
 
+#include <algorithm>
+
 /**
  * @brief Constructs a new Order.
  * @param orderData The data associated with the order, including type, side, size, limit price, and timestamps.
@@ -15,6 +17,9 @@ Order::Order(const OrderData& orderData, Limit* parentLimit, OrderIdSequence& id
     if (orderData.shares <= 0) {
         throw std::invalid_argument("The order size must be positive");
     }
+    if (orderData.minQuantity < 0) {
+        throw std::invalid_argument("The minimum quantity can't be negative");
+    }
 
     orderId = idSequence.getNextId();
 }
@@ -122,3 +127,28 @@ OrderType Order::getOrderType() const {
 int64_t Order::getOrderId() const {
     return orderId;
 }
+
+/**
+ * @brief Returns the minimum quantity of each execution against the order.
+ * @return Minimum quantity, 0 if the order has none, allOrNoneQuantity for an all-or-none order.
+ */
+int Order::getMinQuantity() const {
+    return orderData.minQuantity;
+}
+
+/**
+ * @brief Returns whether the order can refuse an execution, having a minimum quantity above one share.
+ * @return True if the order is all-or-none or has a minimum quantity.
+ */
+bool Order::isConstrained() const {
+    return orderData.minQuantity > 1;
+}
+
+/**
+ * @brief Returns the smallest volume that can execute against the order right now: its minimum
+ *        quantity, capped by the shares left, so all of them for an all-or-none order.
+ * @return The minimum execution.
+ */
+int Order::getMinExecution() const {
+    return std::min(orderData.minQuantity, orderData.shares);
+}
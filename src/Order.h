@@ -58,6 +58,9 @@ public:
     int getShares() const;
     int64_t getOrderId() const;
     OrderType getOrderType() const;
+    int getMinQuantity() const;
+    bool isConstrained() const;
+    int getMinExecution() const;
     
     // setters
     void setNextOrder(Order* nextOrder);
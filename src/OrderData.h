@@ -25,6 +25,8 @@
 #pragma once
 
 #include <chrono>
+#include <cmath>
+#include <limits>
 #include <optional>
 #include "OrderType.h"
 #include "Side.hpp"
@@ -37,6 +39,9 @@ inline int getCurrentTimeSeconds() {
     return static_cast<int>(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
 }
 
+/// minimum quantity of an all-or-none order, which can't execute for less than all its shares left
+constexpr int allOrNoneQuantity = std::numeric_limits<int>::max();
+
 /**
  * @struct OrderData
  * @brief Represents the data associated with an order.
@@ -48,6 +53,8 @@ struct OrderData {
     std::optional<int> limit; // limit is an optional field (market orders)
     int entryTime;
     int eventTime;
+    /// smallest volume an execution against the resting order may have, 0 for none, allOrNoneQuantity for all-or-none
+    int minQuantity = 0;
 
     // Constructor where limit is provided
     OrderData(Side orderSide, int shares, float limit, OrderType orderType)
@@ -38,6 +38,21 @@ public:
         return currentId.fetch_add(1, std::memory_order_relaxed);
     }
 
+    /**
+     * @brief Moves the sequence so the next id is the given one, when restoring orders with their ids.
+     * @param nextId The next id to hand out.
+     */
+    void restore(int64_t nextId) {
+        currentId.store(nextId, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the id the next call to next() will hand out, without consuming it.
+     */
+    int64_t peekNextId() const {
+        return currentId.load(std::memory_order_relaxed);
+    }
+
 private:
     std::atomic<int64_t> currentId;
 };
@@ -0,0 +1,303 @@
+#include "PositionKeeper.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+/**
+ * @brief Allocates the positions of every account and instrument. The thread is only started by start.
+ * @param accounts Number of accounts, identified by 0 to accounts - 1.
+ * @param instruments Number of instruments, identified by 0 to instruments - 1.
+ * @param queueCapacity Number of fills the queue holds before publishers have to wait.
+ */
+PositionKeeper::PositionKeeper(uint32_t accounts, uint32_t instruments, size_t queueCapacity)
+    : accounts(accounts), instruments(instruments),
+      positions(std::make_unique<PositionRow[]>(static_cast<size_t>(accounts) * instruments)),
+      queue(std::bit_ceil(std::max<size_t>(queueCapacity, 2))), running(false), sleeping(false), wakeups(0),
+      processedFills(0), fullQueueWaits(0) {}
+
+/**
+ * @brief Stops the thread, applying the fills already queued.
+ */
+PositionKeeper::~PositionKeeper() {
+    stop();
+}
+
+/**
+ * @brief Starts consuming fills on a dedicated thread.
+ */
+void PositionKeeper::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    thread = std::thread(&PositionKeeper::run, this);
+}
+
+/**
+ * @brief Stops the thread once every queued fill has been applied.
+ */
+void PositionKeeper::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    wakeups.fetch_add(1);
+    wakeups.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Queues a fill, waking the keeper if it sleeps.
+ * @param fill The fill.
+ * @return False if the queue is full.
+ * @throws std::out_of_range if the account or the instrument is unknown.
+ */
+bool PositionKeeper::tryPublish(const AccountFill& fill) {
+    if (fill.account >= accounts || fill.instrument >= instruments) {
+        throw std::out_of_range("Unknown account or instrument in a drop-copy fill.");
+    }
+    if (!queue.tryPush(fill)) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_seq_cst)) {
+        wakeups.fetch_add(1);
+        wakeups.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Queues a fill, yielding while the queue is full: positions must see every fill, so a
+ *        keeper that fell behind by a whole queue slows the publishers down rather than lose one.
+ * @param fill The fill.
+ */
+void PositionKeeper::publish(const AccountFill& fill) {
+    while (!tryPublish(fill)) {
+        fullQueueWaits.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Returns a consistent copy of a position. Safe from any thread.
+ * @param account The account.
+ * @param instrument The instrument.
+ * @return The position.
+ * @throws std::out_of_range if the account or the instrument is unknown.
+ */
+PositionSnapshot PositionKeeper::getPosition(uint32_t account, uint32_t instrument) const {
+    if (account >= accounts || instrument >= instruments) {
+        throw std::out_of_range("Unknown account or instrument.");
+    }
+    const PositionRow& row = positions[static_cast<size_t>(account) * instruments + instrument];
+    PositionSnapshot snapshot;
+    while (true) {
+        const uint32_t before = row.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        snapshot.netShares = row.netShares.load(std::memory_order_relaxed);
+        snapshot.openNotional = row.openNotional.load(std::memory_order_relaxed);
+        snapshot.realizedPnl = row.realizedPnl.load(std::memory_order_relaxed);
+        snapshot.tradedNotional = row.tradedNotional.load(std::memory_order_relaxed);
+        snapshot.tradedShares = row.tradedShares.load(std::memory_order_relaxed);
+        snapshot.fills = row.fills.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (row.sequence.load(std::memory_order_relaxed) == before) {
+            return snapshot;
+        }
+    }
+}
+
+/**
+ * @brief Returns the positions of an account in every instrument, indexed by instrument.
+ * @param account The account.
+ * @return The positions.
+ * @throws std::out_of_range if the account is unknown.
+ */
+std::vector<PositionSnapshot> PositionKeeper::getAccountPositions(uint32_t account) const {
+    std::vector<PositionSnapshot> result;
+    result.reserve(instruments);
+    for (uint32_t instrument = 0; instrument < instruments; ++instrument) {
+        result.push_back(getPosition(account, instrument));
+    }
+    return result;
+}
+
+uint32_t PositionKeeper::getAccountCount() const {
+    return accounts;
+}
+
+uint32_t PositionKeeper::getInstrumentCount() const {
+    return instruments;
+}
+
+/**
+ * @brief Returns the number of fills applied to the positions so far.
+ * @return The number of fills.
+ */
+uint64_t PositionKeeper::getProcessedFills() const {
+    return processedFills.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of times a publisher found the queue full and had to wait.
+ * @return The number of waits.
+ */
+uint64_t PositionKeeper::getFullQueueWaits() const {
+    return fullQueueWaits.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Thread loop: applies queued fills, and sleeps when the queue is empty.
+ */
+void PositionKeeper::run() {
+    while (running.load(std::memory_order_relaxed)) {
+        if (drain()) {
+            continue;
+        }
+
+        const uint32_t seen = wakeups.load();
+        sleeping.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (drain() == 0 && running.load()) {
+            wakeups.wait(seen);
+        }
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    while (drain()) {
+    }
+}
+
+/**
+ * @brief Applies the fills currently queued.
+ * @return The number of fills applied.
+ */
+size_t PositionKeeper::drain() {
+    size_t applied = 0;
+    AccountFill fill;
+    while (queue.tryPop(fill)) {
+        apply(fill);
+        ++applied;
+    }
+    if (applied) {
+        processedFills.store(processedFills.load(std::memory_order_relaxed) + applied, std::memory_order_relaxed);
+    }
+    return applied;
+}
+
+/**
+ * @brief Updates a position with a fill at the average entry price: shares reducing the position
+ *        realize the difference between the fill price and the average price, shares beyond a
+ *        flat position open a new one at the fill price.
+ */
+void PositionKeeper::apply(const AccountFill& fill) {
+    PositionRow& row = positions[static_cast<size_t>(fill.account) * instruments + fill.instrument];
+    int64_t netShares = row.netShares.load(std::memory_order_relaxed);
+    int64_t openNotional = row.openNotional.load(std::memory_order_relaxed);
+    int64_t realizedPnl = row.realizedPnl.load(std::memory_order_relaxed);
+
+    const int64_t direction = fill.side == Side::Buy ? 1 : -1;
+    int64_t remaining = fill.shares;
+    if (netShares != 0 && (netShares > 0) != (direction > 0)) {
+        const int64_t held = netShares > 0 ? netShares : -netShares;
+        const int64_t closed = std::min(remaining, held);
+        const int64_t closedNotional = closed == held ? openNotional : openNotional * closed / held;
+        const int64_t netDirection = netShares > 0 ? 1 : -1;
+        realizedPnl += netDirection * static_cast<int64_t>(fill.price) * closed - closedNotional;
+        openNotional -= closedNotional;
+        netShares -= netDirection * closed;
+        remaining -= closed;
+    }
+    netShares += direction * remaining;
+    openNotional += direction * static_cast<int64_t>(fill.price) * remaining;
+
+    const uint32_t sequence = row.sequence.load(std::memory_order_relaxed);
+    row.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    row.netShares.store(netShares, std::memory_order_relaxed);
+    row.openNotional.store(openNotional, std::memory_order_relaxed);
+    row.realizedPnl.store(realizedPnl, std::memory_order_relaxed);
+    row.tradedNotional.store(row.tradedNotional.load(std::memory_order_relaxed) + static_cast<int64_t>(fill.price) * fill.shares,
+                             std::memory_order_relaxed);
+    row.tradedShares.store(row.tradedShares.load(std::memory_order_relaxed) + fill.shares, std::memory_order_relaxed);
+    row.fills.store(row.fills.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    row.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Constructs the sink of one book. It still has to be registered with Book::addFillSink.
+ * @param keeper The position keeper receiving the account fills.
+ * @param instrument The index of the book's instrument in the keeper.
+ */
+AccountFillSink::AccountFillSink(PositionKeeper& keeper, uint32_t instrument)
+    : keeper(keeper), instrument(instrument), aggressorAccount(0), unattributedFills(0) {}
+
+/**
+ * @brief Applies a command on behalf of an account, remembering the owner of the order it leaves
+ *        in the book and forgetting the orders it cancelled or executed completely.
+ * @param book The book, which must have this sink registered.
+ * @param command The command.
+ * @param orderIdSequence The sequence assigning ids to resting orders.
+ * @param account The account sending the command.
+ * @return The result of the command.
+ */
+CommandResult AccountFillSink::apply(Book& book, const BookCommand& command, OrderIdSequence& orderIdSequence, uint32_t account) {
+    aggressorAccount = account;
+    const CommandResult result = applyCommand(book, command, orderIdSequence);
+
+    // also forgets the orders executed by auctions run since the last command
+    const auto* restingOrders = book.getAllOrders();
+    for (int64_t orderId : executedOrders) {
+        if (!restingOrders->count(orderId)) {
+            orderAccounts.erase(orderId);
+        }
+    }
+    executedOrders.clear();
+    if (result.accepted && command.type == CommandType::Add && result.orderId) {
+        orderAccounts[*result.orderId] = account;
+    } else if (result.accepted && command.type == CommandType::Cancel) {
+        orderAccounts.erase(command.orderId);
+    }
+    return result;
+}
+
+/**
+ * @brief Forwards the resting and the aggressive side of a fill to the keeper. The resting side
+ *        is dropped and counted if the resting order was not entered through apply. The buy of an
+ *        auction fill rests too, so it goes to the owner of that order rather than the sender of
+ *        the command being applied.
+ */
+void AccountFillSink::onFill(const Fill& fill) {
+    const Side restingSide = fill.aggressorSide == Side::Buy ? Side::Sell : Side::Buy;
+    publishResting(fill.restingOrderId, restingSide, fill);
+    if (fill.contraOrderId >= 0) {
+        publishResting(fill.contraOrderId, fill.aggressorSide, fill);
+    } else {
+        keeper.publish({aggressorAccount, instrument, fill.aggressorSide, fill.price, fill.shares});
+    }
+}
+
+void AccountFillSink::publishResting(int64_t orderId, Side side, const Fill& fill) {
+    auto owner = orderAccounts.find(orderId);
+    if (owner != orderAccounts.end()) {
+        keeper.publish({owner->second, instrument, side, fill.price, fill.shares});
+        executedOrders.push_back(orderId);
+    } else {
+        ++unattributedFills;
+    }
+}
+
+/**
+ * @brief Returns the number of fills whose resting order had no known account.
+ * @return The number of fills.
+ */
+uint64_t AccountFillSink::getUnattributedFills() const {
+    return unattributedFills;
+}
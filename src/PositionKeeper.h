@@ -0,0 +1,157 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "BookCommand.h"
+#include "BoundedQueue.hpp"
+#include "Fill.h"
+
+/**
+ * @struct AccountFill
+ * @brief One account's side of a fill, as carried from the books to the position keeper.
+ */
+struct AccountFill {
+    uint32_t account;
+    uint32_t instrument;
+    /// side of the account in the trade
+    Side side;
+    int price;
+    int shares;
+};
+
+/**
+ * @struct PositionSnapshot
+ * @brief The position of an account in an instrument. Amounts are in cents.
+ */
+struct PositionSnapshot {
+    /// shares held, negative when short
+    int64_t netShares = 0;
+    /// cost of the open position at the average entry price, negative when short
+    int64_t openNotional = 0;
+    /// profit and loss of the shares bought and sold back, at the average entry price
+    int64_t realizedPnl = 0;
+    /// sum of price * shares of every fill
+    int64_t tradedNotional = 0;
+    int64_t tradedShares = 0;
+    uint64_t fills = 0;
+};
+
+/**
+ * @class PositionKeeper
+ * @brief The drop-copy stage: consumes the account fills of every book from a lock-free queue on
+ *        its own thread and keeps a position per account and instrument in one flat array. The
+ *        matching threads only push fills; any thread can read a consistent position at any time.
+ */
+class PositionKeeper {
+public:
+    PositionKeeper(uint32_t accounts, uint32_t instruments, size_t queueCapacity = 65536);
+    ~PositionKeeper();
+
+    void start();
+    void stop();
+
+    bool tryPublish(const AccountFill& fill);
+    void publish(const AccountFill& fill);
+
+    PositionSnapshot getPosition(uint32_t account, uint32_t instrument) const;
+    std::vector<PositionSnapshot> getAccountPositions(uint32_t account) const;
+
+    uint32_t getAccountCount() const;
+    uint32_t getInstrumentCount() const;
+    uint64_t getProcessedFills() const;
+    uint64_t getFullQueueWaits() const;
+
+    PositionKeeper(const PositionKeeper&) = delete;
+    PositionKeeper& operator=(const PositionKeeper&) = delete;
+
+private:
+    /**
+     * @brief A position guarded by a sequence lock: the keeper makes the sequence odd while it
+     *        updates the row, and readers retry until they copied the row under an even sequence.
+     */
+    struct alignas(64) PositionRow {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<int64_t> netShares{0};
+        std::atomic<int64_t> openNotional{0};
+        std::atomic<int64_t> realizedPnl{0};
+        std::atomic<int64_t> tradedNotional{0};
+        std::atomic<int64_t> tradedShares{0};
+        std::atomic<uint64_t> fills{0};
+    };
+
+    void run();
+    size_t drain();
+    void apply(const AccountFill& fill);
+
+    uint32_t accounts;
+    uint32_t instruments;
+    /// one row per account and instrument, account major
+    std::unique_ptr<PositionRow[]> positions;
+    BoundedQueue<AccountFill> queue;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<bool> sleeping;
+    std::atomic<uint32_t> wakeups;
+
+    std::atomic<uint64_t> processedFills;
+    std::atomic<uint64_t> fullQueueWaits;
+};
+
+/**
+ * @class AccountFillSink
+ * @brief Attributes the fills of one book to accounts and forwards both sides of each fill to a
+ *        position keeper. Commands must be applied through apply, on the thread that owns the
+ *        book, so the sink knows the account of the aggressor and of every resting order.
+ */
+class AccountFillSink : public FillSink {
+public:
+    AccountFillSink(PositionKeeper& keeper, uint32_t instrument);
+
+    CommandResult apply(Book& book, const BookCommand& command, OrderIdSequence& orderIdSequence, uint32_t account);
+    void onFill(const Fill& fill) override;
+
+    uint64_t getUnattributedFills() const;
+
+private:
+    void publishResting(int64_t orderId, Side side, const Fill& fill);
+
+    PositionKeeper& keeper;
+    uint32_t instrument;
+    /// account of the command being applied
+    uint32_t aggressorAccount;
+    /// account of each order resting in the book
+    std::unordered_map<int64_t, uint32_t> orderAccounts;
+    /// resting orders executed by the command being applied
+    std::vector<int64_t> executedOrders;
+    uint64_t unattributedFills;
+};
@@ -0,0 +1,145 @@
+#include "PublishedDepth.h"
+#include "Book.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Copies the best levels of a side, walking the tree from the touch.
+ * @return The number of levels copied.
+ */
+template<typename Iterator>
+int copyLevels(Iterator begin, Iterator end, std::array<DepthLevel, publishedDepthLevels>& levels) {
+    int count = 0;
+    for (auto it = begin; it != end && count < publishedDepthLevels; ++it, ++count) {
+        const Limit& limit = *it->second;
+        levels[count] = DepthLevel{limit.getLimitPrice(), limit.getTotalVolume(), limit.getSize()};
+    }
+    return count;
+}
+
+} // namespace
+
+/**
+ * @brief Allocates the buffers and publishes an empty view.
+ * @param buffers Number of view buffers, at least 2. More buffers let the writer keep publishing
+ *        while readers are slow to finish their copies.
+ */
+PublishedDepth::PublishedDepth(size_t buffers)
+    : buffers(std::make_unique<Buffer[]>(std::max<size_t>(buffers, 2))), bufferCount(std::max<size_t>(buffers, 2)),
+      current(nullptr), epoch(1), hasLastTrade(false), lastTrade{} {
+    current.store(&this->buffers[0]);
+}
+
+/**
+ * @brief Keeps the fill as the last trade of the next view.
+ */
+void PublishedDepth::onFill(const Fill& fill) {
+    hasLastTrade = true;
+    lastTrade = fill;
+}
+
+/**
+ * @brief Publishes the current depth of the book. Must be called by the thread that mutates the book.
+ * @param book The book.
+ * @return False if the publication was skipped because every spare buffer was still being read.
+ */
+bool PublishedDepth::publish(const Book& book) {
+    Buffer* buffer = findFreeBuffer();
+    if (!buffer) {
+        skippedPublications.increment();
+        return false;
+    }
+
+    DepthView& view = buffer->view;
+    const auto& bidTree = book.getBuySide()->getSideTree();
+    const auto& askTree = book.getSellSide()->getSideTree();
+    view.version = publications.get() + 1;
+    view.bidLevels = copyLevels(bidTree.rbegin(), bidTree.rend(), view.bids);
+    view.askLevels = copyLevels(askTree.begin(), askTree.end(), view.asks);
+    view.hasLastTrade = hasLastTrade;
+    view.lastTrade = lastTrade;
+
+    Buffer* previous = current.exchange(buffer, std::memory_order_seq_cst);
+    const uint64_t retiredAt = epoch.load(std::memory_order_relaxed);
+    previous->retiredEpoch = retiredAt;
+    epoch.store(retiredAt + 1, std::memory_order_seq_cst);
+    publications.increment();
+    return true;
+}
+
+/**
+ * @brief Returns the number of views published, the initial empty one excluded.
+ * @return The number of publications.
+ */
+uint64_t PublishedDepth::getPublications() const {
+    return publications.get();
+}
+
+/**
+ * @brief Returns the number of publications skipped because readers held every spare buffer.
+ * @return The number of skipped publications.
+ */
+uint64_t PublishedDepth::getSkippedPublications() const {
+    return skippedPublications.get();
+}
+
+/**
+ * @brief Finds a buffer that is not current and that no reader can still be copying: every reader
+ *        is either idle or started reading after the buffer was retired.
+ * @return The buffer, null if there is none.
+ */
+PublishedDepth::Buffer* PublishedDepth::findFreeBuffer() {
+    uint64_t oldestReader = UINT64_MAX;
+    for (const ReaderSlot& reader : readers) {
+        const uint64_t readerEpoch = reader.epoch.load(std::memory_order_seq_cst);
+        if (readerEpoch != 0 && readerEpoch < oldestReader) {
+            oldestReader = readerEpoch;
+        }
+    }
+
+    Buffer* published = current.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < bufferCount; ++i) {
+        Buffer* buffer = &buffers[i];
+        if (buffer != published && buffer->retiredEpoch < oldestReader) {
+            return buffer;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Claims a reader slot of the published depth.
+ * @param depth The published depth to read.
+ * @throws std::runtime_error if maxDepthReaders readers are already registered.
+ */
+DepthReader::DepthReader(PublishedDepth& depth)
+    : depth(depth), slot([&depth]() -> PublishedDepth::ReaderSlot& {
+          for (PublishedDepth::ReaderSlot& candidate : depth.readers) {
+              bool expected = false;
+              if (candidate.registered.compare_exchange_strong(expected, true)) {
+                  return candidate;
+              }
+          }
+          throw std::runtime_error("Too many readers registered on the published depth.");
+      }()) {}
+
+/**
+ * @brief Releases the reader slot.
+ */
+DepthReader::~DepthReader() {
+    slot.registered.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Copies the latest published view. Wait-free: the copy never retries and never blocks.
+ * @return The view.
+ */
+DepthView DepthReader::read() const {
+    slot.epoch.store(depth.epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    const DepthView view = depth.current.load(std::memory_order_seq_cst)->view;
+    slot.epoch.store(0, std::memory_order_release);
+    return view;
+}
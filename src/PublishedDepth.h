@@ -0,0 +1,140 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "Fill.h"
+#include "Metrics.h"
+
+class Book;
+
+/// number of price levels per side in a published depth view
+constexpr int publishedDepthLevels = 10;
+/// maximum number of readers registered at the same time on a published depth
+constexpr size_t maxDepthReaders = 64;
+
+/**
+ * @struct DepthLevel
+ * @brief A price level of a published depth view. Prices are in cents.
+ */
+struct DepthLevel {
+    int price = 0;
+    int volume = 0;
+    /// number of orders resting at the level
+    int orders = 0;
+};
+
+/**
+ * @struct DepthView
+ * @brief A consistent copy of the top of a book: the best levels of each side, best first, and
+ *        the last trade, as of the end of a matching batch.
+ */
+struct DepthView {
+    /// number of publications before this one, increasing by one per publication
+    uint64_t version = 0;
+    int bidLevels = 0;
+    int askLevels = 0;
+    std::array<DepthLevel, publishedDepthLevels> bids{};
+    std::array<DepthLevel, publishedDepthLevels> asks{};
+    bool hasLastTrade = false;
+    Fill lastTrade{};
+};
+
+/**
+ * @class PublishedDepth
+ * @brief Publishes depth views of a book from the matching thread to any number of reader threads.
+ *        Views are written into a small pool of buffers and published by swapping a pointer; a
+ *        buffer is only rewritten once no reader can still be copying it, which is tracked with
+ *        per-reader epochs. Reading is a fixed number of steps, so readers never wait for the
+ *        writer nor for each other, and the writer never waits for readers: if every spare buffer
+ *        is still pinned by a slow reader, the publication is skipped and the next one catches up.
+ *        Registered as a fill sink of the book, it also keeps the last trade.
+ */
+class PublishedDepth : public FillSink {
+public:
+    explicit PublishedDepth(size_t buffers = 4);
+
+    void onFill(const Fill& fill) override;
+    bool publish(const Book& book);
+
+    uint64_t getPublications() const;
+    uint64_t getSkippedPublications() const;
+
+    PublishedDepth(const PublishedDepth&) = delete;
+    PublishedDepth& operator=(const PublishedDepth&) = delete;
+
+private:
+    friend class DepthReader;
+
+    struct alignas(64) ReaderSlot {
+        /// epoch at which the reader started its current read, 0 while it is not reading
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> registered{false};
+    };
+
+    struct Buffer {
+        DepthView view;
+        /// epoch at which the buffer stopped being the current one
+        uint64_t retiredEpoch = 0;
+    };
+
+    Buffer* findFreeBuffer();
+
+    std::unique_ptr<Buffer[]> buffers;
+    size_t bufferCount;
+    std::atomic<Buffer*> current;
+    std::atomic<uint64_t> epoch;
+    std::array<ReaderSlot, maxDepthReaders> readers;
+
+    /// the last fill seen by the writer, copied into every view
+    bool hasLastTrade;
+    Fill lastTrade;
+
+    MetricsCounter publications;
+    MetricsCounter skippedPublications;
+};
+
+/**
+ * @class DepthReader
+ * @brief A registration of a reader thread on a published depth. Each reader thread uses its own.
+ */
+class DepthReader {
+public:
+    explicit DepthReader(PublishedDepth& depth);
+    ~DepthReader();
+
+    DepthView read() const;
+
+    DepthReader(const DepthReader&) = delete;
+    DepthReader& operator=(const DepthReader&) = delete;
+
+private:
+    PublishedDepth& depth;
+    PublishedDepth::ReaderSlot& slot;
+};
@@ -0,0 +1,348 @@
+#include "QuoteConsolidator.h"
+#include "Exchange.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * @brief Registers a venue.
+ * @param exchange The exchange of the venue, which must outlive the consolidator.
+ * @return The index of the venue, its bit in the venue sets.
+ * @throws std::runtime_error if maxConsolidatedVenues venues are already registered.
+ */
+uint32_t QuoteConsolidator::addVenue(Exchange& exchange) {
+    if (venues.size() == maxConsolidatedVenues) {
+        throw std::runtime_error("Too many venues for the consolidator.");
+    }
+    venues.push_back(&exchange);
+    return static_cast<uint32_t>(venues.size() - 1);
+}
+
+/**
+ * @brief Registers a symbol, quoted by the book of the same ticker on each venue.
+ * @param symbol The ticker.
+ * @return The index of the symbol, the existing one if it was already registered.
+ */
+uint32_t QuoteConsolidator::addSymbol(const std::string& symbol) {
+    auto [it, inserted] = symbolIndex.try_emplace(symbol, static_cast<uint32_t>(symbols.size()));
+    if (inserted) {
+        symbols.push_back(std::make_unique<Symbol>());
+        symbols.back()->name = symbol;
+    }
+    return it->second;
+}
+
+/**
+ * @brief Returns the index of a registered symbol.
+ * @param symbol The ticker.
+ * @return The index of the symbol.
+ * @throws std::out_of_range if the symbol is not registered.
+ */
+uint32_t QuoteConsolidator::getSymbol(const std::string& symbol) const {
+    auto it = symbolIndex.find(symbol);
+    if (it == symbolIndex.end()) {
+        throw std::out_of_range("The symbol is not consolidated.");
+    }
+    return it->second;
+}
+
+/**
+ * @brief Replaces the top of book of a symbol on a venue and publishes the consolidated quote if
+ *        it changed.
+ * @param venue The venue.
+ * @param symbol The symbol.
+ * @param quote The new top of book of the venue.
+ * @return Whether the consolidated quote changed.
+ * @throws std::out_of_range if the venue or the symbol is unknown.
+ */
+bool QuoteConsolidator::updateQuote(uint32_t venue, uint32_t symbol, const VenueQuote& quote) {
+    if (venue >= venues.size()) {
+        throw std::out_of_range("Unknown venue.");
+    }
+    Symbol& state = findSymbol(symbol);
+    if (state.venues[venue] == quote) {
+        return false;
+    }
+    const ConsolidatedQuote before = state.current;
+    state.venues[venue] = quote;
+    updateBid(state, venue, quote);
+    updateAsk(state, venue, quote);
+
+    ConsolidatedQuote& after = state.current;
+    after.bidSize = 0;
+    for (uint64_t set = after.bidVenues; set != 0; set &= set - 1) {
+        after.bidSize += state.venues[std::countr_zero(set)].bidSize;
+    }
+    after.askSize = 0;
+    for (uint64_t set = after.askVenues; set != 0; set &= set - 1) {
+        after.askSize += state.venues[std::countr_zero(set)].askSize;
+    }
+    if (after.bidVenues == before.bidVenues && after.bidPrice == before.bidPrice && after.bidSize == before.bidSize &&
+        after.askVenues == before.askVenues && after.askPrice == before.askPrice && after.askSize == before.askSize) {
+        return false;
+    }
+    ++after.version;
+    publish(symbol, state);
+    return true;
+}
+
+/**
+ * @brief Reads the top of book of a venue's book and updates the consolidated quote with it.
+ * @param venue The venue.
+ * @param symbol The symbol.
+ * @param book The book of the symbol on the venue. Must be called on the thread mutating it.
+ * @return Whether the consolidated quote changed.
+ * @throws std::out_of_range if the venue or the symbol is unknown.
+ */
+bool QuoteConsolidator::updateFromBook(uint32_t venue, uint32_t symbol, const Book& book) {
+    VenueQuote quote;
+    if (const Limit* bid = book.getBuySide()->getBestLimit()) {
+        quote.hasBid = true;
+        quote.bidPrice = bid->getLimitPrice();
+        quote.bidSize = bid->getTotalVolume();
+    }
+    if (const Limit* ask = book.getSellSide()->getBestLimit()) {
+        quote.hasAsk = true;
+        quote.askPrice = ask->getLimitPrice();
+        quote.askSize = ask->getTotalVolume();
+    }
+    return updateQuote(venue, symbol, quote);
+}
+
+/**
+ * @brief Applies a command to the book of a symbol on a venue and consolidates its new top of book.
+ * @param venue The venue.
+ * @param symbol The symbol.
+ * @param command The command.
+ * @return The result of the command.
+ * @throws std::out_of_range if the venue or the symbol is unknown.
+ * @throws std::invalid_argument if the venue does not list the symbol.
+ */
+CommandResult QuoteConsolidator::applyCommand(uint32_t venue, uint32_t symbol, const BookCommand& command) {
+    if (venue >= venues.size()) {
+        throw std::out_of_range("Unknown venue.");
+    }
+    const Symbol& state = findSymbol(symbol);
+    Book* book = venues[venue]->getOrderBook(state.name);
+    if (book == nullptr) {
+        throw std::invalid_argument("The instrument is not covered by the exchange.");
+    }
+    const CommandResult result = ::applyCommand(*book, command, venues[venue]->getOrderIdSequence());
+    updateFromBook(venue, symbol, *book);
+    return result;
+}
+
+/**
+ * @brief Returns a consistent copy of the consolidated quote of a symbol. Safe from any thread.
+ * @param symbol The symbol.
+ * @return The quote.
+ * @throws std::out_of_range if the symbol is unknown.
+ */
+ConsolidatedQuote QuoteConsolidator::getQuote(uint32_t symbol) const {
+    const PublishedQuote& row = findSymbol(symbol).published;
+    ConsolidatedQuote quote;
+    while (true) {
+        const uint32_t before = row.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        quote.version = row.version.load(std::memory_order_relaxed);
+        quote.bidPrice = row.bidPrice.load(std::memory_order_relaxed);
+        quote.bidSize = row.bidSize.load(std::memory_order_relaxed);
+        quote.bidVenues = row.bidVenues.load(std::memory_order_relaxed);
+        quote.askPrice = row.askPrice.load(std::memory_order_relaxed);
+        quote.askSize = row.askSize.load(std::memory_order_relaxed);
+        quote.askVenues = row.askVenues.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (row.sequence.load(std::memory_order_relaxed) == before) {
+            return quote;
+        }
+    }
+}
+
+/**
+ * @brief Returns the last top of book of a symbol on a venue. Only on the updating thread.
+ * @param venue The venue.
+ * @param symbol The symbol.
+ * @return The top of book.
+ * @throws std::out_of_range if the venue or the symbol is unknown.
+ */
+const VenueQuote& QuoteConsolidator::getVenueQuote(uint32_t venue, uint32_t symbol) const {
+    if (venue >= venues.size()) {
+        throw std::out_of_range("Unknown venue.");
+    }
+    return findSymbol(symbol).venues[venue];
+}
+
+/**
+ * @brief Checks whether executing at a price on a venue would trade through a better price
+ *        displayed by another venue, which a router must then take out first. Safe from any thread.
+ * @param symbol The symbol.
+ * @param venue The venue the execution would happen on.
+ * @param side The side of the aggressive order: buys are checked against the asks, sells against the bids.
+ * @param price The execution price.
+ * @return The check, with the better away price and the venues displaying it.
+ * @throws std::out_of_range if the symbol is unknown.
+ */
+TradeThroughCheck QuoteConsolidator::checkTradeThrough(uint32_t symbol, uint32_t venue, Side side, int price) const {
+    const ConsolidatedQuote quote = getQuote(symbol);
+    const uint64_t otherVenues = ~(uint64_t{1} << venue);
+    TradeThroughCheck check;
+    if (side == Side::Buy && quote.hasAsk() && quote.askPrice < price && (quote.askVenues & otherVenues)) {
+        check = {true, quote.askPrice, quote.askVenues & otherVenues};
+    } else if (side == Side::Sell && quote.hasBid() && quote.bidPrice > price && (quote.bidVenues & otherVenues)) {
+        check = {true, quote.bidPrice, quote.bidVenues & otherVenues};
+    }
+    return check;
+}
+
+/**
+ * @brief Registers a sink receiving every change of the consolidated quotes.
+ * @param sink The sink, which must outlive its registration.
+ */
+void QuoteConsolidator::addQuoteSink(QuoteSink* sink) {
+    quoteSinks.push_back(sink);
+}
+
+void QuoteConsolidator::removeQuoteSink(QuoteSink* sink) {
+    quoteSinks.erase(std::remove(quoteSinks.begin(), quoteSinks.end(), sink), quoteSinks.end());
+}
+
+Exchange& QuoteConsolidator::getVenue(uint32_t venue) const {
+    return *venues.at(venue);
+}
+
+size_t QuoteConsolidator::getVenueCount() const {
+    return venues.size();
+}
+
+const std::string& QuoteConsolidator::getSymbolName(uint32_t symbol) const {
+    return findSymbol(symbol).name;
+}
+
+size_t QuoteConsolidator::getSymbolCount() const {
+    return symbols.size();
+}
+
+/**
+ * @brief Returns how many updates had to rescan every venue because the last venue at a best price left it.
+ * @return The number of rescans.
+ */
+uint64_t QuoteConsolidator::getRescans() const {
+    return rescans;
+}
+
+/**
+ * @brief Updates the best bid of a symbol after a venue changed its quote. A better or equal bid
+ *        only touches the venue set; the venues are rescanned when the last one at the best bid
+ *        moved away from it.
+ */
+void QuoteConsolidator::updateBid(Symbol& symbol, uint32_t venue, const VenueQuote& quote) {
+    ConsolidatedQuote& best = symbol.current;
+    const uint64_t bit = uint64_t{1} << venue;
+    if (quote.hasBid && (best.bidVenues == 0 || quote.bidPrice > best.bidPrice)) {
+        best.bidPrice = quote.bidPrice;
+        best.bidVenues = bit;
+        return;
+    }
+    if (quote.hasBid && quote.bidPrice == best.bidPrice) {
+        best.bidVenues |= bit;
+        return;
+    }
+    if (!(best.bidVenues & bit)) {
+        return;
+    }
+    best.bidVenues &= ~bit;
+    if (best.bidVenues != 0) {
+        return;
+    }
+    ++rescans;
+    for (uint32_t other = 0; other < venues.size(); ++other) {
+        const VenueQuote& candidate = symbol.venues[other];
+        if (!candidate.hasBid) {
+            continue;
+        }
+        if (best.bidVenues == 0 || candidate.bidPrice > best.bidPrice) {
+            best.bidPrice = candidate.bidPrice;
+            best.bidVenues = uint64_t{1} << other;
+        } else if (candidate.bidPrice == best.bidPrice) {
+            best.bidVenues |= uint64_t{1} << other;
+        }
+    }
+    if (best.bidVenues == 0) {
+        best.bidPrice = 0;
+    }
+}
+
+/**
+ * @brief Updates the best ask of a symbol after a venue changed its quote, like updateBid.
+ */
+void QuoteConsolidator::updateAsk(Symbol& symbol, uint32_t venue, const VenueQuote& quote) {
+    ConsolidatedQuote& best = symbol.current;
+    const uint64_t bit = uint64_t{1} << venue;
+    if (quote.hasAsk && (best.askVenues == 0 || quote.askPrice < best.askPrice)) {
+        best.askPrice = quote.askPrice;
+        best.askVenues = bit;
+        return;
+    }
+    if (quote.hasAsk && quote.askPrice == best.askPrice) {
+        best.askVenues |= bit;
+        return;
+    }
+    if (!(best.askVenues & bit)) {
+        return;
+    }
+    best.askVenues &= ~bit;
+    if (best.askVenues != 0) {
+        return;
+    }
+    ++rescans;
+    for (uint32_t other = 0; other < venues.size(); ++other) {
+        const VenueQuote& candidate = symbol.venues[other];
+        if (!candidate.hasAsk) {
+            continue;
+        }
+        if (best.askVenues == 0 || candidate.askPrice < best.askPrice) {
+            best.askPrice = candidate.askPrice;
+            best.askVenues = uint64_t{1} << other;
+        } else if (candidate.askPrice == best.askPrice) {
+            best.askVenues |= uint64_t{1} << other;
+        }
+    }
+    if (best.askVenues == 0) {
+        best.askPrice = 0;
+    }
+}
+
+/**
+ * @brief Publishes the current quote of a symbol to the readers and the sinks.
+ */
+void QuoteConsolidator::publish(uint32_t symbolIndex, Symbol& symbol) {
+    const ConsolidatedQuote& quote = symbol.current;
+    PublishedQuote& row = symbol.published;
+    const uint32_t sequence = row.sequence.load(std::memory_order_relaxed);
+    row.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    row.version.store(quote.version, std::memory_order_relaxed);
+    row.bidPrice.store(quote.bidPrice, std::memory_order_relaxed);
+    row.bidSize.store(quote.bidSize, std::memory_order_relaxed);
+    row.bidVenues.store(quote.bidVenues, std::memory_order_relaxed);
+    row.askPrice.store(quote.askPrice, std::memory_order_relaxed);
+    row.askSize.store(quote.askSize, std::memory_order_relaxed);
+    row.askVenues.store(quote.askVenues, std::memory_order_relaxed);
+    row.sequence.store(sequence + 2, std::memory_order_release);
+
+    for (QuoteSink* sink : quoteSinks) {
+        sink->onQuote(symbolIndex, quote);
+    }
+}
+
+QuoteConsolidator::Symbol& QuoteConsolidator::findSymbol(uint32_t symbol) const {
+    if (symbol >= symbols.size()) {
+        throw std::out_of_range("Unknown symbol.");
+    }
+    return *symbols[symbol];
+}
@@ -0,0 +1,170 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BookCommand.h"
+
+class Exchange;
+
+/// maximum number of venues consolidated, one bit each in the venue sets
+constexpr size_t maxConsolidatedVenues = 64;
+
+/**
+ * @struct VenueQuote
+ * @brief The top of book of one symbol on one venue. Prices are in cents.
+ */
+struct VenueQuote {
+    bool hasBid = false;
+    int bidPrice = 0;
+    int64_t bidSize = 0;
+    bool hasAsk = false;
+    int askPrice = 0;
+    int64_t askSize = 0;
+
+    bool operator==(const VenueQuote&) const = default;
+};
+
+/**
+ * @struct ConsolidatedQuote
+ * @brief The best bid and offer of a symbol across every venue, with the venues quoting them.
+ */
+struct ConsolidatedQuote {
+    /// incremented at every change of the quote
+    uint64_t version = 0;
+    int bidPrice = 0;
+    /// displayed shares at the best bid, summed over the venues quoting it
+    int64_t bidSize = 0;
+    /// one bit per venue quoting the best bid, no bid at all when empty
+    uint64_t bidVenues = 0;
+    int askPrice = 0;
+    int64_t askSize = 0;
+    uint64_t askVenues = 0;
+
+    bool hasBid() const { return bidVenues != 0; }
+    bool hasAsk() const { return askVenues != 0; }
+};
+
+/**
+ * @struct TradeThroughCheck
+ * @brief Whether an execution on a venue would trade through a better quote displayed by another.
+ */
+struct TradeThroughCheck {
+    bool tradesThrough = false;
+    /// the better price displayed away, when tradesThrough
+    int awayPrice = 0;
+    /// the venues displaying it
+    uint64_t awayVenues = 0;
+};
+
+/**
+ * @class QuoteSink
+ * @brief Receives the changes of the consolidated quotes, on the thread updating the consolidator.
+ */
+class QuoteSink {
+public:
+    virtual ~QuoteSink() = default;
+    virtual void onQuote(uint32_t symbol, const ConsolidatedQuote& quote) = 0;
+};
+
+/**
+ * @class QuoteConsolidator
+ * @brief Maintains the best bid and offer of each symbol across several exchanges running in the
+ *        same process. It is updated incrementally from the top of book of one venue at a time:
+ *        each symbol keeps the best prices with the set of venues quoting them as a bitset, so a
+ *        change only rescans the venues when the last one at the best price leaves it. Quotes are
+ *        published under a sequence lock and can be read from any thread, while updates come from
+ *        a single thread. Venues and symbols are registered before readers start.
+ */
+class QuoteConsolidator {
+public:
+    QuoteConsolidator() = default;
+
+    uint32_t addVenue(Exchange& exchange);
+    uint32_t addSymbol(const std::string& symbol);
+    uint32_t getSymbol(const std::string& symbol) const;
+
+    bool updateQuote(uint32_t venue, uint32_t symbol, const VenueQuote& quote);
+    bool updateFromBook(uint32_t venue, uint32_t symbol, const Book& book);
+    CommandResult applyCommand(uint32_t venue, uint32_t symbol, const BookCommand& command);
+
+    ConsolidatedQuote getQuote(uint32_t symbol) const;
+    const VenueQuote& getVenueQuote(uint32_t venue, uint32_t symbol) const;
+    TradeThroughCheck checkTradeThrough(uint32_t symbol, uint32_t venue, Side side, int price) const;
+
+    void addQuoteSink(QuoteSink* sink);
+    void removeQuoteSink(QuoteSink* sink);
+
+    Exchange& getVenue(uint32_t venue) const;
+    size_t getVenueCount() const;
+    const std::string& getSymbolName(uint32_t symbol) const;
+    size_t getSymbolCount() const;
+    uint64_t getRescans() const;
+
+    QuoteConsolidator(const QuoteConsolidator&) = delete;
+    QuoteConsolidator& operator=(const QuoteConsolidator&) = delete;
+
+private:
+    /**
+     * @brief The published quote of a symbol, guarded by a sequence lock like the rows of the
+     *        PositionKeeper.
+     */
+    struct alignas(64) PublishedQuote {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<int> bidPrice{0};
+        std::atomic<int> askPrice{0};
+        std::atomic<int64_t> bidSize{0};
+        std::atomic<int64_t> askSize{0};
+        std::atomic<uint64_t> bidVenues{0};
+        std::atomic<uint64_t> askVenues{0};
+        std::atomic<uint64_t> version{0};
+    };
+
+    struct Symbol {
+        std::string name;
+        std::array<VenueQuote, maxConsolidatedVenues> venues{};
+        /// the quote as last published, kept by the writer to detect changes
+        ConsolidatedQuote current;
+        PublishedQuote published;
+    };
+
+    void updateBid(Symbol& symbol, uint32_t venue, const VenueQuote& quote);
+    void updateAsk(Symbol& symbol, uint32_t venue, const VenueQuote& quote);
+    void publish(uint32_t symbolIndex, Symbol& symbol);
+    Symbol& findSymbol(uint32_t symbol) const;
+
+    std::vector<Exchange*> venues;
+    std::vector<std::unique_ptr<Symbol>> symbols;
+    std::unordered_map<std::string, uint32_t> symbolIndex;
+    std::vector<QuoteSink*> quoteSinks;
+    uint64_t rescans = 0;
+};
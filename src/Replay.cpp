@@ -0,0 +1,227 @@
+#include "Replay.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+/**
+ * @brief Collects the fills of one book into its replay output.
+ */
+class CollectingFillSink : public FillSink {
+public:
+    explicit CollectingFillSink(std::vector<Fill>& fills) : fills(fills) {}
+
+    void onFill(const Fill& fill) override {
+        fills.push_back(fill);
+    }
+
+private:
+    std::vector<Fill>& fills;
+};
+
+/**
+ * @brief Replays the messages of one instrument on a fresh book.
+ */
+void replayInstrument(const std::vector<BookCommand>& commands, bool collectFills, InstrumentReplay& output) {
+    Book book;
+    OrderIdSequence orderIdSequence;
+    CollectingFillSink sink(output.fills);
+    if (collectFills) {
+        book.addFillSink(&sink);
+    }
+
+    // historical order id -> id assigned by the book
+    std::unordered_map<int64_t, int64_t> orderIds;
+    orderIds.reserve(commands.size() / 2);
+
+    for (BookCommand command : commands) {
+        if (command.type == CommandType::Cancel || command.type == CommandType::ModifySize) {
+            auto it = orderIds.find(command.orderId);
+            if (it == orderIds.end()) {
+                ++output.rejects;
+                continue;
+            }
+            command.orderId = it->second;
+            if (command.type == CommandType::Cancel) {
+                orderIds.erase(it);
+            }
+        }
+
+        const CommandResult result = applyCommand(book, command, orderIdSequence);
+        if (!result.accepted) {
+            ++output.rejects;
+        } else if (command.type == CommandType::Add && result.orderId && command.orderId >= 0) {
+            orderIds[command.orderId] = *result.orderId;
+        }
+    }
+
+    output.commands = commands.size();
+    output.metrics = book.getMetrics().snapshot();
+}
+
+CommandType parseAction(const std::string& action) {
+    if (action == "add") return CommandType::Add;
+    if (action == "cancel") return CommandType::Cancel;
+    if (action == "modify") return CommandType::ModifySize;
+    if (action == "market") return CommandType::Market;
+    throw std::invalid_argument("Unknown replay action: " + action);
+}
+
+} // namespace
+
+/**
+ * @brief Parses a CSV replay file. Each line is "eventTime,ticker,action,side,shares,price,orderId",
+ *        with side B or S, price in cents, and unused fields left empty. Blank lines are skipped.
+ * @param in The stream to read.
+ * @return The parsed input, tickers indexed in order of first appearance.
+ * @throws std::invalid_argument on a malformed line.
+ */
+ReplayInput readReplayCsv(std::istream& in) {
+    ReplayInput input;
+    std::unordered_map<std::string, uint32_t> instruments;
+    std::string line;
+    size_t lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 7) {
+            fields.resize(7);
+        }
+
+        try {
+            auto [it, inserted] = instruments.try_emplace(fields[1], static_cast<uint32_t>(input.tickers.size()));
+            if (inserted) {
+                input.tickers.push_back(fields[1]);
+            }
+
+            BookCommand command{};
+            command.eventTime = std::stoi(fields[0]);
+            command.type = parseAction(fields[2]);
+            command.side = fields[3] == "S" ? Side::Sell : Side::Buy;
+            command.shares = fields[4].empty() ? 0 : std::stoi(fields[4]);
+            command.price = fields[5].empty() ? 0 : std::stoi(fields[5]);
+            command.orderId = fields[6].empty() || fields[6] == "\r" ? -1 : std::stoll(fields[6]);
+            input.messages.push_back({it->second, command});
+        } catch (const std::exception& e) {
+            throw std::invalid_argument("Malformed replay line " + std::to_string(lineNumber) + ": " + e.what());
+        }
+    }
+    return input;
+}
+
+/**
+ * @brief Replays the input. Messages are partitioned by instrument, keeping their feed order, and each
+ *        partition is replayed on its own book. Partitions run largest first on a work-stealing pool:
+ *        large ones as tasks of their own, small ones batched together. The output only depends on
+ *        the input, never on the number of threads or the scheduling.
+ * @param input The messages to replay.
+ * @param options The number of threads and the task sizing.
+ * @return The per instrument output and the replay throughput.
+ */
+ReplayResult replay(const ReplayInput& input, const ReplayOptions& options) {
+    const size_t instrumentCount = input.tickers.size();
+
+    // Partition with a counting pass first, so the partitions are allocated once
+    std::vector<size_t> counts(instrumentCount, 0);
+    for (const ReplayMessage& message : input.messages) {
+        if (message.instrument >= instrumentCount) {
+            throw std::out_of_range("Replay message for an unknown instrument");
+        }
+        ++counts[message.instrument];
+    }
+    std::vector<std::vector<BookCommand>> partitions(instrumentCount);
+    for (size_t instrument = 0; instrument < instrumentCount; ++instrument) {
+        partitions[instrument].reserve(counts[instrument]);
+    }
+    for (const ReplayMessage& message : input.messages) {
+        partitions[message.instrument].push_back(message.command);
+    }
+
+    std::vector<uint32_t> order(instrumentCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return counts[a] > counts[b]; });
+
+    ReplayResult result;
+    result.instruments.resize(instrumentCount);
+    result.messages = input.messages.size();
+
+    WorkStealingPool pool(options.threads);
+    result.threads = pool.getThreadCount();
+    const auto start = std::chrono::steady_clock::now();
+
+    size_t next = 0;
+    while (next < order.size() && counts[order[next]] > 0) {
+        size_t end = next + 1;
+        size_t batchMessages = counts[order[next]];
+        while (end < order.size() && counts[order[end]] > 0 && batchMessages + counts[order[end]] <= options.taskMessages) {
+            batchMessages += counts[order[end]];
+            ++end;
+        }
+
+        pool.submit([&, next, end] {
+            for (size_t i = next; i < end; ++i) {
+                replayInstrument(partitions[order[i]], options.collectFills, result.instruments[order[i]]);
+            }
+        });
+        ++result.tasks;
+        next = end;
+    }
+    pool.wait();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.stolenTasks = pool.getStolenTasks();
+    return result;
+}
+
+/**
+ * @brief Returns the replay throughput.
+ * @return Messages replayed per second of wall time.
+ */
+double ReplayResult::messagesPerSecond() const {
+    return seconds > 0 ? static_cast<double>(messages) / seconds : 0;
+}
+
+/**
+ * @brief Merges the fills of every instrument into one stream ordered by event time, then instrument
+ *        index, then fill sequence.
+ * @return The merged fills.
+ */
+std::vector<ReplayFill> ReplayResult::mergedFills() const {
+    std::vector<ReplayFill> merged;
+    size_t total = 0;
+    for (const InstrumentReplay& instrument : instruments) {
+        total += instrument.fills.size();
+    }
+    merged.reserve(total);
+    for (size_t instrument = 0; instrument < instruments.size(); ++instrument) {
+        for (const Fill& fill : instruments[instrument].fills) {
+            merged.push_back({static_cast<uint32_t>(instrument), fill});
+        }
+    }
+    std::sort(merged.begin(), merged.end(), [](const ReplayFill& a, const ReplayFill& b) {
+        if (a.fill.eventTime != b.fill.eventTime) {
+            return a.fill.eventTime < b.fill.eventTime;
+        }
+        if (a.instrument != b.instrument) {
+            return a.instrument < b.instrument;
+        }
+        return a.fill.sequence < b.fill.sequence;
+    });
+    return merged;
+}
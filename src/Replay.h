@@ -0,0 +1,108 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include "BookCommand.h"
+
+/**
+ * @struct ReplayMessage
+ * @brief A historical message: a command for the book of one instrument. The order ids of Cancel and
+ *        ModifySize commands, and of Add commands when they are not negative, are the ids of the
+ *        historical feed, which the replay maps to the ids assigned by the book.
+ */
+struct ReplayMessage {
+    uint32_t instrument;
+    BookCommand command;
+};
+
+/**
+ * @struct ReplayInput
+ * @brief The messages to replay, in feed order, and the tickers their instrument indices refer to.
+ */
+struct ReplayInput {
+    std::vector<std::string> tickers;
+    std::vector<ReplayMessage> messages;
+};
+
+// parses "eventTime,ticker,action,side,shares,price,orderId" lines, action being add, cancel, modify or market
+ReplayInput readReplayCsv(std::istream& in);
+
+/**
+ * @struct ReplayFill
+ * @brief A fill of the merged output, tagged with its instrument.
+ */
+struct ReplayFill {
+    uint32_t instrument;
+    Fill fill;
+};
+
+/**
+ * @struct InstrumentReplay
+ * @brief The output of the replay of one instrument.
+ */
+struct InstrumentReplay {
+    uint64_t commands = 0;
+    uint64_t rejects = 0;
+    BookMetricsSnapshot metrics;
+    /// fills of the book in sequence order, only collected if requested
+    std::vector<Fill> fills;
+};
+
+/**
+ * @struct ReplayOptions
+ * @brief How a replay is split into tasks.
+ */
+struct ReplayOptions {
+    size_t threads = 1;
+    /// instruments with at least this many messages get a task of their own, smaller ones are
+    /// batched into tasks of about this many messages
+    size_t taskMessages = 65536;
+    bool collectFills = true;
+};
+
+/**
+ * @struct ReplayResult
+ * @brief The merged output of a replay and how long it took.
+ */
+struct ReplayResult {
+    /// per instrument output, indexed like ReplayInput::tickers
+    std::vector<InstrumentReplay> instruments;
+    uint64_t messages = 0;
+    size_t threads = 0;
+    size_t tasks = 0;
+    uint64_t stolenTasks = 0;
+    /// wall time spent replaying, excluding the partitioning of the input
+    double seconds = 0;
+
+    double messagesPerSecond() const;
+    std::vector<ReplayFill> mergedFills() const;
+};
+
+// replays every instrument of the input on its own book, in parallel
+ReplayResult replay(const ReplayInput& input, const ReplayOptions& options);
@@ -0,0 +1,495 @@
+#include "SharedMemoryOrderEntry.h"
+#include "Futex.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t controlMagic = 0x31544e454d524458; // "XDRMENT1"
+/// polls between two checks that the clients of the active sessions are still running
+constexpr uint32_t livenessCheckInterval = 1 << 16;
+constexpr std::chrono::microseconds gatewaySleep(1000);
+
+std::string requestRingName(const std::string& name, size_t slot, uint32_t generation) {
+    return name + "_" + std::to_string(slot) + "_" + std::to_string(generation) + "_requests";
+}
+
+std::string responseRingName(const std::string& name, size_t slot, uint32_t generation) {
+    return name + "_" + std::to_string(slot) + "_" + std::to_string(generation) + "_responses";
+}
+
+/**
+ * @brief Creates and maps the control block, replacing a stale one with the same name.
+ */
+OrderEntryControlBlock* createControlBlock(const std::string& name) {
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Can't create order entry control block " + name);
+    }
+    if (ftruncate(fd, sizeof(OrderEntryControlBlock)) < 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Can't size order entry control block " + name);
+    }
+    void* mapping = mmap(nullptr, sizeof(OrderEntryControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Can't map order entry control block " + name);
+    }
+
+    auto* control = new (mapping) OrderEntryControlBlock();
+    control->gatewayPid = getpid();
+    for (SessionSlot& slot : control->slots) {
+        slot.state.store(static_cast<uint32_t>(SessionState::Free), std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    control->magic = controlMagic;
+    return control;
+}
+
+/**
+ * @brief Maps the control block of a running gateway.
+ */
+OrderEntryControlBlock* openControlBlock(const std::string& name) {
+    const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("No order entry gateway named " + name);
+    }
+    void* mapping = mmap(nullptr, sizeof(OrderEntryControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Can't map order entry control block " + name);
+    }
+    auto* control = static_cast<OrderEntryControlBlock*>(mapping);
+    if (control->magic != controlMagic) {
+        munmap(mapping, sizeof(OrderEntryControlBlock));
+        throw std::runtime_error("Shared memory object " + name + " is not an order entry control block");
+    }
+    return control;
+}
+
+SessionState loadState(const SessionSlot& slot) {
+    return static_cast<SessionState>(slot.state.load(std::memory_order_acquire));
+}
+
+void storeState(SessionSlot& slot, SessionState state) {
+    slot.state.store(static_cast<uint32_t>(state), std::memory_order_release);
+}
+
+/**
+ * @brief Bumps a signal word and wakes its sleepers, if the other side said it sleeps.
+ */
+void signalIfSleeping(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& sleeping, bool useFutex) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (useFutex && sleeping.load(std::memory_order_seq_cst)) {
+        signal.fetch_add(1, std::memory_order_release);
+        futexWake(signal);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Creates the control block clients connect through. Requests are only served once started.
+ * @param exchange The exchange the requests are applied to.
+ * @param name Name of the control block, starting with '/'. Ring names are derived from it.
+ * @param options Ring capacity, wakeup policy and rate limits. Instruments added to the exchange
+ *        after the gateway was constructed are only limited per session.
+ * @throws std::runtime_error if the control block cannot be created.
+ */
+SharedMemoryOrderGateway::SharedMemoryOrderGateway(Exchange& exchange, const std::string& name, OrderEntryOptions options)
+    : exchange(exchange), name(name), options(options), control(createControlBlock(name)),
+      sessions(maxOrderEntrySessions),
+      throttle(options.sessionRateLimit, options.instrumentRateLimit, maxOrderEntrySessions, exchange.getTickerList()),
+      running(false), activeSessions(0), pollsSinceCheck(0) {}
+
+/**
+ * @brief Stops serving, closes every session and removes the control block.
+ */
+SharedMemoryOrderGateway::~SharedMemoryOrderGateway() {
+    stop();
+    for (size_t slot = 0; slot < sessions.size(); ++slot) {
+        closeSession(slot);
+    }
+    for (Book* book : observedBooks) {
+        book->removeFillSink(&fillSink);
+    }
+    control->magic = 0;
+    munmap(control, sizeof(OrderEntryControlBlock));
+    shm_unlink(name.c_str());
+}
+
+/**
+ * @brief Starts serving the sessions on a dedicated thread.
+ */
+void SharedMemoryOrderGateway::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    thread = std::thread(&SharedMemoryOrderGateway::run, this);
+}
+
+/**
+ * @brief Stops serving. Sessions stay open until the gateway is destroyed.
+ */
+void SharedMemoryOrderGateway::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    control->requestSignal.fetch_add(1);
+    futexWake(control->requestSignal);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Returns the number of sessions with open rings.
+ * @return The number of sessions.
+ */
+size_t SharedMemoryOrderGateway::getActiveSessions() const {
+    return activeSessions.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of requests applied to the exchange.
+ * @return The number of requests.
+ */
+uint64_t SharedMemoryOrderGateway::getProcessedRequests() const {
+    return processedRequests.get();
+}
+
+/**
+ * @brief Returns the rate limiter of the sessions, with its counters of rejected messages.
+ * @return The throttle.
+ */
+const IngressThrottle& SharedMemoryOrderGateway::getThrottle() const {
+    return throttle;
+}
+
+/**
+ * @brief Gateway loop: polls every session, spinning for a while and then sleeping when idle.
+ */
+void SharedMemoryOrderGateway::run() {
+    int idlePolls = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        if (poll()) {
+            idlePolls = 0;
+            continue;
+        }
+        if (!options.useFutex || ++idlePolls < options.spinsBeforeSleep) {
+            continue;
+        }
+
+        const uint32_t seen = control->requestSignal.load(std::memory_order_acquire);
+        control->gatewaySleeping.store(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (poll() == 0 && running.load()) {
+            futexWait(control->requestSignal, seen, gatewaySleep);
+        }
+        control->gatewaySleeping.store(0, std::memory_order_relaxed);
+        idlePolls = 0;
+    }
+}
+
+/**
+ * @brief Handles the session slots once: opens and closes sessions and serves the active ones.
+ * @return The amount of work done, 0 if there was nothing to do.
+ */
+size_t SharedMemoryOrderGateway::poll() {
+    const bool checkLiveness = ++pollsSinceCheck >= livenessCheckInterval;
+    if (checkLiveness) {
+        pollsSinceCheck = 0;
+    }
+
+    size_t work = 0;
+    for (size_t slot = 0; slot < maxOrderEntrySessions; ++slot) {
+        switch (loadState(control->slots[slot])) {
+            case SessionState::Connecting:
+                openSession(slot);
+                ++work;
+                break;
+            case SessionState::Active:
+                if (checkLiveness && !clientAlive(slot)) {
+                    closeSession(slot);
+                    ++work;
+                } else {
+                    work += serveSession(slot);
+                }
+                break;
+            case SessionState::Closing:
+                closeSession(slot);
+                ++work;
+                break;
+            default:
+                break;
+        }
+    }
+    return work;
+}
+
+/**
+ * @brief Applies the pending requests of a session, as long as its response ring has room.
+ *        Requests over the rate limits are answered as Throttled without reaching the exchange;
+ *        cancels are never throttled.
+ * @return The number of requests applied or throttled.
+ */
+size_t SharedMemoryOrderGateway::serveSession(size_t slot) {
+    Session& session = sessions[slot];
+    if (!session.requests) {
+        return 0;
+    }
+
+    size_t served = 0;
+    const int64_t now = coarseNowNanos();
+    OrderEntryRequest request;
+    while (session.responses->size() < session.responses->capacity() && session.requests->tryPop(request)) {
+        request.ticker[orderEntryTickerSize - 1] = '\0';
+        const std::string ticker(request.ticker);
+
+        OrderEntryResponse response{request.requestId, ExecutionReport{}};
+        if (throttle.admit(slot, ticker, request.command.type, now) != ThrottleResult::Admitted) {
+            response.report.status = SubmitStatus::Throttled;
+            session.responses->tryPush(response);
+            ++served;
+            continue;
+        }
+        if (Book* book = exchange.getOrderBook(ticker); book && observedBooks.insert(book).second) {
+            book->addFillSink(&fillSink);
+        }
+        fillSink.report = &response.report;
+        const CommandResult result = exchange.applyCommand(ticker, request.command);
+        fillSink.report = nullptr;
+
+        response.report.status = result.accepted ? SubmitStatus::Accepted : SubmitStatus::Rejected;
+        response.report.orderId = result.orderId;
+        session.responses->tryPush(response);
+        processedRequests.increment();
+        ++served;
+    }
+
+    if (served) {
+        SessionSlot& sessionSlot = control->slots[slot];
+        signalIfSleeping(sessionSlot.responseSignal, sessionSlot.clientSleeping, options.useFutex);
+    }
+    return served;
+}
+
+/**
+ * @brief Creates the rings of a connecting client and activates its session.
+ */
+void SharedMemoryOrderGateway::openSession(size_t slot) {
+    SessionSlot& sessionSlot = control->slots[slot];
+    const uint32_t generation = sessionSlot.generation.load(std::memory_order_relaxed) + 1;
+    sessionSlot.generation.store(generation, std::memory_order_relaxed);
+
+    Session& session = sessions[slot];
+    try {
+        session.requests.emplace(SharedMemoryRing<OrderEntryRequest>::create(requestRingName(name, slot, generation), options.ringCapacity));
+        session.responses.emplace(SharedMemoryRing<OrderEntryResponse>::create(responseRingName(name, slot, generation), options.ringCapacity));
+    } catch (const std::exception&) {
+        closeSession(slot);
+        return;
+    }
+    throttle.resetSession(slot);
+    activeSessions.fetch_add(1, std::memory_order_relaxed);
+    // the client may have given up waiting meanwhile, in which case the slot is already Closing
+    uint32_t expected = static_cast<uint32_t>(SessionState::Connecting);
+    if (!sessionSlot.state.compare_exchange_strong(expected, static_cast<uint32_t>(SessionState::Active),
+                                                   std::memory_order_acq_rel)) {
+        closeSession(slot);
+        return;
+    }
+    sessionSlot.responseSignal.fetch_add(1, std::memory_order_release);
+    futexWake(sessionSlot.responseSignal);
+}
+
+/**
+ * @brief Removes the rings of a session and frees its slot.
+ */
+void SharedMemoryOrderGateway::closeSession(size_t slot) {
+    Session& session = sessions[slot];
+    if (session.requests) {
+        SharedMemoryRing<OrderEntryRequest>::unlink(session.requests->getName());
+        SharedMemoryRing<OrderEntryResponse>::unlink(session.responses->getName());
+        session.requests.reset();
+        session.responses.reset();
+        activeSessions.fetch_sub(1, std::memory_order_relaxed);
+    }
+    SessionSlot& sessionSlot = control->slots[slot];
+    sessionSlot.clientPid = 0;
+    storeState(sessionSlot, SessionState::Free);
+}
+
+/**
+ * @brief Tells whether the process owning a session still exists.
+ */
+bool SharedMemoryOrderGateway::clientAlive(size_t slot) const {
+    const int32_t pid = control->slots[slot].clientPid;
+    return pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+void SharedMemoryOrderGateway::ReportFillSink::onFill(const Fill& fill) {
+    if (report) {
+        ++report->fills;
+        report->filledShares += fill.shares;
+        report->filledNotional += static_cast<int64_t>(fill.price) * fill.shares;
+    }
+}
+
+/**
+ * @brief Opens a session with a gateway: takes a free slot, waits for the gateway to create the rings
+ *        and maps them.
+ * @param gatewayName Name of the gateway's control block.
+ * @param clientName Name of the client, shown in the slot for diagnostics.
+ * @param options Wakeup policy, which should match the gateway's.
+ * @param connectTimeout How long to wait for the gateway to open the session.
+ * @throws std::runtime_error if there is no gateway, no free slot, or the gateway does not answer in time.
+ */
+SharedMemoryOrderClient::SharedMemoryOrderClient(const std::string& gatewayName, const std::string& clientName,
+                                                 OrderEntryOptions options, std::chrono::milliseconds connectTimeout)
+    : options(options), control(openControlBlock(gatewayName)), slot(maxOrderEntrySessions) {
+
+    for (size_t candidate = 0; candidate < maxOrderEntrySessions; ++candidate) {
+        uint32_t expected = static_cast<uint32_t>(SessionState::Free);
+        if (control->slots[candidate].state.compare_exchange_strong(expected, static_cast<uint32_t>(SessionState::Reserved))) {
+            slot = candidate;
+            break;
+        }
+    }
+    if (slot == maxOrderEntrySessions) {
+        munmap(control, sizeof(OrderEntryControlBlock));
+        throw std::runtime_error("No free session on order entry gateway " + gatewayName);
+    }
+
+    SessionSlot& sessionSlot = control->slots[slot];
+    sessionSlot.clientPid = getpid();
+    std::strncpy(sessionSlot.clientName, clientName.c_str(), sizeof(sessionSlot.clientName) - 1);
+    sessionSlot.clientName[sizeof(sessionSlot.clientName) - 1] = '\0';
+    storeState(sessionSlot, SessionState::Connecting);
+    control->requestSignal.fetch_add(1, std::memory_order_release);
+    futexWake(control->requestSignal);
+
+    const auto deadline = std::chrono::steady_clock::now() + connectTimeout;
+    while (loadState(sessionSlot) != SessionState::Active) {
+        if (std::chrono::steady_clock::now() >= deadline || loadState(sessionSlot) == SessionState::Free) {
+            // the gateway may be activating the session right now: a session it activated is closed
+            // normally, and a slot it already freed is no longer ours to touch
+            uint32_t expected = static_cast<uint32_t>(SessionState::Connecting);
+            if (!sessionSlot.state.compare_exchange_strong(expected, static_cast<uint32_t>(SessionState::Closing),
+                                                           std::memory_order_acq_rel) &&
+                expected == static_cast<uint32_t>(SessionState::Active)) {
+                storeState(sessionSlot, SessionState::Closing);
+            }
+            control->requestSignal.fetch_add(1, std::memory_order_release);
+            futexWake(control->requestSignal);
+            munmap(control, sizeof(OrderEntryControlBlock));
+            throw std::runtime_error("Order entry gateway " + gatewayName + " did not open the session");
+        }
+        futexWait(sessionSlot.responseSignal, sessionSlot.responseSignal.load(), std::chrono::microseconds(1000));
+    }
+
+    const uint32_t generation = sessionSlot.generation.load(std::memory_order_relaxed);
+    requests.emplace(SharedMemoryRing<OrderEntryRequest>::open(requestRingName(gatewayName, slot, generation)));
+    responses.emplace(SharedMemoryRing<OrderEntryResponse>::open(responseRingName(gatewayName, slot, generation)));
+}
+
+/**
+ * @brief Closes the session; the gateway removes the rings.
+ */
+SharedMemoryOrderClient::~SharedMemoryOrderClient() {
+    requests.reset();
+    responses.reset();
+    storeState(control->slots[slot], SessionState::Closing);
+    control->requestSignal.fetch_add(1, std::memory_order_release);
+    futexWake(control->requestSignal);
+    munmap(control, sizeof(OrderEntryControlBlock));
+}
+
+/**
+ * @brief Sends a command to the gateway.
+ * @param requestId Echoed in the response.
+ * @param ticker The instrument, shorter than orderEntryTickerSize.
+ * @param command The command.
+ * @return False if the request ring is full.
+ */
+bool SharedMemoryOrderClient::send(uint64_t requestId, const std::string& ticker, const BookCommand& command) {
+    OrderEntryRequest request{requestId, {}, command};
+    std::strncpy(request.ticker, ticker.c_str(), orderEntryTickerSize - 1);
+    if (!requests->tryPush(request)) {
+        return false;
+    }
+    signalIfSleeping(control->requestSignal, control->gatewaySleeping, options.useFutex);
+    return true;
+}
+
+/**
+ * @brief Takes a response if one is available.
+ * @param response Receives the response.
+ * @return False if no response is available.
+ */
+bool SharedMemoryOrderClient::tryReceive(OrderEntryResponse& response) {
+    return responses->tryPop(response);
+}
+
+/**
+ * @brief Waits for a response, spinning first and then sleeping on the session's futex.
+ * @param response Receives the response.
+ * @param timeout The longest time to wait.
+ * @return False if no response arrived in time.
+ */
+bool SharedMemoryOrderClient::receive(OrderEntryResponse& response, std::chrono::microseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (int spin = 0;; ++spin) {
+        if (responses->tryPop(response)) {
+            return true;
+        }
+        if (options.useFutex && spin >= options.spinsBeforeSleep) {
+            break;
+        }
+        if (spin % 1024 == 1023 && std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+    }
+
+    SessionSlot& sessionSlot = control->slots[slot];
+    while (true) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return responses->tryPop(response);
+        }
+
+        const uint32_t seen = sessionSlot.responseSignal.load(std::memory_order_acquire);
+        sessionSlot.clientSleeping.store(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!responses->tryPop(response)) {
+            futexWait(sessionSlot.responseSignal, seen, remaining);
+        } else {
+            sessionSlot.clientSleeping.store(0, std::memory_order_relaxed);
+            return true;
+        }
+        sessionSlot.clientSleeping.store(0, std::memory_order_relaxed);
+        if (responses->tryPop(response)) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Returns the session slot taken by the client.
+ * @return The slot index.
+ */
+size_t SharedMemoryOrderClient::getSlot() const {
+    return slot;
+}
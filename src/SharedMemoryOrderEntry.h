@@ -0,0 +1,213 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "Exchange.hpp"
+#include "MatchingThread.h"
+#include "SharedMemoryRing.hpp"
+#include "Throttle.h"
+
+/// session slots of a shared memory order entry gateway
+constexpr size_t maxOrderEntrySessions = 16;
+/// longest ticker, including the terminating zero, accepted on the shared memory channel
+constexpr size_t orderEntryTickerSize = 24;
+
+/**
+ * @struct OrderEntryRequest
+ * @brief A command sent by a client through its request ring.
+ */
+struct OrderEntryRequest {
+    /// chosen by the client and echoed in the response
+    uint64_t requestId;
+    char ticker[orderEntryTickerSize];
+    BookCommand command;
+};
+
+/**
+ * @struct OrderEntryResponse
+ * @brief The execution report of a request, sent back through the client's response ring.
+ */
+struct OrderEntryResponse {
+    uint64_t requestId;
+    ExecutionReport report;
+};
+
+/**
+ * @enum SessionState
+ * @brief Life cycle of a session slot in the control block.
+ */
+enum class SessionState : uint32_t {
+    Free,
+    /// taken by a client that is still filling in its details
+    Reserved,
+    /// waiting for the gateway to create the rings
+    Connecting,
+    Active,
+    /// released by the client, waiting for the gateway to remove the rings
+    Closing
+};
+
+/**
+ * @struct SessionSlot
+ * @brief The part of the control block describing one client session.
+ */
+struct SessionSlot {
+    std::atomic<uint32_t> state;
+    /// incremented for every session using the slot, part of the ring names
+    std::atomic<uint32_t> generation;
+    int32_t clientPid;
+    char clientName[32];
+    /// incremented by the gateway after sending responses, the client sleeps on it
+    alignas(64) std::atomic<uint32_t> responseSignal;
+    std::atomic<uint32_t> clientSleeping;
+};
+
+/**
+ * @struct OrderEntryControlBlock
+ * @brief The shared memory object through which clients find the gateway and open sessions.
+ */
+struct OrderEntryControlBlock {
+    uint64_t magic;
+    int32_t gatewayPid;
+    /// incremented by clients after sending requests, the gateway sleeps on it
+    alignas(64) std::atomic<uint32_t> requestSignal;
+    std::atomic<uint32_t> gatewaySleeping;
+    SessionSlot slots[maxOrderEntrySessions];
+};
+
+/**
+ * @struct OrderEntryOptions
+ * @brief Tuning of the shared memory channel, for both the gateway and the clients.
+ */
+struct OrderEntryOptions {
+    /// records per ring, a power of two
+    size_t ringCapacity = 1024;
+    /// sleep on a futex after this many empty polls; without futex, poll forever
+    bool useFutex = true;
+    int spinsBeforeSleep = 20000;
+    /// message rate allowed to each session, unlimited by default
+    RateLimit sessionRateLimit;
+    /// message rate allowed to each instrument over all sessions, unlimited by default
+    RateLimit instrumentRateLimit;
+};
+
+/**
+ * @class SharedMemoryOrderGateway
+ * @brief Order entry for clients on the same host. Each client session gets a request ring and a
+ *        response ring in shared memory; a single gateway thread applies the requests of every
+ *        session to the exchange and answers with execution reports. Clients find the gateway
+ *        through a control block holding the session slots. The gateway is the only thread
+ *        mutating the books while it runs.
+ */
+class SharedMemoryOrderGateway {
+public:
+    SharedMemoryOrderGateway(Exchange& exchange, const std::string& name, OrderEntryOptions options = {});
+    ~SharedMemoryOrderGateway();
+
+    void start();
+    void stop();
+
+    size_t getActiveSessions() const;
+    uint64_t getProcessedRequests() const;
+    const IngressThrottle& getThrottle() const;
+
+    SharedMemoryOrderGateway(const SharedMemoryOrderGateway&) = delete;
+    SharedMemoryOrderGateway& operator=(const SharedMemoryOrderGateway&) = delete;
+
+private:
+    struct Session {
+        std::optional<SharedMemoryRing<OrderEntryRequest>> requests;
+        std::optional<SharedMemoryRing<OrderEntryResponse>> responses;
+    };
+
+    /**
+     * @brief Adds the fills of the request being executed to its report.
+     */
+    class ReportFillSink : public FillSink {
+    public:
+        void onFill(const Fill& fill) override;
+        ExecutionReport* report = nullptr;
+    };
+
+    void run();
+    size_t poll();
+    size_t serveSession(size_t slot);
+    void openSession(size_t slot);
+    void closeSession(size_t slot);
+    bool clientAlive(size_t slot) const;
+
+    Exchange& exchange;
+    std::string name;
+    OrderEntryOptions options;
+    OrderEntryControlBlock* control;
+
+    std::vector<Session> sessions;
+    IngressThrottle throttle;
+    ReportFillSink fillSink;
+    /// books the fill sink was registered on
+    std::unordered_set<Book*> observedBooks;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<size_t> activeSessions;
+    MetricsCounter processedRequests;
+    /// polls since the last liveness check of the clients
+    uint32_t pollsSinceCheck;
+};
+
+/**
+ * @class SharedMemoryOrderClient
+ * @brief The client side of a session with a SharedMemoryOrderGateway, used by one thread.
+ */
+class SharedMemoryOrderClient {
+public:
+    SharedMemoryOrderClient(const std::string& gatewayName, const std::string& clientName, OrderEntryOptions options = {},
+                            std::chrono::milliseconds connectTimeout = std::chrono::milliseconds(1000));
+    ~SharedMemoryOrderClient();
+
+    bool send(uint64_t requestId, const std::string& ticker, const BookCommand& command);
+    bool tryReceive(OrderEntryResponse& response);
+    bool receive(OrderEntryResponse& response, std::chrono::microseconds timeout);
+
+    size_t getSlot() const;
+
+    SharedMemoryOrderClient(const SharedMemoryOrderClient&) = delete;
+    SharedMemoryOrderClient& operator=(const SharedMemoryOrderClient&) = delete;
+
+private:
+    OrderEntryOptions options;
+    OrderEntryControlBlock* control;
+    size_t slot;
+    std::optional<SharedMemoryRing<OrderEntryRequest>> requests;
+    std::optional<SharedMemoryRing<OrderEntryResponse>> responses;
+};
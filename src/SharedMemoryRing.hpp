@@ -0,0 +1,319 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+/**
+ * @class SharedMemoryRing
+ * @brief A single-producer single-consumer ring of fixed size records living in a POSIX shared
+ *        memory object, so the producer and the consumer can be in different processes. The
+ *        producer and the consumer each map the ring once and exchange records without syscalls.
+ * @tparam T Record type, copied bytewise into the ring.
+ */
+template<typename T>
+class SharedMemoryRing {
+    static_assert(std::is_trivially_copyable_v<T>, "records are copied bytewise into shared memory");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring indices must be lock free to be shared between processes");
+
+public:
+    static SharedMemoryRing create(const std::string& name, size_t capacity);
+    static SharedMemoryRing open(const std::string& name);
+    static void unlink(const std::string& name);
+
+    SharedMemoryRing(SharedMemoryRing&& other) noexcept;
+    SharedMemoryRing& operator=(SharedMemoryRing&& other) noexcept;
+    ~SharedMemoryRing();
+
+    bool tryPush(const T& record);
+    bool tryPop(T& record);
+
+    size_t size() const;
+    size_t capacity() const;
+    const std::string& getName() const;
+
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+private:
+    static constexpr uint64_t magic = 0x474e495248534d58; // "XMSHRING"
+
+    /**
+     * @brief Layout of the beginning of the shared memory object, followed by the records.
+     *        The two indices live on separate cache lines so producer and consumer do not contend.
+     */
+    struct Header {
+        uint64_t magic;
+        uint64_t capacity;
+        uint64_t recordSize;
+        alignas(64) std::atomic<uint64_t> writeIndex;
+        alignas(64) std::atomic<uint64_t> readIndex;
+    };
+
+    SharedMemoryRing(const std::string& name, void* mapping, size_t mappedSize);
+
+    static size_t mappingSize(size_t capacity);
+
+    std::string name;
+    void* mapping;
+    size_t mappedSize;
+    Header* header;
+    T* records;
+    uint64_t mask;
+    /// producer side copy of the consumer index, refreshed only when the ring looks full
+    uint64_t cachedReadIndex;
+    /// consumer side copy of the producer index, refreshed only when the ring looks empty
+    uint64_t cachedWriteIndex;
+};
+
+/**
+ * @brief Returns the size of the shared memory object holding a ring of the given capacity.
+ */
+template<typename T>
+size_t SharedMemoryRing<T>::mappingSize(size_t capacity) {
+    return sizeof(Header) + capacity * sizeof(T);
+}
+
+/**
+ * @brief Maps an existing ring. Used by create and open.
+ */
+template<typename T>
+SharedMemoryRing<T>::SharedMemoryRing(const std::string& name, void* mapping, size_t mappedSize)
+    : name(name), mapping(mapping), mappedSize(mappedSize), header(static_cast<Header*>(mapping)),
+      records(reinterpret_cast<T*>(static_cast<char*>(mapping) + sizeof(Header))), mask(header->capacity - 1),
+      cachedReadIndex(header->readIndex.load(std::memory_order_acquire)),
+      cachedWriteIndex(header->writeIndex.load(std::memory_order_acquire)) {}
+
+/**
+ * @brief Creates a new ring, replacing any shared memory object with the same name.
+ * @param name Name of the shared memory object, starting with '/'.
+ * @param capacity Number of records the ring can hold, a power of two.
+ * @return The mapped ring.
+ * @throws std::invalid_argument if the capacity is not a power of two, std::runtime_error if the
+ *         shared memory object cannot be created or mapped.
+ */
+template<typename T>
+SharedMemoryRing<T> SharedMemoryRing<T>::create(const std::string& name, size_t capacity) {
+    
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("The ring capacity must be a power of two");
+    }
+
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Can't create shared memory ring " + name);
+    }
+
+    const size_t size = mappingSize(capacity);
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Can't size shared memory ring " + name);
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Can't map shared memory ring " + name);
+    }
+
+    Header* header = new (mapping) Header();
+    header->capacity = capacity;
+    header->recordSize = sizeof(T);
+    header->writeIndex.store(0, std::memory_order_relaxed);
+    header->readIndex.store(0, std::memory_order_relaxed);
+    // publish the magic last, so a process opening the ring never sees a half initialized header
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = magic;
+
+    return SharedMemoryRing(name, mapping, size);
+}
+
+/**
+ * @brief Maps a ring created by another process.
+ * @param name Name of the shared memory object.
+ * @return The mapped ring.
+ * @throws std::runtime_error if the object does not exist, does not hold a ring of T, or is
+ *         smaller than its header says.
+ */
+template<typename T>
+SharedMemoryRing<T> SharedMemoryRing<T>::open(const std::string& name) {
+    
+    const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open shared memory ring " + name);
+    }
+
+    Header probe;
+    if (pread(fd, &probe, sizeof(uint64_t) * 3, 0) != static_cast<ssize_t>(sizeof(uint64_t) * 3) ||
+        probe.magic != magic || probe.recordSize != sizeof(T)) {
+        close(fd);
+        throw std::runtime_error("Shared memory object " + name + " is not a ring of the expected records");
+    }
+
+    // the index mask needs a power of two, and records past the end of the object would fault
+    const size_t capacity = probe.capacity;
+    struct stat status;
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        capacity > (std::numeric_limits<size_t>::max() - sizeof(Header)) / sizeof(T) ||
+        fstat(fd, &status) < 0 || static_cast<uint64_t>(status.st_size) < mappingSize(capacity)) {
+        close(fd);
+        throw std::runtime_error("Shared memory object " + name + " is truncated or has an invalid capacity");
+    }
+
+    const size_t size = mappingSize(capacity);
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Can't map shared memory ring " + name);
+    }
+    return SharedMemoryRing(name, mapping, size);
+}
+
+/**
+ * @brief Removes the name of a ring. Processes that mapped it keep using it until they unmap it.
+ * @param name Name of the shared memory object.
+ */
+template<typename T>
+void SharedMemoryRing<T>::unlink(const std::string& name) {
+    shm_unlink(name.c_str());
+}
+
+template<typename T>
+SharedMemoryRing<T>::SharedMemoryRing(SharedMemoryRing&& other) noexcept
+    : name(std::move(other.name)), mapping(other.mapping), mappedSize(other.mappedSize), header(other.header),
+      records(other.records), mask(other.mask), cachedReadIndex(other.cachedReadIndex),
+      cachedWriteIndex(other.cachedWriteIndex) {
+    other.mapping = nullptr;
+}
+
+template<typename T>
+SharedMemoryRing<T>& SharedMemoryRing<T>::operator=(SharedMemoryRing&& other) noexcept {
+    if (this != &other) {
+        if (mapping) {
+            munmap(mapping, mappedSize);
+        }
+        name = std::move(other.name);
+        mapping = other.mapping;
+        mappedSize = other.mappedSize;
+        header = other.header;
+        records = other.records;
+        mask = other.mask;
+        cachedReadIndex = other.cachedReadIndex;
+        cachedWriteIndex = other.cachedWriteIndex;
+        other.mapping = nullptr;
+    }
+    return *this;
+}
+
+/**
+ * @brief Unmaps the ring. The shared memory object itself is only removed by unlink.
+ */
+template<typename T>
+SharedMemoryRing<T>::~SharedMemoryRing() {
+    if (mapping) {
+        munmap(mapping, mappedSize);
+    }
+}
+
+/**
+ * @brief Appends a record to the ring. Must only be called by the producer.
+ * @param record The record to append.
+ * @return False if the ring is full.
+ */
+template<typename T>
+bool SharedMemoryRing<T>::tryPush(const T& record) {
+    
+    const uint64_t writeIndex = header->writeIndex.load(std::memory_order_relaxed);
+    if (writeIndex - cachedReadIndex > mask) {
+        cachedReadIndex = header->readIndex.load(std::memory_order_acquire);
+        if (writeIndex - cachedReadIndex > mask) {
+            return false;
+        }
+    }
+    std::memcpy(&records[writeIndex & mask], &record, sizeof(T));
+    header->writeIndex.store(writeIndex + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Removes the oldest record from the ring. Must only be called by the consumer.
+ * @param record Receives the record.
+ * @return False if the ring is empty.
+ */
+template<typename T>
+bool SharedMemoryRing<T>::tryPop(T& record) {
+    
+    const uint64_t readIndex = header->readIndex.load(std::memory_order_relaxed);
+    if (readIndex == cachedWriteIndex) {
+        cachedWriteIndex = header->writeIndex.load(std::memory_order_acquire);
+        if (readIndex == cachedWriteIndex) {
+            return false;
+        }
+    }
+    std::memcpy(&record, &records[readIndex & mask], sizeof(T));
+    header->readIndex.store(readIndex + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Returns the number of records in the ring. Only exact when neither side is active.
+ * @return The number of records.
+ */
+template<typename T>
+size_t SharedMemoryRing<T>::size() const {
+    return header->writeIndex.load(std::memory_order_acquire) - header->readIndex.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Returns the number of records the ring can hold.
+ * @return The capacity.
+ */
+template<typename T>
+size_t SharedMemoryRing<T>::capacity() const {
+    return mask + 1;
+}
+
+/**
+ * @brief Returns the name of the shared memory object.
+ * @return The name.
+ */
+template<typename T>
+const std::string& SharedMemoryRing<T>::getName() const {
+    return name;
+}
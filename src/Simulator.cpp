@@ -0,0 +1,279 @@
+#include "Simulator.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+const std::string Simulation::ticker = "SIM";
+
+namespace {
+
+/**
+ * @brief Scales a probability to the range of a 32 bit random draw.
+ */
+uint32_t probabilityThreshold(double probability) {
+    return static_cast<uint32_t>(std::clamp(probability, 0.0, 1.0) * 4294967295.0);
+}
+
+/**
+ * @brief Spreads a seed over a non-zero 32 bit xorshift state.
+ */
+uint32_t seedState(uint32_t seed, uint32_t stream) {
+    uint64_t z = (static_cast<uint64_t>(seed) << 32 | stream) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    const auto state = static_cast<uint32_t>(z ^ (z >> 31));
+    return state ? state : 1;
+}
+
+} // namespace
+
+/**
+ * @brief Sets up the exchange, the book and the state of every agent.
+ * @param config The parameters of the simulation.
+ * @param seed The seed of every random draw of the simulation.
+ */
+Simulation::Simulation(const SimulationConfig& config, uint32_t seed)
+    : config(config), exchange("SIMEX"), book(nullptr), fillSink(*this), fundamentalRandom(seedState(seed, 0)),
+      fundamental(config.initialPrice), noiseHead(0), noiseCount(0) {
+
+    exchange.addInstrument(ticker);
+    book = exchange.getOrderBook(ticker);
+    book->addFillSink(&fillSink);
+    result.seed = seed;
+
+    const AgentPopulation& population = config.population;
+    makerHalfSpread.resize(population.marketMakers);
+    makerQuotedAt.assign(population.marketMakers, 0);
+    makerBidId.assign(population.marketMakers, -1);
+    makerAskId.assign(population.marketMakers, -1);
+    for (size_t i = 0; i < population.marketMakers; ++i) {
+        makerHalfSpread[i] = config.makerHalfSpread + static_cast<int>(i) * config.makerSpreadStep;
+    }
+
+    momentumRandom.resize(population.momentumTraders);
+    momentumThreshold.resize(population.momentumTraders);
+    momentumDecision.assign(population.momentumTraders, 0);
+    for (size_t i = 0; i < population.momentumTraders; ++i) {
+        momentumRandom[i] = seedState(seed, static_cast<uint32_t>(1 + i));
+        momentumThreshold[i] = config.momentumThreshold + static_cast<int>(i);
+    }
+    midHistory.assign(static_cast<size_t>(std::max(config.momentumLookback, 1)) + 1, config.initialPrice);
+
+    noiseRandom.resize(population.noiseTraders);
+    noiseActive.assign(population.noiseTraders, 0);
+    for (size_t i = 0; i < population.noiseTraders; ++i) {
+        noiseRandom[i] = seedState(seed, static_cast<uint32_t>(1 + population.momentumTraders + i));
+    }
+    noiseOrders.assign(std::max<size_t>(config.maxNoiseOrders, 1), -1);
+
+    result.midPrices.reserve(static_cast<size_t>(std::max(config.steps, 0)));
+}
+
+/**
+ * @brief Runs every step of the simulation.
+ * @return The counters, the mid price path and the trades of the simulation.
+ */
+SimulationResult Simulation::run() {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int step = 0; step < config.steps; ++step) {
+        const int eventTime = config.startTime + step * config.secondsPerStep;
+
+        stepFundamental();
+        stepMarketMakers(eventTime);
+        stepMomentumTraders(eventTime);
+        stepNoiseTraders(eventTime);
+
+        const int mid = currentMid();
+        midHistory[static_cast<size_t>(step) % midHistory.size()] = mid ? mid : fundamental;
+        result.midPrices.push_back(mid);
+    }
+
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.simulatedSeconds = config.steps * config.secondsPerStep;
+    result.metrics = book->getMetrics().snapshot();
+    return std::move(result);
+}
+
+/**
+ * @brief Advances the xorshift32 generator of an agent.
+ */
+uint32_t Simulation::nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/**
+ * @brief Moves the fundamental price by a uniform step in [-fundamentalVolatility, fundamentalVolatility].
+ */
+void Simulation::stepFundamental() {
+    const int range = 2 * config.fundamentalVolatility + 1;
+    fundamental += static_cast<int>(nextRandom(fundamentalRandom) % static_cast<uint32_t>(range)) - config.fundamentalVolatility;
+    fundamental = std::max(fundamental, config.noiseMaxOffset + config.makerHalfSpread + 1);
+}
+
+/**
+ * @brief Requotes the makers whose quotes are stale: the fundamental moved, or a quote was filled.
+ */
+void Simulation::stepMarketMakers(int eventTime) {
+    const auto* orders = book->getAllOrders();
+    for (size_t i = 0; i < makerHalfSpread.size(); ++i) {
+        const bool moved = std::abs(fundamental - makerQuotedAt[i]) >= config.makerRequoteTicks;
+        const bool filled = !orders->count(makerBidId[i]) || !orders->count(makerAskId[i]);
+        if (!moved && !filled) {
+            continue;
+        }
+
+        cancelIfResting(makerBidId[i]);
+        cancelIfResting(makerAskId[i]);
+        makerBidId[i] = submit(Side::Buy, config.makerSize, fundamental - makerHalfSpread[i], eventTime).value_or(-1);
+        makerAskId[i] = submit(Side::Sell, config.makerSize, fundamental + makerHalfSpread[i], eventTime).value_or(-1);
+        makerQuotedAt[i] = fundamental;
+    }
+}
+
+/**
+ * @brief Lets momentum traders whose threshold is exceeded by the recent mid move cross the spread.
+ */
+void Simulation::stepMomentumTraders(int eventTime) {
+    const size_t agents = momentumThreshold.size();
+    const size_t latest = (result.midPrices.size() + midHistory.size() - 1) % midHistory.size();
+    const size_t oldest = result.midPrices.size() % midHistory.size();
+    const int move = midHistory[latest] - midHistory[oldest];
+    const uint32_t activity = probabilityThreshold(config.momentumActivity);
+
+    // decision pass over all agents: +1 buy, -1 sell, 0 stay out
+    for (size_t i = 0; i < agents; ++i) {
+        const uint32_t draw = nextRandom(momentumRandom[i]);
+        const int8_t direction = static_cast<int8_t>((move >= momentumThreshold[i]) - (move <= -momentumThreshold[i]));
+        momentumDecision[i] = draw < activity ? direction : 0;
+    }
+
+    for (size_t i = 0; i < agents; ++i) {
+        if (!momentumDecision[i]) {
+            continue;
+        }
+        const Side side = momentumDecision[i] > 0 ? Side::Buy : Side::Sell;
+        const Limit* opposite = side == Side::Buy ? book->getSellSide()->getBestLimit() : book->getBuySide()->getBestLimit();
+        const int price = opposite ? opposite->getLimitPrice() : fundamental;
+        // priced one cent through the touch, since the book only crosses strictly better prices
+        submit(side, config.momentumSize, side == Side::Buy ? price + 1 : price - 1, eventTime);
+    }
+}
+
+/**
+ * @brief Lets the active noise traders place a limit order at a random offset from the mid price,
+ *        cancelling the oldest noise orders when too many rest in the book.
+ */
+void Simulation::stepNoiseTraders(int eventTime) {
+    const size_t agents = noiseRandom.size();
+    const uint32_t activity = probabilityThreshold(config.noiseActivity);
+
+    // decision pass over all agents
+    for (size_t i = 0; i < agents; ++i) {
+        noiseActive[i] = nextRandom(noiseRandom[i]) < activity;
+    }
+
+    const int mid = currentMid() ? currentMid() : fundamental;
+    for (size_t i = 0; i < agents; ++i) {
+        if (!noiseActive[i]) {
+            continue;
+        }
+        const uint32_t draw = nextRandom(noiseRandom[i]);
+        const Side side = (draw & 1) ? Side::Buy : Side::Sell;
+        const int offset = static_cast<int>((draw >> 1) % static_cast<uint32_t>(2 * config.noiseMaxOffset + 1)) - config.noiseMaxOffset;
+        const int shares = 1 + static_cast<int>((draw >> 16) % static_cast<uint32_t>(config.noiseMaxSize));
+        const int price = side == Side::Buy ? mid - offset : mid + offset;
+
+        if (noiseCount == noiseOrders.size()) {
+            cancelIfResting(noiseOrders[noiseHead]);
+            noiseHead = (noiseHead + 1) % noiseOrders.size();
+            --noiseCount;
+        }
+        if (auto orderId = submit(side, shares, price, eventTime)) {
+            noiseOrders[(noiseHead + noiseCount) % noiseOrders.size()] = *orderId;
+            ++noiseCount;
+        }
+    }
+}
+
+/**
+ * @brief Returns the mid price of the book, 0 if one side is empty.
+ */
+int Simulation::currentMid() const {
+    const Limit* bestBid = book->getBuySide()->getBestLimit();
+    const Limit* bestAsk = book->getSellSide()->getBestLimit();
+    if (!bestBid || !bestAsk) {
+        return 0;
+    }
+    return (bestBid->getLimitPrice() + bestAsk->getLimitPrice()) / 2;
+}
+
+/**
+ * @brief Submits a limit order through the exchange.
+ * @return The id of the resting remainder, empty if the order was completely filled or had no valid price.
+ */
+std::optional<int64_t> Simulation::submit(Side side, int shares, int price, int eventTime) {
+    if (price <= 0 || shares <= 0) {
+        return std::nullopt;
+    }
+    OrderData orderData(side, shares, OrderType::Limit);
+    orderData.limit = price;
+    orderData.entryTime = eventTime;
+    orderData.eventTime = eventTime;
+    ++result.ordersSubmitted;
+    return exchange.addOrder(ticker, orderData);
+}
+
+/**
+ * @brief Cancels an order unless it already left the book.
+ */
+void Simulation::cancelIfResting(int64_t orderId) {
+    if (orderId >= 0 && book->getAllOrders()->count(orderId)) {
+        exchange.cancelOrder(ticker, orderId);
+        ++result.cancels;
+    }
+}
+
+Simulation::ResultFillSink::ResultFillSink(Simulation& simulation) : simulation(simulation) {}
+
+void Simulation::ResultFillSink::onFill(const Fill& fill) {
+    ++simulation.result.fills;
+    simulation.result.sharesTraded += fill.shares;
+    if (simulation.config.recordFills) {
+        simulation.result.trades.push_back(fill);
+    }
+}
+
+/**
+ * @brief Returns how much faster than real time the simulation ran.
+ * @return Simulated seconds per wall clock second.
+ */
+double SimulationResult::speedup() const {
+    return wallSeconds > 0 ? simulatedSeconds / wallSeconds : 0;
+}
+
+/**
+ * @brief Runs independent simulations, one per seed, in parallel. Each simulation owns its exchange,
+ *        so the results only depend on the configuration and the seed.
+ * @param config The parameters shared by every simulation.
+ * @param seeds One seed per simulation.
+ * @param threads Number of worker threads.
+ * @return The results, in the order of the seeds.
+ */
+std::vector<SimulationResult> runSimulations(const SimulationConfig& config, const std::vector<uint32_t>& seeds, size_t threads) {
+    std::vector<SimulationResult> results(seeds.size());
+    WorkStealingPool pool(threads);
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        pool.submit([&config, &seeds, &results, i] {
+            Simulation simulation(config, seeds[i]);
+            results[i] = simulation.run();
+        });
+    }
+    pool.wait();
+    return results;
+}
@@ -0,0 +1,177 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Exchange.hpp"
+
+/**
+ * @struct AgentPopulation
+ * @brief Number of agents of each kind trading the simulated instrument.
+ */
+struct AgentPopulation {
+    /// quote both sides around the fundamental price and requote when it moves
+    size_t marketMakers = 4;
+    /// cross the spread in the direction of the recent mid price move
+    size_t momentumTraders = 16;
+    /// place limit orders at random around the mid price
+    size_t noiseTraders = 256;
+};
+
+/**
+ * @struct SimulationConfig
+ * @brief Parameters of a simulation. Prices and offsets are in cents.
+ */
+struct SimulationConfig {
+    AgentPopulation population;
+    int steps = 10000;
+    /// simulated seconds between two steps, stamped on the orders as event time
+    int secondsPerStep = 1;
+    int startTime = 0;
+    int initialPrice = 10000;
+    /// largest move of the fundamental price in one step
+    int fundamentalVolatility = 2;
+
+    /// half spread of the first maker, each following maker quotes makerSpreadStep wider
+    int makerHalfSpread = 2;
+    int makerSpreadStep = 1;
+    int makerSize = 200;
+    /// fundamental move that makes a maker cancel and replace its quotes
+    int makerRequoteTicks = 2;
+
+    /// steps over which momentum traders measure the mid price move
+    int momentumLookback = 10;
+    /// move that triggers the first momentum trader, each following one needs a cent more
+    int momentumThreshold = 3;
+    /// probability that a triggered momentum trader acts in a step
+    double momentumActivity = 0.2;
+    int momentumSize = 50;
+
+    /// probability that a noise trader places an order in a step
+    double noiseActivity = 0.05;
+    int noiseMaxOffset = 10;
+    int noiseMaxSize = 100;
+    /// resting noise orders kept in the book, the oldest are cancelled beyond it
+    size_t maxNoiseOrders = 4096;
+
+    /// keep every fill in the result, as a synthetic trade dataset
+    bool recordFills = true;
+};
+
+/**
+ * @struct SimulationResult
+ * @brief What a simulation produced.
+ */
+struct SimulationResult {
+    uint32_t seed = 0;
+    uint64_t ordersSubmitted = 0;
+    uint64_t cancels = 0;
+    uint64_t fills = 0;
+    uint64_t sharesTraded = 0;
+    BookMetricsSnapshot metrics;
+    /// mid price at the end of each step, 0 while one side of the book is empty
+    std::vector<int> midPrices;
+    /// every fill, if SimulationConfig::recordFills
+    std::vector<Fill> trades;
+    int simulatedSeconds = 0;
+    double wallSeconds = 0;
+
+    double speedup() const;
+};
+
+/**
+ * @class Simulation
+ * @brief An agent-based simulation of one instrument traded on an Exchange, in simulated time.
+ *        Agent state is kept per kind in flat arrays, and each step first updates the state of
+ *        every agent of a kind in one branch-free loop (random draws and trigger tests) before
+ *        the few agents that decided to act submit their orders. Apart from the book's own order
+ *        storage and the recorded trades, nothing is allocated once the simulation is constructed.
+ */
+class Simulation {
+public:
+    Simulation(const SimulationConfig& config, uint32_t seed);
+
+    SimulationResult run();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+private:
+    class ResultFillSink : public FillSink {
+    public:
+        explicit ResultFillSink(Simulation& simulation);
+        void onFill(const Fill& fill) override;
+
+    private:
+        Simulation& simulation;
+    };
+
+    static uint32_t nextRandom(uint32_t& state);
+
+    void stepFundamental();
+    void stepMarketMakers(int eventTime);
+    void stepMomentumTraders(int eventTime);
+    void stepNoiseTraders(int eventTime);
+
+    int currentMid() const;
+    std::optional<int64_t> submit(Side side, int shares, int price, int eventTime);
+    void cancelIfResting(int64_t orderId);
+
+    static const std::string ticker;
+
+    SimulationConfig config;
+    Exchange exchange;
+    Book* book;
+    ResultFillSink fillSink;
+    SimulationResult result;
+
+    /// random state driving the fundamental price
+    uint32_t fundamentalRandom;
+    int fundamental;
+
+    std::vector<int> makerHalfSpread;
+    std::vector<int> makerQuotedAt;
+    std::vector<int64_t> makerBidId;
+    std::vector<int64_t> makerAskId;
+
+    std::vector<uint32_t> momentumRandom;
+    std::vector<int> momentumThreshold;
+    std::vector<int8_t> momentumDecision;
+    /// mid prices of the last momentumLookback + 1 steps
+    std::vector<int> midHistory;
+
+    std::vector<uint32_t> noiseRandom;
+    std::vector<uint8_t> noiseActive;
+    /// ids of the resting noise orders, oldest first from noiseHead
+    std::vector<int64_t> noiseOrders;
+    size_t noiseHead;
+    size_t noiseCount;
+};
+
+// runs one simulation per seed on a pool of threads, results in the order of the seeds
+std::vector<SimulationResult> runSimulations(const SimulationConfig& config, const std::vector<uint32_t>& seeds, size_t threads);
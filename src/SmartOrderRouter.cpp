@@ -0,0 +1,199 @@
+#include "SmartOrderRouter.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief A coroutine that starts eagerly and is never awaited; its frame is freed when it returns.
+ */
+struct SmartOrderRouter::ChildTask {
+    struct promise_type {
+        ChildTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Constructs the awaitable of a routed parent order. Nothing is sent until it is awaited.
+ * @param router The router owning the venues.
+ * @param plan The plan of the parent order.
+ * @param executor The executor resuming the awaiting coroutine.
+ */
+RouteAwaitable::RouteAwaitable(SmartOrderRouter& router, RoutePlan plan, Executor& executor)
+    : router(router), plan(std::move(plan)), executor(executor), pending(0) {
+    report.requestedShares = this->plan.requestedShares;
+    report.routedShares = this->plan.routedShares;
+    report.children.resize(this->plan.children.size());
+    residualCancelled.resize(this->plan.children.size());
+}
+
+bool RouteAwaitable::await_ready() const noexcept {
+    return plan.children.empty();
+}
+
+/**
+ * @brief Sends every child. The last report may arrive before the last child is sent, so the
+ *        awaitable holds one extra count until it is done sending.
+ * @param handle The awaiting coroutine.
+ * @return Whether the coroutine stays suspended, false if every child already reported.
+ */
+bool RouteAwaitable::await_suspend(std::coroutine_handle<> handle) noexcept {
+    task.handle = handle;
+    pending.store(plan.children.size() + 1, std::memory_order_relaxed);
+    for (size_t child = 0; child < plan.children.size(); ++child) {
+        SmartOrderRouter::sendChild(*this, child);
+    }
+    return pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+}
+
+/**
+ * @brief Aggregates the reports of the children.
+ * @return The report of the parent order.
+ */
+RouteReport RouteAwaitable::await_resume() noexcept {
+    for (size_t child = 0; child < report.children.size(); ++child) {
+        const ExecutionReport& childReport = report.children[child];
+        report.filledShares += childReport.filledShares;
+        report.filledNotional += childReport.filledNotional;
+        report.fills += childReport.fills;
+        report.rejectedChildren += childReport.status != SubmitStatus::Accepted;
+        report.cancelledResiduals += residualCancelled[child];
+        if (childReport.orderId) {
+            report.restingChildren.push_back(*childReport.orderId);
+        }
+    }
+    return std::move(report);
+}
+
+/**
+ * @brief Counts a child as reported, resuming the parent on its executor after the last one. The
+ *        awaitable may be destroyed as soon as the parent resumes.
+ */
+void RouteAwaitable::childCompleted() {
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        executor.post(&task);
+    }
+}
+
+/**
+ * @brief Registers a venue.
+ * @param name The name of the venue.
+ * @param matchingThread The matching thread of the venue's book for the routed instrument.
+ * @param depth The depth published by that matching thread. Both must outlive the router.
+ * @return The index of the venue.
+ * @throws std::runtime_error if the published depth has no free reader slot.
+ */
+uint32_t SmartOrderRouter::addVenue(const std::string& name, MatchingThread& matchingThread, PublishedDepth& depth) {
+    venues.push_back({name, &matchingThread, std::make_unique<DepthReader>(depth)});
+    return static_cast<uint32_t>(venues.size() - 1);
+}
+
+/**
+ * @brief Splits a parent order across the venues. The published levels of every venue within the
+ *        limit price are merged best price first, ties going to the venue registered first, and
+ *        taken until they hold the parent's shares.
+ * @param side The side of the parent order.
+ * @param shares The shares of the parent order.
+ * @param limitPrice The worst price the parent accepts, in cents.
+ * @return The plan, with at most one child per venue.
+ * @throws std::invalid_argument if shares is not positive.
+ */
+RoutePlan SmartOrderRouter::plan(Side side, int shares, int limitPrice) {
+    if (shares <= 0) {
+        throw std::invalid_argument("The shares of a parent order must be positive.");
+    }
+    levels.clear();
+    for (uint32_t venue = 0; venue < venues.size(); ++venue) {
+        const DepthView view = venues[venue].reader->read();
+        const auto& opposite = side == Side::Buy ? view.asks : view.bids;
+        const int count = side == Side::Buy ? view.askLevels : view.bidLevels;
+        for (int i = 0; i < count; ++i) {
+            if (side == Side::Buy ? opposite[i].price > limitPrice : opposite[i].price < limitPrice) {
+                break;
+            }
+            levels.push_back({opposite[i].price, opposite[i].volume, venue});
+        }
+    }
+    std::sort(levels.begin(), levels.end(), [side](const VenueLevel& a, const VenueLevel& b) {
+        if (a.price != b.price) {
+            return side == Side::Buy ? a.price < b.price : a.price > b.price;
+        }
+        return a.venue < b.venue;
+    });
+
+    allotted.assign(venues.size(), 0);
+    worstPrices.assign(venues.size(), 0);
+    int remaining = shares;
+    for (const VenueLevel& level : levels) {
+        if (remaining == 0) {
+            break;
+        }
+        const int taken = std::min(remaining, level.volume);
+        allotted[level.venue] += taken;
+        worstPrices[level.venue] = level.price;
+        remaining -= taken;
+    }
+
+    RoutePlan result;
+    result.side = side;
+    result.requestedShares = shares;
+    result.routedShares = shares - remaining;
+    for (uint32_t venue = 0; venue < venues.size(); ++venue) {
+        if (allotted[venue] > 0) {
+            result.children.push_back({venue, allotted[venue], worstPrices[venue]});
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Prepares the sending of a plan, which happens when the result is awaited.
+ * @param plan The plan, usually returned by plan.
+ * @param executor The executor resuming the awaiting coroutine once every venue reported.
+ * @return The awaitable.
+ */
+RouteAwaitable SmartOrderRouter::route(RoutePlan plan, Executor& executor) {
+    return RouteAwaitable(*this, std::move(plan), executor);
+}
+
+const std::string& SmartOrderRouter::getVenueName(uint32_t venue) const {
+    return venues.at(venue).name;
+}
+
+size_t SmartOrderRouter::getVenueCount() const {
+    return venues.size();
+}
+
+/**
+ * @brief Sends one child as a limit order one tick through its worst price, since the book only
+ *        crosses a level priced strictly better than the order, and cancels what it left resting.
+ *        The cancel is not retried when the venue is busy: the child runs on the venue's matching
+ *        thread, which can't free records while it waits. The residual then keeps its order id.
+ * @param route The parent order.
+ * @param child The index of the child in the plan.
+ */
+SmartOrderRouter::ChildTask SmartOrderRouter::sendChild(RouteAwaitable& route, size_t child) {
+    const ChildOrder order = route.plan.children[child];
+    const Side side = route.plan.side;
+    MatchingThread& matchingThread = *route.router.venues[order.venue].matchingThread;
+    Executor& executor = route.router.childExecutor;
+
+    const int price = side == Side::Buy ? order.worstPrice + 1 : order.worstPrice - 1;
+    ExecutionReport report = co_await matchingThread.submit({CommandType::Add, side, order.shares, price, -1, 0}, executor);
+    if (report.status == SubmitStatus::Accepted && report.orderId) {
+        const ExecutionReport cancel =
+            co_await matchingThread.submit({CommandType::Cancel, side, 0, 0, *report.orderId, 0}, executor);
+        if (cancel.status == SubmitStatus::Accepted) {
+            route.residualCancelled[child] = 1;
+            report.orderId.reset();
+        } else if (cancel.status == SubmitStatus::Rejected) {
+            // the residual already left the book
+            report.orderId.reset();
+        }
+    }
+    route.report.children[child] = report;
+    route.childCompleted();
+}
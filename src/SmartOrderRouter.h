@@ -0,0 +1,169 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MatchingThread.h"
+
+/**
+ * @struct ChildOrder
+ * @brief The part of a parent order sent to one venue.
+ */
+struct ChildOrder {
+    uint32_t venue = 0;
+    int shares = 0;
+    /// the worst price of the venue's depth the child is planned to take, in cents
+    int worstPrice = 0;
+};
+
+/**
+ * @struct RoutePlan
+ * @brief How a parent order is split across venues, at most one child per venue.
+ */
+struct RoutePlan {
+    Side side = Side::Buy;
+    int requestedShares = 0;
+    /// shares allotted to the children, less than requested when the published depth is too thin
+    int routedShares = 0;
+    std::vector<ChildOrder> children;
+};
+
+/**
+ * @struct RouteReport
+ * @brief The aggregated outcome of a routed parent order.
+ */
+struct RouteReport {
+    int requestedShares = 0;
+    int routedShares = 0;
+    int filledShares = 0;
+    /// sum of price * shares of the fills on every venue, in cents
+    int64_t filledNotional = 0;
+    uint32_t fills = 0;
+    /// children not accepted by their venue
+    uint32_t rejectedChildren = 0;
+    /// child residuals cancelled because the depth moved before they arrived
+    uint32_t cancelledResiduals = 0;
+    /// ids of child residuals still resting because their venue was too busy to take the cancel,
+    /// left for the caller to cancel
+    std::vector<int64_t> restingChildren;
+    /// one report per child, in the order of the plan
+    std::vector<ExecutionReport> children;
+};
+
+class SmartOrderRouter;
+
+/**
+ * @class RouteAwaitable
+ * @brief Awaiting it sends the children of a plan to their venues at once and suspends the coroutine
+ *        until every venue reported; it then resumes on the executor given to route. Each child is
+ *        sent as a limit order through its planned worst price, and a residual left in the book
+ *        because the depth moved is cancelled. A child only rests when its venue could not take
+ *        the cancel, and its id is then reported.
+ */
+class RouteAwaitable {
+public:
+    RouteAwaitable(SmartOrderRouter& router, RoutePlan plan, Executor& executor);
+
+    bool await_ready() const noexcept;
+    bool await_suspend(std::coroutine_handle<> handle) noexcept;
+    RouteReport await_resume() noexcept;
+
+    RouteAwaitable(const RouteAwaitable&) = delete;
+    RouteAwaitable& operator=(const RouteAwaitable&) = delete;
+
+private:
+    friend class SmartOrderRouter;
+
+    void childCompleted();
+
+    SmartOrderRouter& router;
+    RoutePlan plan;
+    Executor& executor;
+    RouteReport report;
+    /// set by each child whose residual it cancelled, so children never write the same memory
+    std::vector<uint8_t> residualCancelled;
+    /// children still running, plus one held by await_suspend while it sends them
+    std::atomic<size_t> pending;
+    ExecutorTask task;
+};
+
+/**
+ * @class SmartOrderRouter
+ * @brief Splits parent orders across the matching threads of several venues. Plans walk the depth
+ *        published by every venue, best price first, and allot each level to the venue displaying
+ *        it; the children are then sent concurrently and their reports aggregated. A router reads
+ *        the published depth through its own readers, so it is used by a single thread.
+ */
+class SmartOrderRouter {
+public:
+    SmartOrderRouter() = default;
+
+    uint32_t addVenue(const std::string& name, MatchingThread& matchingThread, PublishedDepth& depth);
+
+    RoutePlan plan(Side side, int shares, int limitPrice);
+    RouteAwaitable route(RoutePlan plan, Executor& executor);
+
+    const std::string& getVenueName(uint32_t venue) const;
+    size_t getVenueCount() const;
+
+    SmartOrderRouter(const SmartOrderRouter&) = delete;
+    SmartOrderRouter& operator=(const SmartOrderRouter&) = delete;
+
+private:
+    friend class RouteAwaitable;
+
+    struct Venue {
+        std::string name;
+        MatchingThread* matchingThread;
+        std::unique_ptr<DepthReader> reader;
+    };
+
+    /**
+     * @brief A level of a venue's depth, merged with the levels of the other venues.
+     */
+    struct VenueLevel {
+        int price;
+        int volume;
+        uint32_t venue;
+    };
+
+    /// the coroutine sending one child, defined with the router
+    struct ChildTask;
+    static ChildTask sendChild(RouteAwaitable& route, size_t child);
+
+    std::vector<Venue> venues;
+    /// children resume on the matching thread reporting them, which they only briefly hold
+    InlineExecutor childExecutor;
+    /// scratch space of plan
+    std::vector<VenueLevel> levels;
+    std::vector<int> allotted;
+    std::vector<int> worstPrices;
+};
@@ -0,0 +1,59 @@
+#include "StorageAdvisor.h"
+
+#include <sstream>
+
+/**
+ * @brief Recommends how to store the levels of a book.
+ *
+ * A dense ladder only works if almost every order lands within a bounded distance of the touch, so
+ * the window is sized from the 99th percentile of that distance, doubled to leave room for the touch
+ * to move. It is then only worth it if the book creates and destroys levels often or aggressive
+ * orders sweep deep, since those are the operations where the tree pays for allocation,
+ * rebalancing and pointer chasing.
+ *
+ * @param statistics The workload statistics of the book.
+ * @return The recommended storage policy and ladder window.
+ */
+StorageRecommendation StorageAdvisor::recommend(const BookStatisticsSnapshot& statistics) {
+    
+    StorageRecommendation recommendation;
+    std::ostringstream rationale;
+
+    const uint64_t orders = statistics.levelCreations + statistics.levelJoins;
+    if (orders < minimumOrders) {
+        rationale << "only " << orders << " orders observed, keeping the sparse tree";
+        recommendation.rationale = rationale.str();
+        return recommendation;
+    }
+
+    const size_t distanceBucket = statistics.touchDistance.percentileBucket(0.99);
+    if (distanceBucket + 1 >= touchDistanceBuckets) {
+        recommendation.rationale = "orders are placed too far from the touch for a bounded ladder";
+        return recommendation;
+    }
+
+    const uint64_t p99Distance = HistogramSnapshot<touchDistanceBuckets>::upperBound(distanceBucket);
+    const uint64_t window = 2 * (p99Distance + 1);
+    if (window > static_cast<uint64_t>(maximumLadderWindow)) {
+        rationale << "99% of orders land within " << p99Distance << " ticks of the touch, wider than the "
+                  << maximumLadderWindow << " tick ladder limit";
+        recommendation.rationale = rationale.str();
+        return recommendation;
+    }
+
+    const double churn = static_cast<double>(statistics.levelCreations) / static_cast<double>(orders);
+    const uint64_t p99Sweep = HistogramSnapshot<sweepDepthBuckets>::upperBound(statistics.sweepDepth.percentileBucket(0.99));
+
+    rationale << "99% of orders within " << p99Distance << " ticks of the touch, " << static_cast<int>(churn * 100)
+              << "% of orders create a level, 99% of sweeps cross at most " << p99Sweep << " levels";
+
+    if (churn >= churnThreshold || p99Sweep >= deepSweepLevels) {
+        recommendation.policy = StoragePolicy::DenseLadder;
+        recommendation.ladderWindowTicks = static_cast<int>(window);
+    } else {
+        rationale << ": level churn is low, the sparse tree is sufficient";
+    }
+
+    recommendation.rationale = rationale.str();
+    return recommendation;
+}
@@ -0,0 +1,77 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include "BookStatistics.h"
+
+/**
+ * @enum StoragePolicy
+ * @brief How the price levels of one side of a book can be stored.
+ */
+enum class StoragePolicy {
+    /// an ordered tree keyed by price, as LOBSide uses today: memory proportional to the number of levels
+    SparseTree,
+    /// a contiguous array of levels indexed by the distance in ticks from a window origin near the touch
+    DenseLadder
+};
+
+/**
+ * @brief Returns the name of a storage policy.
+ * @param policy The storage policy.
+ * @return The name of the policy.
+ */
+inline const char* toString(StoragePolicy policy) {
+    return policy == StoragePolicy::DenseLadder ? "dense_ladder" : "sparse_tree";
+}
+
+/**
+ * @struct StorageRecommendation
+ * @brief The storage policy recommended for an instrument and the reasoning behind it.
+ */
+struct StorageRecommendation {
+    StoragePolicy policy = StoragePolicy::SparseTree;
+    /// number of ticks the ladder should cover, 0 for the sparse tree
+    int ladderWindowTicks = 0;
+    std::string rationale;
+};
+
+/**
+ * @class StorageAdvisor
+ * @brief Recommends a level storage policy and ladder window size for a book from the shape of its workload.
+ */
+class StorageAdvisor {
+public:
+    /// orders a book must have seen before the advisor trusts its statistics
+    static constexpr uint64_t minimumOrders = 1000;
+    /// largest ladder the advisor recommends, in ticks
+    static constexpr int maximumLadderWindow = 1 << 16;
+    /// share of orders creating a level above which tree node churn dominates
+    static constexpr double churnThreshold = 0.2;
+    /// 99th percentile sweep depth above which walking contiguous levels pays off
+    static constexpr uint64_t deepSweepLevels = 4;
+
+    static StorageRecommendation recommend(const BookStatisticsSnapshot& statistics);
+};
@@ -0,0 +1,149 @@
+#include "Throttle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+int64_t coarseNowNanos() {
+#ifdef CLOCK_MONOTONIC_COARSE
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief Constructs a full bucket.
+ * @param limit The sustained rate and the burst.
+ */
+TokenBucket::TokenBucket(RateLimit limit)
+    : tokensPerNano(limit.messagesPerSecond / 1e9), burst(std::max(limit.burst, 1.0)), tokens(burst), lastRefill(0) {}
+
+/**
+ * @brief Refills the bucket for the time elapsed since the previous check and tells whether a
+ *        message can be sent.
+ * @param nowNanos The current time, from coarseNowNanos or any monotonic clock in nanoseconds.
+ * @return True if a token is available.
+ */
+bool TokenBucket::available(int64_t nowNanos) {
+    if (isUnlimited()) {
+        return true;
+    }
+    if (lastRefill != 0 && nowNanos > lastRefill) {
+        tokens = std::min(burst, tokens + static_cast<double>(nowNanos - lastRefill) * tokensPerNano);
+    }
+    if (nowNanos > lastRefill) {
+        lastRefill = nowNanos;
+    }
+    return tokens >= 1;
+}
+
+/**
+ * @brief Takes the token of a message. Must follow a successful call to available.
+ */
+void TokenBucket::take() {
+    if (!isUnlimited()) {
+        tokens -= 1;
+    }
+}
+
+/**
+ * @brief Fills the bucket up again, as for a new session.
+ */
+void TokenBucket::reset() {
+    tokens = burst;
+    lastRefill = 0;
+}
+
+bool TokenBucket::isUnlimited() const {
+    return tokensPerNano <= 0;
+}
+
+/**
+ * @brief Constructs the buckets of every session and instrument.
+ * @param sessionLimit The rate limit of each session.
+ * @param instrumentLimit The rate limit of each instrument.
+ * @param sessions Number of sessions, identified by 0 to sessions - 1.
+ * @param tickers The instruments; messages for other tickers are only limited by their session.
+ */
+IngressThrottle::IngressThrottle(RateLimit sessionLimit, RateLimit instrumentLimit, size_t sessions,
+                                 const std::vector<std::string>& tickers)
+    : sessions(sessions) {
+    for (SessionThrottle& session : this->sessions) {
+        session.bucket = TokenBucket(sessionLimit);
+    }
+    for (const std::string& ticker : tickers) {
+        instruments[ticker].bucket = TokenBucket(instrumentLimit);
+    }
+}
+
+/**
+ * @brief Decides whether a message is passed on to the book, taking its tokens if it is. Cancels
+ *        are admitted without taking tokens, so a throttled session can still reduce its exposure.
+ * @param session The session sending the message.
+ * @param ticker The instrument of the message.
+ * @param type The command of the message.
+ * @param nowNanos The current time, see coarseNowNanos.
+ * @return Admitted, or the limit the message exceeded.
+ */
+ThrottleResult IngressThrottle::admit(size_t session, const std::string& ticker, CommandType type, int64_t nowNanos) {
+    if (type == CommandType::Cancel) {
+        admittedMessages.increment();
+        return ThrottleResult::Admitted;
+    }
+
+    SessionThrottle& sessionThrottle = sessions[session];
+    if (!sessionThrottle.bucket.available(nowNanos)) {
+        sessionThrottle.rejects.increment();
+        return ThrottleResult::SessionLimited;
+    }
+
+    auto instrument = instruments.find(ticker);
+    if (instrument != instruments.end()) {
+        if (!instrument->second.bucket.available(nowNanos)) {
+            instrument->second.rejects.increment();
+            return ThrottleResult::InstrumentLimited;
+        }
+        instrument->second.bucket.take();
+    }
+    sessionThrottle.bucket.take();
+    admittedMessages.increment();
+    return ThrottleResult::Admitted;
+}
+
+/**
+ * @brief Gives a session a full bucket, when the slot is reused by a new client.
+ * @param session The session.
+ */
+void IngressThrottle::resetSession(size_t session) {
+    sessions[session].bucket.reset();
+}
+
+/**
+ * @brief Returns the number of messages admitted so far.
+ * @return The number of messages.
+ */
+uint64_t IngressThrottle::getAdmittedMessages() const {
+    return admittedMessages.get();
+}
+
+/**
+ * @brief Returns the number of messages of a session rejected by its own rate limit.
+ * @param session The session.
+ * @return The number of messages.
+ */
+uint64_t IngressThrottle::getSessionRejects(size_t session) const {
+    return sessions.at(session).rejects.get();
+}
+
+/**
+ * @brief Returns the number of messages rejected by the rate limit of an instrument.
+ * @param ticker The instrument.
+ * @return The number of messages, 0 for an unknown instrument.
+ */
+uint64_t IngressThrottle::getInstrumentRejects(const std::string& ticker) const {
+    auto instrument = instruments.find(ticker);
+    return instrument == instruments.end() ? 0 : instrument->second.rejects.get();
+}
@@ -0,0 +1,126 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BookCommand.h"
+#include "Metrics.h"
+
+/**
+ * @struct RateLimit
+ * @brief A sustained message rate and the burst allowed on top of it. A zero rate means unlimited.
+ */
+struct RateLimit {
+    double messagesPerSecond = 0;
+    /// messages that can be sent at once after a quiet period, at least 1
+    double burst = 1;
+};
+
+/**
+ * @brief Returns a monotonic time in nanoseconds from the cheapest clock available. On Linux it is
+ *        the coarse monotonic clock, read from the vDSO without a syscall, with the resolution of
+ *        the scheduler tick, which is plenty to refill token buckets.
+ * @return The time in nanoseconds.
+ */
+int64_t coarseNowNanos();
+
+/**
+ * @class TokenBucket
+ * @brief A token bucket refilled lazily when a message is checked: each message takes a token,
+ *        tokens come back at the sustained rate and accumulate up to the burst.
+ */
+class TokenBucket {
+public:
+    explicit TokenBucket(RateLimit limit = {});
+
+    bool available(int64_t nowNanos);
+    void take();
+    void reset();
+
+    bool isUnlimited() const;
+
+private:
+    double tokensPerNano;
+    double burst;
+    double tokens;
+    /// time of the last refill, 0 before the first message
+    int64_t lastRefill;
+};
+
+/**
+ * @enum ThrottleResult
+ * @brief Outcome of the admission of a message by the ingress throttle.
+ */
+enum class ThrottleResult : uint8_t {
+    Admitted,
+    /// the session exceeded its rate
+    SessionLimited,
+    /// the instrument exceeded its rate, over all sessions
+    InstrumentLimited
+};
+
+/**
+ * @class IngressThrottle
+ * @brief Rate limits the messages of the order entry sessions before they reach any book, with a
+ *        token bucket per session and one per instrument shared by all sessions. A message is
+ *        admitted only if both buckets have a token. Cancels are always admitted without taking
+ *        tokens, so a session over its rate can still pull its resting orders. Used by the single
+ *        thread serving the
+ *        sessions; its counters can be read from any thread.
+ */
+class IngressThrottle {
+public:
+    IngressThrottle(RateLimit sessionLimit, RateLimit instrumentLimit, size_t sessions, const std::vector<std::string>& tickers);
+
+    ThrottleResult admit(size_t session, const std::string& ticker, CommandType type, int64_t nowNanos);
+    void resetSession(size_t session);
+
+    uint64_t getAdmittedMessages() const;
+    uint64_t getSessionRejects(size_t session) const;
+    uint64_t getInstrumentRejects(const std::string& ticker) const;
+
+    IngressThrottle(const IngressThrottle&) = delete;
+    IngressThrottle& operator=(const IngressThrottle&) = delete;
+
+private:
+    struct SessionThrottle {
+        TokenBucket bucket;
+        MetricsCounter rejects;
+    };
+
+    struct InstrumentThrottle {
+        TokenBucket bucket;
+        MetricsCounter rejects;
+    };
+
+    std::vector<SessionThrottle> sessions;
+    /// one entry per ticker known at construction, never modified afterwards
+    std::unordered_map<std::string, InstrumentThrottle> instruments;
+    MetricsCounter admittedMessages;
+};
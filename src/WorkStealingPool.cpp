@@ -0,0 +1,144 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+/**
+ * @brief Starts the worker threads.
+ * @param threads Number of workers, at least one.
+ */
+WorkStealingPool::WorkStealingPool(size_t threads)
+    : queued(0), pending(0), stopping(false), nextQueue(0), stolenTasks(0) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+/**
+ * @brief Lets the workers finish the submitted tasks, then joins them.
+ */
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        allDone.wait(lock, [this] { return pending == 0; });
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Submits a task. Tasks are spread round robin over the worker queues.
+ * @param task The task.
+ */
+void WorkStealingPool::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++queued;
+        ++pending;
+    }
+    WorkerQueue& queue = *queues[nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+/**
+ * @brief Blocks until every submitted task has finished.
+ * @throws The first exception thrown by a task since the previous wait.
+ */
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Returns the number of worker threads.
+ * @return The number of workers.
+ */
+size_t WorkStealingPool::getThreadCount() const {
+    return workers.size();
+}
+
+/**
+ * @brief Returns the number of tasks run by a worker other than the one they were submitted to.
+ * @return The number of stolen tasks.
+ */
+uint64_t WorkStealingPool::getStolenTasks() const {
+    return stolenTasks.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Worker loop: runs tasks until the pool is destroyed, sleeping while there is nothing to take.
+ * @param worker Index of the worker's own queue.
+ */
+void WorkStealingPool::run(size_t worker) {
+    while (true) {
+        Task task;
+        if (tryTake(worker, task)) {
+            std::exception_ptr error;
+            try {
+                task();
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (error && !firstError) {
+                firstError = error;
+            }
+            if (--pending == 0) {
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Takes the oldest task of the worker's own queue, or else the newest task of another queue.
+ * @param worker Index of the worker's own queue.
+ * @param task Receives the task.
+ * @return False if every queue is empty.
+ */
+bool WorkStealingPool::tryTake(size_t worker, Task& task) {
+    for (size_t offset = 0; offset < queues.size(); ++offset) {
+        WorkerQueue& queue = *queues[(worker + offset) % queues.size()];
+        std::unique_lock<std::mutex> queueLock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (offset == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            stolenTasks.fetch_add(1, std::memory_order_relaxed);
+        }
+        queueLock.unlock();
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        --queued;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,88 @@
+// An order book implementation
+//
+// MIT License
+//
+// Copyright (c) 2024 Riccardo Canton
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkStealingPool
+ * @brief A fixed pool of threads, each owning a task queue. A worker runs its own tasks in submission
+ *        order and, when its queue is empty, steals the most recently submitted task of another worker,
+ *        so submitting the longest tasks first keeps every thread busy until the end. Meant for coarse tasks such as replaying whole books:
+ *        the queues are guarded by plain mutexes.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(size_t threads);
+    ~WorkStealingPool();
+
+    void submit(Task task);
+    void wait();
+
+    size_t getThreadCount() const;
+    uint64_t getStolenTasks() const;
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(size_t worker);
+    bool tryTake(size_t worker, Task& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    /// guards queued, pending, stopping and firstError
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    /// tasks submitted and not yet taken by a worker
+    size_t queued;
+    /// tasks submitted and not yet finished
+    size_t pending;
+    bool stopping;
+    /// first exception thrown by a task since the last wait
+    std::exception_ptr firstError;
+
+    /// queue receiving the next submitted task
+    std::atomic<size_t> nextQueue;
+    std::atomic<uint64_t> stolenTasks;
+};